@@ -214,6 +214,7 @@ struct dwrite_fontface
     struct dwrite_fonttable cpal;
     struct dwrite_fonttable colr;
     DWRITE_GLYPH_METRICS *glyphs[GLYPH_MAX/GLYPH_BLOCK_SIZE];
+    UINT16 *bmp_glyphs[0x10000/GLYPH_BLOCK_SIZE];
 
     DWRITE_FONT_STYLE style;
     DWRITE_FONT_STRETCH stretch;
@@ -223,6 +224,12 @@ struct dwrite_fontface
     UINT32 glyph_image_formats;
 
     struct scriptshaping_cache *shaping_cache;
+    struct
+    {
+        struct list *buckets;
+        struct list lru;
+        SIZE_T size;
+    } shaped_runs;
 
     LOGFONTW lf;
 };
@@ -282,6 +289,36 @@ extern float fontface_get_scaled_design_advance(struct dwrite_fontface *fontface
         float emsize, float ppdip, const DWRITE_MATRIX *transform, UINT16 glyph, BOOL is_sideways) DECLSPEC_HIDDEN;
 extern struct dwrite_fontface *unsafe_impl_from_IDWriteFontFace(IDWriteFontFace *iface) DECLSPEC_HIDDEN;
 
+/* Shaping output cached per font face, keyed by everything that affects GetGlyphs() and
+   Get[GdiCompatible]GlyphPlacements() results for a layout run. */
+struct shaped_run_key
+{
+    const WCHAR *text;
+    UINT32 length;
+    const WCHAR *locale;
+    DWRITE_SCRIPT_ANALYSIS sa;
+    float emsize;
+    BOOL is_sideways;
+    BOOL is_rtl;
+    DWRITE_MEASURING_MODE measuring_mode;
+    float ppdip;                /* only used for GDI compatible modes */
+    DWRITE_MATRIX transform;    /* only used for GDI compatible modes */
+};
+
+struct shaped_run
+{
+    UINT32 glyph_count;
+    UINT16 *clustermap;
+    UINT16 *glyphs;
+    float *advances;
+    DWRITE_GLYPH_OFFSET *offsets;
+};
+
+extern BOOL fontface_get_shaped_run(struct dwrite_fontface *fontface, const struct shaped_run_key *key,
+        struct shaped_run *run) DECLSPEC_HIDDEN;
+extern void fontface_cache_shaped_run(struct dwrite_fontface *fontface, const struct shaped_run_key *key,
+        const struct shaped_run *run) DECLSPEC_HIDDEN;
+
 /* Opentype font table functions */
 struct dwrite_font_props {
     DWRITE_FONT_STYLE style;
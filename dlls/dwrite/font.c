@@ -69,6 +69,17 @@ struct dwrite_font_propvec {
     FLOAT weight;
 };
 
+/* Face properties that don't depend on simulations, resolved once per font. */
+struct dwrite_fontface_info
+{
+    DWRITE_CARET_METRICS caret;
+    unsigned int typo_ascent;
+    unsigned int typo_descent;
+    INT charmap;
+    UINT16 flags;
+    UINT32 glyph_image_formats;
+};
+
 struct dwrite_font_data {
     LONG ref;
 
@@ -94,6 +105,9 @@ struct dwrite_font_data {
 
     LOGFONTW lf;
 
+    /* set on first face creation, reused by following faces */
+    struct dwrite_fontface_info *face_info;
+
     /* used to mark font as tested when scanning for simulation candidate */
     BOOL bold_sim_tested : 1;
     BOOL oblique_sim_tested : 1;
@@ -271,6 +285,203 @@ struct scriptshaping_cache *fontface_get_shaping_cache(struct dwrite_fontface *f
     return fontface->shaping_cache = create_scriptshaping_cache(fontface, &dwrite_font_ops);
 }
 
+#define SHAPED_RUNS_HASH_SIZE 64
+#define SHAPED_RUNS_MAX_SIZE  0x40000
+
+struct shaped_run_entry
+{
+    struct list entry;
+    struct list lru_entry;
+    unsigned int hash;
+    SIZE_T size;
+    struct shaped_run_key key;
+    struct shaped_run run;
+    WCHAR locale[LOCALE_NAME_MAX_LENGTH];
+};
+
+static unsigned int shaped_run_key_hash(const struct shaped_run_key *key)
+{
+    unsigned int hash = 2166136261u, i;
+
+    for (i = 0; i < key->length; i++)
+        hash = (hash ^ key->text[i]) * 16777619u;
+    hash = (hash ^ key->sa.script) * 16777619u;
+    hash = (hash ^ (unsigned int)key->emsize) * 16777619u;
+
+    return hash;
+}
+
+static BOOL is_same_shaped_run_key(const struct shaped_run_key *left, const struct shaped_run_key *right)
+{
+    return left->length == right->length &&
+            left->emsize == right->emsize &&
+            left->is_sideways == right->is_sideways &&
+            left->is_rtl == right->is_rtl &&
+            left->sa.script == right->sa.script &&
+            left->sa.shapes == right->sa.shapes &&
+            left->measuring_mode == right->measuring_mode &&
+            left->ppdip == right->ppdip &&
+            !memcmp(&left->transform, &right->transform, sizeof(left->transform)) &&
+            !strcmpW(left->locale, right->locale) &&
+            !memcmp(left->text, right->text, left->length * sizeof(*left->text));
+}
+
+static void fontface_remove_shaped_run(struct dwrite_fontface *fontface, struct shaped_run_entry *entry)
+{
+    list_remove(&entry->entry);
+    list_remove(&entry->lru_entry);
+    fontface->shaped_runs.size -= entry->size;
+    heap_free(entry);
+}
+
+static void fontface_release_shaped_runs(struct dwrite_fontface *fontface)
+{
+    struct shaped_run_entry *entry, *entry2;
+
+    LIST_FOR_EACH_ENTRY_SAFE(entry, entry2, &fontface->shaped_runs.lru, struct shaped_run_entry, lru_entry)
+        fontface_remove_shaped_run(fontface, entry);
+    heap_free(fontface->shaped_runs.buckets);
+}
+
+/* Returns a copy of cached shaping results, arrays are allocated separately and owned by the caller. */
+BOOL fontface_get_shaped_run(struct dwrite_fontface *fontface, const struct shaped_run_key *key,
+        struct shaped_run *run)
+{
+    unsigned int hash = shaped_run_key_hash(key);
+    struct shaped_run_entry *entry;
+    BOOL found = FALSE;
+
+    factory_lock(fontface->factory);
+
+    if (fontface->shaped_runs.buckets)
+    {
+        LIST_FOR_EACH_ENTRY(entry, &fontface->shaped_runs.buckets[hash % SHAPED_RUNS_HASH_SIZE],
+                struct shaped_run_entry, entry)
+        {
+            if (entry->hash != hash || !is_same_shaped_run_key(&entry->key, key))
+                continue;
+
+            run->glyph_count = entry->run.glyph_count;
+            run->clustermap = heap_calloc(key->length, sizeof(*run->clustermap));
+            run->glyphs = heap_calloc(run->glyph_count, sizeof(*run->glyphs));
+            run->advances = heap_calloc(run->glyph_count, sizeof(*run->advances));
+            run->offsets = heap_calloc(run->glyph_count, sizeof(*run->offsets));
+            if (run->clustermap && run->glyphs && run->advances && run->offsets)
+            {
+                memcpy(run->clustermap, entry->run.clustermap, key->length * sizeof(*run->clustermap));
+                memcpy(run->glyphs, entry->run.glyphs, run->glyph_count * sizeof(*run->glyphs));
+                memcpy(run->advances, entry->run.advances, run->glyph_count * sizeof(*run->advances));
+                memcpy(run->offsets, entry->run.offsets, run->glyph_count * sizeof(*run->offsets));
+                found = TRUE;
+
+                list_remove(&entry->lru_entry);
+                list_add_head(&fontface->shaped_runs.lru, &entry->lru_entry);
+            }
+            else
+            {
+                heap_free(run->clustermap);
+                heap_free(run->glyphs);
+                heap_free(run->advances);
+                heap_free(run->offsets);
+            }
+            break;
+        }
+    }
+
+    factory_unlock(fontface->factory);
+
+    return found;
+}
+
+void fontface_cache_shaped_run(struct dwrite_fontface *fontface, const struct shaped_run_key *key,
+        const struct shaped_run *run)
+{
+    struct shaped_run_entry *entry;
+    unsigned int i;
+    SIZE_T size;
+    BYTE *ptr;
+
+    size = sizeof(*entry) + run->glyph_count * (sizeof(*run->advances) + sizeof(*run->offsets) + sizeof(*run->glyphs)) +
+            key->length * (sizeof(*key->text) + sizeof(*run->clustermap));
+
+    /* Don't let a single long run flush the whole cache. */
+    if (size > SHAPED_RUNS_MAX_SIZE / 4 || strlenW(key->locale) >= LOCALE_NAME_MAX_LENGTH)
+        return;
+
+    if (!(entry = heap_alloc(size)))
+        return;
+
+    entry->hash = shaped_run_key_hash(key);
+    entry->size = size;
+    entry->key = *key;
+    entry->run.glyph_count = run->glyph_count;
+
+    /* Arrays are laid out after the header, ordered by decreasing alignment requirement. */
+    ptr = (BYTE *)(entry + 1);
+    entry->run.advances = (float *)ptr;
+    memcpy(ptr, run->advances, run->glyph_count * sizeof(*run->advances));
+    ptr += run->glyph_count * sizeof(*run->advances);
+    entry->run.offsets = (DWRITE_GLYPH_OFFSET *)ptr;
+    memcpy(ptr, run->offsets, run->glyph_count * sizeof(*run->offsets));
+    ptr += run->glyph_count * sizeof(*run->offsets);
+    entry->key.text = (WCHAR *)ptr;
+    memcpy(ptr, key->text, key->length * sizeof(*key->text));
+    ptr += key->length * sizeof(*key->text);
+    entry->run.clustermap = (UINT16 *)ptr;
+    memcpy(ptr, run->clustermap, key->length * sizeof(*run->clustermap));
+    ptr += key->length * sizeof(*run->clustermap);
+    entry->run.glyphs = (UINT16 *)ptr;
+    memcpy(ptr, run->glyphs, run->glyph_count * sizeof(*run->glyphs));
+    strcpyW(entry->locale, key->locale);
+    entry->key.locale = entry->locale;
+
+    factory_lock(fontface->factory);
+
+    if (!fontface->shaped_runs.buckets)
+    {
+        if ((fontface->shaped_runs.buckets = heap_calloc(SHAPED_RUNS_HASH_SIZE, sizeof(*fontface->shaped_runs.buckets))))
+        {
+            for (i = 0; i < SHAPED_RUNS_HASH_SIZE; i++)
+                list_init(&fontface->shaped_runs.buckets[i]);
+        }
+    }
+
+    if (fontface->shaped_runs.buckets)
+    {
+        struct shaped_run_entry *cur, *cur2;
+        struct list *bucket = &fontface->shaped_runs.buckets[entry->hash % SHAPED_RUNS_HASH_SIZE];
+
+        /* Concurrent layouts could have shaped the same run. */
+        LIST_FOR_EACH_ENTRY(cur, bucket, struct shaped_run_entry, entry)
+        {
+            if (cur->hash == entry->hash && is_same_shaped_run_key(&cur->key, &entry->key))
+            {
+                heap_free(entry);
+                entry = NULL;
+                break;
+            }
+        }
+
+        if (entry)
+        {
+            LIST_FOR_EACH_ENTRY_SAFE_REV(cur, cur2, &fontface->shaped_runs.lru, struct shaped_run_entry, lru_entry)
+            {
+                if (fontface->shaped_runs.size + size <= SHAPED_RUNS_MAX_SIZE)
+                    break;
+                fontface_remove_shaped_run(fontface, cur);
+            }
+
+            list_add_head(bucket, &entry->entry);
+            list_add_head(&fontface->shaped_runs.lru, &entry->lru_entry);
+            fontface->shaped_runs.size += size;
+        }
+    }
+    else
+        heap_free(entry);
+
+    factory_unlock(fontface->factory);
+}
+
 static inline struct dwrite_fontface *impl_from_IDWriteFontFace4(IDWriteFontFace4 *iface)
 {
     return CONTAINING_RECORD(iface, struct dwrite_fontface, IDWriteFontFace4_iface);
@@ -425,6 +636,7 @@ static void release_font_data(struct dwrite_font_data *data)
         IDWriteLocalizedStrings_Release(data->names);
 
     IDWriteFontFile_Release(data->file);
+    heap_free(data->face_info);
     heap_free(data->facename);
     heap_free(data);
 }
@@ -502,6 +714,7 @@ static ULONG WINAPI dwritefontface_Release(IDWriteFontFace4 *iface)
             heap_free(This->cached);
         }
         release_scriptshaping_cache(This->shaping_cache);
+        fontface_release_shaped_runs(This);
         if (This->cmap.context)
             IDWriteFontFace4_ReleaseFontTable(iface, This->cmap.context);
         if (This->vdmx.context)
@@ -522,6 +735,8 @@ static ULONG WINAPI dwritefontface_Release(IDWriteFontFace4 *iface)
 
         for (i = 0; i < ARRAY_SIZE(This->glyphs); i++)
             heap_free(This->glyphs[i]);
+        for (i = 0; i < ARRAY_SIZE(This->bmp_glyphs); i++)
+            heap_free(This->bmp_glyphs[i]);
 
         freetype_notify_cacheremove(iface);
 
@@ -629,9 +844,37 @@ static HRESULT WINAPI dwritefontface_GetDesignGlyphMetrics(IDWriteFontFace4 *ifa
     return S_OK;
 }
 
+/* Most lookups are for BMP characters, their mapping is resolved a whole block at a time
+   and kept with the face. */
+static const UINT16 *fontface_get_bmp_glyphs(struct dwrite_fontface *fontface, UINT32 block)
+{
+    UINT32 codepoints[GLYPH_BLOCK_SIZE], i;
+    UINT16 *glyphs;
+
+    if (fontface->bmp_glyphs[block])
+        return fontface->bmp_glyphs[block];
+
+    if (!(glyphs = heap_calloc(GLYPH_BLOCK_SIZE, sizeof(*glyphs))))
+        return NULL;
+
+    for (i = 0; i < GLYPH_BLOCK_SIZE; i++)
+        codepoints[i] = (block << GLYPH_BLOCK_SHIFT) + i;
+    freetype_get_glyphs(&fontface->IDWriteFontFace4_iface, fontface->charmap, codepoints, GLYPH_BLOCK_SIZE, glyphs);
+
+    if (InterlockedCompareExchangePointer((void **)&fontface->bmp_glyphs[block], glyphs, NULL)) {
+        heap_free(glyphs);
+        return fontface->bmp_glyphs[block];
+    }
+
+    return glyphs;
+}
+
 static HRESULT fontface_get_glyphs(struct dwrite_fontface *fontface, UINT32 const *codepoints,
         UINT32 count, UINT16 *glyphs)
 {
+    const UINT16 *block;
+    UINT32 i;
+
     if (!glyphs)
         return E_INVALIDARG;
 
@@ -640,7 +883,13 @@ static HRESULT fontface_get_glyphs(struct dwrite_fontface *fontface, UINT32 cons
         return E_INVALIDARG;
     }
 
-    freetype_get_glyphs(&fontface->IDWriteFontFace4_iface, fontface->charmap, codepoints, count, glyphs);
+    for (i = 0; i < count; i++) {
+        if (codepoints[i] < 0x10000 && (block = fontface_get_bmp_glyphs(fontface, codepoints[i] >> GLYPH_BLOCK_SHIFT)))
+            glyphs[i] = block[codepoints[i] & GLYPH_BLOCK_MASK];
+        else
+            freetype_get_glyphs(&fontface->IDWriteFontFace4_iface, fontface->charmap, &codepoints[i], 1, &glyphs[i]);
+    }
+
     return S_OK;
 }
 
@@ -3512,6 +3761,7 @@ static HRESULT init_font_data_from_font(const struct dwrite_font_data *src, DWRI
         data->style = DWRITE_FONT_STYLE_OBLIQUE;
     memset(data->info_strings, 0, sizeof(data->info_strings));
     data->names = NULL;
+    data->face_info = NULL;
     IDWriteFontFile_AddRef(data->file);
 
     create_localizedstrings(&data->names);
@@ -4428,12 +4678,36 @@ HRESULT create_font_file(IDWriteFontFileLoader *loader, const void *reference_ke
     return S_OK;
 }
 
-HRESULT create_fontface(const struct fontface_desc *desc, struct list *cached_list, IDWriteFontFace4 **ret)
+static void fontface_get_info(struct dwrite_fontface *fontface, const struct fontface_desc *desc,
+        struct dwrite_fontface_info *info)
 {
     struct file_stream_desc stream_desc;
+    BOOL is_symbol;
+
+    stream_desc.stream = fontface->stream;
+    stream_desc.face_type = desc->face_type;
+    stream_desc.face_index = desc->index;
+    opentype_get_font_metrics(&stream_desc, &fontface->metrics, &info->caret);
+    opentype_get_font_typo_metrics(&stream_desc, &info->typo_ascent, &info->typo_descent);
+
+    info->flags = 0;
+    info->charmap = freetype_get_charmap_index(&fontface->IDWriteFontFace4_iface, &is_symbol);
+    if (is_symbol)
+        info->flags |= FONTFACE_IS_SYMBOL;
+    if (freetype_has_kerning_pairs(&fontface->IDWriteFontFace4_iface))
+        info->flags |= FONTFACE_HAS_KERNING_PAIRS;
+    if (freetype_is_monospaced(&fontface->IDWriteFontFace4_iface))
+        info->flags |= FONTFACE_IS_MONOSPACED;
+    if (opentype_has_vertical_variants(&fontface->IDWriteFontFace4_iface))
+        info->flags |= FONTFACE_HAS_VERTICAL_VARIANTS;
+    info->glyph_image_formats = opentype_get_glyph_image_formats(&fontface->IDWriteFontFace4_iface);
+}
+
+HRESULT create_fontface(const struct fontface_desc *desc, struct list *cached_list, IDWriteFontFace4 **ret)
+{
+    struct dwrite_fontface_info info, *cached_info;
     struct dwrite_fontface *fontface;
     HRESULT hr = S_OK;
-    BOOL is_symbol;
     int i;
 
     *ret = NULL;
@@ -4459,6 +4733,7 @@ HRESULT create_fontface(const struct fontface_desc *desc, struct list *cached_li
     fontface->colr.exists = TRUE;
     fontface->index = desc->index;
     fontface->simulations = desc->simulations;
+    list_init(&fontface->shaped_runs.lru);
     IDWriteFactory5_AddRef(fontface->factory = desc->factory);
 
     for (i = 0; i < fontface->file_count; i++) {
@@ -4468,11 +4743,28 @@ HRESULT create_fontface(const struct fontface_desc *desc, struct list *cached_li
     fontface->stream = desc->stream;
     IDWriteFontFileStream_AddRef(fontface->stream);
 
-    stream_desc.stream = fontface->stream;
-    stream_desc.face_type = desc->face_type;
-    stream_desc.face_index = desc->index;
-    opentype_get_font_metrics(&stream_desc, &fontface->metrics, &fontface->caret);
-    opentype_get_font_typo_metrics(&stream_desc, &fontface->typo_metrics.ascent, &fontface->typo_metrics.descent);
+    /* Faces are created and released repeatedly for the same font, table parsing results are
+       kept with font data to avoid going through the font file again. */
+    if (desc->font_data && desc->font_data->face_info) {
+        fontface->metrics = desc->font_data->metrics;
+        info = *desc->font_data->face_info;
+    }
+    else {
+        fontface_get_info(fontface, desc, &info);
+        if (desc->font_data && (cached_info = heap_alloc(sizeof(*cached_info)))) {
+            *cached_info = info;
+            if (InterlockedCompareExchangePointer((void **)&desc->font_data->face_info, cached_info, NULL))
+                heap_free(cached_info);
+        }
+    }
+
+    fontface->caret = info.caret;
+    fontface->typo_metrics.ascent = info.typo_ascent;
+    fontface->typo_metrics.descent = info.typo_descent;
+    fontface->charmap = info.charmap;
+    fontface->flags = info.flags;
+    fontface->glyph_image_formats = info.glyph_image_formats;
+
     if (desc->simulations & DWRITE_FONT_SIMULATIONS_OBLIQUE) {
         /* TODO: test what happens if caret is already slanted */
         if (fontface->caret.slopeRise == 1) {
@@ -4481,17 +4773,6 @@ HRESULT create_fontface(const struct fontface_desc *desc, struct list *cached_li
         }
     }
 
-    fontface->charmap = freetype_get_charmap_index(&fontface->IDWriteFontFace4_iface, &is_symbol);
-    if (is_symbol)
-        fontface->flags |= FONTFACE_IS_SYMBOL;
-    if (freetype_has_kerning_pairs(&fontface->IDWriteFontFace4_iface))
-        fontface->flags |= FONTFACE_HAS_KERNING_PAIRS;
-    if (freetype_is_monospaced(&fontface->IDWriteFontFace4_iface))
-        fontface->flags |= FONTFACE_IS_MONOSPACED;
-    if (opentype_has_vertical_variants(&fontface->IDWriteFontFace4_iface))
-        fontface->flags |= FONTFACE_HAS_VERTICAL_VARIANTS;
-    fontface->glyph_image_formats = opentype_get_glyph_image_formats(&fontface->IDWriteFontFace4_iface);
-
     /* Font properties are reused from font object when 'normal' face creation path is used:
        collection -> family -> matching font -> fontface.
 
@@ -923,17 +923,68 @@ fatal:
     return hr;
 }
 
+static void layout_set_run_glyphs(struct regular_layout_run *run)
+{
+    run->run.glyphIndices = run->glyphs;
+    run->descr.clusterMap = run->clustermap;
+    run->run.glyphAdvances = run->advances;
+    run->run.glyphOffsets = run->offsets;
+
+    /* Special treatment for runs that don't produce visual output, shaping code adds normal glyphs for them,
+       with valid cluster map and potentially with non-zero advances; layout code exposes those as zero
+       width clusters. */
+    if (run->sa.shapes == DWRITE_SCRIPT_SHAPES_NO_VISUAL)
+        run->run.glyphCount = 0;
+    else
+        run->run.glyphCount = run->glyphcount;
+}
+
+static void layout_get_shaped_run_key(struct dwrite_textlayout *layout, const struct regular_layout_run *run,
+        struct shaped_run_key *key)
+{
+    memset(key, 0, sizeof(*key));
+    key->text = run->descr.string;
+    key->length = run->descr.stringLength;
+    key->locale = run->descr.localeName;
+    key->sa = run->sa;
+    key->emsize = run->run.fontEmSize;
+    key->is_sideways = run->run.isSideways;
+    key->is_rtl = run->run.bidiLevel & 1;
+    key->measuring_mode = layout->measuringmode;
+    if (is_layout_gdi_compatible(layout)) {
+        key->ppdip = layout->ppdip;
+        key->transform = layout->transform;
+    }
+}
+
 static HRESULT layout_shape_run(struct dwrite_textlayout *layout, struct regular_layout_run *run)
 {
     DWRITE_SHAPING_GLYPH_PROPERTIES *glyph_props;
     DWRITE_SHAPING_TEXT_PROPERTIES *text_props;
+    struct dwrite_fontface *fontface;
     IDWriteTextAnalyzer *analyzer;
     struct layout_range *range;
+    struct shaped_run_key key;
+    struct shaped_run shaped;
     UINT32 max_count;
     HRESULT hr;
 
     range = get_layout_range_by_pos(layout, run->descr.textPosition);
     run->descr.localeName = range->locale;
+
+    /* Identical runs are common across layouts, e.g. when a layout is recreated for every frame. */
+    fontface = unsafe_impl_from_IDWriteFontFace(run->run.fontFace);
+    layout_get_shaped_run_key(layout, run, &key);
+    if (fontface_get_shaped_run(fontface, &key, &shaped)) {
+        run->clustermap = shaped.clustermap;
+        run->glyphs = shaped.glyphs;
+        run->advances = shaped.advances;
+        run->offsets = shaped.offsets;
+        run->glyphcount = shaped.glyph_count;
+        layout_set_run_glyphs(run);
+        return S_OK;
+    }
+
     run->clustermap = heap_calloc(run->descr.stringLength, sizeof(*run->clustermap));
 
     max_count = 3 * run->descr.stringLength / 2 + 16;
@@ -981,9 +1032,6 @@ static HRESULT layout_shape_run(struct dwrite_textlayout *layout, struct regular
         return hr;
     }
 
-    run->run.glyphIndices = run->glyphs;
-    run->descr.clusterMap = run->clustermap;
-
     run->advances = heap_calloc(run->glyphcount, sizeof(*run->advances));
     run->offsets = heap_calloc(run->glyphcount, sizeof(*run->offsets));
     if (!run->advances || !run->offsets)
@@ -991,14 +1039,14 @@ static HRESULT layout_shape_run(struct dwrite_textlayout *layout, struct regular
 
     /* Get advances and offsets. */
     if (is_layout_gdi_compatible(layout))
-        hr = IDWriteTextAnalyzer_GetGdiCompatibleGlyphPlacements(analyzer, run->descr.string, run->descr.clusterMap,
-                text_props, run->descr.stringLength, run->run.glyphIndices, glyph_props, run->glyphcount,
+        hr = IDWriteTextAnalyzer_GetGdiCompatibleGlyphPlacements(analyzer, run->descr.string, run->clustermap,
+                text_props, run->descr.stringLength, run->glyphs, glyph_props, run->glyphcount,
                 run->run.fontFace, run->run.fontEmSize, layout->ppdip, &layout->transform,
                 layout->measuringmode == DWRITE_MEASURING_MODE_GDI_NATURAL, run->run.isSideways, run->run.bidiLevel & 1,
                 &run->sa, run->descr.localeName, NULL, NULL, 0, run->advances, run->offsets);
     else
-        hr = IDWriteTextAnalyzer_GetGlyphPlacements(analyzer, run->descr.string, run->descr.clusterMap, text_props,
-                run->descr.stringLength, run->run.glyphIndices, glyph_props, run->glyphcount, run->run.fontFace,
+        hr = IDWriteTextAnalyzer_GetGlyphPlacements(analyzer, run->descr.string, run->clustermap, text_props,
+                run->descr.stringLength, run->glyphs, glyph_props, run->glyphcount, run->run.fontFace,
                 run->run.fontEmSize, run->run.isSideways, run->run.bidiLevel & 1, &run->sa, run->descr.localeName,
                 NULL, NULL, 0, run->advances, run->offsets);
 
@@ -1009,17 +1057,16 @@ static HRESULT layout_shape_run(struct dwrite_textlayout *layout, struct regular
         memset(run->offsets, 0, run->glyphcount * sizeof(*run->offsets));
         WARN("%s: failed to get glyph placement info, hr %#x.\n", debugstr_rundescr(&run->descr), hr);
     }
+    else {
+        shaped.glyph_count = run->glyphcount;
+        shaped.clustermap = run->clustermap;
+        shaped.glyphs = run->glyphs;
+        shaped.advances = run->advances;
+        shaped.offsets = run->offsets;
+        fontface_cache_shaped_run(fontface, &key, &shaped);
+    }
 
-    run->run.glyphAdvances = run->advances;
-    run->run.glyphOffsets = run->offsets;
-
-    /* Special treatment for runs that don't produce visual output, shaping code adds normal glyphs for them,
-       with valid cluster map and potentially with non-zero advances; layout code exposes those as zero
-       width clusters. */
-    if (run->sa.shapes == DWRITE_SCRIPT_SHAPES_NO_VISUAL)
-        run->run.glyphCount = 0;
-    else
-        run->run.glyphCount = run->glyphcount;
+    layout_set_run_glyphs(run);
 
     return S_OK;
 }
@@ -2570,6 +2617,8 @@ static inline HRESULT return_range(const struct layout_range_header *h, DWRITE_T
 static HRESULT set_layout_range_attr(struct dwrite_textlayout *layout, enum layout_range_attr_kind attr, struct layout_range_attr_value *value)
 {
     struct layout_range_header *cur, *right, *left, *outer;
+    /* Attributes that are only applied when building lines don't invalidate shaping results. */
+    USHORT recompute = RECOMPUTE_EVERYTHING;
     BOOL changed = FALSE;
     struct list *ranges;
     DWRITE_TEXT_RANGE r;
@@ -2594,12 +2643,15 @@ static HRESULT set_layout_range_attr(struct dwrite_textlayout *layout, enum layo
         break;
     case LAYOUT_RANGE_ATTR_UNDERLINE:
         ranges = &layout->underline_ranges;
+        recompute = RECOMPUTE_LINES_AND_OVERHANGS;
         break;
     case LAYOUT_RANGE_ATTR_STRIKETHROUGH:
         ranges = &layout->strike_ranges;
+        recompute = RECOMPUTE_LINES_AND_OVERHANGS;
         break;
     case LAYOUT_RANGE_ATTR_EFFECT:
         ranges = &layout->effects;
+        recompute = RECOMPUTE_LINES_AND_OVERHANGS;
         break;
     case LAYOUT_RANGE_ATTR_SPACING:
         ranges = &layout->spacing;
@@ -2670,7 +2722,7 @@ static HRESULT set_layout_range_attr(struct dwrite_textlayout *layout, enum layo
         list_add_after(&outer->entry, &cur->entry);
         list_add_after(&cur->entry, &right->entry);
 
-        layout->recompute = RECOMPUTE_EVERYTHING;
+        layout->recompute |= recompute;
         return S_OK;
     }
 
@@ -2710,7 +2762,7 @@ done:
     if (changed) {
         struct list *next, *i;
 
-        layout->recompute = RECOMPUTE_EVERYTHING;
+        layout->recompute |= recompute;
         i = list_head(ranges);
         while ((next = list_next(ranges, i))) {
             struct layout_range_header *next_range = LIST_ENTRY(next, struct layout_range_header, entry);
@@ -9173,6 +9173,93 @@ todo_wine
     ok(ref == 0, "factory not released, %u\n", ref);
 }
 
+static void test_GetGlyphIndices(void)
+{
+    static const UINT32 codepoints[] = {'a', 'b', 0x20ac, 0x4e00, 0xfffd, 0xffff, 0x10000, 0x1f600, 0x10ffff, 0x110000, 'a'};
+    UINT16 glyphs[ARRAY_SIZE(codepoints)], glyph, *bmp_glyphs;
+    DWRITE_FONT_METRICS metrics, metrics2;
+    DWRITE_CARET_METRICS caret, caret2;
+    IDWriteFontFace1 *fontface1;
+    IDWriteFontFace *fontface;
+    IDWriteFactory *factory;
+    UINT32 i, cp, *bmp_codepoints;
+    IDWriteFont *font;
+    HRESULT hr;
+    ULONG ref;
+
+    factory = create_factory();
+    font = get_tahoma_instance(factory, DWRITE_FONT_STYLE_NORMAL);
+
+    hr = IDWriteFont_CreateFontFace(font, &fontface);
+    ok(hr == S_OK, "Failed to create fontface, hr %#x.\n", hr);
+
+    memset(glyphs, 0xcc, sizeof(glyphs));
+    hr = IDWriteFontFace_GetGlyphIndices(fontface, codepoints, ARRAY_SIZE(codepoints), glyphs);
+    ok(hr == S_OK, "Failed to get glyph indices, hr %#x.\n", hr);
+    ok(glyphs[0] != 0, "Unexpected glyph index.\n");
+    ok(glyphs[0] == glyphs[ARRAY_SIZE(codepoints) - 1], "Unexpected glyph index %u.\n", glyphs[ARRAY_SIZE(codepoints) - 1]);
+    ok(glyphs[0] != glyphs[1], "Unexpected glyph index.\n");
+    ok(glyphs[9] == 0, "Unexpected glyph index %u.\n", glyphs[9]);
+
+    /* Batched lookups match individual ones. */
+    for (i = 0; i < ARRAY_SIZE(codepoints); i++)
+    {
+        glyph = 0xcccc;
+        hr = IDWriteFontFace_GetGlyphIndices(fontface, &codepoints[i], 1, &glyph);
+        ok(hr == S_OK, "Failed to get glyph index, hr %#x.\n", hr);
+        ok(glyph == glyphs[i], "%u: unexpected glyph index %u, expected %u.\n", i, glyph, glyphs[i]);
+    }
+
+    /* Whole BMP at once. */
+    bmp_codepoints = heap_alloc(0x10000 * sizeof(*bmp_codepoints));
+    bmp_glyphs = heap_alloc(0x10000 * sizeof(*bmp_glyphs));
+    for (cp = 0; cp < 0x10000; cp++)
+        bmp_codepoints[cp] = cp;
+    hr = IDWriteFontFace_GetGlyphIndices(fontface, bmp_codepoints, 0x10000, bmp_glyphs);
+    ok(hr == S_OK, "Failed to get glyph indices, hr %#x.\n", hr);
+    ok(bmp_glyphs['a'] == glyphs[0], "Unexpected glyph index %u.\n", bmp_glyphs['a']);
+    ok(bmp_glyphs[0x20ac] == glyphs[2], "Unexpected glyph index %u.\n", bmp_glyphs[0x20ac]);
+    heap_free(bmp_codepoints);
+    heap_free(bmp_glyphs);
+
+    IDWriteFontFace_GetMetrics(fontface, &metrics);
+    hr = IDWriteFontFace_QueryInterface(fontface, &IID_IDWriteFontFace1, (void **)&fontface1);
+    if (hr == S_OK)
+    {
+        IDWriteFontFace1_GetCaretMetrics(fontface1, &caret);
+        IDWriteFontFace1_Release(fontface1);
+    }
+    ref = IDWriteFontFace_Release(fontface);
+    ok(ref == 0, "Unexpected refcount %u.\n", ref);
+
+    /* New face instance for the same font. */
+    hr = IDWriteFont_CreateFontFace(font, &fontface);
+    ok(hr == S_OK, "Failed to create fontface, hr %#x.\n", hr);
+
+    IDWriteFontFace_GetMetrics(fontface, &metrics2);
+    ok(!memcmp(&metrics, &metrics2, sizeof(metrics)), "Unexpected font metrics.\n");
+    hr = IDWriteFontFace_QueryInterface(fontface, &IID_IDWriteFontFace1, (void **)&fontface1);
+    if (hr == S_OK)
+    {
+        IDWriteFontFace1_GetCaretMetrics(fontface1, &caret2);
+        ok(!memcmp(&caret, &caret2, sizeof(caret)), "Unexpected caret metrics.\n");
+        IDWriteFontFace1_Release(fontface1);
+    }
+
+    for (i = 0; i < ARRAY_SIZE(codepoints); i++)
+    {
+        glyph = 0xcccc;
+        hr = IDWriteFontFace_GetGlyphIndices(fontface, &codepoints[i], 1, &glyph);
+        ok(hr == S_OK, "Failed to get glyph index, hr %#x.\n", hr);
+        ok(glyph == glyphs[i], "%u: unexpected glyph index %u, expected %u.\n", i, glyph, glyphs[i]);
+    }
+
+    IDWriteFontFace_Release(fontface);
+    IDWriteFont_Release(font);
+    ref = IDWriteFactory_Release(factory);
+    ok(ref == 0, "factory not released, %u\n", ref);
+}
+
 START_TEST(font)
 {
     IDWriteFactory *factory;
@@ -9240,6 +9327,7 @@ START_TEST(font)
     test_localfontfileloader();
     test_AnalyzeContainerType();
     test_fontsetbuilder();
+    test_GetGlyphIndices();
 
     IDWriteFactory_Release(factory);
 }
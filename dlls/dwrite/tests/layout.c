@@ -5734,6 +5734,90 @@ todo_wine {
     IDWriteFactory_Release(factory);
 }
 
+static void test_layout_reuse(void)
+{
+    static const WCHAR strW[] = {'a','b','c',' ','d','e','f',' ','a','b','c'};
+    DWRITE_CLUSTER_METRICS clusters[ARRAY_SIZE(strW)], clusters2[ARRAY_SIZE(strW)];
+    DWRITE_TEXT_METRICS metrics, metrics2;
+    IDWriteTextLayout *layout, *layout2;
+    IDWriteTextFormat *format;
+    IDWriteFactory *factory;
+    DWRITE_TEXT_RANGE range;
+    UINT32 count;
+    HRESULT hr;
+
+    factory = create_factory();
+
+    hr = IDWriteFactory_CreateTextFormat(factory, tahomaW, NULL, DWRITE_FONT_WEIGHT_NORMAL,
+            DWRITE_FONT_STYLE_NORMAL, DWRITE_FONT_STRETCH_NORMAL, 10.0f, enusW, &format);
+    ok(hr == S_OK, "Failed to create text format, hr %#x.\n", hr);
+
+    hr = IDWriteFactory_CreateTextLayout(factory, strW, ARRAY_SIZE(strW), format, 1000.0f, 1000.0f, &layout);
+    ok(hr == S_OK, "Failed to create text layout, hr %#x.\n", hr);
+
+    hr = IDWriteTextLayout_GetClusterMetrics(layout, clusters, ARRAY_SIZE(clusters), &count);
+    ok(hr == S_OK, "Failed to get cluster metrics, hr %#x.\n", hr);
+    ok(count == ARRAY_SIZE(strW), "Unexpected cluster count %u.\n", count);
+
+    hr = IDWriteTextLayout_GetMetrics(layout, &metrics);
+    ok(hr == S_OK, "Failed to get layout metrics, hr %#x.\n", hr);
+
+    /* Formatting that does not affect glyphs keeps cluster and text metrics. */
+    range.startPosition = 2;
+    range.length = 5;
+    hr = IDWriteTextLayout_SetUnderline(layout, TRUE, range);
+    ok(hr == S_OK, "Failed to set underline, hr %#x.\n", hr);
+    hr = IDWriteTextLayout_SetStrikethrough(layout, TRUE, range);
+    ok(hr == S_OK, "Failed to set strikethrough, hr %#x.\n", hr);
+    hr = IDWriteTextLayout_SetDrawingEffect(layout, (IUnknown *)factory, range);
+    ok(hr == S_OK, "Failed to set drawing effect, hr %#x.\n", hr);
+
+    hr = IDWriteTextLayout_GetClusterMetrics(layout, clusters2, ARRAY_SIZE(clusters2), &count);
+    ok(hr == S_OK, "Failed to get cluster metrics, hr %#x.\n", hr);
+    ok(count == ARRAY_SIZE(strW), "Unexpected cluster count %u.\n", count);
+    ok(!memcmp(clusters, clusters2, sizeof(clusters)), "Unexpected cluster metrics.\n");
+
+    hr = IDWriteTextLayout_GetMetrics(layout, &metrics2);
+    ok(hr == S_OK, "Failed to get layout metrics, hr %#x.\n", hr);
+    ok(metrics2.width == metrics.width && metrics2.height == metrics.height, "Unexpected layout metrics.\n");
+
+    /* Narrower layout wraps without changing clusters. */
+    hr = IDWriteTextLayout_SetMaxWidth(layout, clusters[0].width + clusters[1].width + clusters[2].width + 1.0f);
+    ok(hr == S_OK, "Failed to set max width, hr %#x.\n", hr);
+    hr = IDWriteTextLayout_GetMetrics(layout, &metrics2);
+    ok(hr == S_OK, "Failed to get layout metrics, hr %#x.\n", hr);
+    ok(metrics2.lineCount == 3, "Unexpected line count %u.\n", metrics2.lineCount);
+
+    hr = IDWriteTextLayout_GetClusterMetrics(layout, clusters2, ARRAY_SIZE(clusters2), &count);
+    ok(hr == S_OK, "Failed to get cluster metrics, hr %#x.\n", hr);
+    ok(!memcmp(clusters, clusters2, sizeof(clusters)), "Unexpected cluster metrics.\n");
+
+    /* Identical layouts produce identical results. */
+    hr = IDWriteFactory_CreateTextLayout(factory, strW, ARRAY_SIZE(strW), format, 1000.0f, 1000.0f, &layout2);
+    ok(hr == S_OK, "Failed to create text layout, hr %#x.\n", hr);
+
+    hr = IDWriteTextLayout_GetClusterMetrics(layout2, clusters2, ARRAY_SIZE(clusters2), &count);
+    ok(hr == S_OK, "Failed to get cluster metrics, hr %#x.\n", hr);
+    ok(!memcmp(clusters, clusters2, sizeof(clusters)), "Unexpected cluster metrics.\n");
+
+    IDWriteTextLayout_Release(layout2);
+
+    /* Font size is a part of shaping results. */
+    range.startPosition = 0;
+    range.length = ~0u;
+    hr = IDWriteTextLayout_SetFontSize(layout, 20.0f, range);
+    ok(hr == S_OK, "Failed to set font size, hr %#x.\n", hr);
+
+    hr = IDWriteTextLayout_GetClusterMetrics(layout, clusters2, ARRAY_SIZE(clusters2), &count);
+    ok(hr == S_OK, "Failed to get cluster metrics, hr %#x.\n", hr);
+    ok(clusters2[0].width > clusters[0].width, "Unexpected cluster width %f, %f.\n", clusters2[0].width,
+            clusters[0].width);
+
+    IDWriteTextLayout_Release(layout);
+    IDWriteTextFormat_Release(format);
+    IDWriteFactory_Release(factory);
+}
+
 START_TEST(layout)
 {
     IDWriteFactory *factory;
@@ -5785,6 +5869,7 @@ START_TEST(layout)
     test_line_spacing();
     test_GetOverhangMetrics();
     test_tab_stops();
+    test_layout_reuse();
 
     IDWriteFactory_Release(factory);
 }
@@ -19,6 +19,9 @@
  */
 
 #include <assert.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "gdi_private.h"
 #include "dibdrv.h"
@@ -264,10 +267,22 @@ static inline void memset_16( WORD *start, WORD val, DWORD size )
 #endif
 }
 
+static inline void do_rop_row_32( DWORD *ptr, DWORD and, DWORD xor, int len )
+{
+#ifdef __SSE2__
+    const __m128i and_mask = _mm_set1_epi32( and ), xor_mask = _mm_set1_epi32( xor );
+
+    for ( ; len >= 4; len -= 4, ptr += 4)
+        _mm_storeu_si128( (__m128i *)ptr, _mm_xor_si128( _mm_and_si128( _mm_loadu_si128( (__m128i *)ptr ),
+                                                                        and_mask ), xor_mask ));
+#endif
+    while (len--) do_rop_32( ptr++, and, xor );
+}
+
 static void solid_rects_32(const dib_info *dib, int num, const RECT *rc, DWORD and, DWORD xor)
 {
-    DWORD *ptr, *start;
-    int x, y, i;
+    DWORD *start;
+    int y, i;
 
     for(i = 0; i < num; i++, rc++)
     {
@@ -276,8 +291,7 @@ static void solid_rects_32(const dib_info *dib, int num, const RECT *rc, DWORD a
         start = get_pixel_ptr_32(dib, rc->left, rc->top);
         if (and)
             for(y = rc->top; y < rc->bottom; y++, start += dib->stride / 4)
-                for(x = rc->left, ptr = start; x < rc->right; x++)
-                    do_rop_32(ptr++, and, xor);
+                do_rop_row_32( start, and, xor, rc->right - rc->left );
         else
             for(y = rc->top; y < rc->bottom; y++, start += dib->stride / 4)
                 memset_32( start, xor, rc->right - rc->left );
@@ -4651,6 +4665,135 @@ static inline DWORD blend_rgb( BYTE dst_r, BYTE dst_g, BYTE dst_b, DWORD src, BL
             blend_color( dst_r, src >> 16, blend.SourceConstantAlpha ) << 16);
 }
 
+#ifdef __SSE2__
+
+/* exact (val + 127) / 255 on each 16-bit lane, for val <= 255 * 255 */
+static inline __m128i div255_epu16( __m128i val )
+{
+    val = _mm_add_epi16( val, _mm_set1_epi16( 127 ));
+    return _mm_srli_epi16( _mm_add_epi16( _mm_add_epi16( val, _mm_set1_epi16( 1 )),
+                                          _mm_srli_epi16( val, 8 )), 8 );
+}
+
+/* broadcast the alpha of each of the two unpacked pixels to all its channels */
+static inline __m128i alpha_epu16( __m128i val )
+{
+    val = _mm_shufflelo_epi16( val, _MM_SHUFFLE( 3, 3, 3, 3 ));
+    return _mm_shufflehi_epi16( val, _MM_SHUFFLE( 3, 3, 3, 3 ));
+}
+
+/* a channel of a source that isn't properly premultiplied can exceed 255, in which
+ * case the scalar code lets it spill into the next channel; let it handle those */
+static inline BOOL blend_overflow( __m128i lo, __m128i hi )
+{
+    const __m128i max = _mm_set1_epi16( 255 );
+    return _mm_movemask_epi8( _mm_or_si128( _mm_cmpgt_epi16( lo, max ), _mm_cmpgt_epi16( hi, max )));
+}
+
+static void blend_argb_row_sse2( DWORD *dst, const DWORD *src, int len )
+{
+    const __m128i zero = _mm_setzero_si128(), max = _mm_set1_epi16( 255 );
+    const __m128i alpha_mask = _mm_set1_epi32( 0xff000000 );
+    __m128i s, d, s_lo, s_hi, d_lo, d_hi;
+    int x, i;
+
+    for (x = 0; x + 4 <= len; x += 4)
+    {
+        s = _mm_loadu_si128( (const __m128i *)(src + x) );
+        if (_mm_movemask_epi8( _mm_cmpeq_epi32( s, zero )) == 0xffff) continue;
+        if (_mm_movemask_epi8( _mm_cmpeq_epi32( _mm_and_si128( s, alpha_mask ), alpha_mask )) == 0xffff)
+        {
+            _mm_storeu_si128( (__m128i *)(dst + x), s );
+            continue;
+        }
+        d = _mm_loadu_si128( (const __m128i *)(dst + x) );
+        s_lo = _mm_unpacklo_epi8( s, zero );
+        s_hi = _mm_unpackhi_epi8( s, zero );
+        d_lo = _mm_unpacklo_epi8( d, zero );
+        d_hi = _mm_unpackhi_epi8( d, zero );
+        d_lo = _mm_add_epi16( s_lo, div255_epu16( _mm_mullo_epi16( d_lo, _mm_sub_epi16( max, alpha_epu16( s_lo )))));
+        d_hi = _mm_add_epi16( s_hi, div255_epu16( _mm_mullo_epi16( d_hi, _mm_sub_epi16( max, alpha_epu16( s_hi )))));
+        if (blend_overflow( d_lo, d_hi ))
+        {
+            for (i = x; i < x + 4; i++) dst[i] = blend_argb( dst[i], src[i] );
+            continue;
+        }
+        _mm_storeu_si128( (__m128i *)(dst + x), _mm_packus_epi16( d_lo, d_hi ));
+    }
+    for ( ; x < len; x++) dst[x] = blend_argb( dst[x], src[x] );
+}
+
+static void blend_argb_alpha_row_sse2( DWORD *dst, const DWORD *src, int len, DWORD alpha )
+{
+    const __m128i zero = _mm_setzero_si128(), max = _mm_set1_epi16( 255 );
+    const __m128i const_alpha = _mm_set1_epi16( alpha );
+    __m128i s, d, s_lo, s_hi, d_lo, d_hi;
+    int x, i;
+
+    for (x = 0; x + 4 <= len; x += 4)
+    {
+        s = _mm_loadu_si128( (const __m128i *)(src + x) );
+        d = _mm_loadu_si128( (const __m128i *)(dst + x) );
+        s_lo = div255_epu16( _mm_mullo_epi16( _mm_unpacklo_epi8( s, zero ), const_alpha ));
+        s_hi = div255_epu16( _mm_mullo_epi16( _mm_unpackhi_epi8( s, zero ), const_alpha ));
+        d_lo = _mm_unpacklo_epi8( d, zero );
+        d_hi = _mm_unpackhi_epi8( d, zero );
+        d_lo = _mm_add_epi16( s_lo, div255_epu16( _mm_mullo_epi16( d_lo, _mm_sub_epi16( max, alpha_epu16( s_lo )))));
+        d_hi = _mm_add_epi16( s_hi, div255_epu16( _mm_mullo_epi16( d_hi, _mm_sub_epi16( max, alpha_epu16( s_hi )))));
+        if (blend_overflow( d_lo, d_hi ))
+        {
+            for (i = x; i < x + 4; i++) dst[i] = blend_argb_alpha( dst[i], src[i], alpha );
+            continue;
+        }
+        _mm_storeu_si128( (__m128i *)(dst + x), _mm_packus_epi16( d_lo, d_hi ));
+    }
+    for ( ; x < len; x++) dst[x] = blend_argb_alpha( dst[x], src[x], alpha );
+}
+
+static void blend_constant_alpha_row_sse2( DWORD *dst, const DWORD *src, int len, DWORD alpha, BOOL src_alpha )
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i src_or = _mm_set1_epi32( src_alpha ? 0 : 0xff000000 );
+    const __m128i src_mul = _mm_set1_epi16( alpha ), dst_mul = _mm_set1_epi16( 255 - alpha );
+    __m128i s, d, lo, hi;
+    int x;
+
+    for (x = 0; x + 4 <= len; x += 4)
+    {
+        s = _mm_or_si128( _mm_loadu_si128( (const __m128i *)(src + x) ), src_or );
+        d = _mm_loadu_si128( (const __m128i *)(dst + x) );
+        lo = _mm_add_epi16( _mm_mullo_epi16( _mm_unpacklo_epi8( s, zero ), src_mul ),
+                            _mm_mullo_epi16( _mm_unpacklo_epi8( d, zero ), dst_mul ));
+        hi = _mm_add_epi16( _mm_mullo_epi16( _mm_unpackhi_epi8( s, zero ), src_mul ),
+                            _mm_mullo_epi16( _mm_unpackhi_epi8( d, zero ), dst_mul ));
+        _mm_storeu_si128( (__m128i *)(dst + x), _mm_packus_epi16( div255_epu16( lo ), div255_epu16( hi )));
+    }
+    for ( ; x < len; x++)
+        dst[x] = src_alpha ? blend_argb_constant_alpha( dst[x], src[x], alpha )
+                           : blend_argb_no_src_alpha( dst[x], src[x], alpha );
+}
+
+static void blend_rect_8888_sse2(const dib_info *dst, const RECT *rc,
+                                 const dib_info *src, const POINT *origin, BLENDFUNCTION blend)
+{
+    DWORD *src_ptr = get_pixel_ptr_32( src, origin->x, origin->y );
+    DWORD *dst_ptr = get_pixel_ptr_32( dst, rc->left, rc->top );
+    int y, len = rc->right - rc->left;
+
+    for (y = rc->top; y < rc->bottom; y++, dst_ptr += dst->stride / 4, src_ptr += src->stride / 4)
+    {
+        if (!(blend.AlphaFormat & AC_SRC_ALPHA))
+            blend_constant_alpha_row_sse2( dst_ptr, src_ptr, len, blend.SourceConstantAlpha,
+                                           src->compression == BI_RGB );
+        else if (blend.SourceConstantAlpha == 255)
+            blend_argb_row_sse2( dst_ptr, src_ptr, len );
+        else
+            blend_argb_alpha_row_sse2( dst_ptr, src_ptr, len, blend.SourceConstantAlpha );
+    }
+}
+
+#endif  /* __SSE2__ */
+
 static void blend_rect_8888(const dib_info *dst, const RECT *rc,
                             const dib_info *src, const POINT *origin, BLENDFUNCTION blend)
 {
@@ -4658,6 +4801,14 @@ static void blend_rect_8888(const dib_info *dst, const RECT *rc,
     DWORD *dst_ptr = get_pixel_ptr_32( dst, rc->left, rc->top );
     int x, y;
 
+#ifdef __SSE2__
+    if (rc->right - rc->left >= 4)
+    {
+        blend_rect_8888_sse2( dst, rc, src, origin, blend );
+        return;
+    }
+#endif
+
     if (blend.AlphaFormat & AC_SRC_ALPHA)
     {
 	if (blend.SourceConstantAlpha == 255)
@@ -275,9 +275,12 @@ typedef struct tagFace {
     WCHAR *file;
     dev_t dev;
     ino_t ino;
+    time_t mtime;         /* file stamp, for reusing font database entries */
+    off_t file_size;
     void *font_data_ptr;
     DWORD font_data_size;
     FT_Long face_index;
+    FT_Long num_faces;    /* number of faces in the file */
     FONTSIGNATURE fs;
     DWORD ntmFlags;
     FT_Fixed font_version;
@@ -285,6 +288,7 @@ typedef struct tagFace {
     Bitmap_Size size;     /* set if face is a bitmap */
     DWORD flags;          /* ADDFONT flags */
     struct tagFamily *family;
+    UINT db_index;        /* index in the font database, or ~0u */
     /* Cached data for Enum */
     struct enum_data *cached_enum_data;
 } Face;
@@ -303,6 +307,7 @@ typedef struct tagFamily {
     WCHAR *EnglishName;
     struct list faces;
     struct list *replacement;
+    UINT db_index;        /* index in the font database, or ~0u */
 } Family;
 
 typedef struct {
@@ -409,6 +414,7 @@ struct tagGdiFont {
     DWORD total_kern_pairs;
     KERNINGPAIR *kern_pairs;
     struct list child_fonts;
+    struct list glyph_cache;   /* rendered glyphs requested through this font */
 
     /* the following members can be accessed without locking, they are never modified after creation */
     FT_Face ft_face;
@@ -598,6 +604,88 @@ static const WCHAR face_internal_leading_value[] = {'I','n','t','e','r','n','a',
 static const WCHAR face_font_sig_value[] = {'F','o','n','t',' ','S','i','g','n','a','t','u','r','e',0};
 static const WCHAR face_file_name_value[] = {'F','i','l','e',' ','N','a','m','e','\0'};
 static const WCHAR face_full_name_value[] = {'F','u','l','l',' ','N','a','m','e','\0'};
+static const WCHAR font_db_serial_value[] = {'D','a','t','a','b','a','s','e',' ','S','e','r','i','a','l',0};
+
+/* Font database: a binary snapshot of the cached part of the font list, kept
+ * in the prefix and mapped read-only by every process of the session. */
+
+#define FONT_DB_MAGIC     0x62646677  /* "wfdb" */
+#define FONT_DB_VERSION   1
+
+struct font_db_header
+{
+    UINT magic;
+    UINT version;
+    UINT size;           /* total file size */
+    UINT serial;         /* matches the value stored in the volatile cache key */
+    LCID lcid;           /* locale used for the localized names */
+    UINT hash_size;      /* number of buckets of the hash tables, power of 2 */
+    UINT family_count;
+    UINT face_count;
+    UINT families;       /* offsets from the start of the file */
+    UINT faces;
+    UINT family_hash;    /* family index + 1, by name */
+    UINT file_hash;      /* face index + 1, by file name without directory */
+    UINT strings;        /* NUL-terminated WCHAR strings, up to the end of the file */
+    UINT reserved;
+};
+
+struct font_db_family
+{
+    UINT name;           /* string offsets, 0 if not present */
+    UINT english_name;
+    UINT first_face;
+    UINT face_count;
+    UINT hash_next;      /* next family index + 1 in the same bucket */
+};
+
+struct font_db_face
+{
+    ULONGLONG     dev;
+    ULONGLONG     ino;
+    LONGLONG      mtime;
+    LONGLONG      file_size;
+    UINT          file;
+    UINT          style_name;
+    UINT          full_name;
+    UINT          family;
+    UINT          hash_next; /* next face index + 1 in the same bucket */
+    UINT          flags;
+    UINT          ntm_flags;
+    INT           face_index;
+    INT           num_faces;
+    INT           font_version;
+    UINT          scalable;
+    FONTSIGNATURE fs;
+    INT           size;
+    INT           x_ppem;
+    INT           y_ppem;
+    SHORT         height;
+    SHORT         width;
+    SHORT         internal_leading;
+    SHORT         pad;
+};
+
+C_ASSERT( sizeof(struct font_db_header) == 56 );
+C_ASSERT( sizeof(struct font_db_face) == 120 );
+
+struct font_db
+{
+    const struct font_db_header *header;
+    size_t                       size;
+    const struct font_db_family *families;
+    const struct font_db_face   *faces;
+    const UINT                  *family_hash;
+    const UINT                  *file_hash;
+};
+
+static struct font_db font_db;      /* database the font list was loaded from */
+static struct font_db old_font_db;  /* previous database, while rebuilding the list */
+static Family **db_families;        /* live families and faces by database index */
+static Face **db_faces;
+static UINT extra_families;         /* families that aren't in the database */
+static BOOL font_db_building;       /* set while the first process of the session scans the fonts */
+static BOOL font_db_dirty;          /* a font had to be loaded from scratch while scanning */
 
 
 struct font_mapping
@@ -635,6 +723,7 @@ static BOOL get_outline_text_metrics(GdiFont *font);
 static BOOL get_bitmap_text_metrics(GdiFont *font);
 static BOOL get_text_metrics(GdiFont *font, LPTEXTMETRICW ptm);
 static void remove_face_from_cache( Face *face );
+static Family *get_family_from_names( WCHAR *name, WCHAR *english_name );
 
 static const WCHAR system_link[] = {'S','o','f','t','w','a','r','e','\\','M','i','c','r','o','s','o','f','t','\\',
                                     'W','i','n','d','o','w','s',' ','N','T','\\',
@@ -1038,6 +1127,58 @@ static const struct list *get_face_list_from_family(const Family *family)
         return family->replacement;
 }
 
+static inline const WCHAR *font_db_string( const struct font_db *db, UINT offset )
+{
+    return offset ? (const WCHAR *)((const char *)db->header + offset) : NULL;
+}
+
+static UINT font_db_hash( const WCHAR *str, UINT len )
+{
+    UINT hash = 0;
+
+    while (len-- && *str) hash = hash * 33 + tolowerW( *str++ );
+    return hash;
+}
+
+static const WCHAR *get_file_name( const WCHAR *path )
+{
+    const WCHAR *file = strrchrW( path, '/' );
+    return file ? file + 1 : path;
+}
+
+static Family *find_font_db_family( const WCHAR *name )
+{
+    UINT i = font_db.family_hash[font_db_hash( name, LF_FACESIZE - 1 ) & (font_db.header->hash_size - 1)];
+
+    /* chains are stored in increasing index order, which also stops a corrupted one from looping */
+    while (i && i <= font_db.header->family_count)
+    {
+        Family *family = db_families[i - 1];
+
+        if (family && !strncmpiW( family->FamilyName, name, LF_FACESIZE - 1 )) return family;
+        if (font_db.families[i - 1].hash_next <= i) break;
+        i = font_db.families[i - 1].hash_next;
+    }
+    return NULL;
+}
+
+static Face *find_font_db_face( const WCHAR *file_name, const WCHAR *face_name )
+{
+    UINT i = font_db.file_hash[font_db_hash( file_name, ~0u ) & (font_db.header->hash_size - 1)];
+
+    while (i && i <= font_db.header->face_count)
+    {
+        Face *face = db_faces[i - 1];
+
+        if (face && face->family && !strcmpiW( get_file_name( face->file ), file_name ) &&
+            (!face_name || !strncmpiW( face_name, face->family->FamilyName, LF_FACESIZE - 1 )))
+            return face;
+        if (font_db.faces[i - 1].hash_next <= i) break;
+        i = font_db.faces[i - 1].hash_next;
+    }
+    return NULL;
+}
+
 static Face *find_face_from_filename(const WCHAR *file_name, const WCHAR *face_name)
 {
     Family *family;
@@ -1046,6 +1187,12 @@ static Face *find_face_from_filename(const WCHAR *file_name, const WCHAR *face_n
 
     TRACE("looking for file %s name %s\n", debugstr_w(file_name), debugstr_w(face_name));
 
+    if (font_db.header && (face = find_font_db_face( file_name, face_name )))
+    {
+        face->refcount++;
+        return face;
+    }
+
     LIST_FOR_EACH_ENTRY(family, &font_list, Family, entry)
     {
         const struct list *face_list;
@@ -1073,6 +1220,12 @@ static Family *find_family_from_name(const WCHAR *name)
 {
     Family *family;
 
+    if (font_db.header)
+    {
+        if ((family = find_font_db_family( name ))) return family;
+        if (!extra_families) return NULL;
+    }
+
     LIST_FOR_EACH_ENTRY(family, &font_list, Family, entry)
     {
         if(!strncmpiW(family->FamilyName, name, LF_FACESIZE -1))
@@ -1499,13 +1652,24 @@ static inline BOOL faces_equal( const Face *f1, const Face *f2 )
     return !memcmp( &f1->fs, &f2->fs, sizeof(f1->fs) );
 }
 
+/* strings loaded from the font database point directly into its mapping */
+static void free_font_string( WCHAR *str )
+{
+    const char *ptr = (const char *)str, *base = (const char *)font_db.header;
+
+    if (base && ptr >= base && ptr < base + font_db.size) return;
+    HeapFree( GetProcessHeap(), 0, str );
+}
+
 static void release_family( Family *family )
 {
     if (--family->refcount) return;
     assert( list_empty( &family->faces ));
     list_remove( &family->entry );
-    HeapFree( GetProcessHeap(), 0, family->FamilyName );
-    HeapFree( GetProcessHeap(), 0, family->EnglishName );
+    if (family->db_index != ~0u) db_families[family->db_index] = NULL;
+    else extra_families--;
+    free_font_string( family->FamilyName );
+    free_font_string( family->EnglishName );
     HeapFree( GetProcessHeap(), 0, family );
 }
 
@@ -1518,9 +1682,10 @@ static void release_face( Face *face )
         list_remove( &face->entry );
         release_family( face->family );
     }
-    HeapFree( GetProcessHeap(), 0, face->file );
-    HeapFree( GetProcessHeap(), 0, face->StyleName );
-    HeapFree( GetProcessHeap(), 0, face->FullName );
+    if (face->db_index != ~0u) db_faces[face->db_index] = NULL;
+    free_font_string( face->file );
+    free_font_string( face->StyleName );
+    free_font_string( face->FullName );
     HeapFree( GetProcessHeap(), 0, face->cached_enum_data );
     HeapFree( GetProcessHeap(), 0, face );
 }
@@ -1608,6 +1773,8 @@ static Family *create_family( WCHAR *name, WCHAR *english_name )
     family->EnglishName = english_name;
     list_init( &family->faces );
     family->replacement = &family->faces;
+    family->db_index = ~0u;
+    extra_families++;
     list_add_tail( &font_list, &family->entry );
 
     return family;
@@ -1661,6 +1828,10 @@ static void load_face(HKEY hkey_face, WCHAR *face_name, Family *family, void *bu
         face = HeapAlloc(GetProcessHeap(), 0, sizeof(*face));
         face->cached_enum_data = NULL;
         face->family = NULL;
+        face->db_index = ~0u;
+        face->mtime = 0;
+        face->file_size = 0;
+        face->num_faces = 0;
 
         face->refcount = 1;
         face->file = strdupW( buffer );
@@ -1776,17 +1947,8 @@ static void load_font_list_from_cache(HKEY hkey_font_cache)
         if (!RegQueryValueExW(hkey_family, english_name_value, NULL, NULL, (BYTE *)buffer, &size))
             english_family = strdupW( buffer );
 
-        family = create_family(family_name, english_family);
-
-        if(english_family)
-        {
-            FontSubst *subst = HeapAlloc(GetProcessHeap(), 0, sizeof(*subst));
-            subst->from.name = strdupW(english_family);
-            subst->from.charset = -1;
-            subst->to.name = strdupW(family_name);
-            subst->to.charset = -1;
-            add_font_subst(&font_subst_list, subst, 0);
-        }
+        /* the family may already have been loaded from the font database */
+        family = get_family_from_names(family_name, english_family);
 
         size = sizeof(buffer);
         while (!RegEnumKeyExW(hkey_family, face_index++, buffer, &size, NULL, NULL, NULL, NULL))
@@ -1884,7 +2046,8 @@ static void remove_face_from_cache( Face *face )
 {
     HKEY hkey_family;
 
-    RegOpenKeyExW( hkey_font_cache, face->family->FamilyName, 0, KEY_ALL_ACCESS, &hkey_family );
+    if (RegOpenKeyExW( hkey_font_cache, face->family->FamilyName, 0, KEY_ALL_ACCESS, &hkey_family ))
+        return;
 
     if (face->scalable)
     {
@@ -1939,27 +2102,25 @@ static void get_family_names( FT_Face ft_face, WCHAR **name, WCHAR **english, BO
     }
 }
 
-static Family *get_family( FT_Face ft_face, BOOL vertical )
+static void add_english_name_subst( const WCHAR *english_name, const WCHAR *name )
 {
-    Family *family;
-    WCHAR *name, *english_name;
-
-    get_family_names( ft_face, &name, &english_name, vertical );
+    FontSubst *subst = HeapAlloc( GetProcessHeap(), 0, sizeof(*subst) );
+    subst->from.name = strdupW( english_name );
+    subst->from.charset = -1;
+    subst->to.name = strdupW( name );
+    subst->to.charset = -1;
+    add_font_subst( &font_subst_list, subst, 0 );
+}
 
-    family = find_family_from_name( name );
+/* takes ownership of the names */
+static Family *get_family_from_names( WCHAR *name, WCHAR *english_name )
+{
+    Family *family = find_family_from_name( name );
 
     if (!family)
     {
         family = create_family( name, english_name );
-        if (english_name)
-        {
-            FontSubst *subst = HeapAlloc( GetProcessHeap(), 0, sizeof(*subst) );
-            subst->from.name = strdupW( english_name );
-            subst->from.charset = -1;
-            subst->to.name = strdupW( name );
-            subst->to.charset = -1;
-            add_font_subst( &font_subst_list, subst, 0 );
-        }
+        if (english_name) add_english_name_subst( english_name, name );
     }
     else
     {
@@ -1971,6 +2132,14 @@ static Family *get_family( FT_Face ft_face, BOOL vertical )
     return family;
 }
 
+static Family *get_family( FT_Face ft_face, BOOL vertical )
+{
+    WCHAR *name, *english_name;
+
+    get_family_names( ft_face, &name, &english_name, vertical );
+    return get_family_from_names( name, english_name );
+}
+
 static inline FT_Fixed get_font_version( FT_Face ft_face )
 {
     FT_Fixed version = 0;
@@ -2107,6 +2276,8 @@ static Face *create_face( FT_Face ft_face, FT_Long face_index, const char *file,
 
     face->dev = 0;
     face->ino = 0;
+    face->mtime = 0;
+    face->file_size = 0;
     if (file)
     {
         face->file = towstr( CP_UNIXCP, file );
@@ -2116,6 +2287,8 @@ static Face *create_face( FT_Face ft_face, FT_Long face_index, const char *file,
         {
             face->dev = st.st_dev;
             face->ino = st.st_ino;
+            face->mtime = st.st_mtime;
+            face->file_size = st.st_size;
         }
     }
     else
@@ -2126,6 +2299,7 @@ static Face *create_face( FT_Face ft_face, FT_Long face_index, const char *file,
     }
 
     face->face_index = face_index;
+    face->num_faces = ft_face->num_faces;
     get_fontsig( ft_face, &face->fs );
     face->ntmFlags = get_ntm_flags( ft_face );
     face->font_version = get_font_version( ft_face );
@@ -2144,6 +2318,7 @@ static Face *create_face( FT_Face ft_face, FT_Long face_index, const char *file,
     if (!HIWORD( flags )) flags |= ADDFONT_AA_FLAGS( default_aa_flags );
     face->flags  = flags;
     face->family = NULL;
+    face->db_index = ~0u;
     face->cached_enum_data = NULL;
 
     TRACE("fsCsb = %08x %08x/%08x %08x %08x %08x\n",
@@ -2165,7 +2340,8 @@ static void AddFaceToList(FT_Face ft_face, const char *file, void *font_data_ptr
 
     if (insert_face_in_family_list( face, family ))
     {
-        if (flags & ADDFONT_ADD_TO_CACHE)
+        /* while scanning, cached faces are saved to the font database at the end */
+        if ((flags & ADDFONT_ADD_TO_CACHE) && !font_db_building)
             add_face_to_cache( face );
 
         TRACE("Added font %s %s\n", debugstr_w(family->FamilyName),
@@ -2175,6 +2351,527 @@ static void AddFaceToList(FT_Face ft_face, const char *file, void *font_data_ptr
     release_family( family );
 }
 
+static const DWORD FS_DBCS_MASK = FS_JISJAPAN|FS_CHINESESIMP|FS_WANSUNG|FS_CHINESETRAD|FS_JOHAB;
+
+static char *get_font_db_path( const char *suffix )
+{
+    static const char db_name[] = "/fontdb";
+    const char *dir = wine_get_config_dir();
+    char *path;
+
+    if (!dir) return NULL;
+    if (!(path = HeapAlloc( GetProcessHeap(), 0, strlen(dir) + sizeof(db_name) + strlen(suffix) )))
+        return NULL;
+    strcpy( path, dir );
+    strcat( path, db_name );
+    strcat( path, suffix );
+    return path;
+}
+
+static BOOL check_font_db_table( const struct font_db_header *header, UINT offset, UINT count, UINT size )
+{
+    return !(offset % 8) && offset >= sizeof(*header) && offset <= header->strings &&
+           count <= (header->strings - offset) / size;
+}
+
+static BOOL check_font_db_string( const struct font_db_header *header, UINT offset, BOOL optional )
+{
+    if (!offset) return optional;
+    return !(offset % sizeof(WCHAR)) && offset >= header->strings && offset < header->size;
+}
+
+static BOOL check_font_db( const struct font_db_header *header, size_t size )
+{
+    const struct font_db_family *families = (const struct font_db_family *)((const char *)header + header->families);
+    const struct font_db_face *faces = (const struct font_db_face *)((const char *)header + header->faces);
+    UINT i;
+
+    if (header->magic != FONT_DB_MAGIC || header->version != FONT_DB_VERSION) return FALSE;
+    if (header->size != size || header->strings > size - sizeof(WCHAR) || header->strings % sizeof(WCHAR))
+        return FALSE;
+    /* the string table is terminated by the end of the file */
+    if (*(const WCHAR *)((const char *)header + size - sizeof(WCHAR))) return FALSE;
+    if (!header->hash_size || (header->hash_size & (header->hash_size - 1))) return FALSE;
+    if (!check_font_db_table( header, header->families, header->family_count, sizeof(*families) ) ||
+        !check_font_db_table( header, header->faces, header->face_count, sizeof(*faces) ) ||
+        !check_font_db_table( header, header->family_hash, header->hash_size, sizeof(UINT) ) ||
+        !check_font_db_table( header, header->file_hash, header->hash_size, sizeof(UINT) ))
+        return FALSE;
+
+    for (i = 0; i < header->family_count; i++)
+    {
+        if (!check_font_db_string( header, families[i].name, FALSE ) ||
+            !check_font_db_string( header, families[i].english_name, TRUE ) ||
+            families[i].first_face > header->face_count ||
+            families[i].face_count > header->face_count - families[i].first_face)
+            return FALSE;
+    }
+    for (i = 0; i < header->face_count; i++)
+    {
+        if (!check_font_db_string( header, faces[i].file, FALSE ) ||
+            !check_font_db_string( header, faces[i].style_name, FALSE ) ||
+            !check_font_db_string( header, faces[i].full_name, TRUE ) ||
+            faces[i].family >= header->family_count)
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/* map the font database; if serial is non-zero it has to match */
+static BOOL map_font_db( struct font_db *db, UINT serial )
+{
+    const struct font_db_header *header;
+    struct stat st;
+    char *path;
+    void *ptr;
+    int fd;
+
+    if (!(path = get_font_db_path( "" ))) return FALSE;
+    fd = open( path, O_RDONLY );
+    HeapFree( GetProcessHeap(), 0, path );
+    if (fd == -1) return FALSE;
+
+    if (fstat( fd, &st ) == -1 || st.st_size < sizeof(*header) || st.st_size > 0x7fffffff)
+    {
+        close( fd );
+        return FALSE;
+    }
+    ptr = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );
+    if (ptr == MAP_FAILED) return FALSE;
+
+    header = ptr;
+    if (!check_font_db( header, st.st_size ) || (serial && header->serial != serial))
+    {
+        WARN( "ignoring stale or invalid font database\n" );
+        munmap( ptr, st.st_size );
+        return FALSE;
+    }
+
+    db->header      = header;
+    db->size        = st.st_size;
+    db->families    = (const struct font_db_family *)((const char *)ptr + header->families);
+    db->faces       = (const struct font_db_face *)((const char *)ptr + header->faces);
+    db->family_hash = (const UINT *)((const char *)ptr + header->family_hash);
+    db->file_hash   = (const UINT *)((const char *)ptr + header->file_hash);
+    TRACE( "mapped font database serial %08x with %u families %u faces\n",
+           header->serial, header->family_count, header->face_count );
+    return TRUE;
+}
+
+static void unmap_font_db( struct font_db *db )
+{
+    munmap( (void *)db->header, db->size );
+    memset( db, 0, sizeof(*db) );
+}
+
+static WCHAR *get_font_db_string( const struct font_db *db, UINT offset, BOOL copy )
+{
+    const WCHAR *str = font_db_string( db, offset );
+
+    if (!str || !copy) return (WCHAR *)str;
+    return strdupW( str );
+}
+
+static Face *create_face_from_db( const struct font_db *db, const struct font_db_face *rec, BOOL copy )
+{
+    Face *face = HeapAlloc( GetProcessHeap(), 0, sizeof(*face) );
+
+    face->refcount         = 1;
+    face->StyleName        = get_font_db_string( db, rec->style_name, copy );
+    face->FullName         = get_font_db_string( db, rec->full_name, copy );
+    face->file             = get_font_db_string( db, rec->file, copy );
+    face->dev              = rec->dev;
+    face->ino              = rec->ino;
+    face->mtime            = rec->mtime;
+    face->file_size        = rec->file_size;
+    face->font_data_ptr    = NULL;
+    face->font_data_size   = 0;
+    face->face_index       = rec->face_index;
+    face->num_faces        = rec->num_faces;
+    face->fs               = rec->fs;
+    face->ntmFlags         = rec->ntm_flags;
+    face->font_version     = rec->font_version;
+    face->scalable         = rec->scalable;
+    face->size.height      = rec->height;
+    face->size.width       = rec->width;
+    face->size.size        = rec->size;
+    face->size.x_ppem      = rec->x_ppem;
+    face->size.y_ppem      = rec->y_ppem;
+    face->size.internal_leading = rec->internal_leading;
+    face->flags            = rec->flags;
+    face->family           = NULL;
+    face->db_index         = ~0u;
+    face->cached_enum_data = NULL;
+    return face;
+}
+
+/*************************************************************
+ *    add_font_from_db
+ *
+ * Add the faces of an unmodified font file from the previous font
+ * database instead of loading it through FreeType again. All the faces
+ * the file provided last time need to be present, otherwise the file
+ * is loaded from scratch.
+ */
+static INT add_font_from_db( const char *file, DWORD flags )
+{
+    const struct font_db *db = &old_font_db;
+    const struct font_db_face *rec, **slots = NULL;
+    struct stat st;
+    WCHAR *fileW;
+    UINT i, bucket;
+    INT num_faces = 0, ret = 0;
+
+    if (!db->header || !(flags & ADDFONT_ADD_TO_CACHE) || stat( file, &st )) return 0;
+    if (!HIWORD( flags )) flags |= ADDFONT_AA_FLAGS( default_aa_flags );
+    if (!(fileW = towstr( CP_UNIXCP, file ))) return 0;
+
+    bucket = font_db_hash( get_file_name( fileW ), ~0u ) & (db->header->hash_size - 1);
+    for (i = db->file_hash[bucket]; i && i <= db->header->face_count; i = rec->hash_next)
+    {
+        rec = &db->faces[i - 1];
+        if (rec->dev == st.st_dev && rec->ino == st.st_ino && rec->mtime == st.st_mtime &&
+            rec->file_size == st.st_size && (rec->flags & ~ADDFONT_VERTICAL_FONT) == flags &&
+            !strcmpW( font_db_string( db, rec->file ), fileW ) &&
+            rec->face_index >= 0 && rec->face_index < rec->num_faces && rec->num_faces <= 0x1000)
+        {
+            if (!slots)
+            {
+                num_faces = rec->num_faces;
+                if (!(slots = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, num_faces * 2 * sizeof(*slots) )))
+                    break;
+            }
+            if (rec->num_faces != num_faces) goto done;
+            slots[rec->face_index * 2 + !!(rec->flags & ADDFONT_VERTICAL_FONT)] = rec;
+        }
+        if (rec->hash_next <= i) break;
+    }
+    if (!slots) goto done;
+
+    for (i = 0; i < num_faces; i++)
+    {
+        if (!slots[2 * i]) goto done;
+        if (!(slots[2 * i]->fs.fsCsb[0] & FS_DBCS_MASK) != !slots[2 * i + 1]) goto done;
+    }
+
+    for (i = 0; i < 2 * num_faces; i++)
+    {
+        const struct font_db_family *db_family;
+        Family *family;
+        Face *face;
+
+        if (!(rec = slots[i])) continue;
+        db_family = &db->families[rec->family];
+        face = create_face_from_db( db, rec, TRUE );
+        family = get_family_from_names( get_font_db_string( db, db_family->name, TRUE ),
+                                        get_font_db_string( db, db_family->english_name, TRUE ) );
+        if (insert_face_in_family_list( face, family ))
+            TRACE( "Added font %s %s from the font database\n", debugstr_w(family->FamilyName),
+                   debugstr_w(face->StyleName) );
+        release_face( face );
+        release_family( family );
+        ret++;
+    }
+
+done:
+    HeapFree( GetProcessHeap(), 0, slots );
+    HeapFree( GetProcessHeap(), 0, fileW );
+    return ret;
+}
+
+static inline BOOL is_face_cached( const Face *face )
+{
+    return face->file && (face->flags & ADDFONT_ADD_TO_CACHE);
+}
+
+static UINT add_font_db_string( char *data, UINT *pos, const WCHAR *str )
+{
+    UINT ret = *pos, len;
+
+    if (!str) return 0;
+    len = (strlenW( str ) + 1) * sizeof(WCHAR);
+    memcpy( data + ret, str, len );
+    *pos += len;
+    return ret;
+}
+
+static int compare_family_names( const void *p1, const void *p2 )
+{
+    const Family *family1 = *(const Family * const *)p1;
+    const Family *family2 = *(const Family * const *)p2;
+
+    return strcmpiW( family1->FamilyName, family2->FamilyName );
+}
+
+static BOOL write_font_db_file( const char *data, UINT size )
+{
+    char *path, *tmp_path;
+    BOOL ret = FALSE;
+    UINT pos;
+    int fd, res;
+
+    if (!(path = get_font_db_path( "" ))) return FALSE;
+    if (!(tmp_path = get_font_db_path( ".tmp" ))) goto done;
+
+    if ((fd = open( tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0666 )) == -1) goto done;
+    for (pos = 0; pos < size; pos += res)
+        if ((res = write( fd, data + pos, size - pos )) <= 0) break;
+    if (close( fd ) == -1) pos = 0;
+
+    /* processes of a previous session may still have the old file mapped */
+    if (pos == size && !rename( tmp_path, path )) ret = TRUE;
+    else unlink( tmp_path );
+
+done:
+    if (!ret) WARN( "failed to write font database %s\n", debugstr_a(path) );
+    HeapFree( GetProcessHeap(), 0, tmp_path );
+    HeapFree( GetProcessHeap(), 0, path );
+    return ret;
+}
+
+/*************************************************************
+ *    write_font_db
+ *
+ * Save the cached part of the font list. Families are sorted by name, the
+ * order the registry cache used to provide them in. Returns the serial of
+ * the new database, or 0 on failure.
+ */
+static UINT write_font_db(void)
+{
+    struct font_db_header *header;
+    struct font_db_family *db_family;
+    struct font_db_face *db_face;
+    UINT *family_hash, *file_hash;
+    Family *family, **families;
+    Face *face;
+    UINT i, j, bucket, pos, size, family_count = 0, face_count = 0, strings_size = 0, hash_size = 16, serial = 0;
+    char *data;
+
+    LIST_FOR_EACH_ENTRY( family, &font_list, Family, entry )
+    {
+        UINT count = 0;
+
+        LIST_FOR_EACH_ENTRY( face, &family->faces, Face, entry )
+        {
+            if (!is_face_cached( face )) continue;
+            strings_size += (strlenW( face->file ) + strlenW( face->StyleName ) + 2) * sizeof(WCHAR);
+            if (face->FullName) strings_size += (strlenW( face->FullName ) + 1) * sizeof(WCHAR);
+            count++;
+        }
+        if (!count) continue;
+        strings_size += (strlenW( family->FamilyName ) + 1) * sizeof(WCHAR);
+        if (family->EnglishName) strings_size += (strlenW( family->EnglishName ) + 1) * sizeof(WCHAR);
+        face_count += count;
+        family_count++;
+    }
+    while (hash_size < face_count) hash_size *= 2;
+
+    if (!(families = HeapAlloc( GetProcessHeap(), 0, max( family_count, 1 ) * sizeof(*families) )))
+        return 0;
+    i = 0;
+    LIST_FOR_EACH_ENTRY( family, &font_list, Family, entry )
+    {
+        LIST_FOR_EACH_ENTRY( face, &family->faces, Face, entry )
+        {
+            if (!is_face_cached( face )) continue;
+            families[i++] = family;
+            break;
+        }
+    }
+    qsort( families, family_count, sizeof(*families), compare_family_names );
+
+    pos = sizeof(*header);
+    pos += family_count * sizeof(*db_family);
+    pos = (pos + 7) & ~7;
+    pos += face_count * sizeof(*db_face);
+    pos += 2 * hash_size * sizeof(UINT);
+    size = pos + strings_size + sizeof(WCHAR);
+
+    if (!(data = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, size )))
+    {
+        HeapFree( GetProcessHeap(), 0, families );
+        return 0;
+    }
+    header = (struct font_db_header *)data;
+    header->magic        = FONT_DB_MAGIC;
+    header->version      = FONT_DB_VERSION;
+    header->size         = size;
+    header->lcid         = GetSystemDefaultLCID();
+    header->hash_size    = hash_size;
+    header->family_count = family_count;
+    header->face_count   = face_count;
+    header->families     = sizeof(*header);
+    header->faces        = (header->families + family_count * sizeof(*db_family) + 7) & ~7;
+    header->family_hash  = header->faces + face_count * sizeof(*db_face);
+    header->file_hash    = header->family_hash + hash_size * sizeof(UINT);
+    header->strings      = header->file_hash + hash_size * sizeof(UINT);
+
+    db_family   = (struct font_db_family *)(data + header->families);
+    db_face     = (struct font_db_face *)(data + header->faces);
+    family_hash = (UINT *)(data + header->family_hash);
+    file_hash   = (UINT *)(data + header->file_hash);
+    pos = header->strings;
+
+    for (i = j = 0; i < family_count; i++, db_family++)
+    {
+        family = families[i];
+        db_family->name = add_font_db_string( data, &pos, family->FamilyName );
+        db_family->english_name = add_font_db_string( data, &pos, family->EnglishName );
+        db_family->first_face = j;
+
+        LIST_FOR_EACH_ENTRY( face, &family->faces, Face, entry )
+        {
+            if (!is_face_cached( face )) continue;
+            db_face->dev          = face->dev;
+            db_face->ino          = face->ino;
+            db_face->mtime        = face->mtime;
+            db_face->file_size    = face->file_size;
+            db_face->file         = add_font_db_string( data, &pos, face->file );
+            db_face->style_name   = add_font_db_string( data, &pos, face->StyleName );
+            db_face->full_name    = add_font_db_string( data, &pos, face->FullName );
+            db_face->family       = i;
+            db_face->flags        = face->flags;
+            db_face->ntm_flags    = face->ntmFlags;
+            db_face->face_index   = face->face_index;
+            db_face->num_faces    = face->num_faces;
+            db_face->font_version = face->font_version;
+            db_face->scalable     = face->scalable;
+            db_face->fs           = face->fs;
+            db_face->size         = face->size.size;
+            db_face->x_ppem       = face->size.x_ppem;
+            db_face->y_ppem       = face->size.y_ppem;
+            db_face->height       = face->size.height;
+            db_face->width        = face->size.width;
+            db_face->internal_leading = face->size.internal_leading;
+            db_face++;
+            j++;
+        }
+        db_family->face_count = j - db_family->first_face;
+    }
+
+    /* link the hash chains in increasing index order */
+    db_family = (struct font_db_family *)(data + header->families);
+    for (i = family_count; i > 0; i--)
+    {
+        bucket = font_db_hash( families[i - 1]->FamilyName, LF_FACESIZE - 1 ) & (hash_size - 1);
+        db_family[i - 1].hash_next = family_hash[bucket];
+        family_hash[bucket] = i;
+    }
+    db_face = (struct font_db_face *)(data + header->faces);
+    for (i = face_count; i > 0; i--)
+    {
+        const WCHAR *file = (const WCHAR *)(data + db_face[i - 1].file);
+
+        bucket = font_db_hash( get_file_name( file ), ~0u ) & (hash_size - 1);
+        db_face[i - 1].hash_next = file_hash[bucket];
+        file_hash[bucket] = i;
+    }
+
+    header->serial = (GetTickCount() ^ (GetCurrentProcessId() << 16)) | 1;
+    if (old_font_db.header && header->serial == old_font_db.header->serial) header->serial += 2;
+
+    if (write_font_db_file( data, size ))
+    {
+        serial = header->serial;
+        TRACE( "wrote font database serial %08x with %u families %u faces\n", serial, family_count, face_count );
+    }
+    HeapFree( GetProcessHeap(), 0, data );
+    HeapFree( GetProcessHeap(), 0, families );
+    return serial;
+}
+
+/*************************************************************
+ *    update_font_db
+ *
+ * Called by the first process of the session once the font directories
+ * have been scanned. The database is only rewritten if some font had to
+ * be loaded from scratch or some font went away.
+ */
+static void update_font_db(void)
+{
+    Family *family;
+    Face *face;
+    UINT serial = 0, count = 0;
+
+    LIST_FOR_EACH_ENTRY( family, &font_list, Family, entry )
+        LIST_FOR_EACH_ENTRY( face, &family->faces, Face, entry )
+            if (is_face_cached( face )) count++;
+
+    if (old_font_db.header && !font_db_dirty && count == old_font_db.header->face_count)
+        serial = old_font_db.header->serial;
+    else
+        serial = write_font_db();
+
+    if (old_font_db.header) unmap_font_db( &old_font_db );
+
+    if (serial)
+    {
+        reg_save_dword( hkey_font_cache, font_db_serial_value, serial );
+        return;
+    }
+
+    /* no database, fall back to the registry cache */
+    LIST_FOR_EACH_ENTRY( family, &font_list, Family, entry )
+        LIST_FOR_EACH_ENTRY( face, &family->faces, Face, entry )
+            if (is_face_cached( face )) add_face_to_cache( face );
+}
+
+/*************************************************************
+ *    load_font_list_from_db
+ *
+ * Build the font list of a process from the database written by the
+ * first process of the session. The names are used in place from the
+ * mapping, which is never unmapped.
+ */
+static void load_font_list_from_db(void)
+{
+    DWORD serial;
+    UINT i, j;
+
+    if (reg_load_dword( hkey_font_cache, font_db_serial_value, &serial )) return;
+    if (!map_font_db( &font_db, serial )) return;
+
+    db_families = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                             max( font_db.header->family_count, 1 ) * sizeof(*db_families) );
+    db_faces = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                          max( font_db.header->face_count, 1 ) * sizeof(*db_faces) );
+    if (!db_families || !db_faces)
+    {
+        HeapFree( GetProcessHeap(), 0, db_families );
+        HeapFree( GetProcessHeap(), 0, db_faces );
+        db_families = NULL;
+        db_faces = NULL;
+        unmap_font_db( &font_db );
+        return;
+    }
+
+    for (i = 0; i < font_db.header->family_count; i++)
+    {
+        const struct font_db_family *rec = &font_db.families[i];
+        WCHAR *name = get_font_db_string( &font_db, rec->name, FALSE );
+        WCHAR *english_name = get_font_db_string( &font_db, rec->english_name, FALSE );
+        Family *family = create_family( name, english_name );
+
+        family->db_index = i;
+        extra_families--;
+        db_families[i] = family;
+        if (english_name) add_english_name_subst( english_name, name );
+
+        for (j = rec->first_face; j < rec->first_face + rec->face_count; j++)
+        {
+            Face *face = create_face_from_db( &font_db, &font_db.faces[j], FALSE );
+
+            face->db_index = j;
+            db_faces[j] = face;
+            if (insert_face_in_family_list( face, family ))
+                TRACE( "Added font %s %s\n", debugstr_w(family->FamilyName), debugstr_w(face->StyleName) );
+            release_face( face );
+        }
+        release_family( family );
+    }
+}
+
 static FT_Face new_ft_face( const char *file, void *font_data_ptr, DWORD font_data_size,
                             FT_Long face_index, BOOL allow_bitmap )
 {
@@ -2281,8 +2978,9 @@ static INT AddFontToList(const char *file, void *font_data_ptr, DWORD font_data_
     }
 #endif /* HAVE_CARBON_CARBON_H */
 
+    if (file && (ret = add_font_from_db( file, flags ))) return ret;
+
     do {
-        const DWORD FS_DBCS_MASK = FS_JISJAPAN|FS_CHINESESIMP|FS_WANSUNG|FS_CHINESETRAD|FS_JOHAB;
         FONTSIGNATURE fs;
 
         ft_face = new_ft_face( file, font_data_ptr, font_data_size, face_index, flags & ADDFONT_ALLOW_BITMAP );
@@ -2297,6 +2995,7 @@ static INT AddFontToList(const char *file, void *font_data_ptr, DWORD font_data_
 
         AddFaceToList(ft_face, file, font_data_ptr, font_data_size, face_index, flags);
         ++ret;
+        if (font_db_building && (flags & ADDFONT_ADD_TO_CACHE)) font_db_dirty = TRUE;
 
         get_fontsig(ft_face, &fs);
         if (fs.fsCsb[0] & FS_DBCS_MASK)
@@ -2368,6 +3067,8 @@ static BOOL map_font_family(const WCHAR *orig, const WCHAR *repl)
             new_family->EnglishName = NULL;
             list_init(&new_family->faces);
             new_family->replacement = &family->faces;
+            new_family->db_index = ~0u;
+            extra_families++;
             list_add_tail(&font_list, &new_family->entry);
             return TRUE;
         }
@@ -4538,6 +5239,167 @@ static void reorder_font_list(void)
     default_sans = set_default( default_sans_list );
 }
 
+/* Rendered glyph bitmaps, bounded by size and evicted in LRU order. Entries are
+ * linked to the font the glyph was requested through; the font it was actually
+ * rendered with is either the same or one of its linked child fonts, which are
+ * only freed along with it. */
+
+struct glyph_bitmap
+{
+    struct list  hash_entry;
+    struct list  lru_entry;
+    struct list  font_entry;
+    GdiFont     *incoming_font;
+    GdiFont     *font;          /* font the glyph comes from, after font linking */
+    FT_UInt      index;
+    UINT         format;        /* including GGO_UNHINTED */
+    BOOL         tategaki;
+    MAT2         matrix;
+    GLYPHMETRICS gm;
+    ABC          abc;
+    DWORD        size;
+    BYTE         bits[1];
+};
+
+#define GLYPH_BITMAP_HASH_SIZE  1024
+#define GLYPH_BITMAP_CACHE_SIZE (4 * 1024 * 1024)
+
+static struct list glyph_bitmap_hash[GLYPH_BITMAP_HASH_SIZE];
+static struct list glyph_bitmap_lru = LIST_INIT( glyph_bitmap_lru );
+static DWORD glyph_bitmap_cache_max = GLYPH_BITMAP_CACHE_SIZE;
+static DWORD glyph_bitmap_cache_size;
+
+static struct
+{
+    DWORD hits;
+    DWORD misses;
+    DWORD evictions;
+} glyph_bitmap_stats;
+
+static inline BOOL is_glyph_bitmap_format( UINT format )
+{
+    switch (format & ~GGO_UNHINTED)
+    {
+    case GGO_BITMAP:
+    case GGO_GRAY2_BITMAP:
+    case GGO_GRAY4_BITMAP:
+    case GGO_GRAY8_BITMAP:
+    case WINE_GGO_GRAY16_BITMAP:
+    case WINE_GGO_HRGB_BITMAP:
+    case WINE_GGO_HBGR_BITMAP:
+    case WINE_GGO_VRGB_BITMAP:
+    case WINE_GGO_VBGR_BITMAP:
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static inline UINT glyph_bitmap_hash_index( const GdiFont *font, FT_UInt index, UINT format, const MAT2 *matrix )
+{
+    UINT hash = (UINT)((UINT_PTR)font >> 4) ^ (index * 0x9e3779b1) ^ (format << 24);
+    hash ^= (matrix->eM11.value << 8) ^ matrix->eM11.fract ^ (matrix->eM22.value << 16) ^ matrix->eM22.fract;
+    return (hash ^ (hash >> 16)) % GLYPH_BITMAP_HASH_SIZE;
+}
+
+static void free_glyph_bitmap( struct glyph_bitmap *glyph )
+{
+    list_remove( &glyph->hash_entry );
+    list_remove( &glyph->lru_entry );
+    list_remove( &glyph->font_entry );
+    glyph_bitmap_cache_size -= glyph->size;
+    HeapFree( GetProcessHeap(), 0, glyph );
+}
+
+static void free_cached_glyph_bitmaps( GdiFont *font )
+{
+    struct glyph_bitmap *glyph, *next;
+
+    LIST_FOR_EACH_ENTRY_SAFE( glyph, next, &font->glyph_cache, struct glyph_bitmap, font_entry )
+        free_glyph_bitmap( glyph );
+}
+
+static struct glyph_bitmap *find_glyph_bitmap( GdiFont *incoming_font, GdiFont *font, FT_UInt index,
+                                               UINT format, BOOL tategaki, const MAT2 *matrix )
+{
+    struct list *bucket = &glyph_bitmap_hash[glyph_bitmap_hash_index( incoming_font, index, format, matrix )];
+    struct glyph_bitmap *glyph;
+
+    if (!bucket->next) return NULL;  /* not initialized yet */
+
+    LIST_FOR_EACH_ENTRY( glyph, bucket, struct glyph_bitmap, hash_entry )
+    {
+        if (glyph->incoming_font != incoming_font || glyph->font != font || glyph->index != index ||
+            glyph->format != format || glyph->tategaki != tategaki ||
+            memcmp( &glyph->matrix, matrix, sizeof(*matrix) ))
+            continue;
+        list_remove( &glyph->lru_entry );
+        list_add_head( &glyph_bitmap_lru, &glyph->lru_entry );
+        glyph_bitmap_stats.hits++;
+        return glyph;
+    }
+    glyph_bitmap_stats.misses++;
+    return NULL;
+}
+
+static struct glyph_bitmap *alloc_glyph_bitmap( DWORD size )
+{
+    struct glyph_bitmap *glyph;
+
+    if (size > glyph_bitmap_cache_max / 16) return NULL;
+    if (!(glyph = HeapAlloc( GetProcessHeap(), 0, FIELD_OFFSET( struct glyph_bitmap, bits[size] ))))
+        return NULL;
+    glyph->size = size;
+    return glyph;
+}
+
+static void add_glyph_bitmap( struct glyph_bitmap *glyph, GdiFont *incoming_font, GdiFont *font,
+                              FT_UInt index, UINT format, BOOL tategaki, const MAT2 *matrix )
+{
+    struct list *bucket = &glyph_bitmap_hash[glyph_bitmap_hash_index( incoming_font, index, format, matrix )];
+    struct list *ptr;
+    UINT i;
+
+    if (!bucket->next)
+        for (i = 0; i < GLYPH_BITMAP_HASH_SIZE; i++) list_init( &glyph_bitmap_hash[i] );
+
+    while (glyph_bitmap_cache_size + glyph->size > glyph_bitmap_cache_max &&
+           (ptr = list_tail( &glyph_bitmap_lru )))
+    {
+        free_glyph_bitmap( LIST_ENTRY( ptr, struct glyph_bitmap, lru_entry ));
+        glyph_bitmap_stats.evictions++;
+    }
+
+    glyph->incoming_font = incoming_font;
+    glyph->font          = font;
+    glyph->index         = index;
+    glyph->format        = format;
+    glyph->tategaki      = tategaki;
+    glyph->matrix        = *matrix;
+    list_add_head( bucket, &glyph->hash_entry );
+    list_add_head( &glyph_bitmap_lru, &glyph->lru_entry );
+    list_add_tail( &incoming_font->glyph_cache, &glyph->font_entry );
+    glyph_bitmap_cache_size += glyph->size;
+
+    if (!((glyph_bitmap_stats.hits + glyph_bitmap_stats.misses) % 4096))
+        TRACE( "glyph cache: %u hits %u misses %u evictions, %u bytes used\n", glyph_bitmap_stats.hits,
+               glyph_bitmap_stats.misses, glyph_bitmap_stats.evictions, glyph_bitmap_cache_size );
+}
+
+/* return a cached glyph the same way get_glyph_outline() would */
+static DWORD get_cached_glyph_bitmap( const struct glyph_bitmap *glyph, LPGLYPHMETRICS lpgm, ABC *abc,
+                                      DWORD buflen, LPVOID buf )
+{
+    *abc = glyph->abc;
+    if (buf && buflen)
+    {
+        if (!glyph->size || glyph->size > buflen) return GDI_ERROR;
+        memcpy( buf, glyph->bits, glyph->size );
+        memset( (BYTE *)buf + glyph->size, 0, buflen - glyph->size );
+    }
+    *lpgm = glyph->gm;
+    return glyph->size;
+}
+
 /*************************************************************
  *    WineEngInit
  *
@@ -4563,6 +5425,7 @@ BOOL WineEngInit(void)
         static const WCHAR antialias_fake_bold_or_italic[] = { 'A','n','t','i','a','l','i','a','s','F','a','k','e',
                                                                'B','o','l','d','O','r','I','t','a','l','i','c',0 };
         static const WCHAR true_options[] = { 'y','Y','t','T','1',0 };
+        static const WCHAR glyph_cache_size_value[] = { 'G','l','y','p','h','C','a','c','h','e','S','i','z','e',0 };
         DWORD type, size;
         WCHAR buffer[20];
 
@@ -4572,6 +5435,9 @@ BOOL WineEngInit(void)
         {
             antialias_fakes = (strchrW(true_options, buffer[0]) != NULL);
         }
+        /* size of the rendered glyph cache in KB, 0 disables it */
+        if (!reg_load_dword(hkey, glyph_cache_size_value, &size))
+            glyph_bitmap_cache_max = min( size, 0x100000 ) * 1024;
         RegCloseKey(hkey);
     }
 
@@ -4585,9 +5451,21 @@ BOOL WineEngInit(void)
     create_font_cache_key(&hkey_font_cache, &disposition);
 
     if(disposition == REG_CREATED_NEW_KEY)
+    {
+        /* reuse what we can from the database of the previous session */
+        if (map_font_db( &old_font_db, 0 ) && old_font_db.header->lcid != GetSystemDefaultLCID())
+            unmap_font_db( &old_font_db );
+        font_db_building = TRUE;
         init_font_list();
+        font_db_building = FALSE;
+        update_font_db();
+    }
     else
+    {
+        load_font_list_from_db();
+        /* fonts added since the database was written, or all of them if it couldn't be */
         load_font_list_from_cache(hkey_font_cache);
+    }
 
     reorder_font_list();
 
@@ -4843,6 +5721,7 @@ static GdiFont *alloc_font(void)
     ret->kern_pairs = NULL;
     ret->instance_id = alloc_font_handle(ret);
     list_init(&ret->child_fonts);
+    list_init(&ret->glyph_cache);
     return ret;
 }
 
@@ -4851,6 +5730,7 @@ static void free_font(GdiFont *font)
     CHILD_FONT *child, *child_next;
     DWORD i;
 
+    free_cached_glyph_bitmaps( font );
     LIST_FOR_EACH_ENTRY_SAFE( child, child_next, &font->child_fonts, CHILD_FONT, entry )
     {
         list_remove(&child->entry);
@@ -7461,6 +8341,28 @@ static DWORD get_subpixel_glyph_bitmap( FT_GlyphSlot glyph, FT_BBox bbox, UINT f
     return needed;
 }
 
+static DWORD get_glyph_bitmap( FT_GlyphSlot glyph, FT_BBox bbox, UINT format,
+                               BOOL fake_bold, BOOL needs_transform, FT_Matrix matrices[3],
+                               GLYPHMETRICS *gm, DWORD buflen, BYTE *buf )
+{
+    switch (format)
+    {
+    case GGO_BITMAP:
+        return get_mono_glyph_bitmap( glyph, bbox, fake_bold, needs_transform, matrices, buflen, buf );
+
+    case GGO_GRAY2_BITMAP:
+    case GGO_GRAY4_BITMAP:
+    case GGO_GRAY8_BITMAP:
+    case WINE_GGO_GRAY16_BITMAP:
+        return get_antialias_glyph_bitmap( glyph, bbox, format, fake_bold, needs_transform, matrices,
+                                           buflen, buf );
+
+    default:
+        return get_subpixel_glyph_bitmap( glyph, bbox, format, fake_bold, needs_transform, matrices,
+                                          gm, buflen, buf );
+    }
+}
+
 static unsigned int get_native_glyph_outline(FT_Outline *outline, unsigned int buflen, char *buf)
 {
     TTPOLYGONHEADER *pph;
@@ -7706,6 +8608,8 @@ static DWORD get_glyph_outline(GdiFont *incoming_font, UINT glyph, UINT format,
     BOOL needsTransform = FALSE;
     BOOL tategaki = (font->name[0] == '@');
     BOOL vertical_metrics;
+    struct glyph_bitmap *cached;
+    UINT cache_format;
 
     TRACE("%p, %04x, %08x, %p, %08x, %p, %p\n", font, glyph, format, lpgm,
 	  buflen, buf, lpmat);
@@ -7734,12 +8638,17 @@ static DWORD get_glyph_outline(GdiFont *incoming_font, UINT glyph, UINT format,
             tategaki = check_unicode_tategaki(glyph);
     }
 
+    cache_format = format;
     format &= ~GGO_UNHINTED;
 
     if (format == GGO_METRICS && is_identity_MAT2(lpmat) &&
         get_cached_metrics( font, glyph_index, lpgm, abc ))
         return 1; /* FIXME */
 
+    if (is_glyph_bitmap_format( format ) && glyph_bitmap_cache_max &&
+        (cached = find_glyph_bitmap( incoming_font, font, glyph_index, cache_format, tategaki, lpmat )))
+        return get_cached_glyph_bitmap( cached, lpgm, abc, buflen, buf );
+
     needsTransform = get_transform_matrices( font, tategaki, lpmat, matrices );
 
     vertical_metrics = (tategaki && FT_HAS_VERTICAL(ft_face));
@@ -7801,27 +8710,45 @@ static DWORD get_glyph_outline(GdiFont *incoming_font, UINT glyph, UINT format,
 	return GDI_ERROR;
     }
 
+    /* render the whole bitmap into the cache even for a size query,
+     * the caller usually asks for the bits right after */
+    if (is_glyph_bitmap_format( format ) && glyph_bitmap_cache_max)
+    {
+        GLYPHMETRICS size_gm = gm;
+
+        needed = get_glyph_bitmap( ft_face->glyph, bbox, format, font->fake_bold,
+                                   needsTransform, matrices, &size_gm, 0, NULL );
+        if (needed != GDI_ERROR && (cached = alloc_glyph_bitmap( needed )))
+        {
+            /* the renderers don't write the row padding of 1-bpp bitmaps
+             * copied from bitmap strikes, don't cache whatever the heap had */
+            memset( cached->bits, 0, needed );
+            if (needed && get_glyph_bitmap( ft_face->glyph, bbox, format, font->fake_bold, needsTransform,
+                                            matrices, &gm, needed, cached->bits ) == GDI_ERROR)
+            {
+                HeapFree( GetProcessHeap(), 0, cached );
+                return GDI_ERROR;
+            }
+            cached->gm  = gm;
+            cached->abc = *abc;
+            add_glyph_bitmap( cached, incoming_font, font, glyph_index, cache_format, tategaki, lpmat );
+            return get_cached_glyph_bitmap( cached, lpgm, abc, buflen, buf );
+        }
+    }
+
     switch (format)
     {
     case GGO_BITMAP:
-        needed = get_mono_glyph_bitmap( ft_face->glyph, bbox, font->fake_bold,
-                                        needsTransform, matrices, buflen, buf );
-        break;
-
     case GGO_GRAY2_BITMAP:
     case GGO_GRAY4_BITMAP:
     case GGO_GRAY8_BITMAP:
     case WINE_GGO_GRAY16_BITMAP:
-        needed = get_antialias_glyph_bitmap( ft_face->glyph, bbox, format, font->fake_bold,
-                                             needsTransform, matrices, buflen, buf );
-	break;
-
     case WINE_GGO_HRGB_BITMAP:
     case WINE_GGO_HBGR_BITMAP:
     case WINE_GGO_VRGB_BITMAP:
     case WINE_GGO_VBGR_BITMAP:
-        needed = get_subpixel_glyph_bitmap( ft_face->glyph, bbox, format, font->fake_bold,
-                                            needsTransform, matrices, &gm, buflen, buf );
+        needed = get_glyph_bitmap( ft_face->glyph, bbox, format, font->fake_bold,
+                                   needsTransform, matrices, &gm, buflen, buf );
         break;
 
     case GGO_NATIVE:
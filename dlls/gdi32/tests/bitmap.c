@@ -3846,6 +3846,119 @@ static void test_GdiAlphaBlend(void)
     HeapFree(GetProcessHeap(), 0, bmi);
 }
 
+static BYTE ref_blend_color( BYTE dst, BYTE src, DWORD alpha )
+{
+    return (src * alpha + dst * (255 - alpha) + 127) / 255;
+}
+
+static DWORD ref_alpha_blend( DWORD dst, DWORD src, BLENDFUNCTION blend )
+{
+    DWORD ret = 0, alpha = blend.SourceConstantAlpha;
+    BYTE chan[4];
+    int i;
+
+    if (!(blend.AlphaFormat & AC_SRC_ALPHA))
+    {
+        for (i = 0; i < 32; i += 8)
+            ret |= ref_blend_color( dst >> i, src >> i, alpha ) << i;
+        return ret;
+    }
+    for (i = 0; i < 4; i++) chan[i] = ((BYTE)(src >> (i * 8)) * alpha + 127) / 255;
+    for (i = 0; i < 4; i++)
+        ret |= (chan[i] + ((BYTE)(dst >> (i * 8)) * (255 - chan[3]) + 127) / 255) << (i * 8);
+    return ret;
+}
+
+static void test_AlphaBlend_large(void)
+{
+    static const BLENDFUNCTION blends[] =
+    {
+        { AC_SRC_OVER, 0, 255, AC_SRC_ALPHA },
+        { AC_SRC_OVER, 0, 128, AC_SRC_ALPHA },
+        { AC_SRC_OVER, 0, 77, 0 },
+    };
+    const int width = 517, height = 301, loops = 20;
+    BITMAPINFO bmi;
+    HBITMAP bmp_src, bmp_dst;
+    HDC hdc_src, hdc_dst;
+    DWORD *src_bits, *dst_bits, *orig, seed = 1, start, i, j, k;
+    BOOL ret;
+
+    if (!pGdiAlphaBlend)
+    {
+        win_skip("GdiAlphaBlend() is not implemented\n");
+        return;
+    }
+
+    memset( &bmi, 0, sizeof(bmi) );
+    bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+    bmi.bmiHeader.biWidth = width;
+    bmi.bmiHeader.biHeight = -height;
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+
+    hdc_src = CreateCompatibleDC( 0 );
+    hdc_dst = CreateCompatibleDC( 0 );
+    bmp_src = CreateDIBSection( hdc_src, &bmi, DIB_RGB_COLORS, (void **)&src_bits, NULL, 0 );
+    bmp_dst = CreateDIBSection( hdc_dst, &bmi, DIB_RGB_COLORS, (void **)&dst_bits, NULL, 0 );
+    ok( bmp_src && bmp_dst, "failed to create DIB sections\n" );
+    SelectObject( hdc_src, bmp_src );
+    SelectObject( hdc_dst, bmp_dst );
+    orig = HeapAlloc( GetProcessHeap(), 0, width * height * sizeof(DWORD) );
+
+    /* premultiplied source with fully transparent and opaque runs mixed in */
+    for (i = 0; i < width * height; i++)
+    {
+        BYTE alpha, b, g, r;
+
+        seed = seed * 1103515245 + 12345;
+        alpha = (i % 61 < 10) ? 0 : (i % 61 < 20) ? 255 : seed >> 24;
+        b = ((seed >> 16) & 0xff) * alpha / 255;
+        g = ((seed >> 8) & 0xff) * alpha / 255;
+        r = (seed & 0xff) * alpha / 255;
+        src_bits[i] = alpha << 24 | r << 16 | g << 8 | b;
+        orig[i] = seed ^ (seed << 13);
+    }
+
+    for (i = 0; i < ARRAY_SIZE(blends); i++)
+    {
+        memcpy( dst_bits, orig, width * height * sizeof(DWORD) );
+        ret = pGdiAlphaBlend( hdc_dst, 0, 0, width, height, hdc_src, 0, 0, width, height, blends[i] );
+        ok( ret, "%u: GdiAlphaBlend failed\n", i );
+        for (j = 0; j < width * height; j++)
+        {
+            DWORD mask = (blends[i].AlphaFormat & AC_SRC_ALPHA) ? ~0u : 0x00ffffff;
+            DWORD expect = ref_alpha_blend( orig[j], src_bits[j], blends[i] );
+            if ((dst_bits[j] & mask) != (expect & mask))
+            {
+                ok( 0, "%u: pixel %u got %08x expected %08x\n", i, j, dst_bits[j], expect );
+                break;
+            }
+        }
+
+        start = GetTickCount();
+        for (k = 0; k < loops; k++)
+            pGdiAlphaBlend( hdc_dst, 0, 0, width, height, hdc_src, 0, 0, width, height, blends[i] );
+        trace( "%u: %u AlphaBlend calls of %ux%u pixels in %u ms\n", i, loops, width, height,
+               GetTickCount() - start );
+    }
+
+    memcpy( orig, dst_bits, width * height * sizeof(DWORD) );
+    start = GetTickCount();
+    for (k = 0; k < loops; k++)
+        PatBlt( hdc_dst, 0, 0, width, height, DSTINVERT );
+    trace( "%u DSTINVERT PatBlt calls of %ux%u pixels in %u ms\n", loops, width, height,
+           GetTickCount() - start );
+    ok( !memcmp( orig, dst_bits, width * height * sizeof(DWORD) ), "wrong bits after DSTINVERT\n" );
+
+    HeapFree( GetProcessHeap(), 0, orig );
+    DeleteDC( hdc_src );
+    DeleteDC( hdc_dst );
+    DeleteObject( bmp_src );
+    DeleteObject( bmp_dst );
+}
+
 static void test_GdiGradientFill(void)
 {
     HDC hdc;
@@ -5980,6 +6093,7 @@ START_TEST(bitmap)
     test_StretchBlt();
     test_StretchDIBits();
     test_GdiAlphaBlend();
+    test_AlphaBlend_large();
     test_GdiGradientFill();
     test_32bit_ddb();
     test_bitmapinfoheadersize();
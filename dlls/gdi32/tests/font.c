@@ -5774,6 +5774,66 @@ static void test_fullname2(void)
 
 }
 
+static void test_GetGlyphOutline_repeat(void)
+{
+    static const UINT formats[] = { GGO_BITMAP, GGO_GRAY2_BITMAP, GGO_GRAY4_BITMAP, GGO_GRAY8_BITMAP,
+                                    GGO_GRAY8_BITMAP | GGO_UNHINTED };
+    static const MAT2 rotate = { {0,0}, {0,1}, {0,-1}, {0,0} };
+    BYTE *buf1, *buf2;
+    GLYPHMETRICS gm1, gm2;
+    DWORD size1, size2;
+    LOGFONTA lf;
+    HFONT hfont, old_hfont;
+    HDC hdc;
+    UINT i, j;
+
+    if (!is_truetype_font_installed("Tahoma"))
+    {
+        skip("Tahoma is not installed\n");
+        return;
+    }
+
+    hdc = CreateCompatibleDC(0);
+    memset(&lf, 0, sizeof(lf));
+    lf.lfHeight = 40;
+    lstrcpyA(lf.lfFaceName, "Tahoma");
+    hfont = CreateFontIndirectA(&lf);
+    old_hfont = SelectObject(hdc, hfont);
+
+    for (i = 0; i < ARRAY_SIZE(formats); i++)
+    {
+        for (j = 0; j < 2; j++)
+        {
+            const MAT2 *matrix = j ? &rotate : &mat;
+
+            size1 = GetGlyphOutlineA(hdc, 'g', formats[i], &gm1, 0, NULL, matrix);
+            ok(size1 != GDI_ERROR && size1, "%u/%u: GetGlyphOutlineA failed\n", i, j);
+            if (size1 == GDI_ERROR || !size1) continue;
+
+            buf1 = HeapAlloc(GetProcessHeap(), 0, size1);
+            buf2 = HeapAlloc(GetProcessHeap(), 0, size1 + 16);
+            memset(buf1, 0xcc, size1);
+            memset(buf2, 0x55, size1 + 16);
+
+            size2 = GetGlyphOutlineA(hdc, 'g', formats[i], &gm2, size1, buf1, matrix);
+            ok(size2 == size1, "%u/%u: got size %u, expected %u\n", i, j, size2, size1);
+            ok(!memcmp(&gm1, &gm2, sizeof(gm1)), "%u/%u: metrics differ\n", i, j);
+
+            size2 = GetGlyphOutlineA(hdc, 'g', formats[i], &gm2, size1 + 16, buf2, matrix);
+            ok(size2 == size1, "%u/%u: got size %u, expected %u\n", i, j, size2, size1);
+            ok(!memcmp(&gm1, &gm2, sizeof(gm1)), "%u/%u: metrics differ\n", i, j);
+            ok(!memcmp(buf1, buf2, size1), "%u/%u: bits differ\n", i, j);
+
+            HeapFree(GetProcessHeap(), 0, buf1);
+            HeapFree(GetProcessHeap(), 0, buf2);
+        }
+    }
+
+    SelectObject(hdc, old_hfont);
+    DeleteObject(hfont);
+    DeleteDC(hdc);
+}
+
 static void test_GetGlyphOutline_empty_contour(void)
 {
     HDC hdc;
@@ -7250,6 +7310,7 @@ START_TEST(font)
     test_RealizationInfo();
     test_GetTextFace();
     test_GetGlyphOutline();
+    test_GetGlyphOutline_repeat();
     test_GetTextMetrics2("Tahoma", -11);
     test_GetTextMetrics2("Tahoma", -55);
     test_GetTextMetrics2("Tahoma", -110);
@@ -535,12 +535,10 @@ static GpStatus alpha_blend_pixels(GpGraphics *graphics, INT dst_x, INT dst_y,
     return alpha_blend_pixels_hrgn(graphics, dst_x, dst_y, src, src_width, src_height, src_stride, NULL, fmt);
 }
 
-static ARGB blend_colors(ARGB start, ARGB end, REAL position)
+/* pos is the weight of end in the range 0-255 */
+static ARGB blend_colors_pos(ARGB start, ARGB end, INT pos)
 {
     INT start_a, end_a, final_a;
-    INT pos;
-
-    pos = gdip_round(position * 0xff);
 
     start_a = ((start >> 24) & 0xff) * (pos ^ 0xff);
     end_a = ((end >> 24) & 0xff) * pos;
@@ -555,6 +553,11 @@ static ARGB blend_colors(ARGB start, ARGB end, REAL position)
         (((start & 0xff) * start_a + ((end & 0xff) * end_a)) / final_a);
 }
 
+static ARGB blend_colors(ARGB start, ARGB end, REAL position)
+{
+    return blend_colors_pos(start, end, gdip_round(position * 0xff));
+}
+
 static ARGB blend_line_gradient(GpLineGradient* brush, REAL position)
 {
     REAL blendfac;
@@ -946,18 +949,29 @@ static ARGB sample_bitmap_pixel(GDIPCONST GpRect *src_rect, LPBYTE bits, UINT wi
     return ((DWORD*)(bits))[(x - src_rect->X) + (y - src_rect->Y) * src_rect->Width];
 }
 
-static ARGB resample_bitmap_pixel(GDIPCONST GpRect *src_rect, LPBYTE bits, UINT width,
-    UINT height, GpPointF *point, GDIPCONST GpImageAttributes *attributes,
-    InterpolationMode interpolation, PixelOffsetMode offset_mode)
+static InterpolationMode get_resample_mode(InterpolationMode interpolation)
 {
     static int fixme;
 
     switch (interpolation)
     {
+    case InterpolationModeNearestNeighbor:
+    case InterpolationModeBilinear:
+        return interpolation;
     default:
         if (!fixme++)
             FIXME("Unimplemented interpolation %i\n", interpolation);
-        /* fall-through */
+        return InterpolationModeBilinear;
+    }
+}
+
+static ARGB resample_bitmap_pixel(GDIPCONST GpRect *src_rect, LPBYTE bits, UINT width,
+    UINT height, GpPointF *point, GDIPCONST GpImageAttributes *attributes,
+    InterpolationMode interpolation, PixelOffsetMode offset_mode)
+{
+    switch (get_resample_mode(interpolation))
+    {
+    default:
     case InterpolationModeBilinear:
     {
         REAL leftxf, topyf;
@@ -1015,6 +1029,224 @@ static ARGB resample_bitmap_pixel(GDIPCONST GpRect *src_rect, LPBYTE bits, UINT
     }
 }
 
+/* One destination column or row of an axis-aligned resampling operation. */
+struct resample_coord
+{
+    INT index[2];   /* source pixels relative to the sampled area, see get_sample_index */
+    INT weight;     /* weight of index[1] in the range 0-255 */
+    BOOL single;    /* both source pixels are the same */
+    BOOL inside;    /* the co-ordinate lies within the source rectangle */
+};
+
+/* Apply the wrapping rules of sample_bitmap_pixel to a single axis. Returns -1
+ * for co-ordinates outside a clamped bitmap and -2 for co-ordinates outside the
+ * sampled area. */
+static INT get_sample_index(INT x, UINT size, INT start, INT count, WrapMode wrap, BOOL flip)
+{
+    if (wrap == WrapModeClamp)
+    {
+        if (x < 0 || x >= size)
+            return -1;
+    }
+    else
+    {
+        if (x < 0)
+            x = size*2 + x % (size * 2);
+
+        if (flip && (x / size) % 2 != 0)
+            x = size - 1 - x % size;
+        else
+            x = x % size;
+    }
+
+    if (x < start || x >= start + count)
+        return -2;
+
+    return x - start;
+}
+
+static void init_resample_coords(struct resample_coord *coords, INT first, INT count,
+    REAL origin, REAL step, REAL src_start, REAL src_size, UINT size, INT sample_start,
+    INT sample_count, WrapMode wrap, BOOL flip, InterpolationMode interpolation,
+    REAL pixel_offset)
+{
+    INT i;
+
+    for (i = 0; i < count; i++)
+    {
+        REAL pos = origin + (first + i) * step;
+        struct resample_coord *coord = &coords[i];
+
+        coord->inside = pos >= src_start && pos < src_start + src_size;
+
+        if (interpolation == InterpolationModeNearestNeighbor)
+        {
+            coord->index[0] = coord->index[1] = get_sample_index(floorf(pos + pixel_offset),
+                size, sample_start, sample_count, wrap, flip);
+            coord->weight = 0;
+            coord->single = TRUE;
+        }
+        else
+        {
+            REAL lowf = floorf(pos);
+            INT low = (INT)lowf, high = (INT)ceilf(pos);
+
+            coord->index[0] = get_sample_index(low, size, sample_start, sample_count, wrap, flip);
+            coord->index[1] = get_sample_index(high, size, sample_start, sample_count, wrap, flip);
+            coord->weight = gdip_round((pos - lowf) * 0xff);
+            coord->single = (low == high);
+        }
+    }
+}
+
+static inline ARGB get_sample(const ARGB *bits, INT width, INT x, INT y, ARGB outside_color)
+{
+    if (x == -1 || y == -1)
+        return outside_color;
+
+    if (x < 0 || y < 0)
+    {
+        ERR("out of range pixel requested\n");
+        return 0xffcd0084;
+    }
+
+    return bits[x + y * width];
+}
+
+/* Horizontal pass: interpolate one source row at every destination column. */
+static void resample_row(const struct resample_coord *cols, INT count, const ARGB *bits,
+    INT width, INT y, ARGB outside_color, ARGB *blended, ARGB *first)
+{
+    INT i;
+
+    for (i = 0; i < count; i++)
+    {
+        ARGB left, right;
+
+        if (!cols[i].inside) continue;
+
+        left = get_sample(bits, width, cols[i].index[0], y, outside_color);
+        right = cols[i].single ? left : get_sample(bits, width, cols[i].index[1], y, outside_color);
+
+        first[i] = left;
+        blended[i] = blend_colors_pos(left, right, cols[i].weight);
+    }
+}
+
+/* Resample a bitmap for a transformation that only scales and translates.
+ * The per-column and per-row sample positions and weights are computed once,
+ * and interpolated source rows are reused between destination rows, but the
+ * results are identical to calling resample_bitmap_pixel for every pixel. */
+static GpStatus resample_bitmap_scaled(GDIPCONST GpRect *src_area, LPBYTE src_data,
+    UINT width, UINT height, REAL srcx, REAL srcy, REAL srcwidth, REAL srcheight,
+    const GpPointF *origin, REAL x_dx, REAL y_dy, const RECT *dst_area, LPBYTE dst_data,
+    INT dst_stride, GDIPCONST GpImageAttributes *attributes,
+    InterpolationMode interpolation, PixelOffsetMode offset_mode)
+{
+    INT dst_width = dst_area->right - dst_area->left;
+    INT dst_height = dst_area->bottom - dst_area->top;
+    const ARGB *bits = (const ARGB *)src_data;
+    struct resample_coord *cols, *rows;
+    ARGB *row_buf = NULL, *blended[2], *first[2];
+    INT slot_row[2] = {INT_MIN, INT_MIN};
+    REAL pixel_offset;
+    INT x, y;
+
+    interpolation = get_resample_mode(interpolation);
+
+    switch (offset_mode)
+    {
+    default:
+    case PixelOffsetModeNone:
+    case PixelOffsetModeHighSpeed:
+        pixel_offset = 0.5;
+        break;
+
+    case PixelOffsetModeHalf:
+    case PixelOffsetModeHighQuality:
+        pixel_offset = 0.0;
+        break;
+    }
+
+    cols = heap_alloc(sizeof(*cols) * (dst_width + dst_height));
+    if (!cols)
+        return OutOfMemory;
+    rows = cols + dst_width;
+
+    if (interpolation != InterpolationModeNearestNeighbor)
+    {
+        row_buf = heap_alloc(sizeof(ARGB) * dst_width * 4);
+        if (!row_buf)
+        {
+            heap_free(cols);
+            return OutOfMemory;
+        }
+        blended[0] = row_buf;
+        blended[1] = row_buf + dst_width;
+        first[0] = row_buf + dst_width * 2;
+        first[1] = row_buf + dst_width * 3;
+    }
+
+    init_resample_coords(cols, dst_area->left, dst_width, origin->X, x_dx, srcx, srcwidth,
+        width, src_area->X, src_area->Width, attributes->wrap,
+        (attributes->wrap & WrapModeTileFlipX) != 0, interpolation, pixel_offset);
+    init_resample_coords(rows, dst_area->top, dst_height, origin->Y, y_dy, srcy, srcheight,
+        height, src_area->Y, src_area->Height, attributes->wrap,
+        (attributes->wrap & WrapModeTileFlipY) != 0, interpolation, pixel_offset);
+
+    for (y = 0; y < dst_height; y++)
+    {
+        const struct resample_coord *row = &rows[y];
+        ARGB *dst_row = (ARGB *)(dst_data + dst_stride * y);
+        INT top, bottom;
+
+        if (!row->inside) continue;
+
+        if (interpolation == InterpolationModeNearestNeighbor)
+        {
+            for (x = 0; x < dst_width; x++)
+                if (cols[x].inside)
+                    dst_row[x] = get_sample(bits, src_area->Width, cols[x].index[0],
+                        row->index[0], attributes->outside_color);
+            continue;
+        }
+
+        if (slot_row[0] == row->index[0]) top = 0;
+        else if (slot_row[1] == row->index[0]) top = 1;
+        else
+        {
+            top = (slot_row[0] == row->index[1]) ? 1 : 0;
+            resample_row(cols, dst_width, bits, src_area->Width, row->index[0],
+                attributes->outside_color, blended[top], first[top]);
+            slot_row[top] = row->index[0];
+        }
+
+        if (slot_row[top] == row->index[1]) bottom = top;
+        else if (slot_row[!top] == row->index[1]) bottom = !top;
+        else
+        {
+            bottom = !top;
+            resample_row(cols, dst_width, bits, src_area->Width, row->index[1],
+                attributes->outside_color, blended[bottom], first[bottom]);
+            slot_row[bottom] = row->index[1];
+        }
+
+        for (x = 0; x < dst_width; x++)
+        {
+            if (!cols[x].inside) continue;
+
+            if (cols[x].single && row->single)
+                dst_row[x] = first[top][x];
+            else
+                dst_row[x] = blend_colors_pos(blended[top][x], blended[bottom][x], row->weight);
+        }
+    }
+
+    heap_free(row_buf);
+    heap_free(cols);
+    return Ok;
+}
+
 static REAL intersect_line_scanline(const GpPointF *p1, const GpPointF *p2, REAL y)
 {
     return (p1->X - p2->X) * (p2->Y - y) / (p2->Y - p1->Y) + p2->X;
@@ -1129,6 +1361,13 @@ static BOOL brush_can_fill_pixels(GpBrush *brush)
     }
 }
 
+static BOOL is_antialiased(GpGraphics *graphics)
+{
+    return graphics->smoothing != SmoothingModeDefault &&
+           graphics->smoothing != SmoothingModeNone &&
+           graphics->smoothing != SmoothingModeHighSpeed;
+}
+
 static GpStatus brush_fill_pixels(GpGraphics *graphics, GpBrush *brush,
     DWORD *argb_pixels, GpRect *fill_area, UINT cdwStride)
 {
@@ -3164,23 +3403,38 @@ GpStatus WINGDIPAPI GdipDrawImagePointsRect(GpGraphics *graphics, GpImage *image
                 y_dx = dst_to_src_points[2].X - dst_to_src_points[0].X;
                 y_dy = dst_to_src_points[2].Y - dst_to_src_points[0].Y;
 
-                for (x=dst_area.left; x<dst_area.right; x++)
+                if (x_dy == 0.0 && y_dx == 0.0)
                 {
-                    for (y=dst_area.top; y<dst_area.bottom; y++)
+                    stat = resample_bitmap_scaled(&src_area, src_data, bitmap->width, bitmap->height,
+                        srcx, srcy, srcwidth, srcheight, &dst_to_src_points[0], x_dx, y_dy,
+                        &dst_area, dst_data, dst_stride, imageAttributes, interpolation, offset_mode);
+                    if (stat != Ok)
                     {
-                        GpPointF src_pointf;
-                        ARGB *dst_color;
+                        heap_free(src_data);
+                        heap_free(dst_dyn_data);
+                        return stat;
+                    }
+                }
+                else
+                {
+                    for (x=dst_area.left; x<dst_area.right; x++)
+                    {
+                        for (y=dst_area.top; y<dst_area.bottom; y++)
+                        {
+                            GpPointF src_pointf;
+                            ARGB *dst_color;
 
-                        src_pointf.X = dst_to_src_points[0].X + x * x_dx + y * y_dx;
-                        src_pointf.Y = dst_to_src_points[0].Y + x * x_dy + y * y_dy;
+                            src_pointf.X = dst_to_src_points[0].X + x * x_dx + y * y_dx;
+                            src_pointf.Y = dst_to_src_points[0].Y + x * x_dy + y * y_dy;
 
-                        dst_color = (ARGB*)(dst_data + dst_stride * (y - dst_area.top) + sizeof(ARGB) * (x - dst_area.left));
+                            dst_color = (ARGB*)(dst_data + dst_stride * (y - dst_area.top) + sizeof(ARGB) * (x - dst_area.left));
 
-                        if (src_pointf.X >= srcx && src_pointf.X < srcx + srcwidth && src_pointf.Y >= srcy && src_pointf.Y < srcy+srcheight)
-                            *dst_color = resample_bitmap_pixel(&src_area, src_data, bitmap->width, bitmap->height, &src_pointf,
-                                                               imageAttributes, interpolation, offset_mode);
-                        else
-                            *dst_color = 0;
+                            if (src_pointf.X >= srcx && src_pointf.X < srcx + srcwidth && src_pointf.Y >= srcy && src_pointf.Y < srcy+srcheight)
+                                *dst_color = resample_bitmap_pixel(&src_area, src_data, bitmap->width, bitmap->height, &src_pointf,
+                                                                   imageAttributes, interpolation, offset_mode);
+                            else
+                                *dst_color = 0;
+                        }
                     }
                 }
             }
@@ -3846,15 +4100,17 @@ static GpStatus SOFTWARE_GdipDrawPath(GpGraphics *graphics, GpPen *pen, GpPath *
     GpMatrix *transform=NULL;
     REAL flatness=1.0;
 
-    /* Check if the final pen thickness in pixels is too thin. */
+    /* Check if the final pen thickness in pixels is too thin. Antialiased
+     * pens of at least one pixel are widened so they get proper coverage. */
     if (pen->unit == UnitPixel)
     {
-        if (pen->width < 1.415)
+        if (pen->width < 1.415 && !(is_antialiased(graphics) && pen->width >= 1.0))
             return SOFTWARE_GdipDrawThinPath(graphics, pen, path);
     }
     else
     {
         GpPointF points[3] = {{0,0}, {1,0}, {0,1}};
+        REAL width_x, width_y;
 
         points[1].X = pen->width;
         points[2].Y = pen->width;
@@ -3865,10 +4121,13 @@ static GpStatus SOFTWARE_GdipDrawPath(GpGraphics *graphics, GpPen *pen, GpPath *
         if (stat != Ok)
             return stat;
 
-        if (((points[1].X-points[0].X)*(points[1].X-points[0].X) +
-             (points[1].Y-points[0].Y)*(points[1].Y-points[0].Y) < 2.0001) &&
-            ((points[2].X-points[0].X)*(points[2].X-points[0].X) +
-             (points[2].Y-points[0].Y)*(points[2].Y-points[0].Y) < 2.0001))
+        width_x = (points[1].X-points[0].X)*(points[1].X-points[0].X) +
+                  (points[1].Y-points[0].Y)*(points[1].Y-points[0].Y);
+        width_y = (points[2].X-points[0].X)*(points[2].X-points[0].X) +
+                  (points[2].Y-points[0].Y)*(points[2].Y-points[0].Y);
+
+        if (width_x < 2.0001 && width_y < 2.0001 &&
+            !(is_antialiased(graphics) && width_x > 0.9999 && width_y > 0.9999))
             return SOFTWARE_GdipDrawThinPath(graphics, pen, path);
     }
 
@@ -3943,7 +4202,8 @@ GpStatus WINGDIPAPI GdipDrawPath(GpGraphics *graphics, GpPen *pen, GpPath *path)
 
     if (graphics->image && graphics->image->type == ImageTypeMetafile)
         retval = METAFILE_DrawPath((GpMetafile*)graphics->image, pen, path);
-    else if (!graphics->hdc || graphics->alpha_hdc || !brush_can_fill_path(pen->brush, FALSE))
+    else if (!graphics->hdc || graphics->alpha_hdc || !brush_can_fill_path(pen->brush, FALSE) ||
+             (is_antialiased(graphics) && brush_can_fill_pixels(pen->brush)))
         retval = SOFTWARE_GdipDrawPath(graphics, pen, path);
     else
         retval = GDI32_GdipDrawPath(graphics, pen, path);
@@ -4229,6 +4489,357 @@ end:
     return retval;
 }
 
+/* Number of sub-scanlines sampled per pixel row when antialiasing. Coverage
+ * along a sub-scanline is computed exactly. */
+#define AA_SUBSCANLINES 16
+#define AA_FULL_COVERAGE (256 * AA_SUBSCANLINES)
+
+struct raster_edge
+{
+    REAL x0, y0;    /* upper end point */
+    REAL y1;        /* lower end, exclusive */
+    REAL dxdy;
+    INT dir;        /* 1 if the edge goes down, -1 if it goes up */
+};
+
+struct raster_crossing
+{
+    REAL x;
+    INT dir;
+};
+
+static int compare_raster_edges(const void *a, const void *b)
+{
+    const struct raster_edge *edge_a = a, *edge_b = b;
+
+    if (edge_a->y0 < edge_b->y0) return -1;
+    if (edge_a->y0 > edge_b->y0) return 1;
+    return 0;
+}
+
+static void add_raster_edge(struct raster_edge *edges, INT *count, const GpPointF *p1, const GpPointF *p2)
+{
+    struct raster_edge *edge;
+
+    if (p1->Y == p2->Y)
+        return;
+
+    edge = &edges[(*count)++];
+
+    if (p1->Y < p2->Y)
+    {
+        edge->x0 = p1->X;
+        edge->y0 = p1->Y;
+        edge->y1 = p2->Y;
+        edge->dir = 1;
+    }
+    else
+    {
+        edge->x0 = p2->X;
+        edge->y0 = p2->Y;
+        edge->y1 = p1->Y;
+        edge->dir = -1;
+    }
+
+    edge->dxdy = (p2->X - p1->X) / (p2->Y - p1->Y);
+}
+
+/* Build the edge table of a flattened path, implicitly closing every figure,
+ * sorted by the upper end of each edge. */
+static GpStatus get_raster_edges(const GpPath *path, struct raster_edge **edges, INT *count)
+{
+    const GpPointF *points = path->pathdata.Points;
+    const BYTE *types = path->pathdata.Types;
+    INT i, start = 0;
+
+    *count = 0;
+    *edges = heap_alloc(sizeof(**edges) * (path->pathdata.Count + 1));
+    if (!*edges)
+        return OutOfMemory;
+
+    for (i = 1; i <= path->pathdata.Count; i++)
+    {
+        if (i == path->pathdata.Count || (types[i] & PathPointTypePathTypeMask) == PathPointTypeStart)
+        {
+            add_raster_edge(*edges, count, &points[i - 1], &points[start]);
+            start = i;
+        }
+        else
+            add_raster_edge(*edges, count, &points[i - 1], &points[i]);
+    }
+
+    qsort(*edges, *count, sizeof(**edges), compare_raster_edges);
+
+    return Ok;
+}
+
+/* Accumulate the coverage of the span [left, right) on one sub-scanline. Fully
+ * covered pixels are recorded as a run so the cost does not depend on the span
+ * length. */
+static void add_coverage_span(INT *partial, INT *runs, INT width, REAL left, REAL right)
+{
+    INT first, last;
+
+    if (left < 0.0) left = 0.0;
+    if (right > width) right = width;
+    if (right <= left) return;
+
+    first = (INT)left;
+    last = (INT)right;
+
+    if (first == last)
+    {
+        partial[first] += gdip_round((right - left) * 256);
+        return;
+    }
+
+    partial[first] += gdip_round((first + 1 - left) * 256);
+    runs[first + 1] += 256;
+    runs[last] -= 256;
+    if (last < width)
+        partial[last] += gdip_round((right - last) * 256);
+}
+
+/* Scan convert a set of edges into per pixel coverage values (0-255) for the
+ * given device rectangle, keeping a table of the edges that cross the current
+ * sub-scanline. */
+static GpStatus rasterize_edges(struct raster_edge *edges, INT edge_count, FillMode fill_mode,
+    const GpRect *area, BYTE *coverage)
+{
+    struct raster_edge **active;
+    struct raster_crossing *crossings;
+    INT *partial, *runs;
+    INT active_count = 0, next_edge = 0;
+    INT x, y, i, j, k, sub;
+
+    active = heap_alloc(sizeof(*active) * edge_count);
+    crossings = heap_alloc(sizeof(*crossings) * edge_count);
+    partial = heap_alloc(sizeof(*partial) * (area->Width + 1) * 2);
+    if (!active || !crossings || !partial)
+    {
+        heap_free(active);
+        heap_free(crossings);
+        heap_free(partial);
+        return OutOfMemory;
+    }
+    runs = partial + area->Width + 1;
+
+    for (y = 0; y < area->Height; y++)
+    {
+        BYTE *row = coverage + y * area->Width;
+        BOOL touched = FALSE;
+
+        if (!active_count && (next_edge == edge_count || edges[next_edge].y0 >= area->Y + y + 1))
+            continue;
+
+        memset(partial, 0, sizeof(*partial) * (area->Width + 1) * 2);
+
+        for (sub = 0; sub < AA_SUBSCANLINES; sub++)
+        {
+            REAL sample_y = area->Y + y + (sub + 0.5) / AA_SUBSCANLINES;
+            INT crossing_count = 0, winding = 0;
+            REAL span_start = 0.0;
+
+            while (next_edge < edge_count && edges[next_edge].y0 <= sample_y)
+                active[active_count++] = &edges[next_edge++];
+
+            for (i = 0, j = 0; i < active_count; i++)
+            {
+                struct raster_edge *edge = active[i];
+                REAL edge_x;
+
+                if (edge->y1 <= sample_y) continue;
+                active[j++] = edge;
+
+                if (edge->y0 > sample_y) continue;
+
+                /* insertion sort; the order rarely changes between sub-scanlines */
+                edge_x = edge->x0 + (sample_y - edge->y0) * edge->dxdy - area->X;
+                for (k = crossing_count; k > 0 && crossings[k - 1].x > edge_x; k--)
+                    crossings[k] = crossings[k - 1];
+                crossings[k].x = edge_x;
+                crossings[k].dir = edge->dir;
+                crossing_count++;
+            }
+            active_count = j;
+
+            for (i = 0; i < crossing_count; i++)
+            {
+                BOOL was_inside, inside;
+
+                if (fill_mode == FillModeAlternate)
+                {
+                    was_inside = winding & 1;
+                    winding++;
+                    inside = winding & 1;
+                }
+                else
+                {
+                    was_inside = winding != 0;
+                    winding += crossings[i].dir;
+                    inside = winding != 0;
+                }
+
+                if (!was_inside && inside)
+                    span_start = crossings[i].x;
+                else if (was_inside && !inside)
+                {
+                    add_coverage_span(partial, runs, area->Width, span_start, crossings[i].x);
+                    touched = TRUE;
+                }
+            }
+        }
+
+        if (!touched) continue;
+
+        for (x = 0, i = 0; x < area->Width; x++)
+        {
+            INT value;
+
+            i += runs[x];
+            value = partial[x] + i;
+
+            if (value <= 0)
+                row[x] = 0;
+            else if (value >= AA_FULL_COVERAGE)
+                row[x] = 255;
+            else
+                row[x] = (value * 255 + AA_FULL_COVERAGE / 2) / AA_FULL_COVERAGE;
+        }
+    }
+
+    heap_free(active);
+    heap_free(crossings);
+    heap_free(partial);
+
+    return Ok;
+}
+
+/* Fill a path with antialiasing by computing the exact coverage of every
+ * pixel it touches, instead of going through an aliased GDI region. */
+static GpStatus SOFTWARE_GdipFillPathAntialiased(GpGraphics *graphics, GpBrush *brush, GpPath *path)
+{
+    GpStatus stat;
+    GpPath *flat_path;
+    GpMatrix world_to_device;
+    GpRectF graphics_bounds;
+    struct raster_edge *edges = NULL;
+    INT edge_count = 0, i, x, y;
+    REAL min_x, min_y, max_x, max_y;
+    GpRect area;
+    BYTE *coverage = NULL;
+    DWORD *pixel_data = NULL;
+
+    stat = gdi_transform_acquire(graphics);
+    if (stat != Ok)
+        return stat;
+
+    stat = get_graphics_device_bounds(graphics, &graphics_bounds);
+
+    if (stat == Ok)
+        stat = get_graphics_transform(graphics, WineCoordinateSpaceGdiDevice,
+            CoordinateSpaceWorld, &world_to_device);
+
+    /* Pixels are centered on integer co-ordinates unless offset by half a pixel. */
+    if (stat == Ok && graphics->pixeloffset != PixelOffsetModeHalf &&
+        graphics->pixeloffset != PixelOffsetModeHighQuality)
+        stat = GdipTranslateMatrix(&world_to_device, 0.5, 0.5, MatrixOrderAppend);
+
+    if (stat == Ok)
+        stat = GdipClonePath(path, &flat_path);
+
+    if (stat != Ok)
+    {
+        gdi_transform_release(graphics);
+        return stat;
+    }
+
+    stat = GdipFlattenPath(flat_path, &world_to_device, 0.25);
+
+    if (stat == Ok)
+        stat = get_raster_edges(flat_path, &edges, &edge_count);
+
+    if (stat == Ok && edge_count)
+    {
+        min_x = max_x = flat_path->pathdata.Points[0].X;
+        min_y = max_y = flat_path->pathdata.Points[0].Y;
+        for (i = 1; i < flat_path->pathdata.Count; i++)
+        {
+            min_x = min(min_x, flat_path->pathdata.Points[i].X);
+            max_x = max(max_x, flat_path->pathdata.Points[i].X);
+            min_y = min(min_y, flat_path->pathdata.Points[i].Y);
+            max_y = max(max_y, flat_path->pathdata.Points[i].Y);
+        }
+
+        min_x = max(min_x, graphics_bounds.X);
+        min_y = max(min_y, graphics_bounds.Y);
+        max_x = min(max_x, graphics_bounds.X + graphics_bounds.Width);
+        max_y = min(max_y, graphics_bounds.Y + graphics_bounds.Height);
+
+        area.X = floorf(min_x);
+        area.Y = floorf(min_y);
+        area.Width = (INT)ceilf(max_x) - area.X;
+        area.Height = (INT)ceilf(max_y) - area.Y;
+
+        if (area.Width > 0 && area.Height > 0)
+        {
+            coverage = heap_alloc_zero(area.Width * area.Height);
+            pixel_data = heap_alloc_zero(sizeof(*pixel_data) * area.Width * area.Height);
+            if (!coverage || !pixel_data)
+                stat = OutOfMemory;
+
+            if (stat == Ok)
+                stat = rasterize_edges(edges, edge_count, flat_path->fill, &area, coverage);
+
+            /* solid colors are only written where there is coverage */
+            if (stat == Ok && brush->bt != BrushTypeSolidColor)
+                stat = brush_fill_pixels(graphics, brush, pixel_data, &area, area.Width);
+
+            if (stat == Ok)
+            {
+                ARGB solid_color = 0;
+
+                if (brush->bt == BrushTypeSolidColor)
+                    solid_color = ((GpSolidFill*)brush)->color;
+
+                for (y = 0; y < area.Height; y++)
+                {
+                    const BYTE *cov = coverage + y * area.Width;
+                    DWORD *pixel = pixel_data + y * area.Width;
+
+                    for (x = 0; x < area.Width; x++)
+                    {
+                        ARGB color;
+
+                        if (!cov[x])
+                        {
+                            pixel[x] = 0;
+                            continue;
+                        }
+
+                        color = brush->bt == BrushTypeSolidColor ? solid_color : pixel[x];
+                        if (cov[x] != 255)
+                            color = ((((color >> 24) * cov[x] + 127) / 255) << 24) | (color & 0xffffff);
+                        pixel[x] = color;
+                    }
+                }
+
+                stat = alpha_blend_pixels_hrgn(graphics, area.X, area.Y, (BYTE*)pixel_data,
+                    area.Width, area.Height, area.Width * 4, NULL, PixelFormat32bppARGB);
+            }
+        }
+    }
+
+    heap_free(pixel_data);
+    heap_free(coverage);
+    heap_free(edges);
+    GdipDeletePath(flat_path);
+
+    gdi_transform_release(graphics);
+
+    return stat;
+}
+
 static GpStatus SOFTWARE_GdipFillPath(GpGraphics *graphics, GpBrush *brush, GpPath *path)
 {
     GpStatus stat;
@@ -4237,6 +4848,9 @@ static GpStatus SOFTWARE_GdipFillPath(GpGraphics *graphics, GpBrush *brush, GpPa
     if (!brush_can_fill_pixels(brush))
         return NotImplemented;
 
+    if (is_antialiased(graphics))
+        return SOFTWARE_GdipFillPathAntialiased(graphics, brush, path);
+
     /* FIXME: This could probably be done more efficiently without regions. */
 
     stat = GdipCreateRegionPath(path, &rgn);
@@ -4269,7 +4883,8 @@ GpStatus WINGDIPAPI GdipFillPath(GpGraphics *graphics, GpBrush *brush, GpPath *p
     if (graphics->image && graphics->image->type == ImageTypeMetafile)
         return METAFILE_FillPath((GpMetafile*)graphics->image, brush, path);
 
-    if (!graphics->image && !graphics->alpha_hdc)
+    if (!graphics->image && !graphics->alpha_hdc &&
+        !(is_antialiased(graphics) && brush_can_fill_pixels(brush)))
         stat = GDI32_GdipFillPath(graphics, brush, path);
 
     if (stat == NotImplemented)
@@ -4941,6 +5556,7 @@ GpStatus WINGDIPAPI GdipGraphicsClear(GpGraphics *graphics, ARGB color)
     GpSolidFill *brush;
     GpStatus stat;
     GpRectF wnd_rect;
+    SmoothingMode smoothing;
 
     TRACE("(%p, %x)\n", graphics, color);
 
@@ -4961,9 +5577,15 @@ GpStatus WINGDIPAPI GdipGraphicsClear(GpGraphics *graphics, ARGB color)
         return stat;
     }
 
+    /* clearing is never antialiased */
+    smoothing = graphics->smoothing;
+    graphics->smoothing = SmoothingModeNone;
+
     GdipFillRectangle(graphics, (GpBrush*)brush, wnd_rect.X, wnd_rect.Y,
                                                  wnd_rect.Width, wnd_rect.Height);
 
+    graphics->smoothing = smoothing;
+
     GdipDeleteBrush((GpBrush*)brush);
 
     return Ok;
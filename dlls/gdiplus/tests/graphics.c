@@ -6792,6 +6792,93 @@ static void test_hdc_caching(void)
     DeleteObject(hbm);
 }
 
+static void test_antialias_fill(void)
+{
+    GpStatus status;
+    GpBitmap *bitmap;
+    GpGraphics *graphics;
+    GpSolidFill *brush;
+    GpPen *pen;
+    GpPointF points[16];
+    ARGB color;
+    DWORD start;
+    int i, j, value;
+
+    status = GdipCreateBitmapFromScan0(400, 300, 0, PixelFormat32bppARGB, NULL, &bitmap);
+    expect(Ok, status);
+    status = GdipGetImageGraphicsContext((GpImage *)bitmap, &graphics);
+    expect(Ok, status);
+    status = GdipCreateSolidFill(0xff000000, &brush);
+    expect(Ok, status);
+
+    status = GdipSetSmoothingMode(graphics, SmoothingModeAntiAlias);
+    expect(Ok, status);
+
+    /* with half pixel offset, pixel n covers [n, n + 1) */
+    status = GdipSetPixelOffsetMode(graphics, PixelOffsetModeHalf);
+    expect(Ok, status);
+    status = GdipGraphicsClear(graphics, 0xffffffff);
+    expect(Ok, status);
+    status = GdipFillRectangle(graphics, (GpBrush *)brush, 2.0, 2.0, 6.5, 4.0);
+    expect(Ok, status);
+
+    GdipBitmapGetPixel(bitmap, 1, 3, &color);
+    expect(0xffffffff, color);
+    GdipBitmapGetPixel(bitmap, 2, 3, &color);
+    expect(0xff000000, color);
+    GdipBitmapGetPixel(bitmap, 7, 3, &color);
+    expect(0xff000000, color);
+    GdipBitmapGetPixel(bitmap, 8, 3, &color);
+    value = color & 0xff;
+    ok(value > 0x60 && value < 0xa0, "got 0x%08x\n", color);
+    GdipBitmapGetPixel(bitmap, 9, 3, &color);
+    expect(0xffffffff, color);
+
+    /* without it, pixel centers are on integer co-ordinates */
+    status = GdipSetPixelOffsetMode(graphics, PixelOffsetModeNone);
+    expect(Ok, status);
+    status = GdipGraphicsClear(graphics, 0xffffffff);
+    expect(Ok, status);
+    status = GdipFillRectangle(graphics, (GpBrush *)brush, 2.0, 2.0, 4.0, 4.0);
+    expect(Ok, status);
+
+    GdipBitmapGetPixel(bitmap, 2, 4, &color);
+    value = color & 0xff;
+    ok(value > 0x60 && value < 0xa0, "got 0x%08x\n", color);
+    GdipBitmapGetPixel(bitmap, 4, 4, &color);
+    expect(0xff000000, color);
+    GdipBitmapGetPixel(bitmap, 6, 4, &color);
+    value = color & 0xff;
+    ok(value > 0x60 && value < 0xa0, "got 0x%08x\n", color);
+
+    /* a chart-like workload of antialiased polylines */
+    status = GdipCreatePen1(0xff0000ff, 1.5, UnitPixel, &pen);
+    expect(Ok, status);
+    status = GdipGraphicsClear(graphics, 0xffffffff);
+    expect(Ok, status);
+
+    start = GetTickCount();
+    for (i = 0; i < 500; i++)
+    {
+        for (j = 0; j < ARRAY_SIZE(points); j++)
+        {
+            points[j].X = 10.0 + j * 25.0;
+            points[j].Y = 150.0 + 120.0 * sin((i + j * 7) * 0.1);
+        }
+        status = GdipDrawLines(graphics, pen, points, ARRAY_SIZE(points));
+        expect(Ok, status);
+    }
+    trace("500 antialiased polylines took %u ms\n", GetTickCount() - start);
+
+    GdipBitmapGetPixel(bitmap, 5, 150, &color);
+    expect(0xffffffff, color);
+
+    GdipDeletePen(pen);
+    GdipDeleteBrush((GpBrush *)brush);
+    GdipDeleteGraphics(graphics);
+    GdipDisposeImage((GpImage *)bitmap);
+}
+
 START_TEST(graphics)
 {
     struct GdiplusStartupInput gdiplusStartupInput;
@@ -6885,6 +6972,7 @@ START_TEST(graphics)
     test_GdipGraphicsSetAbort();
     test_cliphrgn_transform();
     test_hdc_caching();
+    test_antialias_fill();
 
     GdiplusShutdown(gdiplusToken);
     DestroyWindow( hwnd );
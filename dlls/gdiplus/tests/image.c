@@ -4477,6 +4477,96 @@ static void test_DrawImage_scale(void)
     expect(Ok, status);
 }
 
+static void test_DrawImage_resample(void)
+{
+    static const InterpolationMode modes[] =
+    {
+        InterpolationModeNearestNeighbor,
+        InterpolationModeBilinear,
+        InterpolationModeBicubic,
+        InterpolationModeHighQualityBilinear,
+        InterpolationModeHighQualityBicubic,
+    };
+    static const ARGB color = 0xff4080c0;
+    const int src_width = 160, src_height = 120, dst_width = 800, dst_height = 600;
+    GpBitmap *src, *ramp, *dst;
+    GpGraphics *graphics;
+    GpStatus status;
+    ARGB *src_bits, *ramp_bits, *dst_bits;
+    DWORD start;
+    int i, x, y, mismatch;
+
+    src_bits = HeapAlloc(GetProcessHeap(), 0, src_width * src_height * sizeof(ARGB));
+    ramp_bits = HeapAlloc(GetProcessHeap(), 0, src_width * src_height * sizeof(ARGB));
+    dst_bits = HeapAlloc(GetProcessHeap(), 0, dst_width * dst_height * sizeof(ARGB));
+
+    for (y = 0; y < src_height; y++)
+        for (x = 0; x < src_width; x++)
+        {
+            src_bits[x + y * src_width] = color;
+            ramp_bits[x + y * src_width] = 0xff000000 | (x * 255 / (src_width - 1)) * 0x010101;
+        }
+
+    status = GdipCreateBitmapFromScan0(src_width, src_height, src_width * sizeof(ARGB),
+                                       PixelFormat32bppARGB, (BYTE *)src_bits, &src);
+    expect(Ok, status);
+    status = GdipCreateBitmapFromScan0(src_width, src_height, src_width * sizeof(ARGB),
+                                       PixelFormat32bppARGB, (BYTE *)ramp_bits, &ramp);
+    expect(Ok, status);
+    status = GdipCreateBitmapFromScan0(dst_width, dst_height, dst_width * sizeof(ARGB),
+                                       PixelFormat32bppARGB, (BYTE *)dst_bits, &dst);
+    expect(Ok, status);
+    status = GdipGetImageGraphicsContext((GpImage *)dst, &graphics);
+    expect(Ok, status);
+
+    for (i = 0; i < ARRAY_SIZE(modes); i++)
+    {
+        status = GdipSetInterpolationMode(graphics, modes[i]);
+        expect(Ok, status);
+
+        /* a solid image must stay solid away from the edges */
+        memset(dst_bits, 0, dst_width * dst_height * sizeof(ARGB));
+        start = GetTickCount();
+        status = GdipDrawImageRectI(graphics, (GpImage *)src, 0, 0, dst_width, dst_height);
+        expect(Ok, status);
+        trace("mode %d: %dx%d -> %dx%d took %u ms\n", modes[i], src_width, src_height,
+              dst_width, dst_height, GetTickCount() - start);
+
+        mismatch = 0;
+        for (y = 16; y < dst_height - 16; y++)
+            for (x = 16; x < dst_width - 16; x++)
+                if (!color_match(color, dst_bits[x + y * dst_width], 1) && !mismatch++)
+                    ok(0, "mode %d: got 0x%08x at %d,%d\n", modes[i], dst_bits[x + y * dst_width], x, y);
+        ok(!mismatch, "mode %d: %d pixels differ\n", modes[i], mismatch);
+
+        /* downscaling and upscaling a ramp must keep it increasing */
+        memset(dst_bits, 0, dst_width * dst_height * sizeof(ARGB));
+        status = GdipDrawImageRectI(graphics, (GpImage *)ramp, 0, 0, dst_width / 2, dst_height / 2);
+        expect(Ok, status);
+        status = GdipDrawImageRectI(graphics, (GpImage *)ramp, 0, dst_height / 2, dst_width, dst_height / 2);
+        expect(Ok, status);
+
+        for (y = dst_height / 4; y < dst_height; y += dst_height / 2)
+        {
+            int end = y < dst_height / 2 ? dst_width / 2 : dst_width;
+
+            mismatch = 0;
+            for (x = 17; x < end - 16; x++)
+                if ((dst_bits[x + y * dst_width] & 0xff) + 1 < (dst_bits[x - 1 + y * dst_width] & 0xff))
+                    mismatch++;
+            ok(!mismatch, "mode %d, row %d: ramp is not increasing\n", modes[i], y);
+        }
+    }
+
+    GdipDeleteGraphics(graphics);
+    GdipDisposeImage((GpImage *)dst);
+    GdipDisposeImage((GpImage *)ramp);
+    GdipDisposeImage((GpImage *)src);
+    HeapFree(GetProcessHeap(), 0, dst_bits);
+    HeapFree(GetProcessHeap(), 0, ramp_bits);
+    HeapFree(GetProcessHeap(), 0, src_bits);
+}
+
 static const BYTE animatedgif[] = {
 'G','I','F','8','9','a',0x01,0x00,0x01,0x00,0xA1,0x02,0x00,
 0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0a,0x0b,0x0c,
@@ -5515,6 +5605,7 @@ START_TEST(image)
     test_CloneBitmapArea();
     test_ARGB_conversion();
     test_DrawImage_scale();
+    test_DrawImage_resample();
     test_image_format();
     test_DrawImage();
     test_DrawImage_SourceCopy();
@@ -224,6 +224,7 @@ static unsigned push_instr(compiler_ctx_t *ctx, jsop_t op)
     }
 
     ctx->code->instrs[ctx->code_off].op = op;
+    memset(&ctx->code->instrs[ctx->code_off].u, 0, sizeof(ctx->code->instrs[ctx->code_off].u));
     return ctx->code_off++;
 }
 
@@ -352,29 +353,118 @@ static HRESULT push_instr_uint(compiler_ctx_t *ctx, jsop_t op, unsigned arg)
     return S_OK;
 }
 
+static inline INT fold_to_int32(compiler_ctx_t *ctx, double n)
+{
+    INT ret;
+
+    /* Can't fail for numbers. */
+    to_int32(ctx->parser->script, jsval_number(n), &ret);
+    return ret;
+}
+
+/* Evaluates an operation on number constants at compile time. Operands are folded before
+ * their parent, so constants like -1 or 24*60*60 end up as a single OP_double. */
+static BOOL fold_number_operation(compiler_ctx_t *ctx, expression_type_t type, double l, double r, double *ret)
+{
+    switch(type) {
+    case EXPR_MINUS:
+        *ret = -l;
+        break;
+    case EXPR_PLUS:
+        *ret = l;
+        break;
+    case EXPR_BITNEG:
+        *ret = ~fold_to_int32(ctx, l);
+        break;
+    case EXPR_ADD:
+        *ret = l + r;
+        break;
+    case EXPR_SUB:
+        *ret = l - r;
+        break;
+    case EXPR_MUL:
+        *ret = l * r;
+        break;
+    case EXPR_DIV:
+        *ret = l / r;
+        break;
+    case EXPR_MOD:
+        *ret = fmod(l, r);
+        break;
+    case EXPR_BAND:
+        *ret = fold_to_int32(ctx, l) & fold_to_int32(ctx, r);
+        break;
+    case EXPR_BOR:
+        *ret = fold_to_int32(ctx, l) | fold_to_int32(ctx, r);
+        break;
+    case EXPR_BXOR:
+        *ret = fold_to_int32(ctx, l) ^ fold_to_int32(ctx, r);
+        break;
+    case EXPR_LSHIFT:
+        *ret = (INT)((UINT32)fold_to_int32(ctx, l) << (fold_to_int32(ctx, r) & 0x1f));
+        break;
+    case EXPR_RSHIFT:
+        *ret = fold_to_int32(ctx, l) >> (fold_to_int32(ctx, r) & 0x1f);
+        break;
+    case EXPR_RRSHIFT:
+        *ret = (UINT32)fold_to_int32(ctx, l) >> (fold_to_int32(ctx, r) & 0x1f);
+        break;
+    default:
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* checks if the code between off and end is a single number constant */
+static BOOL get_folded_number(compiler_ctx_t *ctx, unsigned off, unsigned end, double *ret)
+{
+    if(end != off+1 || instr_ptr(ctx, off)->op != OP_double)
+        return FALSE;
+
+    *ret = instr_ptr(ctx, off)->u.dbl;
+    return TRUE;
+}
+
 static HRESULT compile_binary_expression(compiler_ctx_t *ctx, binary_expression_t *expr, jsop_t op)
 {
+    unsigned off = ctx->code_off, off2;
+    double l, r, n;
     HRESULT hres;
 
     hres = compile_expression(ctx, expr->expression1, TRUE);
     if(FAILED(hres))
         return hres;
 
+    off2 = ctx->code_off;
     hres = compile_expression(ctx, expr->expression2, TRUE);
     if(FAILED(hres))
         return hres;
 
+    if(get_folded_number(ctx, off, off2, &l) && get_folded_number(ctx, off2, ctx->code_off, &r)
+       && fold_number_operation(ctx, expr->expr.type, l, r, &n)) {
+        ctx->code_off = off;
+        return push_instr_double(ctx, OP_double, n);
+    }
+
     return push_instr(ctx, op) ? S_OK : E_OUTOFMEMORY;
 }
 
 static HRESULT compile_unary_expression(compiler_ctx_t *ctx, unary_expression_t *expr, jsop_t op)
 {
+    unsigned off = ctx->code_off;
+    double n;
     HRESULT hres;
 
     hres = compile_expression(ctx, expr->expression, TRUE);
     if(FAILED(hres))
         return hres;
 
+    if(get_folded_number(ctx, off, ctx->code_off, &n) && fold_number_operation(ctx, expr->expr.type, n, 0, &n)) {
+        ctx->code_off = off;
+        return push_instr_double(ctx, OP_double, n);
+    }
+
     return push_instr(ctx, op) ? S_OK : E_OUTOFMEMORY;
 }
 
@@ -509,8 +599,10 @@ static HRESULT compile_memberid_expression(compiler_ctx_t *ctx, expression_t *ex
     return hres;
 }
 
-static HRESULT compile_increment_expression(compiler_ctx_t *ctx, unary_expression_t *expr, jsop_t op, int n)
+static HRESULT compile_increment_expression(compiler_ctx_t *ctx, unary_expression_t *expr, jsop_t op, int n,
+        BOOL emit_ret)
 {
+    unsigned instr;
     HRESULT hres;
 
     if(!is_memberid_expr(expr->expression->type)) {
@@ -518,14 +610,24 @@ static HRESULT compile_increment_expression(compiler_ctx_t *ctx, unary_expressio
         if(FAILED(hres))
             return hres;
 
-        return push_instr_uint(ctx, OP_throw_ref, JS_E_ILLEGAL_ASSIGN);
+        hres = push_instr_uint(ctx, OP_throw_ref, JS_E_ILLEGAL_ASSIGN);
+        if(FAILED(hres))
+            return hres;
+
+        return emit_ret ? S_OK : push_instr_uint(ctx, OP_pop, 1);
     }
 
     hres = compile_memberid_expression(ctx, expr->expression, fdexNameEnsure);
     if(FAILED(hres))
         return hres;
 
-    return push_instr_int(ctx, op, n);
+    instr = push_instr(ctx, op);
+    if(!instr)
+        return E_OUTOFMEMORY;
+
+    instr_ptr(ctx, instr)->u.arg[0].lng = n;
+    instr_ptr(ctx, instr)->u.arg[1].uint = emit_ret;
+    return S_OK;
 }
 
 /* ECMA-262 3rd Edition    11.14 */
@@ -726,7 +828,7 @@ static HRESULT compile_delete_expression(compiler_ctx_t *ctx, unary_expression_t
     return S_OK;
 }
 
-static HRESULT compile_assign_expression(compiler_ctx_t *ctx, binary_expression_t *expr, jsop_t op)
+static HRESULT compile_assign_expression(compiler_ctx_t *ctx, binary_expression_t *expr, jsop_t op, BOOL emit_ret)
 {
     BOOL use_throw_path = FALSE;
     unsigned arg_cnt = 0;
@@ -776,7 +878,11 @@ static HRESULT compile_assign_expression(compiler_ctx_t *ctx, binary_expression_
         if(op != OP_LAST && !push_instr(ctx, op))
             return E_OUTOFMEMORY;
 
-        return push_instr_uint(ctx, OP_throw_ref, JS_E_ILLEGAL_ASSIGN);
+        hres = push_instr_uint(ctx, OP_throw_ref, JS_E_ILLEGAL_ASSIGN);
+        if(FAILED(hres))
+            return hres;
+
+        return emit_ret ? S_OK : push_instr_uint(ctx, OP_pop, 1);
     }
 
     if(op != OP_LAST && !push_instr(ctx, OP_refval))
@@ -789,13 +895,15 @@ static HRESULT compile_assign_expression(compiler_ctx_t *ctx, binary_expression_
     if(op != OP_LAST && !push_instr(ctx, op))
         return E_OUTOFMEMORY;
 
-    if(arg_cnt)
-        return push_instr_uint(ctx, OP_assign_call, arg_cnt);
+    if(arg_cnt) {
+        hres = push_instr_uint(ctx, OP_assign_call, arg_cnt);
+        if(FAILED(hres))
+            return hres;
 
-    if(!push_instr(ctx, OP_assign))
-        return E_OUTOFMEMORY;
+        return emit_ret ? S_OK : push_instr_uint(ctx, OP_pop, 1);
+    }
 
-    return S_OK;
+    return push_instr_uint(ctx, OP_assign, emit_ret);
 }
 
 static HRESULT compile_typeof_expression(compiler_ctx_t *ctx, unary_expression_t *expr)
@@ -927,41 +1035,29 @@ static HRESULT compile_expression(compiler_ctx_t *ctx, expression_t *expr, BOOL
         hres = compile_array_literal(ctx, (array_literal_expression_t*)expr);
         break;
     case EXPR_ASSIGN:
-        hres = compile_assign_expression(ctx, (binary_expression_t*)expr, OP_LAST);
-        break;
+        return compile_assign_expression(ctx, (binary_expression_t*)expr, OP_LAST, emit_ret);
     case EXPR_ASSIGNADD:
-        hres = compile_assign_expression(ctx, (binary_expression_t*)expr, OP_add);
-        break;
+        return compile_assign_expression(ctx, (binary_expression_t*)expr, OP_add, emit_ret);
     case EXPR_ASSIGNAND:
-        hres = compile_assign_expression(ctx, (binary_expression_t*)expr, OP_and);
-        break;
+        return compile_assign_expression(ctx, (binary_expression_t*)expr, OP_and, emit_ret);
     case EXPR_ASSIGNSUB:
-        hres = compile_assign_expression(ctx, (binary_expression_t*)expr, OP_sub);
-        break;
+        return compile_assign_expression(ctx, (binary_expression_t*)expr, OP_sub, emit_ret);
     case EXPR_ASSIGNMUL:
-        hres = compile_assign_expression(ctx, (binary_expression_t*)expr, OP_mul);
-        break;
+        return compile_assign_expression(ctx, (binary_expression_t*)expr, OP_mul, emit_ret);
     case EXPR_ASSIGNDIV:
-        hres = compile_assign_expression(ctx, (binary_expression_t*)expr, OP_div);
-        break;
+        return compile_assign_expression(ctx, (binary_expression_t*)expr, OP_div, emit_ret);
     case EXPR_ASSIGNMOD:
-        hres = compile_assign_expression(ctx, (binary_expression_t*)expr, OP_mod);
-        break;
+        return compile_assign_expression(ctx, (binary_expression_t*)expr, OP_mod, emit_ret);
     case EXPR_ASSIGNOR:
-        hres = compile_assign_expression(ctx, (binary_expression_t*)expr, OP_or);
-        break;
+        return compile_assign_expression(ctx, (binary_expression_t*)expr, OP_or, emit_ret);
     case EXPR_ASSIGNLSHIFT:
-        hres = compile_assign_expression(ctx, (binary_expression_t*)expr, OP_lshift);
-        break;
+        return compile_assign_expression(ctx, (binary_expression_t*)expr, OP_lshift, emit_ret);
     case EXPR_ASSIGNRSHIFT:
-        hres = compile_assign_expression(ctx, (binary_expression_t*)expr, OP_rshift);
-        break;
+        return compile_assign_expression(ctx, (binary_expression_t*)expr, OP_rshift, emit_ret);
     case EXPR_ASSIGNRRSHIFT:
-        hres = compile_assign_expression(ctx, (binary_expression_t*)expr, OP_rshift2);
-        break;
+        return compile_assign_expression(ctx, (binary_expression_t*)expr, OP_rshift2, emit_ret);
     case EXPR_ASSIGNXOR:
-        hres = compile_assign_expression(ctx, (binary_expression_t*)expr, OP_xor);
-        break;
+        return compile_assign_expression(ctx, (binary_expression_t*)expr, OP_xor, emit_ret);
     case EXPR_BAND:
         hres = compile_binary_expression(ctx, (binary_expression_t*)expr, OP_and);
         break;
@@ -1050,17 +1146,13 @@ static HRESULT compile_expression(compiler_ctx_t *ctx, expression_t *expr, BOOL
         hres = compile_unary_expression(ctx, (unary_expression_t*)expr, OP_tonum);
         break;
     case EXPR_POSTDEC:
-        hres = compile_increment_expression(ctx, (unary_expression_t*)expr, OP_postinc, -1);
-        break;
+        return compile_increment_expression(ctx, (unary_expression_t*)expr, OP_postinc, -1, emit_ret);
     case EXPR_POSTINC:
-        hres = compile_increment_expression(ctx, (unary_expression_t*)expr, OP_postinc, 1);
-        break;
+        return compile_increment_expression(ctx, (unary_expression_t*)expr, OP_postinc, 1, emit_ret);
     case EXPR_PREDEC:
-        hres = compile_increment_expression(ctx, (unary_expression_t*)expr, OP_preinc, -1);
-        break;
+        return compile_increment_expression(ctx, (unary_expression_t*)expr, OP_preinc, -1, emit_ret);
     case EXPR_PREINC:
-        hres = compile_increment_expression(ctx, (unary_expression_t*)expr, OP_preinc, 1);
-        break;
+        return compile_increment_expression(ctx, (unary_expression_t*)expr, OP_preinc, 1, emit_ret);
     case EXPR_PROPVAL:
         hres = compile_object_literal(ctx, (property_value_expression_t*)expr);
         break;
@@ -1134,10 +1226,7 @@ static HRESULT compile_variable_list(compiler_ctx_t *ctx, variable_declaration_t
         if(FAILED(hres))
             return hres;
 
-        if(!push_instr(ctx, OP_assign))
-            return E_OUTOFMEMORY;
-
-        hres = push_instr_uint(ctx, OP_pop, 1);
+        hres = push_instr_uint(ctx, OP_assign, FALSE);
         if(FAILED(hres))
             return hres;
     }
@@ -1106,6 +1106,15 @@ HRESULT jsdisp_get_id(jsdisp_t *jsdisp, const WCHAR *name, DWORD flags, DISPID *
     return DISP_E_UNKNOWNNAME;
 }
 
+/* Checks if id, previously returned by jsdisp_get_id for the same name, possibly on another
+   object, identifies the property that name lookup would find. */
+BOOL jsdisp_is_prop_id(jsdisp_t *jsdisp, DISPID id, const WCHAR *name)
+{
+    dispex_prop_t *prop = get_prop(jsdisp, id);
+
+    return prop && !wcscmp(prop->name, name);
+}
+
 HRESULT jsdisp_call_value(jsdisp_t *jsfunc, IDispatch *jsthis, WORD flags, unsigned argc, jsval_t *argv, jsval_t *r)
 {
     HRESULT hres;
@@ -474,6 +474,32 @@ static HRESULT disp_get_id(script_ctx_t *ctx, IDispatch *disp, const WCHAR *name
     return hres;
 }
 
+/* Property access instructions keep the last id they resolved in their second argument.
+ * Objects built the same way (by the same constructor or object literal) get their
+ * properties in the same order, so the cached id usually matches other instances too,
+ * skipping name hashing and prototype chain lookup. */
+static HRESULT disp_get_id_cached(script_ctx_t *ctx, IDispatch *disp, const WCHAR *name, BSTR name_bstr,
+        DWORD flags, DISPID *id)
+{
+    call_frame_t *frame = ctx->call_ctx;
+    instr_arg_t *cache = &frame->bytecode->instrs[frame->ip].u.arg[1];
+    jsdisp_t *jsdisp;
+    HRESULT hres;
+
+    if(!(jsdisp = to_jsdisp(disp)))
+        return disp_get_id(ctx, disp, name, name_bstr, flags, id);
+
+    if(cache->lng && jsdisp_is_prop_id(jsdisp, cache->lng, name)) {
+        *id = cache->lng;
+        return S_OK;
+    }
+
+    hres = jsdisp_get_id(jsdisp, name, flags, id);
+    if(SUCCEEDED(hres))
+        cache->lng = *id;
+    return hres;
+}
+
 static HRESULT disp_cmp(IDispatch *disp1, IDispatch *disp2, BOOL *ret)
 {
     IObjectIdentity *identity;
@@ -1069,7 +1095,7 @@ static HRESULT interp_member(script_ctx_t *ctx)
     if(FAILED(hres))
         return hres;
 
-    hres = disp_get_id(ctx, obj, arg, arg, 0, &id);
+    hres = disp_get_id_cached(ctx, obj, arg, arg, 0, &id);
     if(SUCCEEDED(hres)) {
         hres = disp_propget(ctx, obj, id, &v);
     }else if(hres == DISP_E_UNKNOWNNAME) {
@@ -1111,7 +1137,7 @@ static HRESULT interp_memberid(script_ctx_t *ctx)
     if(FAILED(hres))
         return hres;
 
-    hres = disp_get_id(ctx, obj, name, NULL, arg, &id);
+    hres = disp_get_id_cached(ctx, obj, name, NULL, arg, &id);
     jsstr_release(name_str);
     if(SUCCEEDED(hres)) {
         ref.type = EXPRVAL_IDREF;
@@ -1689,6 +1715,11 @@ static HRESULT add_eval(script_ctx_t *ctx, jsval_t lval, jsval_t rval, jsval_t *
     jsval_t r, l;
     HRESULT hres;
 
+    if(is_number(lval) && is_number(rval)) {
+        *ret = jsval_number(get_number(lval)+get_number(rval));
+        return S_OK;
+    }
+
     hres = to_primitive(ctx, lval, &l, NO_HINT);
     if(FAILED(hres))
         return hres;
@@ -2063,6 +2094,7 @@ static HRESULT interp_tonum(script_ctx_t *ctx)
 static HRESULT interp_postinc(script_ctx_t *ctx)
 {
     const int arg = get_op_int(ctx, 0);
+    const unsigned emit_ret = get_op_uint(ctx, 1);
     exprval_t ref;
     jsval_t v;
     HRESULT hres;
@@ -2079,11 +2111,11 @@ static HRESULT interp_postinc(script_ctx_t *ctx)
         hres = to_number(ctx, v, &n);
         if(SUCCEEDED(hres))
             hres = exprval_propput(ctx, &ref, jsval_number(n+(double)arg));
-        if(FAILED(hres))
+        if(FAILED(hres) || !emit_ret)
             jsval_release(v);
     }
     exprval_release(&ref);
-    if(FAILED(hres))
+    if(FAILED(hres) || !emit_ret)
         return hres;
 
     return stack_push(ctx, v);
@@ -2093,6 +2125,7 @@ static HRESULT interp_postinc(script_ctx_t *ctx)
 static HRESULT interp_preinc(script_ctx_t *ctx)
 {
     const int arg = get_op_int(ctx, 0);
+    const unsigned emit_ret = get_op_uint(ctx, 1);
     exprval_t ref;
     double ret;
     jsval_t v;
@@ -2115,7 +2148,7 @@ static HRESULT interp_preinc(script_ctx_t *ctx)
         }
     }
     exprval_release(&ref);
-    if(FAILED(hres))
+    if(FAILED(hres) || !emit_ret)
         return hres;
 
     return stack_push(ctx, jsval_number(ret));
@@ -2292,6 +2325,13 @@ static HRESULT less_eval(script_ctx_t *ctx, jsval_t lval, jsval_t rval, BOOL gre
     jsval_t l, r;
     HRESULT hres;
 
+    if(is_number(lval) && is_number(rval)) {
+        ln = get_number(lval);
+        rn = get_number(rval);
+        *ret = !isnan(ln) && !isnan(rn) && ((ln < rn) ^ greater);
+        return S_OK;
+    }
+
     hres = to_primitive(ctx, lval, &l, NO_HINT);
     if(FAILED(hres))
         return hres;
@@ -2497,11 +2537,12 @@ static HRESULT interp_rshift2(script_ctx_t *ctx)
 /* ECMA-262 3rd Edition    11.13.1 */
 static HRESULT interp_assign(script_ctx_t *ctx)
 {
+    const unsigned emit_ret = get_op_uint(ctx, 0);
     exprval_t ref;
     jsval_t v;
     HRESULT hres;
 
-    TRACE("\n");
+    TRACE("%u\n", emit_ret);
 
     v = stack_pop(ctx);
 
@@ -2512,7 +2553,7 @@ static HRESULT interp_assign(script_ctx_t *ctx)
 
     hres = exprval_propput(ctx, &ref, v);
     exprval_release(&ref);
-    if(FAILED(hres)) {
+    if(FAILED(hres) || !emit_ret) {
         jsval_release(v);
         return hres;
     }
@@ -20,7 +20,7 @@
     X(add,        1, 0,0)                  \
     X(and,        1, 0,0)                  \
     X(array,      1, 0,0)                  \
-    X(assign,     1, 0,0)                  \
+    X(assign,     1, ARG_UINT,   0)        \
     X(assign_call,1, ARG_UINT,   0)        \
     X(bool,       1, ARG_INT,    0)        \
     X(bneg,       1, 0,0)                  \
@@ -71,8 +71,8 @@
     X(pop,        1, ARG_UINT,   0)        \
     X(pop_except, 0, ARG_ADDR,   0)        \
     X(pop_scope,  1, 0,0)                  \
-    X(postinc,    1, ARG_INT,    0)        \
-    X(preinc,     1, ARG_INT,    0)        \
+    X(postinc,    1, ARG_INT,    ARG_UINT) \
+    X(preinc,     1, ARG_INT,    ARG_UINT) \
     X(push_acc,   1, 0,0)                  \
     X(push_except,1, ARG_ADDR,   ARG_UINT) \
     X(push_scope, 1, 0,0)                  \
@@ -34,10 +34,17 @@
  */
 #define JSSTR_MAX_ROPE_DEPTH 100
 
+/*
+ * Builder strings allocate their buffers with room for this many times their length,
+ * so that appending to them has amortized linear cost.
+ */
+#define JSSTR_BUILDER_GROWTH 2
+
 const char *debugstr_jsstr(jsstr_t *str)
 {
     return jsstr_is_inline(str) ? debugstr_wn(jsstr_as_inline(str)->buf, jsstr_length(str))
         : jsstr_is_heap(str) ? debugstr_wn(jsstr_as_heap(str)->buf, jsstr_length(str))
+        : jsstr_is_builder(str) ? debugstr_wn(jsstr_as_builder(str)->buffer->buf, jsstr_length(str))
         : wine_dbg_sprintf("%s...", debugstr_jsstr(jsstr_as_rope(str)->left));
 }
 
@@ -53,6 +60,14 @@ void jsstr_free(jsstr_t *str)
         jsstr_release(rope->right);
         break;
     }
+    case JSSTR_BUILDER: {
+        jsstr_buffer_t *buffer = jsstr_as_builder(str)->buffer;
+        if(!--buffer->ref) {
+            heap_free(buffer->buf);
+            heap_free(buffer);
+        }
+        break;
+    }
     case JSSTR_INLINE:
         break;
     }
@@ -121,6 +136,9 @@ void jsstr_extract(jsstr_t *str, unsigned off, unsigned len, WCHAR *buf)
         return;
     case JSSTR_ROPE:
         return jsstr_rope_extract(jsstr_as_rope(str), off, len, buf);
+    case JSSTR_BUILDER:
+        memcpy(buf, jsstr_as_builder(str)->buffer->buf+off, len*sizeof(WCHAR));
+        return;
     }
 }
 
@@ -135,6 +153,9 @@ static int jsstr_cmp_str(jsstr_t *jsstr, const WCHAR *str, unsigned len)
     case JSSTR_HEAP:
         ret = memcmp(jsstr_as_heap(jsstr)->buf, str, len*sizeof(WCHAR));
         return ret || jsstr_length(jsstr) == len ? ret : 1;
+    case JSSTR_BUILDER:
+        ret = memcmp(jsstr_as_builder(jsstr)->buffer->buf, str, len*sizeof(WCHAR));
+        return ret || jsstr_length(jsstr) == len ? ret : 1;
     case JSSTR_ROPE: {
         jsstr_rope_t *rope = jsstr_as_rope(jsstr);
         unsigned left_len = jsstr_length(rope->left);
@@ -152,11 +173,11 @@ static int jsstr_cmp_str(jsstr_t *jsstr, const WCHAR *str, unsigned len)
 
 #define TMP_BUF_SIZE 256
 
-static int ropes_cmp(jsstr_rope_t *left, jsstr_rope_t *right)
+static int ropes_cmp(jsstr_t *left, jsstr_t *right)
 {
     WCHAR left_buf[TMP_BUF_SIZE], right_buf[TMP_BUF_SIZE];
-    unsigned left_len = jsstr_length(&left->str);
-    unsigned right_len = jsstr_length(&right->str);
+    unsigned left_len = jsstr_length(left);
+    unsigned right_len = jsstr_length(right);
     unsigned cmp_off = 0, cmp_size;
     int ret;
 
@@ -166,9 +187,9 @@ static int ropes_cmp(jsstr_rope_t *left, jsstr_rope_t *right)
         if(cmp_size > TMP_BUF_SIZE)
             cmp_size = TMP_BUF_SIZE;
 
-        jsstr_rope_extract(left, cmp_off, cmp_size, left_buf);
-        jsstr_rope_extract(right, cmp_off, cmp_size, right_buf);
-        ret = memcmp(left_buf, right_buf, cmp_size);
+        jsstr_extract(left, cmp_off, cmp_size, left_buf);
+        jsstr_extract(right, cmp_off, cmp_size, right_buf);
+        ret = memcmp(left_buf, right_buf, cmp_size*sizeof(WCHAR));
         if(ret)
             return ret;
 
@@ -204,7 +225,53 @@ int jsstr_cmp(jsstr_t *str1, jsstr_t *str2)
         return ret || len1 == len2 ? -ret : 1;
     }
 
-    return ropes_cmp(jsstr_as_rope(str1), jsstr_as_rope(str2));
+    return ropes_cmp(str1, str2);
+}
+
+static jsstr_t *jsstr_alloc_builder(jsstr_buffer_t *buffer, unsigned len)
+{
+    jsstr_builder_t *ret;
+
+    ret = heap_alloc(sizeof(*ret));
+    if(!ret)
+        return NULL;
+
+    jsstr_init(&ret->str, len, JSSTR_BUILDER);
+    ret->buffer = buffer;
+    buffer->ref++;
+    return &ret->str;
+}
+
+static jsstr_t *builder_concat(jsstr_t *str1, jsstr_t *str2)
+{
+    unsigned len = jsstr_length(str1) + jsstr_length(str2);
+    jsstr_buffer_t *buffer;
+    jsstr_t *ret;
+
+    if(len > JSSTR_MAX_LENGTH)
+        return NULL;
+
+    buffer = heap_alloc(sizeof(*buffer));
+    if(!buffer)
+        return NULL;
+
+    buffer->size = min(len * JSSTR_BUILDER_GROWTH, JSSTR_MAX_LENGTH);
+    buffer->buf = heap_alloc((buffer->size+1) * sizeof(WCHAR));
+    if(!buffer->buf) {
+        heap_free(buffer);
+        return NULL;
+    }
+
+    buffer->ref = 0;
+    buffer->len = jsstr_flush(str1, buffer->buf);
+    buffer->len += jsstr_flush(str2, buffer->buf+buffer->len);
+
+    ret = jsstr_alloc_builder(buffer, len);
+    if(!ret) {
+        heap_free(buffer->buf);
+        heap_free(buffer);
+    }
+    return ret;
 }
 
 jsstr_t *jsstr_concat(jsstr_t *str1, jsstr_t *str2)
@@ -221,6 +288,18 @@ jsstr_t *jsstr_concat(jsstr_t *str1, jsstr_t *str2)
     if(!len2)
         return jsstr_addref(str1);
 
+    if(jsstr_is_builder(str1) && jsstr_as_builder(str1)->buffer->len == len1) {
+        jsstr_buffer_t *buffer = jsstr_as_builder(str1)->buffer;
+
+        /* Nothing was appended to str1 yet, so we may write directly after it. */
+        if(buffer->size - len1 >= len2) {
+            buffer->len += jsstr_flush(str2, buffer->buf+len1);
+            return jsstr_alloc_builder(buffer, len1+len2);
+        }
+
+        return builder_concat(str1, str2);
+    }
+
     if(len1 + len2 >= JSSTR_SHORT_STRING_LENGTH) {
         unsigned depth, depth2;
         jsstr_rope_t *rope;
@@ -244,6 +323,9 @@ jsstr_t *jsstr_concat(jsstr_t *str1, jsstr_t *str2)
             rope->depth = depth;
             return &rope->str;
         }
+
+        /* Too deep rope, most likely built by appending in a loop. */
+        return builder_concat(str1, str2);
     }
 
     ret = jsstr_alloc_buf(len1+len2, &ptr);
@@ -277,6 +359,35 @@ const WCHAR *jsstr_rope_flatten(jsstr_rope_t *str)
     return jsstr_as_heap(&str->str)->buf = buf;
 }
 
+C_ASSERT(sizeof(jsstr_heap_t) <= sizeof(jsstr_builder_t));
+
+const WCHAR *jsstr_builder_flatten(jsstr_builder_t *str)
+{
+    jsstr_buffer_t *buffer = str->buffer;
+    unsigned len = jsstr_length(&str->str);
+    WCHAR *buf;
+
+    if(buffer->ref == 1) {
+        /* We're the only user of the buffer, take it over. */
+        buf = heap_realloc(buffer->buf, (len+1) * sizeof(WCHAR));
+        if(!buf)
+            buf = buffer->buf;
+        heap_free(buffer);
+    }else {
+        buf = heap_alloc((len+1) * sizeof(WCHAR));
+        if(!buf)
+            return NULL;
+
+        memcpy(buf, buffer->buf, len*sizeof(WCHAR));
+        buffer->ref--;
+    }
+    buf[len] = 0;
+
+    /* Transform to heap string */
+    str->str.length_flags |= JSSTR_HEAP;
+    return jsstr_as_heap(&str->str)->buf = buf;
+}
+
 static jsstr_t *empty_str, *nan_str, *undefined_str, *null_bstr_str;
 
 jsstr_t *jsstr_nan(void)
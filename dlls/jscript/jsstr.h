@@ -24,11 +24,14 @@
  * - heap string - a structure containing a pointer to buffer on the heap.
  * - roper string - a product of concatenation of two strings. Instead of copying whole
  *   buffers, we may store just references to concatenated strings.
+ * - builder string - a prefix of a growable buffer shared by strings created by appending
+ *   to each other. Appending to the string that owns the end of the buffer writes the new
+ *   characters in place, so that building a long string by repeated concatenation is linear.
  *
- * String layout may change over life time of the string. Currently possible transformation
- * is when a rope string becomes a heap stream. That happens when we need a real, linear
- * zero-terminated buffer (a flat buffer). At this point the type of the string is changed
- * and the new buffer is stored in the string, so that subsequent operations requiring
+ * String layout may change over life time of the string. Currently possible transformations
+ * are when a rope or builder string becomes a heap stream. That happens when we need a real,
+ * linear zero-terminated buffer (a flat buffer). At this point the type of the string is
+ * changed and the new buffer is stored in the string, so that subsequent operations requiring
  * a flat string won't need to flatten it again.
  *
  * In the future more layouts and transformations may be added.
@@ -47,6 +50,7 @@ struct _jsstr_t {
 #define JSSTR_FLAG_TAG_MASK 3
 
 typedef enum {
+    JSSTR_BUILDER = 0,
     JSSTR_INLINE = JSSTR_FLAG_FLAT,
     JSSTR_HEAP   = JSSTR_FLAG_FLAT|JSSTR_FLAG_LBIT,
     JSSTR_ROPE   = JSSTR_FLAG_LBIT
@@ -77,6 +81,11 @@ static inline BOOL jsstr_is_rope(jsstr_t *str)
     return jsstr_tag(str) == JSSTR_ROPE;
 }
 
+static inline BOOL jsstr_is_builder(jsstr_t *str)
+{
+    return jsstr_tag(str) == JSSTR_BUILDER;
+}
+
 typedef struct {
     jsstr_t str;
     WCHAR buf[1];
@@ -94,6 +103,18 @@ typedef struct {
     unsigned depth;
 } jsstr_rope_t;
 
+typedef struct {
+    unsigned ref;
+    unsigned len;   /* length of the longest string using the buffer */
+    unsigned size;  /* capacity, not including space for the terminating null */
+    WCHAR *buf;
+} jsstr_buffer_t;
+
+typedef struct {
+    jsstr_t str;
+    jsstr_buffer_t *buffer;
+} jsstr_builder_t;
+
 jsstr_t *jsstr_alloc_len(const WCHAR*,unsigned) DECLSPEC_HIDDEN;
 jsstr_t *jsstr_alloc_buf(unsigned,WCHAR**) DECLSPEC_HIDDEN;
 
@@ -131,13 +152,20 @@ static inline jsstr_rope_t *jsstr_as_rope(jsstr_t *str)
     return CONTAINING_RECORD(str, jsstr_rope_t, str);
 }
 
+static inline jsstr_builder_t *jsstr_as_builder(jsstr_t *str)
+{
+    return CONTAINING_RECORD(str, jsstr_builder_t, str);
+}
+
 const WCHAR *jsstr_rope_flatten(jsstr_rope_t*) DECLSPEC_HIDDEN;
+const WCHAR *jsstr_builder_flatten(jsstr_builder_t*) DECLSPEC_HIDDEN;
 
 static inline const WCHAR *jsstr_flatten(jsstr_t *str)
 {
     return jsstr_is_inline(str) ? jsstr_as_inline(str)->buf
         : jsstr_is_heap(str) ? jsstr_as_heap(str)->buf
-        : jsstr_rope_flatten(jsstr_as_rope(str));
+        : jsstr_is_rope(str) ? jsstr_rope_flatten(jsstr_as_rope(str))
+        : jsstr_builder_flatten(jsstr_as_builder(str));
 }
 
 void jsstr_extract(jsstr_t*,unsigned,unsigned,WCHAR*) DECLSPEC_HIDDEN;
@@ -149,6 +177,8 @@ static inline unsigned jsstr_flush(jsstr_t *str, WCHAR *buf)
         memcpy(buf, jsstr_as_inline(str)->buf, len*sizeof(WCHAR));
     }else if(jsstr_is_heap(str)) {
         memcpy(buf, jsstr_as_heap(str)->buf, len*sizeof(WCHAR));
+    }else if(jsstr_is_builder(str)) {
+        memcpy(buf, jsstr_as_builder(str)->buffer->buf, len*sizeof(WCHAR));
     }else {
         jsstr_rope_t *rope = jsstr_as_rope(str);
         jsstr_flush(rope->left, buf);
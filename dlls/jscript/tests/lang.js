@@ -1867,6 +1867,114 @@ function returnTest() {
 
 ok(returnTest() === undefined, "returnTest = " + returnTest());
 
+ok(1/-0 === -Infinity, "1/-0 = " + (1/-0));
+ok(-(1+2)*3 === -9, "-(1+2)*3 = " + (-(1+2)*3));
+ok("1"+2+3 === "123", "\"1\"+2+3 = " + ("1"+2+3));
+ok(1+2+"3" === "33", "1+2+\"3\" = " + (1+2+"3"));
+ok(~~7.5 === 7, "~~7.5 = " + (~~7.5));
+ok(5 % -3 === 2, "5 % -3 = " + (5 % -3));
+
+function testLongChains() {
+    var i, x = 1, src = "x";
+
+    for(i = 0; i < 1000; i++)
+        src += "+1";
+    ok(eval(src) === 1001, "x+1+...+1 = " + eval(src));
+    ok(eval(src.substr(1)) === 1000, "+1+...+1 = " + eval(src.substr(1)));
+    ok(eval(src + "+'x'") === "1001x", "x+1+...+1+'x' = " + eval(src + "+'x'"));
+}
+
+testLongChains();
+
+function testUnusedResults() {
+    var i, x = 1, y;
+
+    for(i = 0; i < 3; i++)
+        x += i;
+    ok(i === 3, "i = " + i);
+    ok(x === 4, "x = " + x);
+
+    x++, --x, y = x = 6;
+    ok(x === 6, "x = " + x);
+    ok(y === 6, "y = " + y);
+
+    ok((x = 7) === 7, "x = 7 returned " + x);
+    ok(x++ === 7, "x++ !== 7");
+    ok(++x === 9, "++x !== 9");
+    ok(eval("x = 10") === 10, "eval(\"x = 10\") !== 10");
+    ok(eval("x++") === 10, "eval(\"x++\") !== 10");
+    ok(x === 11, "x = " + x);
+}
+
+testUnusedResults();
+
+function testStringAppend() {
+    var s = "", a, b, c, i;
+
+    for(i = 0; i < 1000; i++)
+        s += "x";
+    ok(s.length === 1000, "s.length = " + s.length);
+
+    a = s + "a";
+    b = s + "b";
+    c = a + "c";
+    ok(s.length === 1000, "s.length = " + s.length);
+    ok(a.length === 1001 && a.charAt(1000) === "a", "a.charAt(1000) = " + a.charAt(1000));
+    ok(b.length === 1001 && b.charAt(1000) === "b", "b.charAt(1000) = " + b.charAt(1000));
+    ok(c.length === 1002 && c.substr(1000) === "ac", "c.substr(1000) = " + c.substr(1000));
+    ok(a < b, "a >= b");
+    ok(a !== b, "a === b");
+    ok(a === s + "a", "a !== s + \"a\"");
+    ok(s.indexOf("a") === -1, "s.indexOf(\"a\") = " + s.indexOf("a"));
+}
+
+testStringAppend();
+
+function PropTestObj(x, y) {
+    this.x = x;
+    this.y = y;
+}
+PropTestObj.prototype.z = "proto";
+
+function propTestGet(o) {
+    return o.x + "," + o.y + "," + o.z;
+}
+
+/* Same member access instructions used with objects of different layouts. */
+(function() {
+    var objs = [new PropTestObj(1, 2), {y: 3, x: 4}, new PropTestObj(5, 6), {x: 7}, new PropTestObj(8, 9)];
+    var expected = ["1,2,proto", "4,3,undefined", "5,6,proto", "7,undefined,undefined", "8,9,proto"];
+    var i, j;
+
+    for(j = 0; j < 3; j++) {
+        for(i = 0; i < objs.length; i++)
+            ok(propTestGet(objs[i]) === expected[i], "propTestGet(objs[" + i + "]) = " + propTestGet(objs[i]));
+    }
+
+    delete objs[2].x;
+    ok(propTestGet(objs[2]) === "undefined,6,proto", "propTestGet(objs[2]) = " + propTestGet(objs[2]));
+    objs[2].x = 10;
+    ok(propTestGet(objs[2]) === "10,6,proto", "propTestGet(objs[2]) = " + propTestGet(objs[2]));
+
+    objs[4].z = "own";
+    ok(propTestGet(objs[4]) === "8,9,own", "propTestGet(objs[4]) = " + propTestGet(objs[4]));
+    ok(propTestGet(objs[0]) === "1,2,proto", "propTestGet(objs[0]) = " + propTestGet(objs[0]));
+    delete objs[4].z;
+    ok(propTestGet(objs[4]) === "8,9,proto", "propTestGet(objs[4]) = " + propTestGet(objs[4]));
+
+    PropTestObj.prototype.z = "changed";
+    ok(propTestGet(objs[0]) === "1,2,changed", "propTestGet(objs[0]) = " + propTestGet(objs[0]));
+    delete PropTestObj.prototype.z;
+    ok(propTestGet(objs[0]) === "1,2,undefined", "propTestGet(objs[0]) = " + propTestGet(objs[0]));
+
+    for(i = 0; i < objs.length; i++)
+        objs[i].x += 100;
+    ok(objs[0].x === 101, "objs[0].x = " + objs[0].x);
+    ok(objs[1].x === 104, "objs[1].x = " + objs[1].x);
+    ok(objs[3].x === 107, "objs[3].x = " + objs[3].x);
+    ok(objs[1].y === 3, "objs[1].y = " + objs[1].y);
+})();
+
 ActiveXObject = 1;
 ok(ActiveXObject === 1, "ActiveXObject = " + ActiveXObject);
 
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2019 Wine Project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/* Property get and put on many objects sharing the same layout. */
+
+function Point(x, y) {
+    this.x = x;
+    this.y = y;
+}
+
+Point.prototype.scale = 2;
+
+var points = [], i, j, sum = 0;
+
+for(i = 0; i < 1000; i++)
+    points.push(new Point(i, -i));
+
+for(j = 0; j < 50; j++) {
+    for(i = 0; i < points.length; i++) {
+        var p = points[i];
+        p.x = p.x + p.y * p.scale;
+        p.y = -p.y;
+        sum += p.x;
+    }
+}
+
+for(j = 0; j < 50; j++) {
+    for(i = 0; i < 1000; i++) {
+        var o = {a: i, b: j, c: i + j};
+        sum += o.a + o.b - o.c;
+    }
+}
+
+points = null;
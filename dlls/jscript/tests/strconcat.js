@@ -0,0 +1,34 @@
+/*
+ * Copyright 2019 Wine Project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+
+/* Build long strings by appending in a loop and then use the result. */
+
+var s = "", t, i;
+
+for(i = 0; i < 100000; i++)
+    s += "line " + i + "\n";
+
+t = s;
+for(i = 0; i < 1000; i++)
+    t += s.charAt(i);
+
+if(t.length !== s.length + 1000 || t.indexOf("line 99999\n") === -1)
+    throw "unexpected result";
+
+s = t = null;
@@ -113,6 +113,7 @@ static const MSIVIEWOPS drop_ops =
     NULL,
     NULL,
     NULL,
+    NULL,
 };
 
 UINT DROP_CreateView(MSIDATABASE *db, MSIVIEW **view, LPCWSTR name)
@@ -120,6 +120,165 @@ static void CDECL cabinet_free(void *pv)
     msi_free(pv);
 }
 
+/*
+ * Files extracted from cabinets are written by a separate thread, so that
+ * decompressing the next blocks overlaps with writing out the previous ones.
+ * Operations are processed in the order they were queued.
+ */
+#define MAX_QUEUED_BYTES (8 * 1024 * 1024)
+
+enum write_op_type
+{
+    WRITE_OP_WRITE,
+    WRITE_OP_SET_TIME,
+    WRITE_OP_CLOSE
+};
+
+struct write_op
+{
+    struct list entry;
+    enum write_op_type type;
+    HANDLE handle;
+    FILETIME time;
+    UINT size;
+    BYTE data[1];
+};
+
+struct file_writer
+{
+    CRITICAL_SECTION cs;
+    CONDITION_VARIABLE cv;
+    struct list ops;
+    UINT queued;   /* number of bytes waiting to be written */
+    BOOL busy;     /* an operation is being processed */
+    BOOL shutdown;
+    DWORD error;   /* first error encountered */
+    HANDLE thread;
+};
+
+static struct file_writer *file_writer;
+
+static DWORD WINAPI file_writer_proc( void *arg )
+{
+    struct file_writer *writer = arg;
+    struct write_op *op;
+    DWORD written;
+    BOOL ret;
+
+    EnterCriticalSection( &writer->cs );
+    for (;;)
+    {
+        while (list_empty( &writer->ops ) && !writer->shutdown)
+            SleepConditionVariableCS( &writer->cv, &writer->cs, INFINITE );
+        if (list_empty( &writer->ops )) break;
+
+        op = LIST_ENTRY( list_head( &writer->ops ), struct write_op, entry );
+        list_remove( &op->entry );
+        writer->busy = TRUE;
+        LeaveCriticalSection( &writer->cs );
+
+        switch (op->type)
+        {
+        case WRITE_OP_WRITE:
+            ret = WriteFile( op->handle, op->data, op->size, &written, NULL );
+            if (ret && written != op->size)
+            {
+                SetLastError( ERROR_WRITE_FAULT );
+                ret = FALSE;
+            }
+            break;
+        case WRITE_OP_SET_TIME:
+            ret = SetFileTime( op->handle, &op->time, 0, &op->time );
+            break;
+        default:
+            ret = CloseHandle( op->handle );
+            break;
+        }
+        if (!ret) WARN("operation %u on %p failed, error %u\n", op->type, op->handle, GetLastError());
+
+        EnterCriticalSection( &writer->cs );
+        if (!ret && !writer->error) writer->error = GetLastError();
+        writer->queued -= op->size;
+        writer->busy = FALSE;
+        WakeAllConditionVariable( &writer->cv );
+        msi_free( op );
+    }
+    LeaveCriticalSection( &writer->cs );
+    return 0;
+}
+
+static struct file_writer *create_file_writer(void)
+{
+    struct file_writer *writer;
+
+    if (!(writer = msi_alloc_zero( sizeof(*writer) ))) return NULL;
+
+    InitializeCriticalSection( &writer->cs );
+    InitializeConditionVariable( &writer->cv );
+    list_init( &writer->ops );
+
+    if (!(writer->thread = CreateThread( NULL, 0, file_writer_proc, writer, 0, NULL )))
+    {
+        DeleteCriticalSection( &writer->cs );
+        msi_free( writer );
+        return NULL;
+    }
+    return writer;
+}
+
+static BOOL queue_write_op( struct file_writer *writer, enum write_op_type type, HANDLE handle,
+                            const FILETIME *time, const void *data, UINT size )
+{
+    struct write_op *op;
+
+    if (!(op = msi_alloc( FIELD_OFFSET(struct write_op, data[size]) ))) return FALSE;
+    op->type = type;
+    op->handle = handle;
+    if (time) op->time = *time;
+    op->size = size;
+    if (size) memcpy( op->data, data, size );
+
+    EnterCriticalSection( &writer->cs );
+    while (size && writer->queued && writer->queued + size > MAX_QUEUED_BYTES)
+        SleepConditionVariableCS( &writer->cv, &writer->cs, INFINITE );
+    list_add_tail( &writer->ops, &op->entry );
+    writer->queued += size;
+    WakeAllConditionVariable( &writer->cv );
+    LeaveCriticalSection( &writer->cs );
+    return TRUE;
+}
+
+/* wait until all queued operations are done, returns the first error */
+static DWORD flush_file_writer( struct file_writer *writer )
+{
+    DWORD error;
+
+    EnterCriticalSection( &writer->cs );
+    while (!list_empty( &writer->ops ) || writer->busy)
+        SleepConditionVariableCS( &writer->cv, &writer->cs, INFINITE );
+    error = writer->error;
+    LeaveCriticalSection( &writer->cs );
+    return error;
+}
+
+static DWORD destroy_file_writer( struct file_writer *writer )
+{
+    DWORD error;
+
+    EnterCriticalSection( &writer->cs );
+    writer->shutdown = TRUE;
+    WakeAllConditionVariable( &writer->cv );
+    LeaveCriticalSection( &writer->cs );
+
+    WaitForSingleObject( writer->thread, INFINITE );
+    CloseHandle( writer->thread );
+
+    error = writer->error;
+    DeleteCriticalSection( &writer->cs );
+    msi_free( writer );
+    return error;
+}
+
 static INT_PTR CDECL cabinet_open(char *pszFile, int oflag, int pmode)
 {
     DWORD dwAccess = 0;
@@ -167,6 +326,9 @@ static UINT CDECL cabinet_write(INT_PTR hf, void *pv, UINT cb)
     HANDLE handle = (HANDLE)hf;
     DWORD written;
 
+    if (file_writer)
+        return queue_write_op( file_writer, WRITE_OP_WRITE, handle, NULL, pv, cb ) ? cb : 0;
+
     if (WriteFile(handle, pv, cb, &written, NULL))
         return written;
 
@@ -176,6 +338,11 @@ static UINT CDECL cabinet_write(INT_PTR hf, void *pv, UINT cb)
 static int CDECL cabinet_close(INT_PTR hf)
 {
     HANDLE handle = (HANDLE)hf;
+
+    /* pending writes may still use the handle */
+    if (file_writer)
+        return queue_write_op( file_writer, WRITE_OP_CLOSE, handle, NULL, NULL, 0 ) ? 0 : -1;
+
     return CloseHandle(handle) ? 0 : -1;
 }
 
@@ -439,6 +606,12 @@ static INT_PTR cabinet_copy_file(FDINOTIFICATIONTYPE fdint,
     if (!attrs) attrs = FILE_ATTRIBUTE_NORMAL;
 
     handle = msi_create_file( data->package, path, GENERIC_READ | GENERIC_WRITE, 0, CREATE_ALWAYS, attrs );
+    if (handle == INVALID_HANDLE_VALUE && file_writer)
+    {
+        /* the file may still be open if it was extracted before */
+        flush_file_writer( file_writer );
+        handle = msi_create_file( data->package, path, GENERIC_READ | GENERIC_WRITE, 0, CREATE_ALWAYS, attrs );
+    }
     if (handle == INVALID_HANDLE_VALUE)
     {
         DWORD err = GetLastError();
@@ -501,6 +674,18 @@ done:
     return (INT_PTR)handle;
 }
 
+/* closes a destination file on failure, so that it can be rolled back */
+static void close_extracted_file(HANDLE handle)
+{
+    if (file_writer)
+    {
+        if (queue_write_op( file_writer, WRITE_OP_CLOSE, handle, NULL, NULL, 0 )) return;
+        /* pending writes may still use the handle */
+        flush_file_writer( file_writer );
+    }
+    CloseHandle(handle);
+}
+
 static INT_PTR cabinet_close_file_info(FDINOTIFICATIONTYPE fdint,
                                        PFDINOTIFICATION pfdin)
 {
@@ -511,14 +696,33 @@ static INT_PTR cabinet_close_file_info(FDINOTIFICATIONTYPE fdint,
 
     data->mi->is_continuous = FALSE;
 
-    if (!DosDateTimeToFileTime(pfdin->date, pfdin->time, &ft))
-        return -1;
-    if (!LocalFileTimeToFileTime(&ft, &ftLocal))
-        return -1;
-    if (!SetFileTime(handle, &ftLocal, 0, &ftLocal))
+    if (!DosDateTimeToFileTime(pfdin->date, pfdin->time, &ft) ||
+        !LocalFileTimeToFileTime(&ft, &ftLocal))
+    {
+        close_extracted_file(handle);
         return -1;
+    }
 
-    CloseHandle(handle);
+    if (file_writer)
+    {
+        if (file_writer->error ||
+            !queue_write_op( file_writer, WRITE_OP_SET_TIME, handle, &ftLocal, NULL, 0 ) ||
+            !queue_write_op( file_writer, WRITE_OP_CLOSE, handle, NULL, NULL, 0 ))
+        {
+            close_extracted_file(handle);
+            return -1;
+        }
+    }
+    else
+    {
+        if (!SetFileTime(handle, &ftLocal, 0, &ftLocal))
+        {
+            CloseHandle(handle);
+            return -1;
+        }
+
+        CloseHandle(handle);
+    }
 
     data->cb(data->package, data->curfile, MSICABEXTRACT_FILEEXTRACTED, NULL, NULL,
              data->user);
@@ -650,11 +854,29 @@ static BOOL extract_cabinet_stream( MSIPACKAGE *package, MSIMEDIAINFO *mi, LPVOI
  */
 BOOL msi_cabextract(MSIPACKAGE* package, MSIMEDIAINFO *mi, LPVOID data)
 {
+    DWORD error;
+    BOOL ret;
+
+    if (!(file_writer = create_file_writer()))
+        WARN("failed to create file writer, writing synchronously\n");
+
     if (mi->cabinet[0] == '#')
+        ret = extract_cabinet_stream( package, mi, data );
+    else
+        ret = extract_cabinet( package, mi, data );
+
+    if (file_writer)
     {
-        return extract_cabinet_stream( package, mi, data );
+        error = destroy_file_writer( file_writer );
+        file_writer = NULL;
+        if (error)
+        {
+            ERR("failed to write extracted files, error %u\n", error);
+            mi->is_extracted = FALSE;
+            ret = FALSE;
+        }
     }
-    return extract_cabinet( package, mi, data );
+    return ret;
 }
 
 void msi_free_media_info(MSIMEDIAINFO *mi)
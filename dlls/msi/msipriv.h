@@ -219,7 +219,7 @@ typedef struct _column_info
     struct _column_info *next;
 } column_info;
 
-typedef const struct tagMSICOLUMNHASHENTRY *MSIITERHANDLE;
+typedef UINT MSIITERHANDLE;
 
 typedef struct tagMSIVIEWOPS
 {
@@ -340,6 +340,17 @@ typedef struct tagMSIVIEWOPS
      * drop - drops the table from the database
      */
     UINT (*drop)( struct tagMSIVIEW *view );
+
+    /*
+     * find_matching_rows - iterates through rows that match a value
+     *
+     * The value is compared to the value stored in the table, so a string ID
+     *  should be passed in for string columns.
+     * The handle keeps track of the current position in the iteration. It must
+     *  be initialised to zero before the first call and remains valid until the
+     *  table is modified. Rows are not returned in any particular order.
+     */
+    UINT (*find_matching_rows)( struct tagMSIVIEW *view, UINT col, UINT val, UINT *row, MSIITERHANDLE *handle );
 } MSIVIEWOPS;
 
 struct tagMSIVIEW
@@ -370,6 +370,7 @@ static const MSIVIEWOPS select_ops =
     NULL,
     NULL,
     NULL,
+    NULL,
 };
 
 static UINT SELECT_AddColumn( MSISELECTVIEW *sv, LPCWSTR name,
@@ -38,15 +38,25 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(msidb);
 
-#define MSITABLE_HASH_TABLE_SIZE 37
+#define MSITABLE_HASH_TABLE_SIZE 64
 
 typedef struct tagMSICOLUMNHASHENTRY
 {
-    struct tagMSICOLUMNHASHENTRY *next;
+    UINT next; /* index of the next entry in the bucket plus one, 0 ends the chain */
     UINT value;
     UINT row;
 } MSICOLUMNHASHENTRY;
 
+/* maps column values to rows, kept up to date as rows are inserted, deleted and modified */
+typedef struct tagMSICOLUMNHASHTABLE
+{
+    UINT *buckets; /* index of the first entry in each bucket plus one */
+    UINT bucket_count;
+    MSICOLUMNHASHENTRY *entries;
+    UINT entry_count;
+    UINT entry_size;
+} MSICOLUMNHASHTABLE;
+
 typedef struct tagMSICOLUMNINFO
 {
     LPCWSTR tablename;
@@ -56,7 +66,7 @@ typedef struct tagMSICOLUMNINFO
     UINT    offset;
     INT     ref_count;
     BOOL    temporary;
-    MSICOLUMNHASHENTRY **hash_table;
+    MSICOLUMNHASHTABLE *hash_table;
 } MSICOLUMNINFO;
 
 struct tagMSITABLE
@@ -362,10 +372,129 @@ end:
     return ret;
 }
 
+static void free_hash_table( MSICOLUMNHASHTABLE *hash_table )
+{
+    if (!hash_table) return;
+    msi_free( hash_table->buckets );
+    msi_free( hash_table->entries );
+    msi_free( hash_table );
+}
+
+static inline UINT hash_bucket( const MSICOLUMNHASHTABLE *hash_table, UINT value )
+{
+    return (value ^ (value >> 16)) & (hash_table->bucket_count - 1);
+}
+
+static UINT hash_table_resize( MSICOLUMNHASHTABLE *hash_table, UINT bucket_count )
+{
+    UINT *buckets, i, bucket;
+
+    if (!(buckets = msi_alloc_zero( bucket_count * sizeof(*buckets) )))
+        return ERROR_OUTOFMEMORY;
+
+    msi_free( hash_table->buckets );
+    hash_table->buckets = buckets;
+    hash_table->bucket_count = bucket_count;
+
+    for (i = 0; i < hash_table->entry_count; i++)
+    {
+        bucket = hash_bucket( hash_table, hash_table->entries[i].value );
+        hash_table->entries[i].next = buckets[bucket];
+        buckets[bucket] = i + 1;
+    }
+    return ERROR_SUCCESS;
+}
+
+static MSICOLUMNHASHTABLE *create_hash_table( UINT size )
+{
+    MSICOLUMNHASHTABLE *hash_table;
+    UINT bucket_count = MSITABLE_HASH_TABLE_SIZE;
+
+    while (bucket_count < size) bucket_count *= 2;
+
+    if (!(hash_table = msi_alloc_zero( sizeof(*hash_table) )))
+        return NULL;
+    if (!(hash_table->entries = msi_alloc( bucket_count * sizeof(*hash_table->entries) )) ||
+        hash_table_resize( hash_table, bucket_count ))
+    {
+        free_hash_table( hash_table );
+        return NULL;
+    }
+    hash_table->entry_size = bucket_count;
+    return hash_table;
+}
+
+static UINT hash_table_add( MSICOLUMNHASHTABLE *hash_table, UINT value, UINT row )
+{
+    MSICOLUMNHASHENTRY *entry;
+    UINT bucket;
+
+    if (hash_table->entry_count == hash_table->entry_size)
+    {
+        UINT size = hash_table->entry_size * 2;
+
+        if (!(entry = msi_realloc( hash_table->entries, size * sizeof(*entry) )))
+            return ERROR_OUTOFMEMORY;
+        hash_table->entries = entry;
+        hash_table->entry_size = size;
+    }
+    if (hash_table->entry_count >= hash_table->bucket_count &&
+        hash_table_resize( hash_table, hash_table->bucket_count * 2 ))
+        return ERROR_OUTOFMEMORY;
+
+    bucket = hash_bucket( hash_table, value );
+    entry = &hash_table->entries[hash_table->entry_count++];
+    entry->value = value;
+    entry->row = row;
+    entry->next = hash_table->buckets[bucket];
+    hash_table->buckets[bucket] = hash_table->entry_count;
+    return ERROR_SUCCESS;
+}
+
+/* find the link pointing to the entry for the given row */
+static UINT *hash_table_find_link( MSICOLUMNHASHTABLE *hash_table, UINT value, UINT row )
+{
+    UINT *link = &hash_table->buckets[hash_bucket( hash_table, value )];
+
+    while (*link && hash_table->entries[*link - 1].row != row)
+        link = &hash_table->entries[*link - 1].next;
+    return *link ? link : NULL;
+}
+
+static void hash_table_remove( MSICOLUMNHASHTABLE *hash_table, UINT value, UINT row )
+{
+    MSICOLUMNHASHENTRY *last;
+    UINT *link, index;
+
+    if (!(link = hash_table_find_link( hash_table, value, row )))
+        return;
+
+    index = *link;
+    *link = hash_table->entries[index - 1].next;
+
+    /* keep the entries packed by moving the last one into the freed slot */
+    last = &hash_table->entries[--hash_table->entry_count];
+    if (index - 1 != hash_table->entry_count)
+    {
+        link = hash_table_find_link( hash_table, last->value, last->row );
+        *link = index;
+        hash_table->entries[index - 1] = *last;
+    }
+}
+
+/* adjust row numbers after rows have been inserted or deleted */
+static void hash_table_shift( MSICOLUMNHASHTABLE *hash_table, UINT row, int delta )
+{
+    UINT i;
+
+    for (i = 0; i < hash_table->entry_count; i++)
+        if (hash_table->entries[i].row >= row) hash_table->entries[i].row += delta;
+}
+
 static void msi_free_colinfo( MSICOLUMNINFO *colinfo, UINT count )
 {
     UINT i;
-    for (i = 0; i < count; i++) msi_free( colinfo[i].hash_table );
+    for (i = 0; i < count; i++) free_hash_table( colinfo[i].hash_table );
 }
 
 static void free_table( MSITABLE *table )
@@ -1048,6 +1177,63 @@ static UINT TABLE_fetch_int( struct tagMSIVIEW *view, UINT row, UINT col, UINT *
     return ERROR_SUCCESS;
 }
 
+static UINT TABLE_find_matching_rows( struct tagMSIVIEW *view, UINT col, UINT val, UINT *row,
+                                      MSIITERHANDLE *handle )
+{
+    MSITABLEVIEW *tv = (MSITABLEVIEW*)view;
+    MSICOLUMNHASHTABLE *hash_table;
+    UINT index;
+
+    TRACE("%p, %u, %u, %u\n", view, col, val, *handle);
+
+    if( !tv->table )
+        return ERROR_INVALID_PARAMETER;
+
+    if( (col==0) || (col > tv->num_cols) )
+        return ERROR_INVALID_PARAMETER;
+
+    if (!(hash_table = tv->columns[col-1].hash_table))
+    {
+        UINT i, n, offset = tv->columns[col-1].offset;
+
+        if( offset >= tv->row_size )
+        {
+            ERR("Stuffed up %d >= %d\n", offset, tv->row_size );
+            ERR("%p %p\n", tv, tv->columns );
+            return ERROR_FUNCTION_FAILED;
+        }
+
+        if (!(hash_table = create_hash_table( tv->table->row_count )))
+            return ERROR_OUTOFMEMORY;
+
+        n = bytes_per_column( tv->db, &tv->columns[col - 1], LONG_STR_BYTES );
+        for (i = 0; i < tv->table->row_count; i++)
+        {
+            if (hash_table_add( hash_table, read_table_int( tv->table->data, i, offset, n ), i ))
+            {
+                free_hash_table( hash_table );
+                return ERROR_OUTOFMEMORY;
+            }
+        }
+        tv->columns[col-1].hash_table = hash_table;
+    }
+
+    if (!*handle)
+        index = hash_table->buckets[hash_bucket( hash_table, val )];
+    else
+        index = hash_table->entries[*handle - 1].next;
+
+    while (index && hash_table->entries[index - 1].value != val)
+        index = hash_table->entries[index - 1].next;
+
+    *handle = index;
+    if (!index)
+        return ERROR_NO_MORE_ITEMS;
+
+    *row = hash_table->entries[index - 1].row;
+    return ERROR_SUCCESS;
+}
+
 static UINT get_stream_name( const MSITABLEVIEW *tv, UINT row, WCHAR **pstname )
 {
     LPWSTR p, stname = NULL;
@@ -1166,6 +1352,7 @@ static UINT TABLE_fetch_stream( struct tagMSIVIEW *view, UINT row, UINT col, ISt
 /* Set a table value, i.e. preadjusted integer or string ID. */
 static UINT table_set_bytes( MSITABLEVIEW *tv, UINT row, UINT col, UINT val )
 {
+    MSICOLUMNHASHTABLE *hash_table;
     UINT offset, n, i;
 
     if( !tv->table )
@@ -1184,9 +1371,6 @@ static UINT table_set_bytes( MSITABLEVIEW *tv, UINT row, UINT col, UINT val )
         return ERROR_FUNCTION_FAILED;
     }
 
-    msi_free( tv->columns[col-1].hash_table );
-    tv->columns[col-1].hash_table = NULL;
-
     n = bytes_per_column( tv->db, &tv->columns[col - 1], LONG_STR_BYTES );
     if ( n != 2 && n != 3 && n != 4 )
     {
@@ -1195,6 +1379,21 @@ static UINT table_set_bytes( MSITABLEVIEW *tv, UINT row, UINT col, UINT val )
     }
 
     offset = tv->columns[col-1].offset;
+    if (n < 4) val &= (1 << n * 8) - 1;
+    if ((hash_table = tv->columns[col-1].hash_table))
+    {
+        UINT old = read_table_int( tv->table->data, row, offset, n );
+
+        if (old != val)
+        {
+            hash_table_remove( hash_table, old, row );
+            if (hash_table_add( hash_table, val, row ))
+            {
+                free_hash_table( hash_table );
+                tv->columns[col-1].hash_table = NULL;
+            }
+        }
+    }
     for ( i = 0; i < n; i++ )
         tv->table->data[row][offset + i] = (val >> i * 8) & 0xff;
 
@@ -1750,6 +1949,23 @@ static UINT TABLE_insert_row( struct tagMSIVIEW *view, MSIRECORD *rec, UINT row,
         tv->table->data_persistent[i] = tv->table->data_persistent[i - 1];
     }
 
+    /* the new row holds a copy of the next one until it's set below */
+    for (i = 0; i < tv->num_cols; i++)
+    {
+        MSICOLUMNHASHTABLE *hash_table = tv->columns[i].hash_table;
+        UINT val;
+
+        if (!hash_table) continue;
+        hash_table_shift( hash_table, row, 1 );
+        val = read_table_int( tv->table->data, row, tv->columns[i].offset,
+                              bytes_per_column( tv->db, &tv->columns[i], LONG_STR_BYTES ) );
+        if (hash_table_add( hash_table, val, row ))
+        {
+            free_hash_table( hash_table );
+            tv->columns[i].hash_table = NULL;
+        }
+    }
+
     /* Re-set the persistence flag */
     tv->table->data_persistent[row] = !temporary;
     return TABLE_set_row( view, row, rec, (1<<tv->num_cols) - 1 );
@@ -1775,11 +1991,17 @@ static UINT TABLE_delete_row( struct tagMSIVIEW *view, UINT row )
     num_rows = tv->table->row_count;
     tv->table->row_count--;
 
-    /* reset the hash tables */
+    /* update the hash tables */
     for (i = 0; i < tv->num_cols; i++)
     {
-        msi_free( tv->columns[i].hash_table );
-        tv->columns[i].hash_table = NULL;
+        MSICOLUMNHASHTABLE *hash_table = tv->columns[i].hash_table;
+        UINT val;
+
+        if (!hash_table) continue;
+        val = read_table_int( tv->table->data, row, tv->columns[i].offset,
+                              bytes_per_column( tv->db, &tv->columns[i], LONG_STR_BYTES ) );
+        hash_table_remove( hash_table, val, row );
+        hash_table_shift( hash_table, row + 1, -1 );
     }
 
     for (i = row + 1; i < num_rows; i++)
@@ -2144,6 +2366,7 @@ static const MSIVIEWOPS table_ops =
     TABLE_add_column,
     NULL,
     TABLE_drop,
+    TABLE_find_matching_rows,
 };
 
 UINT TABLE_CreateView( MSIDATABASE *db, LPCWSTR name, MSIVIEW **view )
@@ -2483,20 +2706,44 @@ static UINT msi_row_matches( MSITABLEVIEW *tv, UINT row, const UINT *data, UINT
 
 static UINT msi_table_find_row( MSITABLEVIEW *tv, MSIRECORD *rec, UINT *row, UINT *column )
 {
-    UINT i, r = ERROR_FUNCTION_FAILED, *data;
+    UINT i, col, r = ERROR_FUNCTION_FAILED, found = ~0u, *data;
+    MSIITERHANDLE handle = 0;
 
     data = msi_record_to_row( tv, rec );
     if( !data )
         return r;
-    for( i = 0; i < tv->table->row_count; i++ )
+
+    /* look up the rows matching the first key column, then check the whole key */
+    for( col = 1; col <= tv->num_cols; col++ )
+        if ( tv->columns[col - 1].type & MSITYPE_KEY ) break;
+
+    if ( col <= tv->num_cols )
     {
-        r = msi_row_matches( tv, i, data, column );
-        if( r == ERROR_SUCCESS )
+        while ( !(r = TABLE_find_matching_rows( &tv->view, col, data[col - 1], &i, &handle )) )
         {
-            *row = i;
-            break;
+            if ( i < found && msi_row_matches( tv, i, data, NULL ) == ERROR_SUCCESS )
+                found = i;
+        }
+        if ( r != ERROR_NO_MORE_ITEMS )
+        {
+            /* the index is not available, scan the table */
+            for( i = 0; i < tv->table->row_count; i++ )
+            {
+                if( msi_row_matches( tv, i, data, NULL ) == ERROR_SUCCESS )
+                {
+                    found = i;
+                    break;
+                }
+            }
         }
     }
+
+    r = ERROR_FUNCTION_FAILED;
+    if ( found != ~0u )
+    {
+        r = msi_row_matches( tv, found, data, column );
+        *row = found;
+    }
     msi_free( data );
     return r;
 }
@@ -9196,6 +9196,124 @@ static void test_view_get_error(void)
     DeleteFileA(msifile);
 }
 
+static UINT count_rows(MSIHANDLE hdb, const char *query)
+{
+    MSIHANDLE hview, hrec;
+    UINT r, count = 0;
+
+    r = MsiDatabaseOpenViewA(hdb, query, &hview);
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %d\n", r);
+    r = MsiViewExecute(hview, 0);
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %d\n", r);
+
+    while (MsiViewFetch(hview, &hrec) == ERROR_SUCCESS)
+    {
+        count++;
+        MsiCloseHandle(hrec);
+    }
+
+    MsiViewClose(hview);
+    MsiCloseHandle(hview);
+    return count;
+}
+
+static void test_indexed_lookup(void)
+{
+    MSIHANDLE hdb, hview, hrec;
+    char query[256];
+    UINT r, i;
+
+    hdb = create_db();
+    ok(hdb, "failed to create db\n");
+
+    r = run_query(hdb, 0, "CREATE TABLE `Parent` (`Id` CHAR(72) NOT NULL, `Num` SHORT PRIMARY KEY `Id`)");
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %d\n", r);
+    r = run_query(hdb, 0, "CREATE TABLE `Child` (`Name` CHAR(72) NOT NULL, `Parent_` CHAR(72), "
+                          "`Value` LONG PRIMARY KEY `Name`)");
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %d\n", r);
+
+    for (i = 0; i < 20; i++)
+    {
+        sprintf(query, "INSERT INTO `Parent` (`Id`, `Num`) VALUES ('p%u', %u)", i, i);
+        r = run_query(hdb, 0, query);
+        ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %d\n", r);
+    }
+    for (i = 0; i < 60; i++)
+    {
+        sprintf(query, "INSERT INTO `Child` (`Name`, `Parent_`, `Value`) VALUES ('c%u', 'p%u', %u)",
+                i, i % 20, i);
+        r = run_query(hdb, 0, query);
+        ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %d\n", r);
+    }
+
+    r = run_query(hdb, 0, "INSERT INTO `Parent` (`Id`, `Num`) VALUES ('p3', 3)");
+    ok(r == ERROR_FUNCTION_FAILED, "Expected ERROR_FUNCTION_FAILED, got %d\n", r);
+
+    r = count_rows(hdb, "SELECT * FROM `Child` WHERE `Parent_` = 'p3'");
+    ok(r == 3, "got %u rows\n", r);
+    r = count_rows(hdb, "SELECT * FROM `Child` WHERE `Parent_` = 'p99'");
+    ok(r == 0, "got %u rows\n", r);
+    r = count_rows(hdb, "SELECT * FROM `Child` WHERE `Value` = 10");
+    ok(r == 1, "got %u rows\n", r);
+    r = count_rows(hdb, "SELECT * FROM `Child` WHERE `Value` = -10");
+    ok(r == 0, "got %u rows\n", r);
+    r = count_rows(hdb, "SELECT * FROM `Parent` WHERE `Num` = 100000");
+    ok(r == 0, "got %u rows\n", r);
+    r = count_rows(hdb, "SELECT * FROM `Child`, `Parent` WHERE `Parent_` = `Id`");
+    ok(r == 60, "got %u rows\n", r);
+    r = count_rows(hdb, "SELECT * FROM `Child`, `Parent` WHERE `Parent_` = `Id` AND `Num` = 3");
+    ok(r == 3, "got %u rows\n", r);
+    r = count_rows(hdb, "SELECT * FROM `Child`, `Parent` WHERE `Num` = `Value`");
+    ok(r == 20, "got %u rows\n", r);
+
+    /* modify the tables after their values have been looked up */
+    r = run_query(hdb, 0, "DELETE FROM `Child` WHERE `Name` = 'c23'");
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %d\n", r);
+    r = run_query(hdb, 0, "INSERT INTO `Child` (`Name`, `Parent_`, `Value`) VALUES ('c0a', 'p3', 100)");
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %d\n", r);
+    r = run_query(hdb, 0, "UPDATE `Child` SET `Parent_` = 'p3' WHERE `Name` = 'c4'");
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %d\n", r);
+    r = run_query(hdb, 0, "UPDATE `Child` SET `Parent_` = 'p5' WHERE `Name` = 'c43'");
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %d\n", r);
+
+    r = MsiDatabaseOpenViewA(hdb, "SELECT `Name`, `Num`, `Value` FROM `Child`, `Parent` "
+                                  "WHERE `Parent_` = `Id` AND `Id` = 'p3' ORDER BY `Value`", &hview);
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %d\n", r);
+    r = MsiViewExecute(hview, 0);
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %d\n", r);
+
+    r = MsiViewFetch(hview, &hrec);
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %d\n", r);
+    check_record(hrec, 3, "c3", "3", "3");
+    MsiCloseHandle(hrec);
+
+    r = MsiViewFetch(hview, &hrec);
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %d\n", r);
+    check_record(hrec, 3, "c4", "3", "4");
+    MsiCloseHandle(hrec);
+
+    r = MsiViewFetch(hview, &hrec);
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %d\n", r);
+    check_record(hrec, 3, "c0a", "3", "100");
+    MsiCloseHandle(hrec);
+
+    r = MsiViewFetch(hview, &hrec);
+    ok(r == ERROR_NO_MORE_ITEMS, "Expected ERROR_NO_MORE_ITEMS, got %d\n", r);
+
+    MsiViewClose(hview);
+    MsiCloseHandle(hview);
+
+    r = run_query(hdb, 0, "INSERT INTO `Child` (`Name`, `Parent_`, `Value`) VALUES ('c0a', 'p1', 1)");
+    ok(r == ERROR_FUNCTION_FAILED, "Expected ERROR_FUNCTION_FAILED, got %d\n", r);
+    r = count_rows(hdb, "SELECT * FROM `Child` WHERE `Name` = 'c23'");
+    ok(r == 0, "got %u rows\n", r);
+    r = count_rows(hdb, "SELECT * FROM `Child` WHERE `Parent_` = 'p5'");
+    ok(r == 4, "got %u rows\n", r);
+
+    MsiCloseHandle(hdb);
+    DeleteFileA(msifile);
+}
+
 START_TEST(db)
 {
     test_msidatabase();
@@ -9255,4 +9373,5 @@ START_TEST(db)
     test_viewmodify_merge();
     test_viewmodify_insert();
     test_view_get_error();
+    test_indexed_lookup();
 }
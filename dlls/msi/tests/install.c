@@ -535,6 +535,19 @@ static const CHAR cie_media_dat[] = "DiskId\tLastSequence\tDiskPrompt\tCabinet\t
                                     "2\t2\t\ttest2.cab\tDISK2\t\n"
                                     "3\t12\t\ttest3.cab\tDISK3\t\n";
 
+static const CHAR mcf_file_dat[] = "File\tComponent_\tFileName\tFileSize\tVersion\tLanguage\tAttributes\tSequence\n"
+                                   "s72\ts72\tl255\ti4\tS72\tS20\tI2\ti2\n"
+                                   "File\tFile\n"
+                                   "maximus\tmaximus\tmaximus\t500\t\t\t16384\t1\n"
+                                   "augustus\taugustus\taugustus\t100000\t\t\t16384\t2\n"
+                                   "caesar\tcaesar\tcaesar\t3000000\t\t\t16384\t3\n"
+                                   "gaius\tgaius\tgaius\t40\t\t\t16384\t4";
+
+static const CHAR mcf_media_dat[] = "DiskId\tLastSequence\tDiskPrompt\tCabinet\tVolumeLabel\tSource\n"
+                                    "i2\ti4\tL64\tS255\tS32\tS72\n"
+                                    "Media\tDiskId\n"
+                                    "1\t4\t\ttest1.cab\tDISK1\t\n";
+
 static const CHAR ci_component_dat[] = "Component\tComponentId\tDirectory_\tAttributes\tCondition\tKeyPath\n"
                                        "s72\tS38\ts72\ti2\tS255\tS72\n"
                                        "Component\tComponent\n"
@@ -1640,6 +1653,18 @@ static const msi_table cie_tables[] =
     ADD_TABLE(property),
 };
 
+static const msi_table mcf_tables[] =
+{
+    ADD_TABLE(cie_component),
+    ADD_TABLE(directory),
+    ADD_TABLE(cc_feature),
+    ADD_TABLE(cie_feature_comp),
+    ADD_TABLE(mcf_file),
+    ADD_TABLE(install_exec_seq),
+    ADD_TABLE(mcf_media),
+    ADD_TABLE(property),
+};
+
 static const msi_table tp_tables[] =
 {
     ADD_TABLE(tp_component),
@@ -3739,6 +3764,67 @@ static void generate_transform_manual(void)
     set_transform_summary_info();
 }
 
+static void test_cabmultiplefiles(void)
+{
+    static const struct
+    {
+        const char *name;
+        DWORD size;
+    }
+    files[] =
+    {
+        { "maximus", 500 },
+        { "augustus", 100000 },
+        { "caesar", 3000000 },
+        { "gaius", 40 },
+    };
+    char path[MAX_PATH], *data;
+    unsigned int i;
+    UINT r;
+
+    if (is_process_limited())
+    {
+        skip("process is limited\n");
+        return;
+    }
+
+    CreateDirectoryA("msitest", NULL);
+    for (i = 0; i < ARRAY_SIZE(files); i++)
+        create_file(files[i].name, files[i].size);
+    create_cab_file("test1.cab", MEDIA_SIZE, "maximus\0augustus\0caesar\0gaius\0");
+
+    create_database(msifile, mcf_tables, ARRAY_SIZE(mcf_tables));
+
+    MsiSetInternalUI(INSTALLUILEVEL_NONE, NULL);
+
+    r = MsiInstallProductA(msifile, NULL);
+    if (r == ERROR_INSTALL_PACKAGE_REJECTED)
+    {
+        skip("Not enough rights to perform tests\n");
+        goto error;
+    }
+    ok(r == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %u\n", r);
+
+    /* all files are complete and closed once the install returns */
+    for (i = 0; i < ARRAY_SIZE(files); i++)
+    {
+        data = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, files[i].size);
+        strcpy(data, files[i].name);
+        sprintf(path, "msitest\\%s", files[i].name);
+        ok(compare_pf_data(path, data, files[i].size), "%s: wrong contents\n", files[i].name);
+        ok(delete_pf(path, TRUE), "%s: file not installed\n", files[i].name);
+        HeapFree(GetProcessHeap(), 0, data);
+    }
+    ok(delete_pf("msitest", FALSE), "Directory not created\n");
+
+error:
+    delete_cab_files();
+    DeleteFileA(msifile);
+    for (i = 0; i < ARRAY_SIZE(files); i++)
+        DeleteFileA(files[i].name);
+    RemoveDirectoryA("msitest");
+}
+
 static void test_transformprop(void)
 {
     UINT r;
@@ -6263,6 +6349,7 @@ START_TEST(install)
     test_readonlyfile_cab();
     test_setdirproperty();
     test_cabisextracted();
+    test_cabmultiplefiles();
     test_transformprop();
     test_currentworkingdir();
     test_admin();
@@ -73,6 +73,7 @@ typedef struct tagMSIWHEREVIEW
     struct expr   *cond;
     UINT           rec_index;
     MSIORDERINFO  *order_info;
+    UINT           eval_count; /* number of times the condition was evaluated */
 } MSIWHEREVIEW;
 
 static UINT WHERE_evaluate( MSIWHEREVIEW *wv, const UINT rows[],
@@ -646,38 +647,161 @@ static UINT WHERE_evaluate( MSIWHEREVIEW *wv, const UINT rows[],
     return ERROR_SUCCESS;
 }
 
+static BOOL is_column_expr( const struct expr *expr )
+{
+    return expr->type == EXPR_COL_NUMBER || expr->type == EXPR_COL_NUMBER32 ||
+           expr->type == EXPR_COL_NUMBER_STRING;
+}
+
+/* converts the value compared to a column to the value stored in the table */
+static UINT get_index_value( MSIWHEREVIEW *wv, const UINT rows[], const struct expr *column,
+                             const struct expr *value, UINT *val )
+{
+    const WCHAR *str;
+    INT ival;
+
+    switch (value->type)
+    {
+    case EXPR_COL_NUMBER:
+    case EXPR_COL_NUMBER32:
+    case EXPR_COL_NUMBER_STRING:
+        if (value->type != column->type ||
+            expr_fetch_value( &value->u.column, rows, val ) != ERROR_SUCCESS)
+            return ERROR_FUNCTION_FAILED;
+
+        /* empty strings are equal to nulls, which have different ids */
+        if (value->type == EXPR_COL_NUMBER_STRING)
+        {
+            str = msi_string_lookup( wv->db->strings, *val, NULL );
+            if (!str || !*str)
+                return ERROR_FUNCTION_FAILED;
+        }
+        return ERROR_SUCCESS;
+
+    case EXPR_UVAL:
+        ival = value->u.uval;
+        if (column->type == EXPR_COL_NUMBER)
+        {
+            if (ival < -0x8000 || ival > 0x7fff)
+                return ERROR_NO_MORE_ITEMS;
+            *val = ival + 0x8000;
+        }
+        else if (column->type == EXPR_COL_NUMBER32)
+            *val = ival + 0x80000000;
+        else
+            return ERROR_FUNCTION_FAILED;
+        return ERROR_SUCCESS;
+
+    case EXPR_SVAL:
+        if (column->type != EXPR_COL_NUMBER_STRING || !value->u.sval[0])
+            return ERROR_FUNCTION_FAILED;
+        if (msi_string2id( wv->db->strings, value->u.sval, -1, val ) != ERROR_SUCCESS)
+            return ERROR_NO_MORE_ITEMS;
+        return ERROR_SUCCESS;
+
+    default:
+        return ERROR_FUNCTION_FAILED;
+    }
+}
+
+/* looks for an equality between a column of the table and a value that is
+ * known at this point, so that only the matching rows have to be checked */
+static UINT find_index_value( MSIWHEREVIEW *wv, const UINT rows[], const struct expr *cond,
+                              JOINTABLE *table, UINT *col, UINT *val )
+{
+    const struct expr *left, *right;
+    UINT r;
+
+    if (!cond || (cond->type != EXPR_COMPLEX && cond->type != EXPR_STRCMP))
+        return ERROR_FUNCTION_FAILED;
+
+    left = cond->u.expr.left;
+    right = cond->u.expr.right;
+
+    if (cond->u.expr.op == OP_AND)
+    {
+        r = find_index_value( wv, rows, left, table, col, val );
+        if (r == ERROR_FUNCTION_FAILED)
+            r = find_index_value( wv, rows, right, table, col, val );
+        return r;
+    }
+
+    if (cond->u.expr.op != OP_EQ)
+        return ERROR_FUNCTION_FAILED;
+
+    if (is_column_expr( left ) && left->u.column.parsed.table == table &&
+        (r = get_index_value( wv, rows, left, right, val )) != ERROR_FUNCTION_FAILED)
+    {
+        *col = left->u.column.parsed.column;
+        return r;
+    }
+    if (is_column_expr( right ) && right->u.column.parsed.table == table &&
+        (r = get_index_value( wv, rows, right, left, val )) != ERROR_FUNCTION_FAILED)
+    {
+        *col = right->u.column.parsed.column;
+        return r;
+    }
+    return ERROR_FUNCTION_FAILED;
+}
+
+static UINT check_condition( MSIWHEREVIEW *wv, MSIRECORD *record, JOINTABLE **tables,
+                             UINT table_rows[] );
+
+static UINT check_row( MSIWHEREVIEW *wv, MSIRECORD *record, JOINTABLE **tables,
+                       UINT table_rows[], INT *val )
+{
+    UINT r;
+
+    *val = 0;
+    wv->rec_index = 0;
+    wv->eval_count++;
+    r = WHERE_evaluate( wv, table_rows, wv->cond, val, record );
+    if ((r != ERROR_SUCCESS && r != ERROR_CONTINUE) || !*val)
+        return r;
+
+    if (*(tables + 1))
+        return check_condition(wv, record, tables + 1, table_rows);
+
+    if (r == ERROR_SUCCESS)
+        add_row (wv, table_rows);
+    return r;
+}
+
 static UINT check_condition( MSIWHEREVIEW *wv, MSIRECORD *record, JOINTABLE **tables,
                              UINT table_rows[] )
 {
-    UINT r = ERROR_FUNCTION_FAILED;
+    JOINTABLE *table = *tables;
+    UINT *row = &table_rows[table->table_index];
+    UINT r = ERROR_FUNCTION_FAILED, col = 0, value = 0;
+    MSIITERHANDLE handle = 0;
     INT val;
 
-    for (table_rows[(*tables)->table_index] = 0;
-         table_rows[(*tables)->table_index] < (*tables)->row_count;
-         table_rows[(*tables)->table_index]++)
+    if (table->view->ops->find_matching_rows)
+        r = find_index_value( wv, table_rows, wv->cond, table, &col, &value );
+
+    if (r == ERROR_NO_MORE_ITEMS)
+        r = ERROR_SUCCESS;
+    else if (r == ERROR_SUCCESS)
     {
-        val = 0;
-        wv->rec_index = 0;
-        r = WHERE_evaluate( wv, table_rows, wv->cond, &val, record );
-        if (r != ERROR_SUCCESS && r != ERROR_CONTINUE)
-            break;
-        if (val)
+        while (!(r = table->view->ops->find_matching_rows( table->view, col, value, row, &handle )))
         {
-            if (*(tables + 1))
-            {
-                r = check_condition(wv, record, tables + 1, table_rows);
-                if (r != ERROR_SUCCESS)
-                    break;
-            }
-            else
-            {
-                if (r != ERROR_SUCCESS)
-                    break;
-                add_row (wv, table_rows);
-            }
+            r = check_row( wv, record, tables, table_rows, &val );
+            if (r != ERROR_SUCCESS && (r != ERROR_CONTINUE || val))
+                break;
         }
+        if (r == ERROR_NO_MORE_ITEMS && !handle)
+            r = ERROR_SUCCESS;
     }
-    table_rows[(*tables)->table_index] = INVALID_ROW_INDEX;
+    else
+    {
+        for (*row = 0; *row < table->row_count; (*row)++)
+        {
+            r = check_row( wv, record, tables, table_rows, &val );
+            if (r != ERROR_SUCCESS && (r != ERROR_CONTINUE || val))
+                break;
+        }
+    }
+    *row = INVALID_ROW_INDEX;
     return r;
 }
 
@@ -818,6 +942,7 @@ static UINT WHERE_execute( struct tagMSIVIEW *view, MSIRECORD *record )
     UINT *rows;
     JOINTABLE **ordered_tables;
     UINT i = 0;
+    DWORD start;
 
     TRACE("%p %p\n", wv, record);
 
@@ -851,7 +976,11 @@ static UINT WHERE_execute( struct tagMSIVIEW *view, MSIRECORD *record )
     for (i = 0; i < wv->table_count; i++)
         rows[i] = INVALID_ROW_INDEX;
 
+    start = GetTickCount();
+    wv->eval_count = 0;
     r =  check_condition(wv, record, ordered_tables, rows);
+    TRACE("%p: %u rows selected, condition evaluated %u times in %u ms\n", wv, wv->row_count,
+          wv->eval_count, GetTickCount() - start);
 
     if (wv->order_info)
         wv->order_info->error = ERROR_SUCCESS;
@@ -1132,6 +1261,7 @@ static const MSIVIEWOPS where_ops =
     NULL,
     WHERE_sort,
     NULL,
+    NULL,
 };
 
 static UINT WHERE_VerifyCondition( MSIWHEREVIEW *wv, struct expr *cond,
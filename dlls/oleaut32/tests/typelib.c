@@ -811,6 +811,80 @@ static void test_invoke_func(ITypeInfo *typeinfo)
     ok(hres == DISP_E_BADPARAMCOUNT, "got 0x%08x\n", hres);
 }
 
+static void test_dispatch_lookup(ITypeInfo *typeinfo)
+{
+    static WCHAR testfuncW[] = {'t','e','s','t','f','u','n','c',0};
+    static WCHAR testfuncupperW[] = {'T','E','S','T','F','U','N','C',0};
+    static WCHAR iW[] = {'i',0};
+    static WCHAR gettypeinfoW[] = {'G','e','t','T','y','p','e','I','n','f','o',0};
+    static WCHAR bogusW[] = {'b','o','g','u','s',0};
+    OLECHAR *names[2];
+    DISPID dispids[2];
+    DISPPARAMS dp;
+    VARIANT arg, res;
+    IDispatch *disp;
+    IUnknown *unk;
+    DWORD start;
+    UINT i;
+    HRESULT hr;
+
+    hr = CreateStdDispatch(NULL, &invoketest, typeinfo, &unk);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    hr = IUnknown_QueryInterface(unk, &IID_IDispatch, (void **)&disp);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+
+    names[0] = testfuncupperW;
+    dispids[0] = DISPID_UNKNOWN;
+    hr = IDispatch_GetIDsOfNames(disp, &IID_NULL, names, 1, LOCALE_NEUTRAL, dispids);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(dispids[0] == 3, "got %d\n", dispids[0]);
+
+    names[0] = testfuncW;
+    names[1] = iW;
+    dispids[0] = dispids[1] = DISPID_UNKNOWN;
+    hr = IDispatch_GetIDsOfNames(disp, &IID_NULL, names, 2, LOCALE_NEUTRAL, dispids);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(dispids[0] == 3, "got %d\n", dispids[0]);
+    ok(dispids[1] == 0, "got %d\n", dispids[1]);
+
+    /* inherited from IDispatch, which lives in another type library */
+    names[0] = gettypeinfoW;
+    dispids[0] = DISPID_UNKNOWN;
+    hr = IDispatch_GetIDsOfNames(disp, &IID_NULL, names, 1, LOCALE_NEUTRAL, dispids);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(dispids[0] != DISPID_UNKNOWN, "got %d\n", dispids[0]);
+
+    names[0] = bogusW;
+    dispids[0] = 0;
+    hr = IDispatch_GetIDsOfNames(disp, &IID_NULL, names, 1, LOCALE_NEUTRAL, dispids);
+    ok(hr == DISP_E_UNKNOWNNAME, "got 0x%08x\n", hr);
+    ok(dispids[0] == DISPID_UNKNOWN, "got %d\n", dispids[0]);
+
+    /* name lookup followed by a call, the way late bound clients do it */
+    start = GetTickCount();
+    for (i = 0; i < 20000; i++)
+    {
+        names[0] = testfuncW;
+        hr = IDispatch_GetIDsOfNames(disp, &IID_NULL, names, 1, LOCALE_NEUTRAL, dispids);
+        if (hr != S_OK || dispids[0] != 3) break;
+
+        V_VT(&arg) = VT_INT;
+        V_INT(&arg) = i;
+        dp.rgvarg = &arg;
+        dp.rgdispidNamedArgs = NULL;
+        dp.cArgs = 1;
+        dp.cNamedArgs = 0;
+        V_VT(&res) = VT_EMPTY;
+        hr = IDispatch_Invoke(disp, dispids[0], &IID_NULL, LOCALE_NEUTRAL, DISPATCH_METHOD, &dp, &res, NULL, NULL);
+        if (hr != S_OK || V_VT(&res) != VT_I4 || V_I4(&res) != i + 1) break;
+    }
+    ok(i == 20000, "failed at iteration %u: hr 0x%08x, res %d\n", i, hr, V_I4(&res));
+    trace("%u GetIDsOfNames/Invoke pairs ran in %u ms\n", i, GetTickCount() - start);
+
+    IDispatch_Release(disp);
+    IUnknown_Release(unk);
+}
+
 static const char *create_test_typelib(int res_no)
 {
     static char filename[MAX_PATH];
@@ -1120,6 +1194,7 @@ static void test_TypeInfo(void)
     ok(hr == DISP_E_MEMBERNOTFOUND, "got 0x%08x, %d\n", hr, i);
 
     test_invoke_func(pTypeInfo);
+    test_dispatch_lookup(pTypeInfo);
 
     ITypeInfo_Release(pTypeInfo);
     ITypeLib_Release(pTypeLib);
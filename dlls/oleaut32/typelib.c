@@ -1233,6 +1233,30 @@ typedef struct tagTLBImplType
     struct list custdata_list;
 } TLBImplType;
 
+/* hash lookup of the members of a typeinfo and of the interfaces it inherits
+ * from in the same typelib, in the order GetIDsOfNames searches them */
+typedef struct tagTLBMemberEntry
+{
+    const TLBString *Name;
+    MEMBERID memid;
+    const TLBFuncDesc *func;    /* NULL for variables */
+    ULONG hash;
+    UINT next_name;             /* 1-based entry index, 0 ends the chain */
+    UINT next_memid;
+} TLBMemberEntry;
+
+typedef struct tagTLBMemberIndex
+{
+    struct tagITypeInfoImpl *last;  /* last typeinfo searched, its base has to be loaded */
+    UINT count;
+    UINT cFuncs;                /* functions of the typeinfo itself, indexed by memid */
+    UINT bucket_mask;
+    UINT *name_buckets;
+    UINT *memid_buckets;
+    UINT other_names;           /* chain of names that can't be hashed */
+    TLBMemberEntry *entries;
+} TLBMemberIndex;
+
 /* internal TypeInfo data */
 typedef struct tagITypeInfoImpl
 {
@@ -1271,6 +1295,8 @@ typedef struct tagITypeInfoImpl
 
     struct list *pcustdata_list;
     struct list custdata_list;
+
+    TLBMemberIndex *member_index;   /* built on first use */
 } ITypeInfoImpl;
 
 static inline ITypeInfoImpl *info_impl_from_ITypeComp( ITypeComp *iface )
@@ -5642,6 +5668,7 @@ static void ITypeInfoImpl_Destroy(ITypeInfoImpl *This)
 
     TLB_FreeCustData(&This->custdata_list);
 
+    heap_free(This->member_index);
     heap_free(This);
 }
 
@@ -5659,7 +5686,10 @@ static ULONG WINAPI ITypeInfo_fnRelease(ITypeInfo2 *iface)
         BOOL not_attached_to_typelib = This->not_attached_to_typelib;
         ITypeLib2_Release(&This->pTypeLib->ITypeLib2_iface);
         if (not_attached_to_typelib)
+        {
+            heap_free(This->member_index);
             heap_free(This);
+        }
         /* otherwise This will be freed when typelib is freed */
     }
 
@@ -6251,6 +6281,176 @@ static HRESULT WINAPI ITypeInfo_fnGetImplTypeFlags( ITypeInfo2 *iface,
     return S_OK;
 }
 
+/* Hash the letters and digits of a name, ignoring case. Other ASCII characters
+ * are skipped and names with non-ASCII characters are not hashed at all, so
+ * names that lstrcmpiW considers equal always get the same hash. */
+static BOOL TLB_hash_name(const OLECHAR *name, ULONG *hash)
+{
+    ULONG ret = 0;
+
+    if (!name) return FALSE;
+    for (; *name; name++)
+    {
+        WCHAR c = *name;
+
+        if (c >= 0x80) return FALSE;
+        if (c >= 'a' && c <= 'z') c -= 'a' - 'A';
+        else if (!(c >= 'A' && c <= 'Z') && !(c >= '0' && c <= '9')) continue;
+        ret = ret * 31 + c;
+    }
+    *hash = ret;
+    return TRUE;
+}
+
+static inline UINT TLB_hash_memid(MEMBERID memid)
+{
+    return memid ^ ((UINT)memid >> 16);
+}
+
+/* find the base interface in the same typelib, the way GetRefTypeInfo does */
+static ITypeInfoImpl *TLB_get_internal_base(const ITypeInfoImpl *This)
+{
+    HREFTYPE href;
+    int i;
+
+    if (!This->impltypes) return NULL;
+    href = This->impltypes[0].hRef;
+    if ((INT)href < 0 || (href & 0x1)) return NULL;
+    if ((href & DISPATCH_HREF_MASK) && This->typeattr.typekind == TKIND_DISPATCH) return NULL;
+
+    for (i = 0; i < This->pTypeLib->TypeInfoCount; ++i)
+        if (This->pTypeLib->typeinfos[i]->hreftype == (href & ~0x3))
+            return This->pTypeLib->typeinfos[i];
+    return NULL;
+}
+
+static TLBMemberIndex *TLB_build_member_index(ITypeInfoImpl *This)
+{
+    TLBMemberIndex *index;
+    ITypeInfoImpl *info, *last = This;
+    UINT count, buckets = 8, depth = 0, i, n = 0;
+
+    count = This->typeattr.cFuncs + This->typeattr.cVars;
+    while (depth++ < This->pTypeLib->TypeInfoCount && (info = TLB_get_internal_base(last)))
+    {
+        count += info->typeattr.cFuncs + info->typeattr.cVars;
+        last = info;
+    }
+    while (buckets < count) buckets <<= 1;
+
+    index = heap_alloc_zero(sizeof(*index) + count * sizeof(TLBMemberEntry) + 2 * buckets * sizeof(UINT));
+    if (!index) return NULL;
+    index->last = last;
+    index->count = count;
+    index->cFuncs = This->typeattr.cFuncs;
+    index->bucket_mask = buckets - 1;
+    index->entries = (TLBMemberEntry *)(index + 1);
+    index->name_buckets = (UINT *)(index->entries + count);
+    index->memid_buckets = index->name_buckets + buckets;
+
+    for (info = This;; info = TLB_get_internal_base(info))
+    {
+        for (i = 0; i < info->typeattr.cFuncs; ++i, ++n)
+        {
+            index->entries[n].Name = info->funcdescs[i].Name;
+            index->entries[n].memid = info->funcdescs[i].funcdesc.memid;
+            index->entries[n].func = &info->funcdescs[i];
+        }
+        for (i = 0; i < info->typeattr.cVars; ++i, ++n)
+        {
+            index->entries[n].Name = info->vardescs[i].Name;
+            index->entries[n].memid = info->vardescs[i].vardesc.memid;
+        }
+        if (info == last) break;
+    }
+
+    /* link the entries backwards, so that each chain is in search order */
+    for (i = count; i > 0; --i)
+    {
+        TLBMemberEntry *entry = &index->entries[i - 1];
+        UINT *head;
+
+        if (TLB_hash_name(TLB_get_bstr(entry->Name), &entry->hash))
+            head = &index->name_buckets[entry->hash & index->bucket_mask];
+        else
+            head = &index->other_names;
+        entry->next_name = *head;
+        *head = i;
+
+        if (i <= index->cFuncs)
+        {
+            head = &index->memid_buckets[TLB_hash_memid(entry->memid) & index->bucket_mask];
+            entry->next_memid = *head;
+            *head = i;
+        }
+    }
+
+    TRACE("(%p) indexed %u members\n", This, count);
+    return index;
+}
+
+static const TLBMemberIndex *TLB_get_member_index(ITypeInfoImpl *This)
+{
+    TLBMemberIndex *index;
+
+    if ((index = This->member_index)) return index;
+    if (!(index = TLB_build_member_index(This))) return NULL;
+    if (InterlockedCompareExchangePointer((void **)&This->member_index, index, NULL))
+    {
+        heap_free(index);
+        index = This->member_index;
+    }
+    return index;
+}
+
+/* indexes may point to members of other typeinfos in the same typelib */
+static void TLB_invalidate_member_indexes(ITypeLibImpl *lib)
+{
+    int i;
+
+    for (i = 0; i < lib->TypeInfoCount; ++i)
+    {
+        heap_free(lib->typeinfos[i]->member_index);
+        lib->typeinfos[i]->member_index = NULL;
+    }
+}
+
+static const TLBMemberEntry *TLB_find_member_by_name(const TLBMemberIndex *index, const OLECHAR *name)
+{
+    const TLBMemberEntry *entry;
+    UINT i, found = 0;
+    ULONG hash;
+
+    if (!TLB_hash_name(name, &hash))
+    {
+        for (i = 0; i < index->count; ++i)
+            if (!lstrcmpiW(name, TLB_get_bstr(index->entries[i].Name)))
+                return &index->entries[i];
+        return NULL;
+    }
+
+    for (i = index->name_buckets[hash & index->bucket_mask]; i; i = entry->next_name)
+    {
+        entry = &index->entries[i - 1];
+        if (entry->hash == hash && !lstrcmpiW(name, TLB_get_bstr(entry->Name)))
+        {
+            found = i;
+            break;
+        }
+    }
+    /* names that can't be hashed may still compare equal */
+    for (i = index->other_names; i && (!found || i < found); i = entry->next_name)
+    {
+        entry = &index->entries[i - 1];
+        if (!lstrcmpiW(name, TLB_get_bstr(entry->Name)))
+        {
+            found = i;
+            break;
+        }
+    }
+    return found ? &index->entries[found - 1] : NULL;
+}
+
 /* GetIDsOfNames
  * Maps between member names and member IDs, and parameter names and
  * parameter IDs.
@@ -6259,9 +6459,10 @@ static HRESULT WINAPI ITypeInfo_fnGetIDsOfNames( ITypeInfo2 *iface,
         LPOLESTR  *rgszNames, UINT cNames, MEMBERID  *pMemId)
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
-    const TLBVarDesc *pVDesc;
+    const TLBMemberIndex *index;
+    const TLBMemberEntry *entry;
     HRESULT ret=S_OK;
-    UINT i, fdc;
+    UINT i;
 
     TRACE("(%p) Name %s cNames %d\n", This, debugstr_w(*rgszNames),
             cNames);
@@ -6270,35 +6471,32 @@ static HRESULT WINAPI ITypeInfo_fnGetIDsOfNames( ITypeInfo2 *iface,
     for (i = 0; i < cNames; i++)
         pMemId[i] = MEMBERID_NIL;
 
-    for (fdc = 0; fdc < This->typeattr.cFuncs; ++fdc) {
-        int j;
-        const TLBFuncDesc *pFDesc = &This->funcdescs[fdc];
-        if(!lstrcmpiW(*rgszNames, TLB_get_bstr(pFDesc->Name))) {
-            if(cNames) *pMemId=pFDesc->funcdesc.memid;
-            for(i=1; i < cNames; i++){
-                for(j=0; j<pFDesc->funcdesc.cParams; j++)
-                    if(!lstrcmpiW(rgszNames[i],TLB_get_bstr(pFDesc->pParamDesc[j].Name)))
-                            break;
-                if( j<pFDesc->funcdesc.cParams)
-                    pMemId[i]=j;
-                else
-                   ret=DISP_E_UNKNOWNNAME;
-            };
-            TRACE("-- 0x%08x\n", ret);
-            return ret;
-        }
-    }
-    pVDesc = TLB_get_vardesc_by_name(This->vardescs, This->typeattr.cVars, *rgszNames);
-    if(pVDesc){
-        if(cNames)
-            *pMemId = pVDesc->vardesc.memid;
+    if (!(index = TLB_get_member_index(This)))
+        return E_OUTOFMEMORY;
+
+    if ((entry = TLB_find_member_by_name(index, *rgszNames))) {
+        const TLBFuncDesc *pFDesc = entry->func;
+        if(cNames) *pMemId = entry->memid;
+        if(!pFDesc) return ret;
+        for(i=1; i < cNames; i++){
+            int j;
+            for(j=0; j<pFDesc->funcdesc.cParams; j++)
+                if(!lstrcmpiW(rgszNames[i],TLB_get_bstr(pFDesc->pParamDesc[j].Name)))
+                        break;
+            if( j<pFDesc->funcdesc.cParams)
+                pMemId[i]=j;
+            else
+               ret=DISP_E_UNKNOWNNAME;
+        };
+        TRACE("-- 0x%08x\n", ret);
         return ret;
     }
-    /* not found, see if it can be found in an inherited interface */
-    if(This->impltypes) {
+    /* not found, see if it can be found in an interface of another typelib */
+    if(index->last->impltypes) {
         /* recursive search */
         ITypeInfo *pTInfo;
-        ret = ITypeInfo2_GetRefTypeInfo(iface, This->impltypes[0].hRef, &pTInfo);
+        ret = ITypeInfo2_GetRefTypeInfo(&index->last->ITypeInfo2_iface,
+                index->last->impltypes[0].hRef, &pTInfo);
         if(SUCCEEDED(ret)){
             ret=ITypeInfo_GetIDsOfNames(pTInfo, rgszNames, cNames, pMemId );
             ITypeInfo_Release(pTInfo);
@@ -7046,6 +7244,21 @@ static inline BOOL func_restricted( const FUNCDESC *desc )
     return (desc->wFuncFlags & FUNCFLAG_FRESTRICTED) && (desc->memid >= 0);
 }
 
+static const TLBFuncDesc *TLB_find_func_by_memid(const TLBMemberIndex *index, MEMBERID memid, UINT16 flags)
+{
+    const TLBMemberEntry *entry;
+    UINT i;
+
+    for (i = index->memid_buckets[TLB_hash_memid(memid) & index->bucket_mask]; i; i = entry->next_memid)
+    {
+        entry = &index->entries[i - 1];
+        if (entry->memid == memid && (flags & entry->func->funcdesc.invkind) &&
+            !func_restricted( &entry->func->funcdesc ))
+            return entry->func;
+    }
+    return NULL;
+}
+
 #define INVBUF_ELEMENT_SIZE \
     (sizeof(VARIANTARG) + sizeof(VARIANTARG) + sizeof(VARIANTARG *) + sizeof(VARTYPE))
 #define INVBUF_GET_ARG_ARRAY(buffer, params) (buffer)
@@ -7071,8 +7284,8 @@ static HRESULT WINAPI ITypeInfo_fnInvoke(
     unsigned int var_index;
     TYPEKIND type_kind;
     HRESULT hres;
+    const TLBMemberIndex *index;
     const TLBFuncDesc *pFuncInfo;
-    UINT fdc;
 
     TRACE("(%p)(%p,id=%d,flags=0x%08x,%p,%p,%p,%p)\n",
       This,pIUnk,memid,wFlags,pDispParams,pVarResult,pExcepInfo,pArgErr
@@ -7096,17 +7309,12 @@ static HRESULT WINAPI ITypeInfo_fnInvoke(
         return E_INVALIDARG;
     }
 
+    if (!(index = TLB_get_member_index(This)))
+        return E_OUTOFMEMORY;
+
     /* we do this instead of using GetFuncDesc since it will return a fake
      * FUNCDESC for dispinterfaces and we want the real function description */
-    for (fdc = 0; fdc < This->typeattr.cFuncs; ++fdc){
-        pFuncInfo = &This->funcdescs[fdc];
-        if ((memid == pFuncInfo->funcdesc.memid) &&
-            (wFlags & pFuncInfo->funcdesc.invkind) &&
-            !func_restricted( &pFuncInfo->funcdesc ))
-            break;
-    }
-
-    if (fdc < This->typeattr.cFuncs) {
+    if ((pFuncInfo = TLB_find_func_by_memid(index, memid, wFlags))) {
         const FUNCDESC *func_desc = &pFuncInfo->funcdesc;
 
         if (TRACE_ON(ole))
@@ -7808,6 +8016,7 @@ static HRESULT WINAPI ITypeInfo_fnGetRefTypeInfo(
 
         *pTypeInfoImpl = *This;
         pTypeInfoImpl->ref = 0;
+        pTypeInfoImpl->member_index = NULL;
         list_init(&pTypeInfoImpl->custdata_list);
 
         if (This->typeattr.typekind == TKIND_INTERFACE)
@@ -10595,6 +10804,8 @@ static HRESULT WINAPI ICreateTypeInfo2_fnAddFuncDesc(ICreateTypeInfo2 *iface,
 
     TRACE("%p %u %p\n", This, index, funcDesc);
 
+    TLB_invalidate_member_indexes(This->pTypeLib);
+
     if (!funcDesc || funcDesc->oVft & 3)
         return E_INVALIDARG;
 
@@ -10723,6 +10934,8 @@ static HRESULT WINAPI ICreateTypeInfo2_fnAddImplType(ICreateTypeInfo2 *iface,
 
     TRACE("%p %u %d\n", This, index, refType);
 
+    TLB_invalidate_member_indexes(This->pTypeLib);
+
     switch(This->typeattr.typekind){
         case TKIND_COCLASS: {
             if (index == -1) {
@@ -10845,6 +11058,8 @@ static HRESULT WINAPI ICreateTypeInfo2_fnAddVarDesc(ICreateTypeInfo2 *iface,
 
     TRACE("%p %u %p\n", This, index, varDesc);
 
+    TLB_invalidate_member_indexes(This->pTypeLib);
+
     if (This->vardescs){
         UINT i;
 
@@ -10893,6 +11108,8 @@ static HRESULT WINAPI ICreateTypeInfo2_fnSetFuncAndParamNames(ICreateTypeInfo2 *
 
     TRACE("%p %u %p %u\n", This, index, names, numNames);
 
+    TLB_invalidate_member_indexes(This->pTypeLib);
+
     if (!names)
         return E_INVALIDARG;
 
@@ -10934,6 +11151,8 @@ static HRESULT WINAPI ICreateTypeInfo2_fnSetVarName(ICreateTypeInfo2 *iface,
 
     TRACE("%p %u %s\n", This, index, wine_dbgstr_w(name));
 
+    TLB_invalidate_member_indexes(This->pTypeLib);
+
     if(!name)
         return E_INVALIDARG;
 
@@ -11081,6 +11300,8 @@ static HRESULT WINAPI ICreateTypeInfo2_fnLayOut(ICreateTypeInfo2 *iface)
 
     TRACE("%p\n", This);
 
+    TLB_invalidate_member_indexes(This->pTypeLib);
+
     This->needs_layout = FALSE;
 
     hres = ICreateTypeInfo2_QueryInterface(iface, &IID_ITypeInfo, (LPVOID*)&tinfo);
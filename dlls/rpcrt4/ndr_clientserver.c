@@ -176,6 +176,7 @@ unsigned char *WINAPI NdrGetBuffer(PMIDL_STUB_MESSAGE stubmsg, ULONG buflen, RPC
   stubmsg->Buffer = stubmsg->RpcMsg->Buffer;
   stubmsg->fBufferValid = TRUE;
   stubmsg->BufferLength = stubmsg->RpcMsg->BufferLength;
+  stubmsg->BufferEnd = stubmsg->Buffer + stubmsg->BufferLength;
   return stubmsg->Buffer;
 }
 /***********************************************************************
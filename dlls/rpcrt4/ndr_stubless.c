@@ -132,20 +132,6 @@ static inline unsigned char *call_unmarshaller(PMIDL_STUB_MESSAGE pStubMsg, unsi
     }
 }
 
-static inline void call_freer(PMIDL_STUB_MESSAGE pStubMsg, unsigned char *pMemory,
-                              const NDR_PARAM_OIF *param)
-{
-    PFORMAT_STRING pFormat;
-    NDR_FREE m;
-
-    if (param->attr.IsBasetype) return;  /* nothing to do */
-    pFormat = &pStubMsg->StubDesc->pFormatTypes[param->u.type_offset];
-    if (!param->attr.IsByValue) pMemory = *(unsigned char **)pMemory;
-
-    m = NdrFreer[pFormat[0] & NDR_TABLE_MASK];
-    if (m) m(pStubMsg, pMemory, pFormat);
-}
-
 static DWORD calc_arg_size(MIDL_STUB_MESSAGE *pStubMsg, PFORMAT_STRING pFormat)
 {
     DWORD size;
@@ -654,6 +640,380 @@ PFORMAT_STRING convert_old_args( PMIDL_STUB_MESSAGE pStubMsg, PFORMAT_STRING pFo
     return (PFORMAT_STRING)args;
 }
 
+/* A procedure's format string compiled into the form the interpreter walks
+ * on every call. Plans are built the first time a procedure is called and
+ * live for the rest of the process. */
+struct ndr_param_plan
+{
+    const NDR_PARAM_OIF *param;
+    PFORMAT_STRING format;      /* type format, or the base type character */
+    BOOL deref;                 /* the stack holds a pointer to the data */
+    unsigned char wire_size;    /* base type stored in the buffer as it is in memory */
+    NDR_BUFFERSIZE sizer;
+    NDR_MARSHALL marshaller;
+    NDR_UNMARSHALL unmarshaller;
+    NDR_FREE freer;
+};
+
+struct ndr_proc_plan
+{
+    struct ndr_proc_plan *next;
+    const MIDL_STUB_DESC *stub_desc;
+    PFORMAT_STRING proc_format;
+    const unsigned char *format_copy;       /* to detect a different module at the same address */
+    unsigned int format_size;
+    PFORMAT_STRING handle_format;
+    PFORMAT_STRING param_format;            /* NDR_PARAM_OIF list, converted for -Oi */
+    const NDR_PROC_HEADER_EXTS *extensions;
+    unsigned short procedure_number;
+    unsigned short stack_size;
+    unsigned int number_of_params;
+    INTERPRETER_OPT_FLAGS Oif_flags;
+    INTERPRETER_OPT_FLAGS2 ext_flags;
+    /* buffer length needed by the leading fixed size [in] (client) or
+     * [out] (server) parameters, which the sizing pass can then skip */
+    unsigned int client_fixed_params;
+    ULONG client_fixed_length;
+    unsigned int server_fixed_params;
+    ULONG server_fixed_length;
+    struct ndr_param_plan params[1];
+};
+
+#define PROC_PLAN_HASH_SIZE 256
+
+static struct ndr_proc_plan *proc_plans[PROC_PLAN_HASH_SIZE];
+
+/* size and alignment of a base type in the buffer, 0 if not fixed */
+static unsigned int basetype_buffer_size( unsigned char fc )
+{
+    switch (fc)
+    {
+    case FC_BYTE:
+    case FC_CHAR:
+    case FC_SMALL:
+    case FC_USMALL:
+        return sizeof(UCHAR);
+    case FC_WCHAR:
+    case FC_SHORT:
+    case FC_USHORT:
+    case FC_ENUM16:
+        return sizeof(USHORT);
+    case FC_LONG:
+    case FC_ULONG:
+    case FC_ENUM32:
+    case FC_INT3264:
+    case FC_UINT3264:
+    case FC_FLOAT:
+    case FC_ERROR_STATUS_T:
+        return sizeof(ULONG);
+    case FC_DOUBLE:
+    case FC_HYPER:
+        return sizeof(ULONGLONG);
+    default:
+        return 0;
+    }
+}
+
+/* adds a fixed size parameter to the precomputed buffer length */
+static BOOL add_fixed_length( ULONG *length, const NDR_PARAM_OIF *param )
+{
+    unsigned int size;
+
+    if (!param->attr.IsBasetype || !(size = basetype_buffer_size( param->u.type_format_char )))
+        return FALSE;
+    *length = ((*length + size - 1) & ~(size - 1)) + size;
+    return TRUE;
+}
+
+static void compile_param_plan( const MIDL_STUB_DESC *stub_desc, struct ndr_param_plan *plan,
+                                const NDR_PARAM_OIF *param )
+{
+    unsigned char fc;
+
+    plan->param = param;
+    if (param->attr.IsBasetype)
+    {
+        plan->format = &param->u.type_format_char;
+        plan->deref = param->attr.IsSimpleRef;
+        fc = param->u.type_format_char;
+        if (fc != FC_ENUM16 && (sizeof(void *) == sizeof(ULONG) || (fc != FC_INT3264 && fc != FC_UINT3264)))
+            plan->wire_size = basetype_buffer_size( fc );
+        else
+            plan->wire_size = 0;
+    }
+    else
+    {
+        plan->format = &stub_desc->pFormatTypes[param->u.type_offset];
+        plan->deref = !param->attr.IsByValue;
+        plan->wire_size = 0;
+    }
+    plan->sizer = NdrBufferSizer[plan->format[0] & NDR_TABLE_MASK];
+    plan->marshaller = NdrMarshaller[plan->format[0] & NDR_TABLE_MASK];
+    plan->unmarshaller = NdrUnmarshaller[plan->format[0] & NDR_TABLE_MASK];
+    plan->freer = NdrFreer[plan->format[0] & NDR_TABLE_MASK];
+}
+
+static struct ndr_proc_plan *compile_proc_plan( const MIDL_STUB_DESC *stub_desc, PFORMAT_STRING proc_format )
+{
+    const NDR_PROC_HEADER *header = (const NDR_PROC_HEADER *)proc_format;
+    const NDR_PROC_HEADER_EXTS *extensions = NULL;
+    INTERPRETER_OPT_FLAGS Oif_flags = { 0 };
+    INTERPRETER_OPT_FLAGS2 ext_flags = { 0 };
+    PFORMAT_STRING format = proc_format, handle_format, param_format;
+    unsigned short procedure_number, stack_size;
+    unsigned int i, number_of_params, format_size, args_size = 0;
+    NDR_PARAM_OIF old_args[256];
+    struct ndr_proc_plan *plan;
+    const NDR_PARAM_OIF *params;
+    unsigned char *ptr;
+
+    if (header->Oi_flags & Oi_HAS_RPCFLAGS)
+    {
+        const NDR_PROC_HEADER_RPC *header_rpc = (const NDR_PROC_HEADER_RPC *)proc_format;
+        stack_size = header_rpc->stack_size;
+        procedure_number = header_rpc->proc_num;
+        format += sizeof(NDR_PROC_HEADER_RPC);
+    }
+    else
+    {
+        stack_size = header->stack_size;
+        procedure_number = header->proc_num;
+        format += sizeof(NDR_PROC_HEADER);
+    }
+
+    handle_format = format;
+    format += get_handle_desc_size( header, format );
+
+    if (is_oicf_stubdesc( stub_desc ))
+    {
+        const NDR_PROC_PARTIAL_OIF_HEADER *oif_header = (const NDR_PROC_PARTIAL_OIF_HEADER *)format;
+
+        Oif_flags = oif_header->Oi2Flags;
+        number_of_params = oif_header->number_of_params;
+        format += sizeof(NDR_PROC_PARTIAL_OIF_HEADER);
+
+        if (Oif_flags.HasExtensions)
+        {
+            extensions = (const NDR_PROC_HEADER_EXTS *)format;
+            ext_flags = extensions->Flags2;
+            format += extensions->Size;
+        }
+        param_format = format;
+        format += number_of_params * sizeof(NDR_PARAM_OIF);
+    }
+    else
+    {
+        MIDL_STUB_MESSAGE stub_msg;
+
+        stub_msg.StubDesc = stub_desc;
+        param_format = convert_old_args( &stub_msg, format, stack_size,
+                                         header->Oi_flags & Oi_OBJECT_PROC,
+                                         old_args, sizeof(old_args), &number_of_params );
+        for (i = 0; i < number_of_params; i++)
+            format += old_args[i].attr.IsBasetype ? sizeof(NDR_PARAM_OI_BASETYPE) : sizeof(NDR_PARAM_OI_OTHER);
+        args_size = number_of_params * sizeof(NDR_PARAM_OIF);
+    }
+    format_size = format - proc_format;
+
+    plan = HeapAlloc( GetProcessHeap(), 0, FIELD_OFFSET(struct ndr_proc_plan, params[number_of_params])
+                      + args_size + format_size );
+    if (!plan) RpcRaiseException( RPC_S_OUT_OF_MEMORY );
+
+    ptr = (unsigned char *)&plan->params[number_of_params];
+    if (args_size)
+    {
+        memcpy( ptr, old_args, args_size );
+        param_format = ptr;
+        ptr += args_size;
+    }
+    memcpy( ptr, proc_format, format_size );
+
+    plan->next = NULL;
+    plan->stub_desc = stub_desc;
+    plan->proc_format = proc_format;
+    plan->format_copy = ptr;
+    plan->format_size = format_size;
+    plan->handle_format = handle_format;
+    plan->param_format = param_format;
+    plan->extensions = extensions;
+    plan->procedure_number = procedure_number;
+    plan->stack_size = stack_size;
+    plan->number_of_params = number_of_params;
+    plan->Oif_flags = Oif_flags;
+    plan->ext_flags = ext_flags;
+    plan->client_fixed_length = plan->server_fixed_length = 0;
+
+    params = (const NDR_PARAM_OIF *)param_format;
+    for (i = 0; i < number_of_params; i++)
+        compile_param_plan( stub_desc, &plan->params[i], &params[i] );
+
+    for (i = 0; i < number_of_params; i++)
+        if (params[i].attr.IsIn && !add_fixed_length( &plan->client_fixed_length, &params[i] )) break;
+    plan->client_fixed_params = i;
+
+    for (i = 0; i < number_of_params; i++)
+        if ((params[i].attr.IsOut || params[i].attr.IsReturn) &&
+            !add_fixed_length( &plan->server_fixed_length, &params[i] )) break;
+    plan->server_fixed_params = i;
+
+    TRACE( "proc %u: %u params, client fixed %u/%u bytes, server fixed %u/%u bytes\n",
+           procedure_number, number_of_params, plan->client_fixed_params, plan->client_fixed_length,
+           plan->server_fixed_params, plan->server_fixed_length );
+    return plan;
+}
+
+static const struct ndr_proc_plan *get_proc_plan( const MIDL_STUB_DESC *stub_desc, PFORMAT_STRING proc_format )
+{
+    struct ndr_proc_plan **head = &proc_plans[((ULONG_PTR)proc_format >> 2) % PROC_PLAN_HASH_SIZE];
+    struct ndr_proc_plan *plan, *next;
+
+    for (plan = *head; plan; plan = plan->next)
+    {
+        if (plan->proc_format == proc_format && plan->stub_desc == stub_desc &&
+            !memcmp( plan->format_copy, proc_format, plan->format_size ))
+            return plan;
+    }
+
+    plan = compile_proc_plan( stub_desc, proc_format );
+    do
+    {
+        next = *head;
+        plan->next = next;
+    } while (InterlockedCompareExchangePointer( (void **)head, plan, next ) != next);
+    return plan;
+}
+
+static inline unsigned char *plan_arg_memory( const struct ndr_param_plan *plan, unsigned char *arg )
+{
+    return plan->deref ? *(unsigned char **)arg : arg;
+}
+
+static void plan_buffer_size( MIDL_STUB_MESSAGE *stub_msg, unsigned char *arg, const struct ndr_param_plan *plan )
+{
+    if (!plan->sizer)
+    {
+        FIXME("format type 0x%x not implemented\n", plan->format[0]);
+        RpcRaiseException(RPC_X_BAD_STUB_DATA);
+    }
+    plan->sizer( stub_msg, plan_arg_memory( plan, arg ), plan->format );
+}
+
+static void plan_marshall( MIDL_STUB_MESSAGE *stub_msg, unsigned char *arg, const struct ndr_param_plan *plan )
+{
+    unsigned int size = plan->wire_size;
+
+    if (size)
+    {
+        unsigned char *buffer = (unsigned char *)(((ULONG_PTR)stub_msg->Buffer + size - 1) & ~(ULONG_PTR)(size - 1));
+        if (buffer < stub_msg->Buffer || buffer + size < buffer || buffer + size > stub_msg->BufferEnd)
+        {
+            ERR("buffer overflow - Buffer = %p, BufferEnd = %p, size = %u\n",
+                stub_msg->Buffer, stub_msg->BufferEnd, size);
+            RpcRaiseException(RPC_X_BAD_STUB_DATA);
+        }
+        memset( stub_msg->Buffer, 0, buffer - stub_msg->Buffer );
+        memcpy( buffer, plan_arg_memory( plan, arg ), size );
+        stub_msg->Buffer = buffer + size;
+        return;
+    }
+    if (!plan->marshaller)
+    {
+        FIXME("format type 0x%x not implemented\n", plan->format[0]);
+        RpcRaiseException(RPC_X_BAD_STUB_DATA);
+    }
+    plan->marshaller( stub_msg, plan_arg_memory( plan, arg ), plan->format );
+}
+
+static void plan_unmarshall( MIDL_STUB_MESSAGE *stub_msg, unsigned char **arg, const struct ndr_param_plan *plan )
+{
+    if (!plan->unmarshaller)
+    {
+        FIXME("format type 0x%x not implemented\n", plan->format[0]);
+        RpcRaiseException(RPC_X_BAD_STUB_DATA);
+    }
+    if (plan->deref) arg = (unsigned char **)*arg;
+    plan->unmarshaller( stub_msg, arg, plan->format, 0 );
+}
+
+static void plan_free( MIDL_STUB_MESSAGE *stub_msg, unsigned char *arg, const struct ndr_param_plan *plan )
+{
+    if (plan->param->attr.IsBasetype || !plan->freer) return;
+    plan->freer( stub_msg, plan_arg_memory( plan, arg ), plan->format );
+}
+
+static void client_do_plan_args( MIDL_STUB_MESSAGE *stub_msg, const struct ndr_proc_plan *plan,
+                                 enum stubless_phase phase, void **fpu_args, unsigned char *retval )
+{
+    unsigned int i = 0;
+
+    if (phase == STUBLESS_CALCSIZE && !stub_msg->BufferLength)
+    {
+        for (i = 0; i < plan->client_fixed_params; i++)
+        {
+            if (plan->params[i].param->attr.IsSimpleRef &&
+                !*(unsigned char **)(stub_msg->StackTop + plan->params[i].param->stack_offset))
+                RpcRaiseException(RPC_X_NULL_REF_POINTER);
+        }
+        stub_msg->BufferLength = plan->client_fixed_length;
+    }
+
+    for (; i < plan->number_of_params; i++)
+    {
+        const struct ndr_param_plan *param_plan = &plan->params[i];
+        const NDR_PARAM_OIF *param = param_plan->param;
+        unsigned char *arg = stub_msg->StackTop + param->stack_offset;
+
+#ifdef __x86_64__  /* floats are passed as doubles through varargs functions */
+        float f;
+
+        if (param->attr.IsBasetype &&
+            param->u.type_format_char == FC_FLOAT &&
+            !param->attr.IsSimpleRef &&
+            !fpu_args)
+        {
+            f = *(double *)arg;
+            arg = (unsigned char *)&f;
+        }
+#endif
+
+        TRACE("param[%d]: %p type %02x %s\n", i, arg, param_plan->format[0], debugstr_PROC_PF( param->attr ));
+
+        switch (phase)
+        {
+        case STUBLESS_INITOUT:
+            if (*(unsigned char **)arg)
+            {
+                if (param_needs_alloc(param->attr))
+                    memset( *(unsigned char **)arg, 0, calc_arg_size( stub_msg, param_plan->format ));
+                else if (param_is_out_basetype(param->attr))
+                    memset( *(unsigned char **)arg, 0, basetype_arg_size( param->u.type_format_char ));
+            }
+            break;
+        case STUBLESS_CALCSIZE:
+            if (param->attr.IsSimpleRef && !*(unsigned char **)arg)
+                RpcRaiseException(RPC_X_NULL_REF_POINTER);
+            if (param->attr.IsIn) plan_buffer_size(stub_msg, arg, param_plan);
+            break;
+        case STUBLESS_MARSHAL:
+            if (param->attr.IsIn) plan_marshall(stub_msg, arg, param_plan);
+            break;
+        case STUBLESS_UNMARSHAL:
+            if (param->attr.IsOut)
+            {
+                if (param->attr.IsReturn && retval) arg = retval;
+                plan_unmarshall(stub_msg, &arg, param_plan);
+            }
+            break;
+        case STUBLESS_FREE:
+            if (!param->attr.IsBasetype && param->attr.IsOut && !param->attr.IsByValue)
+                NdrClearOutParameters( stub_msg, param_plan->format, *(unsigned char **)arg );
+            break;
+        default:
+            RpcRaiseException(RPC_S_INTERNAL_ERROR);
+        }
+    }
+}
+
 struct ndr_client_call_ctx
 {
     MIDL_STUB_MESSAGE *stub_msg;
@@ -696,11 +1056,14 @@ static void CALLBACK ndr_client_call_finally(BOOL normal, void *arg)
 
 /* Helper for ndr_client_call, to factor out the part that may or may not be
  * guarded by a try/except block. */
-static LONG_PTR do_ndr_client_call( const MIDL_STUB_DESC *stub_desc, const PFORMAT_STRING format,
-        const PFORMAT_STRING handle_format, void **stack_top, void **fpu_stack, MIDL_STUB_MESSAGE *stub_msg,
-        unsigned short procedure_number, unsigned short stack_size, unsigned int number_of_params,
-        INTERPRETER_OPT_FLAGS Oif_flags, INTERPRETER_OPT_FLAGS2 ext_flags, const NDR_PROC_HEADER *proc_header )
+static LONG_PTR do_ndr_client_call( const MIDL_STUB_DESC *stub_desc, const struct ndr_proc_plan *plan,
+        void **stack_top, void **fpu_stack, MIDL_STUB_MESSAGE *stub_msg )
 {
+    const NDR_PROC_HEADER *proc_header = (const NDR_PROC_HEADER *)plan->proc_format;
+    const PFORMAT_STRING format = plan->param_format;
+    const PFORMAT_STRING handle_format = plan->handle_format;
+    INTERPRETER_OPT_FLAGS Oif_flags = plan->Oif_flags;
+    INTERPRETER_OPT_FLAGS2 ext_flags = plan->ext_flags;
     struct ndr_client_call_ctx finally_ctx;
     RPC_MESSAGE rpc_msg;
     handle_t hbinding = NULL;
@@ -719,7 +1082,7 @@ static LONG_PTR do_ndr_client_call( const MIDL_STUB_DESC *stub_desc, const PFORM
     {
         /* object is always the first argument */
         This = stack_top[0];
-        NdrProxyInitialize(This, &rpc_msg, stub_msg, stub_desc, procedure_number);
+        NdrProxyInitialize(This, &rpc_msg, stub_msg, stub_desc, plan->procedure_number);
     }
 
     finally_ctx.stub_msg = stub_msg;
@@ -733,7 +1096,7 @@ static LONG_PTR do_ndr_client_call( const MIDL_STUB_DESC *stub_desc, const PFORM
     __TRY
     {
         if (!(proc_header->Oi_flags & Oi_OBJECT_PROC))
-            NdrClientInitializeNew(&rpc_msg, stub_msg, stub_desc, procedure_number);
+            NdrClientInitializeNew(&rpc_msg, stub_msg, stub_desc, plan->procedure_number);
 
         stub_msg->StackTop = (unsigned char *)stack_top;
 
@@ -783,14 +1146,12 @@ static LONG_PTR do_ndr_client_call( const MIDL_STUB_DESC *stub_desc, const PFORM
         if (proc_header->Oi_flags & Oi_OBJECT_PROC)
         {
             TRACE( "INITOUT\n" );
-            client_do_args(stub_msg, format, STUBLESS_INITOUT, fpu_stack,
-                           number_of_params, (unsigned char *)&retval);
+            client_do_plan_args(stub_msg, plan, STUBLESS_INITOUT, fpu_stack, (unsigned char *)&retval);
         }
 
         /* 2. CALCSIZE */
         TRACE( "CALCSIZE\n" );
-        client_do_args(stub_msg, format, STUBLESS_CALCSIZE, fpu_stack,
-                       number_of_params, (unsigned char *)&retval);
+        client_do_plan_args(stub_msg, plan, STUBLESS_CALCSIZE, fpu_stack, (unsigned char *)&retval);
 
         /* 3. GETBUFFER */
         TRACE( "GETBUFFER\n" );
@@ -809,8 +1170,7 @@ static LONG_PTR do_ndr_client_call( const MIDL_STUB_DESC *stub_desc, const PFORM
 
         /* 4. MARSHAL */
         TRACE( "MARSHAL\n" );
-        client_do_args(stub_msg, format, STUBLESS_MARSHAL, fpu_stack,
-                       number_of_params, (unsigned char *)&retval);
+        client_do_plan_args(stub_msg, plan, STUBLESS_MARSHAL, fpu_stack, (unsigned char *)&retval);
 
         /* 5. SENDRECEIVE */
         TRACE( "SENDRECEIVE\n" );
@@ -835,8 +1195,7 @@ static LONG_PTR do_ndr_client_call( const MIDL_STUB_DESC *stub_desc, const PFORM
 
         /* 6. UNMARSHAL */
         TRACE( "UNMARSHAL\n" );
-        client_do_args(stub_msg, format, STUBLESS_UNMARSHAL, fpu_stack,
-                       number_of_params, (unsigned char *)&retval);
+        client_do_plan_args(stub_msg, plan, STUBLESS_UNMARSHAL, fpu_stack, (unsigned char *)&retval);
     }
     __FINALLY_CTX(ndr_client_call_finally, &finally_ctx)
 
@@ -848,104 +1207,51 @@ LONG_PTR CDECL DECLSPEC_HIDDEN ndr_client_call( PMIDL_STUB_DESC pStubDesc, PFORM
 {
     /* pointer to start of stack where arguments start */
     MIDL_STUB_MESSAGE stubMsg;
-    /* procedure number */
-    unsigned short procedure_number;
-    /* size of stack */
-    unsigned short stack_size;
-    /* number of parameters. optional for client to give it to us */
-    unsigned int number_of_params;
-    /* cache of Oif_flags from v2 procedure header */
-    INTERPRETER_OPT_FLAGS Oif_flags = { 0 };
-    /* cache of extension flags from NDR_PROC_HEADER_EXTS */
-    INTERPRETER_OPT_FLAGS2 ext_flags = { 0 };
+    /* compiled form of the procedure format string */
+    const struct ndr_proc_plan *plan;
     /* header for procedure string */
     const NDR_PROC_HEADER * pProcHeader = (const NDR_PROC_HEADER *)&pFormat[0];
     /* the value to return to the client from the remote procedure */
     LONG_PTR RetVal = 0;
-    PFORMAT_STRING pHandleFormat;
-    NDR_PARAM_OIF old_args[256];
 
     TRACE("pStubDesc %p, pFormat %p, ...\n", pStubDesc, pFormat);
 
     TRACE("NDR Version: 0x%x\n", pStubDesc->Version);
 
-    if (pProcHeader->Oi_flags & Oi_HAS_RPCFLAGS)
-    {
-        const NDR_PROC_HEADER_RPC *header_rpc = (const NDR_PROC_HEADER_RPC *)&pFormat[0];
-        stack_size = header_rpc->stack_size;
-        procedure_number = header_rpc->proc_num;
-        pFormat += sizeof(NDR_PROC_HEADER_RPC);
-    }
-    else
-    {
-        stack_size = pProcHeader->stack_size;
-        procedure_number = pProcHeader->proc_num;
-        pFormat += sizeof(NDR_PROC_HEADER);
-    }
-    TRACE("stack size: 0x%x\n", stack_size);
-    TRACE("proc num: %d\n", procedure_number);
+    plan = get_proc_plan(pStubDesc, pFormat);
+
+    TRACE("stack size: 0x%x\n", plan->stack_size);
+    TRACE("proc num: %d\n", plan->procedure_number);
     TRACE("Oi_flags = 0x%02x\n", pProcHeader->Oi_flags);
     TRACE("MIDL stub version = 0x%x\n", pStubDesc->MIDLVersion);
+    if (is_oicf_stubdesc(pStubDesc))
+        TRACE("Oif_flags = %s\n", debugstr_INTERPRETER_OPT_FLAGS(plan->Oif_flags) );
 
-    pHandleFormat = pFormat;
-
-    /* we only need a handle if this isn't an object method */
-    if (!(pProcHeader->Oi_flags & Oi_OBJECT_PROC))
-        pFormat += get_handle_desc_size(pProcHeader, pFormat);
-
-    if (is_oicf_stubdesc(pStubDesc))  /* -Oicf format */
-    {
-        const NDR_PROC_PARTIAL_OIF_HEADER *pOIFHeader =
-            (const NDR_PROC_PARTIAL_OIF_HEADER *)pFormat;
-
-        Oif_flags = pOIFHeader->Oi2Flags;
-        number_of_params = pOIFHeader->number_of_params;
-
-        pFormat += sizeof(NDR_PROC_PARTIAL_OIF_HEADER);
-
-        TRACE("Oif_flags = %s\n", debugstr_INTERPRETER_OPT_FLAGS(Oif_flags) );
-
-        if (Oif_flags.HasExtensions)
-        {
-            const NDR_PROC_HEADER_EXTS *pExtensions = (const NDR_PROC_HEADER_EXTS *)pFormat;
-            ext_flags = pExtensions->Flags2;
-            pFormat += pExtensions->Size;
 #ifdef __x86_64__
-            if (pExtensions->Size > sizeof(*pExtensions) && fpu_stack)
+    if (plan->extensions && plan->extensions->Size > sizeof(*plan->extensions) && fpu_stack)
+    {
+        int i;
+        unsigned short fpu_mask = *(unsigned short *)(plan->extensions + 1);
+        for (i = 0; i < 4; i++, fpu_mask >>= 2)
+            switch (fpu_mask & 3)
             {
-                int i;
-                unsigned short fpu_mask = *(unsigned short *)(pExtensions + 1);
-                for (i = 0; i < 4; i++, fpu_mask >>= 2)
-                    switch (fpu_mask & 3)
-                    {
-                    case 1: *(float *)&stack_top[i] = *(float *)&fpu_stack[i]; break;
-                    case 2: *(double *)&stack_top[i] = *(double *)&fpu_stack[i]; break;
-                    }
+            case 1: *(float *)&stack_top[i] = *(float *)&fpu_stack[i]; break;
+            case 2: *(double *)&stack_top[i] = *(double *)&fpu_stack[i]; break;
             }
-#endif
-        }
-    }
-    else
-    {
-        pFormat = convert_old_args( &stubMsg, pFormat, stack_size,
-                                    pProcHeader->Oi_flags & Oi_OBJECT_PROC,
-                                    old_args, sizeof(old_args), &number_of_params );
     }
+#endif
 
     if (pProcHeader->Oi_flags & Oi_OBJECT_PROC)
     {
         __TRY
         {
-            RetVal = do_ndr_client_call(pStubDesc, pFormat, pHandleFormat,
-                    stack_top, fpu_stack, &stubMsg, procedure_number, stack_size,
-                    number_of_params, Oif_flags, ext_flags, pProcHeader);
+            RetVal = do_ndr_client_call(pStubDesc, plan, stack_top, fpu_stack, &stubMsg);
         }
         __EXCEPT_ALL
         {
             /* 7. FREE */
             TRACE( "FREE\n" );
-            client_do_args(&stubMsg, pFormat, STUBLESS_FREE, fpu_stack,
-                           number_of_params, (unsigned char *)&RetVal);
+            client_do_plan_args(&stubMsg, plan, STUBLESS_FREE, fpu_stack, (unsigned char *)&RetVal);
             RetVal = NdrProxyErrorHandler(GetExceptionCode());
         }
         __ENDTRY
@@ -954,13 +1260,11 @@ LONG_PTR CDECL DECLSPEC_HIDDEN ndr_client_call( PMIDL_STUB_DESC pStubDesc, PFORM
     {
         __TRY
         {
-            RetVal = do_ndr_client_call(pStubDesc, pFormat, pHandleFormat,
-                    stack_top, fpu_stack, &stubMsg, procedure_number, stack_size,
-                    number_of_params, Oif_flags, ext_flags, pProcHeader);
+            RetVal = do_ndr_client_call(pStubDesc, plan, stack_top, fpu_stack, &stubMsg);
         }
         __EXCEPT_ALL
         {
-            const COMM_FAULT_OFFSETS *comm_fault_offsets = &pStubDesc->CommFaultOffsets[procedure_number];
+            const COMM_FAULT_OFFSETS *comm_fault_offsets = &pStubDesc->CommFaultOffsets[plan->procedure_number];
             ULONG *comm_status;
             ULONG *fault_status;
 
@@ -987,9 +1291,7 @@ LONG_PTR CDECL DECLSPEC_HIDDEN ndr_client_call( PMIDL_STUB_DESC pStubDesc, PFORM
     }
     else
     {
-        RetVal = do_ndr_client_call(pStubDesc, pFormat, pHandleFormat,
-                stack_top, fpu_stack, &stubMsg, procedure_number, stack_size,
-                number_of_params, Oif_flags, ext_flags, pProcHeader);
+        RetVal = do_ndr_client_call(pStubDesc, plan, stack_top, fpu_stack, &stubMsg);
     }
 
     TRACE("RetVal = 0x%lx\n", RetVal);
@@ -1174,54 +1476,59 @@ LONG_PTR __cdecl call_server_func(SERVER_ROUTINE func, unsigned char * args, uns
 #endif
 
 static LONG_PTR *stub_do_args(MIDL_STUB_MESSAGE *pStubMsg,
-                              PFORMAT_STRING pFormat, enum stubless_phase phase,
-                              unsigned short number_of_params)
+                              const struct ndr_proc_plan *plan, enum stubless_phase phase)
 {
-    const NDR_PARAM_OIF *params = (const NDR_PARAM_OIF *)pFormat;
-    unsigned int i;
+    unsigned int i = 0;
     LONG_PTR *retval_ptr = NULL;
 
-    for (i = 0; i < number_of_params; i++)
+    if (phase == STUBLESS_CALCSIZE && !pStubMsg->BufferLength)
     {
-        unsigned char *pArg = pStubMsg->StackTop + params[i].stack_offset;
-        const unsigned char *pTypeFormat = &pStubMsg->StubDesc->pFormatTypes[params[i].u.type_offset];
+        pStubMsg->BufferLength = plan->server_fixed_length;
+        i = plan->server_fixed_params;
+    }
+
+    for (; i < plan->number_of_params; i++)
+    {
+        const struct ndr_param_plan *param_plan = &plan->params[i];
+        const NDR_PARAM_OIF *param = param_plan->param;
+        unsigned char *pArg = pStubMsg->StackTop + param->stack_offset;
+        const unsigned char *pTypeFormat = param_plan->format;
 
         TRACE("param[%d]: %p -> %p type %02x %s\n", i,
-              pArg, *(unsigned char **)pArg,
-              params[i].attr.IsBasetype ? params[i].u.type_format_char : *pTypeFormat,
-              debugstr_PROC_PF( params[i].attr ));
+              pArg, *(unsigned char **)pArg, param_plan->format[0],
+              debugstr_PROC_PF( param->attr ));
 
         switch (phase)
         {
         case STUBLESS_MARSHAL:
-            if (params[i].attr.IsOut || params[i].attr.IsReturn)
-                call_marshaller(pStubMsg, pArg, &params[i]);
+            if (param->attr.IsOut || param->attr.IsReturn)
+                plan_marshall(pStubMsg, pArg, param_plan);
             break;
         case STUBLESS_MUSTFREE:
-            if (params[i].attr.MustFree)
+            if (param->attr.MustFree)
             {
-                call_freer(pStubMsg, pArg, &params[i]);
+                plan_free(pStubMsg, pArg, param_plan);
             }
             break;
         case STUBLESS_FREE:
-            if (params[i].attr.ServerAllocSize)
+            if (param->attr.ServerAllocSize)
             {
                 HeapFree(GetProcessHeap(), 0, *(void **)pArg);
             }
-            else if (param_needs_alloc(params[i].attr) &&
-                     (!params[i].attr.MustFree || params[i].attr.IsSimpleRef))
+            else if (param_needs_alloc(param->attr) &&
+                     (!param->attr.MustFree || param->attr.IsSimpleRef))
             {
                 if (*pTypeFormat != FC_BIND_CONTEXT) pStubMsg->pfnFree(*(void **)pArg);
             }
             break;
         case STUBLESS_INITOUT:
-            if (param_needs_alloc(params[i].attr) && !params[i].attr.ServerAllocSize)
+            if (param_needs_alloc(param->attr) && !param->attr.ServerAllocSize)
             {
                 if (*pTypeFormat == FC_BIND_CONTEXT)
                 {
                     NDR_SCONTEXT ctxt = NdrContextHandleInitialize(pStubMsg, pTypeFormat);
                     *(void **)pArg = NDRSContextValue(ctxt);
-                    if (params[i].attr.IsReturn) retval_ptr = (LONG_PTR *)NDRSContextValue(ctxt);
+                    if (param->attr.IsReturn) retval_ptr = (LONG_PTR *)NDRSContextValue(ctxt);
                 }
                 else
                 {
@@ -1233,19 +1540,19 @@ static LONG_PTR *stub_do_args(MIDL_STUB_MESSAGE *pStubMsg,
                     }
                 }
             }
-            if (!retval_ptr && params[i].attr.IsReturn) retval_ptr = (LONG_PTR *)pArg;
+            if (!retval_ptr && param->attr.IsReturn) retval_ptr = (LONG_PTR *)pArg;
             break;
         case STUBLESS_UNMARSHAL:
-            if (params[i].attr.ServerAllocSize)
+            if (param->attr.ServerAllocSize)
                 *(void **)pArg = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY,
-                                           params[i].attr.ServerAllocSize * 8);
+                                           param->attr.ServerAllocSize * 8);
 
-            if (params[i].attr.IsIn)
-                call_unmarshaller(pStubMsg, &pArg, &params[i], 0);
+            if (param->attr.IsIn)
+                plan_unmarshall(pStubMsg, &pArg, param_plan);
             break;
         case STUBLESS_CALCSIZE:
-            if (params[i].attr.IsOut || params[i].attr.IsReturn)
-                call_buffer_sizer(pStubMsg, pArg, &params[i]);
+            if (param->attr.IsOut || param->attr.IsReturn)
+                plan_buffer_size(pStubMsg, pArg, param_plan);
             break;
         default:
             RpcRaiseException(RPC_S_INTERNAL_ERROR);
@@ -1276,14 +1583,8 @@ LONG WINAPI NdrStubCall2(
     MIDL_STUB_MESSAGE stubMsg;
     /* pointer to start of stack to pass into stub implementation */
     unsigned char * args;
-    /* size of stack */
-    unsigned short stack_size;
-    /* number of parameters. optional for client to give it to us */
-    unsigned int number_of_params;
-    /* cache of Oif_flags from v2 procedure header */
-    INTERPRETER_OPT_FLAGS Oif_flags = { 0 };
-    /* cache of extension flags from NDR_PROC_HEADER_EXTS */
-    INTERPRETER_OPT_FLAGS2 ext_flags = { 0 };
+    /* compiled form of the procedure format string */
+    const struct ndr_proc_plan *plan;
     /* the type of pass we are currently doing */
     enum stubless_phase phase;
     /* header for procedure string */
@@ -1306,18 +1607,7 @@ LONG WINAPI NdrStubCall2(
 
     TRACE("NDR Version: 0x%x\n", pStubDesc->Version);
 
-    if (pProcHeader->Oi_flags & Oi_HAS_RPCFLAGS)
-    {
-        const NDR_PROC_HEADER_RPC *header_rpc = (const NDR_PROC_HEADER_RPC *)&pFormat[0];
-        stack_size = header_rpc->stack_size;
-        pFormat += sizeof(NDR_PROC_HEADER_RPC);
-
-    }
-    else
-    {
-        stack_size = pProcHeader->stack_size;
-        pFormat += sizeof(NDR_PROC_HEADER);
-    }
+    plan = get_proc_plan(pStubDesc, pFormat);
 
     TRACE("Oi_flags = 0x%02x\n", pProcHeader->Oi_flags);
 
@@ -1326,16 +1616,11 @@ LONG WINAPI NdrStubCall2(
     {
     /* explicit binding: parse additional section */
     case 0:
-        switch (*pFormat) /* handle_type */
+        switch (*plan->handle_format) /* handle_type */
         {
         case FC_BIND_PRIMITIVE: /* explicit primitive */
-            pFormat += sizeof(NDR_EHD_PRIMITIVE);
-            break;
         case FC_BIND_GENERIC: /* explicit generic */
-            pFormat += sizeof(NDR_EHD_GENERIC);
-            break;
         case FC_BIND_CONTEXT: /* explicit context */
-            pFormat += sizeof(NDR_EHD_CONTEXT);
             break;
         default:
             ERR("bad explicit binding handle type (0x%02x)\n", pProcHeader->handle_type);
@@ -1373,9 +1658,9 @@ LONG WINAPI NdrStubCall2(
           FIXME("Set RPCSS memory allocation routines\n");
 #endif
 
-    TRACE("allocating memory for stack of size %x\n", stack_size);
+    TRACE("allocating memory for stack of size %x\n", plan->stack_size);
 
-    args = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, stack_size);
+    args = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, plan->stack_size);
     stubMsg.StackTop = args; /* used by conformance of top-level objects */
 
     /* add the implicit This pointer as the first arg to the function if we
@@ -1385,49 +1670,28 @@ LONG WINAPI NdrStubCall2(
 
     if (is_oicf_stubdesc(pStubDesc))
     {
-        const NDR_PROC_PARTIAL_OIF_HEADER *pOIFHeader = (const NDR_PROC_PARTIAL_OIF_HEADER *)pFormat;
-
-        Oif_flags = pOIFHeader->Oi2Flags;
-        number_of_params = pOIFHeader->number_of_params;
-
-        pFormat += sizeof(NDR_PROC_PARTIAL_OIF_HEADER);
-
-        TRACE("Oif_flags = %s\n", debugstr_INTERPRETER_OPT_FLAGS(Oif_flags) );
-
-        if (Oif_flags.HasExtensions)
-        {
-            const NDR_PROC_HEADER_EXTS *pExtensions = (const NDR_PROC_HEADER_EXTS *)pFormat;
-            ext_flags = pExtensions->Flags2;
-            pFormat += pExtensions->Size;
-        }
+        TRACE("Oif_flags = %s\n", debugstr_INTERPRETER_OPT_FLAGS(plan->Oif_flags) );
 
-        if (Oif_flags.HasPipes)
+        if (plan->Oif_flags.HasPipes)
         {
             FIXME("pipes not supported yet\n");
             RpcRaiseException(RPC_X_WRONG_STUB_VERSION); /* FIXME: remove when implemented */
             /* init pipes package */
             /* NdrPipesInitialize(...) */
         }
-        if (ext_flags.HasNewCorrDesc)
+        if (plan->ext_flags.HasNewCorrDesc)
         {
             /* initialize extra correlation package */
             NdrCorrelationInitialize(&stubMsg, NdrCorrCache, sizeof(NdrCorrCache), 0);
-            if (ext_flags.Unused & 0x2) /* has range on conformance */
+            if (plan->ext_flags.Unused & 0x2) /* has range on conformance */
                 stubMsg.CorrDespIncrement = 12;
         }
     }
-    else
-    {
-        pFormat = convert_old_args( &stubMsg, pFormat, stack_size,
-                                    pProcHeader->Oi_flags & Oi_OBJECT_PROC,
-                                    /* reuse the correlation cache, it's not needed for v1 format */
-                                    NdrCorrCache, sizeof(NdrCorrCache), &number_of_params );
-    }
 
     /* convert strings, floating point values and endianness into our
      * preferred format */
     if ((pRpcMsg->DataRepresentation & 0x0000FFFFUL) != NDR_LOCAL_DATA_REPRESENTATION)
-        NdrConvert(&stubMsg, pFormat);
+        NdrConvert(&stubMsg, plan->param_format);
 
     for (phase = STUBLESS_UNMARSHAL; phase <= STUBLESS_FREE; phase++)
     {
@@ -1452,7 +1716,7 @@ LONG WINAPI NdrStubCall2(
                     func = pServerInfo->DispatchTable[pRpcMsg->ProcNum];
 
                 /* FIXME: what happens with return values that don't fit into a single register on x86? */
-                retval = call_server_func(func, args, stack_size);
+                retval = call_server_func(func, args, plan->stack_size);
 
                 if (retval_ptr)
                 {
@@ -1482,13 +1746,23 @@ LONG WINAPI NdrStubCall2(
                 stubMsg.Buffer = pRpcMsg->Buffer;
             }
             break;
+        case STUBLESS_MARSHAL:
+        {
+            /* BufferEnd has to keep describing the request buffer for the
+             * free phase, see PointerFree() */
+            unsigned char *request_end = stubMsg.BufferEnd;
+
+            stubMsg.BufferEnd = (unsigned char *)pRpcMsg->Buffer + pRpcMsg->BufferLength;
+            retval_ptr = stub_do_args(&stubMsg, plan, phase);
+            stubMsg.BufferEnd = request_end;
+            break;
+        }
         case STUBLESS_UNMARSHAL:
         case STUBLESS_INITOUT:
         case STUBLESS_CALCSIZE:
-        case STUBLESS_MARSHAL:
         case STUBLESS_MUSTFREE:
         case STUBLESS_FREE:
-            retval_ptr = stub_do_args(&stubMsg, pFormat, phase, number_of_params);
+            retval_ptr = stub_do_args(&stubMsg, plan, phase);
             break;
         default:
             ERR("shouldn't reach here. phase %d\n", phase);
@@ -1498,13 +1772,13 @@ LONG WINAPI NdrStubCall2(
 
     pRpcMsg->BufferLength = (unsigned int)(stubMsg.Buffer - (unsigned char *)pRpcMsg->Buffer);
 
-    if (ext_flags.HasNewCorrDesc)
+    if (plan->ext_flags.HasNewCorrDesc)
     {
         /* free extra correlation package */
         NdrCorrelationFree(&stubMsg);
     }
 
-    if (Oif_flags.HasPipes)
+    if (plan->Oif_flags.HasPipes)
     {
         /* NdrPipesDone(...) */
     }
@@ -59,6 +59,8 @@ static RpcConnection *rpcrt4_spawn_connection(RpcConnection *old_connection);
 
 /**** ncacn_np support ****/
 
+struct lrpc_channel;
+
 typedef struct _RpcConnection_np
 {
     RpcConnection common;
@@ -68,8 +70,12 @@ typedef struct _RpcConnection_np
     IO_STATUS_BLOCK io_status;
     HANDLE event_cache;
     BOOL read_closed;
+    struct lrpc_channel *shm;   /* ncalrpc only: shared memory channel replacing pipe I/O */
+    BOOL shm_checked;           /* ncalrpc server only: first message looked at */
 } RpcConnection_np;
 
+static RPC_STATUS lrpc_offer_channel(RpcConnection_np *npc);
+
 static RpcConnection *rpcrt4_conn_np_alloc(void)
 {
   RpcConnection_np *npc = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(RpcConnection_np));
@@ -199,6 +205,9 @@ static RPC_STATUS rpcrt4_ncalrpc_open(RpcConnection* Connection)
   r = rpcrt4_conn_open_pipe(Connection, pname, TRUE);
   I_RpcFree(pname);
 
+  if (r == RPC_S_OK)
+    r = lrpc_offer_channel(npc);
+
   return r;
 }
 
@@ -469,6 +478,470 @@ static int rpcrt4_conn_np_wait_for_incoming_data(RpcConnection *Connection)
     return -1;
 }
 
+/**** ncalrpc shared memory channel ****/
+
+/* Once an ncalrpc pipe is connected, the client offers to move the traffic
+ * to a pair of rings in a section shared with the server. The server creates
+ * the section and the events and duplicates them into the client, which
+ * acknowledges the reply once it has mapped the section. Only then do both
+ * sides switch; otherwise the connection stays on the pipe, which is kept
+ * open for impersonation in any case.
+ *
+ * The offer is exactly as large as a packet common header, which is what
+ * the server reads first from a new connection, and its magic can never be
+ * a valid rpc_ver.
+ *
+ * The peer can write to the section at any time, so apart from the ring
+ * positions and the closed flag nothing is read back from it, and the
+ * positions are only used masked with our own copy of the ring size. */
+
+#define LRPC_OFFER_MAGIC    0x4d48534c  /* "LSHM" */
+#define LRPC_RING_SIZE      0x10000
+#define LRPC_MIN_RING_SIZE  0x1000
+#define LRPC_MAX_RING_SIZE  0x100000
+
+/* sent by the client as offer and as acknowledgement */
+struct lrpc_offer
+{
+    ULONG magic;
+    ULONG ring_size;
+    ULONG status;
+    ULONG reserved;
+};
+
+C_ASSERT(sizeof(struct lrpc_offer) == sizeof(RpcPktCommonHdr));
+
+/* sent by the server, handles are in the client process */
+struct lrpc_reply
+{
+    ULONG magic;
+    ULONG ring_size;
+    ULONG status;
+    ULONG section;
+    ULONG events[4];    /* data and space events of both rings */
+};
+
+struct lrpc_ring
+{
+    volatile LONG read_pos;
+    volatile LONG write_pos;
+    volatile LONG reader_waiting;
+    volatile LONG writer_waiting;
+};
+
+struct lrpc_shm
+{
+    volatile LONG closed;
+    struct lrpc_ring rings[2];  /* client to server, server to client */
+    /* followed by the data of both rings */
+};
+
+struct lrpc_channel
+{
+    struct lrpc_shm *shm;
+    ULONG ring_size;
+    HANDLE section;
+    HANDLE peer_process;
+    struct lrpc_ring *in, *out;
+    unsigned char *in_data, *out_data;
+    HANDLE in_data_event;   /* waited on by us as reader */
+    HANDLE in_space_event;  /* set by us as reader */
+    HANDLE out_data_event;  /* set by us as writer */
+    HANDLE out_space_event; /* waited on by us as writer */
+    LONG cancelled;
+};
+
+static inline SIZE_T lrpc_section_size(ULONG ring_size)
+{
+    return sizeof(struct lrpc_shm) + 2 * (SIZE_T)ring_size;
+}
+
+static inline BOOL lrpc_valid_ring_size(ULONG ring_size)
+{
+    return ring_size >= LRPC_MIN_RING_SIZE && ring_size <= LRPC_MAX_RING_SIZE &&
+           !(ring_size & (ring_size - 1));
+}
+
+static void lrpc_init_channel(struct lrpc_channel *channel, BOOL server)
+{
+    unsigned char *data = (unsigned char *)(channel->shm + 1);
+
+    channel->in = &channel->shm->rings[server ? 0 : 1];
+    channel->out = &channel->shm->rings[server ? 1 : 0];
+    channel->in_data = data + (server ? 0 : channel->ring_size);
+    channel->out_data = data + (server ? channel->ring_size : 0);
+}
+
+static void lrpc_free_channel(struct lrpc_channel *channel)
+{
+    if (channel->shm) UnmapViewOfFile(channel->shm);
+    if (channel->section) CloseHandle(channel->section);
+    if (channel->in_data_event) CloseHandle(channel->in_data_event);
+    if (channel->in_space_event) CloseHandle(channel->in_space_event);
+    if (channel->out_data_event) CloseHandle(channel->out_data_event);
+    if (channel->out_space_event) CloseHandle(channel->out_space_event);
+    if (channel->peer_process) CloseHandle(channel->peer_process);
+    HeapFree(GetProcessHeap(), 0, channel);
+}
+
+static BOOL lrpc_dup_to_client(HANDLE client, HANDLE handle, ULONG *ret)
+{
+    HANDLE dup;
+
+    if (!DuplicateHandle(GetCurrentProcess(), handle, client, &dup, 0, FALSE, DUPLICATE_SAME_ACCESS))
+        return FALSE;
+    *ret = HandleToULong(dup);
+    return TRUE;
+}
+
+/* closes the handles duplicated into the client for a channel it won't use */
+static void lrpc_close_client_handles(HANDLE client, struct lrpc_reply *reply)
+{
+    unsigned int i;
+
+    if (reply->section)
+        DuplicateHandle(client, ULongToHandle(reply->section), NULL, NULL, 0, FALSE, DUPLICATE_CLOSE_SOURCE);
+    for (i = 0; i < ARRAY_SIZE(reply->events); i++)
+        if (reply->events[i])
+            DuplicateHandle(client, ULongToHandle(reply->events[i]), NULL, NULL, 0, FALSE, DUPLICATE_CLOSE_SOURCE);
+    reply->section = 0;
+    memset(reply->events, 0, sizeof(reply->events));
+}
+
+/* creates the server side of a channel and hands its objects to the client */
+static struct lrpc_channel *lrpc_create_channel(HANDLE client, ULONG ring_size, struct lrpc_reply *reply)
+{
+    struct lrpc_channel *channel;
+
+    if (!(channel = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*channel))))
+        return NULL;
+    channel->ring_size = ring_size;
+
+    if (!(channel->section = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0,
+                                                lrpc_section_size(ring_size), NULL)) ||
+        !(channel->shm = MapViewOfFile(channel->section, FILE_MAP_WRITE, 0, 0, 0)) ||
+        !(channel->in_data_event = CreateEventW(NULL, FALSE, FALSE, NULL)) ||
+        !(channel->in_space_event = CreateEventW(NULL, FALSE, FALSE, NULL)) ||
+        !(channel->out_data_event = CreateEventW(NULL, FALSE, FALSE, NULL)) ||
+        !(channel->out_space_event = CreateEventW(NULL, FALSE, FALSE, NULL)))
+    {
+        WARN("failed to create channel objects, error %u\n", GetLastError());
+        lrpc_free_channel(channel);
+        return NULL;
+    }
+
+    if (!lrpc_dup_to_client(client, channel->in_data_event, &reply->events[0]) ||
+        !lrpc_dup_to_client(client, channel->in_space_event, &reply->events[1]) ||
+        !lrpc_dup_to_client(client, channel->out_data_event, &reply->events[2]) ||
+        !lrpc_dup_to_client(client, channel->out_space_event, &reply->events[3]) ||
+        !lrpc_dup_to_client(client, channel->section, &reply->section))
+    {
+        WARN("failed to duplicate channel objects, error %u\n", GetLastError());
+        lrpc_close_client_handles(client, reply);
+        lrpc_free_channel(channel);
+        return NULL;
+    }
+
+    channel->peer_process = client;
+    lrpc_init_channel(channel, TRUE);
+    return channel;
+}
+
+/* maps the channel the server handed to us, takes ownership of the handles */
+static struct lrpc_channel *lrpc_open_channel(HANDLE server, const struct lrpc_reply *reply)
+{
+    struct lrpc_channel *channel;
+
+    if (!(channel = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*channel))))
+    {
+        unsigned int i;
+
+        CloseHandle(ULongToHandle(reply->section));
+        for (i = 0; i < ARRAY_SIZE(reply->events); i++) CloseHandle(ULongToHandle(reply->events[i]));
+        return NULL;
+    }
+
+    channel->ring_size = reply->ring_size;
+    channel->section = ULongToHandle(reply->section);
+    channel->out_data_event = ULongToHandle(reply->events[0]);
+    channel->out_space_event = ULongToHandle(reply->events[1]);
+    channel->in_data_event = ULongToHandle(reply->events[2]);
+    channel->in_space_event = ULongToHandle(reply->events[3]);
+
+    if (!lrpc_valid_ring_size(channel->ring_size) ||
+        !(channel->shm = MapViewOfFile(channel->section, FILE_MAP_WRITE, 0, 0,
+                                       lrpc_section_size(channel->ring_size))))
+    {
+        WARN("failed to map channel, error %u\n", GetLastError());
+        lrpc_free_channel(channel);
+        return NULL;
+    }
+
+    channel->peer_process = server;
+    lrpc_init_channel(channel, FALSE);
+    return channel;
+}
+
+static RPC_STATUS lrpc_offer_channel(RpcConnection_np *npc)
+{
+    struct lrpc_offer offer = { LRPC_OFFER_MAGIC, LRPC_RING_SIZE, 0, 0 };
+    struct lrpc_channel *channel;
+    struct lrpc_reply reply;
+    HANDLE server;
+    ULONG pid;
+
+    if (!GetNamedPipeServerProcessId(npc->pipe, &pid) ||
+        !(server = OpenProcess(SYNCHRONIZE, FALSE, pid)))
+    {
+        WARN("can't watch server process, using the pipe\n");
+        return RPC_S_OK;
+    }
+
+    if (rpcrt4_conn_np_write(&npc->common, &offer, sizeof(offer)) != sizeof(offer) ||
+        rpcrt4_conn_np_read(&npc->common, &reply, sizeof(reply)) != sizeof(reply) ||
+        reply.magic != LRPC_OFFER_MAGIC)
+    {
+        CloseHandle(server);
+        return RPC_S_SERVER_UNAVAILABLE;
+    }
+
+    if (reply.status)
+    {
+        TRACE("offer declined with status %u, using the pipe\n", reply.status);
+        CloseHandle(server);
+        return RPC_S_OK;
+    }
+
+    channel = lrpc_open_channel(server, &reply);
+    offer.status = channel ? RPC_S_OK : RPC_S_OUT_OF_RESOURCES;
+    if (rpcrt4_conn_np_write(&npc->common, &offer, sizeof(offer)) != sizeof(offer))
+    {
+        if (channel) lrpc_free_channel(channel);
+        else CloseHandle(server);
+        return RPC_S_SERVER_UNAVAILABLE;
+    }
+
+    if (!channel)
+    {
+        WARN("can't use shared memory channel, using the pipe\n");
+        CloseHandle(server);
+        return RPC_S_OK;
+    }
+
+    npc->shm = channel;
+    TRACE("using shared memory channel, ring size %#x\n", channel->ring_size);
+    return RPC_S_OK;
+}
+
+static void lrpc_accept_offer(RpcConnection_np *npc, const struct lrpc_offer *offer)
+{
+    struct lrpc_reply reply = { LRPC_OFFER_MAGIC, offer->ring_size, RPC_S_CANNOT_SUPPORT };
+    struct lrpc_channel *channel = NULL;
+    struct lrpc_offer ack;
+    HANDLE client = NULL;
+    ULONG pid;
+
+    if (lrpc_valid_ring_size(offer->ring_size) &&
+        GetNamedPipeClientProcessId(npc->pipe, &pid) &&
+        (client = OpenProcess(PROCESS_DUP_HANDLE | SYNCHRONIZE, FALSE, pid)) &&
+        (channel = lrpc_create_channel(client, offer->ring_size, &reply)))
+        reply.status = RPC_S_OK;
+    else if (client)
+        CloseHandle(client);
+
+    if (rpcrt4_conn_np_write(&npc->common, &reply, sizeof(reply)) != sizeof(reply))
+    {
+        if (channel)
+        {
+            lrpc_close_client_handles(client, &reply);
+            lrpc_free_channel(channel);
+        }
+        return;
+    }
+    if (!channel)
+    {
+        TRACE("offer declined\n");
+        return;
+    }
+
+    /* the client owns the duplicated handles from here on */
+    if (rpcrt4_conn_np_read(&npc->common, &ack, sizeof(ack)) != sizeof(ack) ||
+        ack.magic != LRPC_OFFER_MAGIC || ack.status != RPC_S_OK)
+    {
+        TRACE("offer not acknowledged\n");
+        lrpc_free_channel(channel);
+        return;
+    }
+    npc->shm = channel;
+    TRACE("offer accepted\n");
+}
+
+/* waits for the peer to signal an event, fails if it went away */
+/* reads a position moved by the peer, ordered before the accesses to the data it covers */
+static inline ULONG lrpc_load_pos(volatile LONG *pos)
+{
+    return InterlockedCompareExchange(pos, 0, 0);
+}
+
+static BOOL lrpc_wait(struct lrpc_channel *channel, HANDLE event)
+{
+    HANDLE handles[2] = { event, channel->peer_process };
+    return WaitForMultipleObjects(2, handles, FALSE, INFINITE) == WAIT_OBJECT_0;
+}
+
+static int lrpc_read(RpcConnection_np *npc, void *buffer, unsigned int count)
+{
+    struct lrpc_channel *channel = npc->shm;
+    struct lrpc_ring *ring = channel->in;
+    ULONG size = channel->ring_size;
+    unsigned char *ptr = buffer;
+    unsigned int done = 0;
+
+    while (done < count)
+    {
+        ULONG read_pos = ring->read_pos, avail, offset, chunk;
+
+        if (npc->read_closed) return -1;
+
+        avail = lrpc_load_pos(&ring->write_pos) - read_pos;
+        if (avail > size)
+        {
+            ERR("corrupted ring, %u bytes available\n", avail);
+            return -1;
+        }
+        if (!avail)
+        {
+            if (channel->shm->closed || InterlockedExchange(&channel->cancelled, 0)) return -1;
+            /* the writer clears the flag and sets the event after moving write_pos */
+            InterlockedExchange(&ring->reader_waiting, 1);
+            if (lrpc_load_pos(&ring->write_pos) != read_pos) continue;
+            if (!lrpc_wait(channel, channel->in_data_event)) return -1;
+            continue;
+        }
+
+        offset = read_pos & (size - 1);
+        chunk = min(min(avail, count - done), size - offset);
+        memcpy(ptr + done, channel->in_data + offset, chunk);
+        done += chunk;
+        InterlockedExchange(&ring->read_pos, read_pos + chunk);
+        if (InterlockedExchange(&ring->writer_waiting, 0))
+            SetEvent(channel->in_space_event);
+    }
+    return count;
+}
+
+static int lrpc_write(RpcConnection_np *npc, const void *buffer, unsigned int count)
+{
+    struct lrpc_channel *channel = npc->shm;
+    struct lrpc_ring *ring = channel->out;
+    ULONG size = channel->ring_size;
+    const unsigned char *ptr = buffer;
+    unsigned int done = 0;
+
+    while (done < count)
+    {
+        ULONG write_pos = ring->write_pos, used, offset, chunk;
+
+        if (channel->shm->closed) return -1;
+
+        used = write_pos - lrpc_load_pos(&ring->read_pos);
+        if (used > size)
+        {
+            ERR("corrupted ring, %u bytes used\n", used);
+            return -1;
+        }
+        if (used == size)
+        {
+            /* the reader clears the flag and sets the event after moving read_pos */
+            InterlockedExchange(&ring->writer_waiting, 1);
+            if (write_pos - lrpc_load_pos(&ring->read_pos) != size) continue;
+            if (!lrpc_wait(channel, channel->out_space_event)) return -1;
+            continue;
+        }
+
+        offset = write_pos & (size - 1);
+        chunk = min(min(size - used, count - done), size - offset);
+        memcpy(channel->out_data + offset, ptr + done, chunk);
+        done += chunk;
+        InterlockedExchange(&ring->write_pos, write_pos + chunk);
+        if (InterlockedExchange(&ring->reader_waiting, 0))
+            SetEvent(channel->out_data_event);
+    }
+    return count;
+}
+
+static int rpcrt4_conn_lrpc_read(RpcConnection *conn, void *buffer, unsigned int count)
+{
+    RpcConnection_np *npc = (RpcConnection_np *)conn;
+
+    if (conn->server && !npc->shm_checked)
+    {
+        npc->shm_checked = TRUE;
+        if (count == sizeof(struct lrpc_offer))
+        {
+            int ret = rpcrt4_conn_np_read(conn, buffer, count);
+
+            if (ret != count || ((struct lrpc_offer *)buffer)->magic != LRPC_OFFER_MAGIC)
+                return ret;
+            lrpc_accept_offer(npc, buffer);
+        }
+    }
+
+    if (npc->shm) return lrpc_read(npc, buffer, count);
+    return rpcrt4_conn_np_read(conn, buffer, count);
+}
+
+static int rpcrt4_conn_lrpc_write(RpcConnection *conn, const void *buffer, unsigned int count)
+{
+    RpcConnection_np *npc = (RpcConnection_np *)conn;
+
+    if (npc->shm) return lrpc_write(npc, buffer, count);
+    return rpcrt4_conn_np_write(conn, buffer, count);
+}
+
+static int rpcrt4_conn_lrpc_close(RpcConnection *conn)
+{
+    RpcConnection_np *npc = (RpcConnection_np *)conn;
+    struct lrpc_channel *channel = npc->shm;
+
+    if (channel)
+    {
+        /* wake up the peer, it fails its pending and further calls */
+        InterlockedExchange(&channel->shm->closed, 1);
+        SetEvent(channel->out_data_event);
+        SetEvent(channel->in_space_event);
+        lrpc_free_channel(channel);
+        npc->shm = NULL;
+    }
+    return rpcrt4_conn_np_close(conn);
+}
+
+static void rpcrt4_conn_lrpc_close_read(RpcConnection *conn)
+{
+    RpcConnection_np *npc = (RpcConnection_np *)conn;
+
+    if (npc->shm)
+    {
+        npc->read_closed = TRUE;
+        SetEvent(npc->shm->in_data_event);
+    }
+    else
+        rpcrt4_conn_np_close_read(conn);
+}
+
+static void rpcrt4_conn_lrpc_cancel_call(RpcConnection *conn)
+{
+    RpcConnection_np *npc = (RpcConnection_np *)conn;
+
+    if (npc->shm)
+    {
+        InterlockedExchange(&npc->shm->cancelled, 1);
+        SetEvent(npc->shm->in_data_event);
+    }
+    else
+        rpcrt4_conn_np_cancel_call(conn);
+}
+
 static size_t rpcrt4_ncacn_np_get_top_of_tower(unsigned char *tower_data,
                                                const char *networkaddr,
                                                const char *endpoint)
@@ -3159,11 +3632,11 @@ static const struct connection_ops conn_protseq_list[] = {
     rpcrt4_conn_np_alloc,
     rpcrt4_ncalrpc_open,
     rpcrt4_ncalrpc_handoff,
-    rpcrt4_conn_np_read,
-    rpcrt4_conn_np_write,
-    rpcrt4_conn_np_close,
-    rpcrt4_conn_np_close_read,
-    rpcrt4_conn_np_cancel_call,
+    rpcrt4_conn_lrpc_read,
+    rpcrt4_conn_lrpc_write,
+    rpcrt4_conn_lrpc_close,
+    rpcrt4_conn_lrpc_close_read,
+    rpcrt4_conn_lrpc_cancel_call,
     rpcrt4_ncalrpc_np_is_server_listening,
     rpcrt4_conn_np_wait_for_incoming_data,
     rpcrt4_ncalrpc_get_top_of_tower,
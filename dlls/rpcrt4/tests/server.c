@@ -1845,6 +1845,50 @@ static void test_handle_return(void)
     test_handle(handle2);
 }
 
+static void
+call_speed_tests(const unsigned char *protseq)
+{
+  DWORD start;
+  int i, x, total = 0;
+
+  /* a plain call and one with an [out] parameter, as a rough measure of
+   * the per call marshalling overhead */
+  start = GetTickCount();
+  for (i = 0; i < 5000; i++)
+  {
+    total += sum(i, 1) - i;
+    square_out(i & 0xff, &x);
+    total += x == (i & 0xff) * (i & 0xff);
+  }
+  ok(total == 2 * i, "got %d\n", total);
+  trace("%d %s call pairs over %s ran in %u ms\n", i, is_interp ? "stubless" : "mixed", protseq,
+        GetTickCount() - start);
+}
+
+static void
+large_message_tests(void)
+{
+  int *x, i, n, expected = 0;
+  pints_t *api;
+
+  /* both directions carry messages much larger than a fragment, which
+   * wrap any intermediate buffer of the transport several times */
+  n = 100000;
+  x = HeapAlloc(GetProcessHeap(), 0, n * sizeof(*x));
+  for (i = 0; i < n; i++) expected += x[i] = i % 1000 - 500;
+  ok(sum_conf_array(x, n) == expected, "RPC sum_conf_array\n");
+  HeapFree(GetProcessHeap(), 0, x);
+
+  n = 20000;
+  api = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, n * sizeof(*api));
+  get_numbers(n, n, api);
+  for (i = 0; i < n; i++)
+    if (!api[i].pi || *api[i].pi != i) break;
+  ok(i == n, "wrong number at index %d\n", i);
+  for (i = 0; i < n; i++) MIDL_user_free(api[i].pi);
+  HeapFree(GetProcessHeap(), 0, api);
+}
+
 static void
 run_tests(void)
 {
@@ -1938,6 +1982,8 @@ client(const char *test)
     run_tests(); /* can cause RPC_X_BAD_STUB_DATA exception */
     authinfo_test(RPC_PROTSEQ_LRPC, 0);
     test_is_server_listening(IMixedServer_IfHandle, RPC_S_OK);
+    large_message_tests();
+    call_speed_tests(ncalrpc);
 
     ok(RPC_S_OK == RpcStringFreeA(&binding), "RpcStringFree\n");
     ok(RPC_S_OK == RpcBindingFree(&IMixedServer_IfHandle), "RpcBindingFree\n");
@@ -1994,6 +2040,7 @@ todo_wine
 
     test_is_server_listening(IInterpServer_IfHandle, RPC_S_OK);
     run_tests();
+    call_speed_tests(np);
     authinfo_test(RPC_PROTSEQ_NMP, 0);
     test_is_server_listening(IInterpServer_IfHandle, RPC_S_OK);
 
@@ -2474,6 +2521,214 @@ done:
     return hr;
 }
 
+/* Wine carries ncalrpc over named pipes and offers to move a connection
+ * to a shared memory channel. These mirror the handshake messages in
+ * rpc_transport.c, and lrpc_fake_server() plays a misbehaving server. */
+#define LRPC_OFFER_MAGIC    0x4d48534c
+#define LRPC_RING_SIZE      0x10000
+#define LRPC_FAKE_ENDPOINT  "wine_rpcrt4_test_lrpc_fake"
+
+struct lrpc_offer
+{
+    ULONG magic;
+    ULONG ring_size;
+    ULONG status;
+    ULONG reserved;
+};
+
+struct lrpc_reply
+{
+    ULONG magic;
+    ULONG ring_size;
+    ULONG status;
+    ULONG section;
+    ULONG events[4];
+};
+
+struct lrpc_ring
+{
+    LONG read_pos;
+    LONG write_pos;
+    LONG reader_waiting;
+    LONG writer_waiting;
+};
+
+struct lrpc_shm
+{
+    LONG closed;
+    struct lrpc_ring rings[2];
+};
+
+static ULONG dup_to_process(HANDLE process, HANDLE handle)
+{
+    HANDLE dup = NULL;
+    BOOL ret;
+
+    ret = DuplicateHandle(GetCurrentProcess(), handle, process, &dup, 0, FALSE, DUPLICATE_SAME_ACCESS);
+    ok(ret, "DuplicateHandle failed: %u\n", GetLastError());
+    return HandleToULong(dup);
+}
+
+static void lrpc_fake_server(const char *mode)
+{
+    struct lrpc_reply reply = { LRPC_OFFER_MAGIC, LRPC_RING_SIZE, RPC_S_OK };
+    struct lrpc_offer offer;
+    struct lrpc_shm *shm = NULL;
+    unsigned char buffer[1024];
+    HANDLE pipe, ready, client, section;
+    DWORD size, pid, i;
+    BOOL ret;
+
+    pipe = CreateNamedPipeA("\\\\.\\pipe\\lrpc\\" LRPC_FAKE_ENDPOINT, PIPE_ACCESS_DUPLEX,
+                            PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT, 1,
+                            0x10000, 0x10000, 0, NULL);
+    ok(pipe != INVALID_HANDLE_VALUE, "CreateNamedPipe failed: %u\n", GetLastError());
+    ready = OpenEventA(EVENT_MODIFY_STATE, FALSE, LRPC_FAKE_ENDPOINT);
+    ok(ready != NULL, "OpenEvent failed: %u\n", GetLastError());
+    SetEvent(ready);
+    CloseHandle(ready);
+
+    ret = ConnectNamedPipe(pipe, NULL);
+    ok(ret || GetLastError() == ERROR_PIPE_CONNECTED, "ConnectNamedPipe failed: %u\n", GetLastError());
+
+    ret = ReadFile(pipe, &offer, sizeof(offer), &size, NULL);
+    ok(ret && size == sizeof(offer), "ReadFile failed: %u\n", GetLastError());
+    ok(offer.magic == LRPC_OFFER_MAGIC, "got magic %#x\n", offer.magic);
+
+    ret = GetNamedPipeClientProcessId(pipe, &pid);
+    ok(ret, "GetNamedPipeClientProcessId failed: %u\n", GetLastError());
+    client = OpenProcess(PROCESS_DUP_HANDLE, FALSE, pid);
+    ok(client != NULL, "OpenProcess failed: %u\n", GetLastError());
+
+    if (!strcmp(mode, "nomap"))
+    {
+        /* too small for the rings, the client can't map it */
+        section = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, 0x1000, NULL);
+    }
+    else
+    {
+        section = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0,
+                                     sizeof(*shm) + 2 * LRPC_RING_SIZE, NULL);
+        shm = MapViewOfFile(section, FILE_MAP_WRITE, 0, 0, 0);
+        ok(shm != NULL, "MapViewOfFile failed: %u\n", GetLastError());
+    }
+    ok(section != NULL, "CreateFileMapping failed: %u\n", GetLastError());
+    reply.section = dup_to_process(client, section);
+    for (i = 0; i < ARRAY_SIZE(reply.events); i++)
+    {
+        HANDLE event = CreateEventA(NULL, FALSE, FALSE, NULL);
+        reply.events[i] = dup_to_process(client, event);
+        CloseHandle(event);
+    }
+    ret = WriteFile(pipe, &reply, sizeof(reply), &size, NULL);
+    ok(ret && size == sizeof(reply), "WriteFile failed: %u\n", GetLastError());
+
+    ret = ReadFile(pipe, &offer, sizeof(offer), &size, NULL);
+    ok(ret && size == sizeof(offer), "ReadFile failed: %u\n", GetLastError());
+    ok(offer.magic == LRPC_OFFER_MAGIC, "got magic %#x\n", offer.magic);
+
+    if (!shm)
+    {
+        ok(offer.status != RPC_S_OK, "client acknowledged a section it can't map\n");
+
+        /* the client stays on the pipe */
+        size = 0;
+        ret = ReadFile(pipe, buffer, sizeof(buffer), &size, NULL);
+        ok(ret || GetLastError() == ERROR_MORE_DATA, "ReadFile failed: %u\n", GetLastError());
+        ok(size >= 16 && buffer[0] == 5 && buffer[2] == 11 /* bind */,
+           "expected a bind packet on the pipe, got %u bytes\n", size);
+    }
+    else
+    {
+        ok(offer.status == RPC_S_OK, "client rejected the channel: %u\n", offer.status);
+
+        /* the bind arrives through the ring; go away while the client
+         * waits for the answer */
+        for (i = 0; i < 500 && shm->rings[0].write_pos < 16; i++) Sleep(10);
+        ok(shm->rings[0].write_pos >= 16, "nothing written to the ring\n");
+        memcpy(buffer, shm + 1, 16);
+        ok(buffer[0] == 5 && buffer[2] == 11 /* bind */, "expected a bind packet in the ring\n");
+        UnmapViewOfFile(shm);
+    }
+
+    CloseHandle(section);
+    CloseHandle(client);
+    CloseHandle(pipe);
+}
+
+static DWORD WINAPI lrpc_fake_call_thread(void *arg)
+{
+    DWORD code = 0;
+
+    RpcTryExcept
+    {
+        sum(1, 2);
+    }
+    RpcExcept(TRUE)
+    {
+        code = RpcExceptionCode();
+    }
+    RpcEndExcept
+    return code;
+}
+
+static void test_lrpc_channel(void)
+{
+    static unsigned char ncalrpc[] = "ncalrpc";
+    static unsigned char endpoint[] = LRPC_FAKE_ENDPOINT;
+    static const char *modes[] = { "nomap", "die" };
+    PROCESS_INFORMATION info;
+    STARTUPINFOA startup;
+    char cmdline[MAX_PATH];
+    unsigned char *binding;
+    HANDLE ready, thread;
+    DWORD ret, code;
+    unsigned int i;
+
+    if (strcmp(winetest_platform, "wine"))
+    {
+        skip("ncalrpc isn't carried over named pipes\n");
+        return;
+    }
+
+    for (i = 0; i < ARRAY_SIZE(modes); i++)
+    {
+        ready = CreateEventA(NULL, TRUE, FALSE, LRPC_FAKE_ENDPOINT);
+        ok(ready != NULL, "CreateEvent failed: %u\n", GetLastError());
+
+        memset(&startup, 0, sizeof startup);
+        startup.cb = sizeof startup;
+        sprintf(cmdline, "%s server lrpc_fake %s", progname, modes[i]);
+        ok(CreateProcessA(NULL, cmdline, NULL, NULL, FALSE, 0L, NULL, NULL, &startup, &info), "CreateProcess\n");
+        ret = WaitForSingleObject(ready, 10000);
+        ok(ret == WAIT_OBJECT_0, "fake server didn't start\n");
+
+        ok(RPC_S_OK == RpcStringBindingComposeA(NULL, ncalrpc, NULL, endpoint, NULL, &binding), "RpcStringBindingCompose\n");
+        ok(RPC_S_OK == RpcBindingFromStringBindingA(binding, &IMixedServer_IfHandle), "RpcBindingFromStringBinding\n");
+
+        /* the fake server never answers, the call has to fail once it's gone */
+        thread = CreateThread(NULL, 0, lrpc_fake_call_thread, NULL, 0, NULL);
+        ret = WaitForSingleObject(thread, 20000);
+        ok(ret == WAIT_OBJECT_0, "%s: call still pending after the server went away\n", modes[i]);
+        if (ret == WAIT_OBJECT_0)
+        {
+            GetExitCodeThread(thread, &code);
+            ok(code != 0, "%s: call didn't fail\n", modes[i]);
+        }
+        else
+            TerminateThread(thread, 0);
+        CloseHandle(thread);
+
+        winetest_wait_child_process(info.hProcess);
+        CloseHandle(info.hProcess);
+        CloseHandle(info.hThread);
+        CloseHandle(ready);
+
+        ok(RPC_S_OK == RpcStringFreeA(&binding), "RpcStringFree\n");
+        ok(RPC_S_OK == RpcBindingFree(&IMixedServer_IfHandle), "RpcBindingFree\n");
+    }
+}
+
 START_TEST(server)
 {
   ULONG size = 0;
@@ -2509,6 +2764,10 @@ START_TEST(server)
     {
       test_server_listening();
     }
+    else if (!strcmp(argv[2], "lrpc_fake"))
+    {
+      lrpc_fake_server(argv[3]);
+    }
     else if(!strcmp(argv[2], "run"))
     {
       UINT_PTR event;
@@ -2548,6 +2807,7 @@ START_TEST(server)
         win_skip("Skipping reconnect tests on too old Windows version\n");
 
     run_client("test listen");
+    test_lrpc_channel();
     if (firewall_disabled) set_firewall(APP_REMOVE);
   }
 
@@ -367,8 +367,11 @@ HWND WINAPI GetFocus(void)
  */
 HWND WINAPI GetForegroundWindow(void)
 {
+    struct desktop_shared_memory state;
     HWND ret = 0;
 
+    if (get_shared_desktop_state( &state )) return wine_server_ptr_handle( state.foreground );
+
     SERVER_START_REQ( get_thread_input )
     {
         req->tid = 0;
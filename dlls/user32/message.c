@@ -2281,17 +2281,13 @@ static void accept_hardware_message( UINT hw_id, BOOL remove )
 }
 
 
-static BOOL process_rawinput_message( MSG *msg, const struct hardware_msg_data *msg_data )
+/***********************************************************************
+ *          rawinput_from_hardware_message
+ *
+ * Convert the raw input data of a hardware message to a RAWINPUT structure.
+ */
+BOOL rawinput_from_hardware_message( RAWINPUT *rawinput, const struct hardware_msg_data *msg_data )
 {
-    struct user_thread_info *thread_info = get_user_thread_info();
-    RAWINPUT *rawinput = thread_info->rawinput;
-
-    if (!rawinput)
-    {
-        thread_info->rawinput = HeapAlloc( GetProcessHeap(), 0, sizeof(*rawinput) );
-        if (!(rawinput = thread_info->rawinput)) return FALSE;
-    }
-
     rawinput->header.dwType = msg_data->rawinput.type;
     if (msg_data->rawinput.type == RIM_TYPEMOUSE)
     {
@@ -2388,6 +2384,21 @@ static BOOL process_rawinput_message( MSG *msg, const struct hardware_msg_data *
         FIXME("Unhandled rawinput type %#x.\n", msg_data->rawinput.type);
         return FALSE;
     }
+    return TRUE;
+}
+
+static BOOL process_rawinput_message( MSG *msg, const struct hardware_msg_data *msg_data )
+{
+    struct user_thread_info *thread_info = get_user_thread_info();
+    RAWINPUT *rawinput = thread_info->rawinput;
+
+    if (!rawinput)
+    {
+        thread_info->rawinput = HeapAlloc( GetProcessHeap(), 0, sizeof(*rawinput) );
+        if (!(rawinput = thread_info->rawinput)) return FALSE;
+    }
+
+    if (!rawinput_from_hardware_message( rawinput, msg_data )) return FALSE;
 
     msg->lParam = (LPARAM)rawinput;
     msg->pt = point_phys_to_win_dpi( msg->hwnd, msg->pt );
@@ -2740,6 +2751,95 @@ static inline void call_sendmsg_callback( SENDASYNCPROC callback, HWND hwnd, UIN
 }
 
 
+/***********************************************************************
+ *           get_server_queue_handle
+ *
+ * Get a handle to the server message queue for the current thread.
+ */
+static HANDLE get_server_queue_handle(void)
+{
+    struct user_thread_info *thread_info = get_user_thread_info();
+    HANDLE ret, shm = 0;
+
+    if (!(ret = thread_info->server_queue))
+    {
+        SERVER_START_REQ( get_msg_queue )
+        {
+            wine_server_call( req );
+            ret = wine_server_ptr_handle( reply->handle );
+            shm = wine_server_ptr_handle( reply->shm_handle );
+        }
+        SERVER_END_REQ;
+        thread_info->server_queue = ret;
+        if (!ret) ERR( "Cannot get server thread queue\n" );
+        if (shm)
+        {
+            thread_info->queue_shm = MapViewOfFile( shm, FILE_MAP_READ, 0, 0, 0 );
+            if (!thread_info->queue_shm) WARN( "Cannot map queue shared memory\n" );
+            CloseHandle( shm );
+        }
+    }
+    return ret;
+}
+
+
+/***********************************************************************
+ *           get_shared_queue_state
+ *
+ * Retrieve a consistent copy of the queue state shared by the server.
+ */
+BOOL get_shared_queue_state( struct queue_shared_memory *state )
+{
+    const struct queue_shared_memory *shared = get_user_thread_info()->queue_shm;
+    unsigned int seq;
+
+    if (!shared) return FALSE;
+
+    for (;;)
+    {
+        /* an odd sequence number means that the server is updating the data */
+        seq = __atomic_load_n( &shared->seq, __ATOMIC_ACQUIRE );
+        if (seq & 1) continue;
+        *state = *shared;
+        __atomic_thread_fence( __ATOMIC_ACQUIRE );
+        if (__atomic_load_n( &shared->seq, __ATOMIC_RELAXED ) == seq) return TRUE;
+    }
+}
+
+
+/***********************************************************************
+ *           is_queue_empty
+ *
+ * Check in the shared queue state whether a get_message request would find
+ * nothing and change nothing, in which case the server call can be skipped.
+ */
+static BOOL is_queue_empty( HWND hwnd, UINT first, UINT last, UINT flags, UINT changed_mask )
+{
+    struct queue_shared_memory state;
+    UINT filter = flags >> 16, clear_bits = 0;
+
+    if (hwnd == HWND_TOPMOST) return FALSE;  /* the server may need to set the idle event */
+    if (!get_shared_queue_state( &state )) return FALSE;
+
+    /* don't let the server consider the queue hung */
+    if (GetTickCount() - state.access_time >= 3000) return FALSE;
+
+    if (!filter) filter = QS_ALLINPUT;
+    if (filter & QS_POSTMESSAGE)
+    {
+        clear_bits |= QS_POSTMESSAGE | QS_HOTKEY | QS_TIMER;
+        if (!first && last == ~0U) clear_bits |= QS_ALLPOSTMESSAGE;
+    }
+    if (filter & QS_INPUT) clear_bits |= QS_INPUT;
+    if (filter & QS_PAINT) clear_bits |= QS_PAINT;
+
+    if (state.wake_bits & (filter | QS_SENDMESSAGE)) return FALSE;
+    if (state.changed_bits & clear_bits) return FALSE;
+    return state.wake_mask == (changed_mask & (QS_SENDMESSAGE | QS_SMRESULT)) &&
+           state.changed_mask == changed_mask;
+}
+
+
 /***********************************************************************
  *           peek_message
  *
@@ -2756,11 +2856,19 @@ static BOOL peek_message( MSG *msg, HWND hwnd, UINT first, UINT last, UINT flags
     void *buffer;
     size_t buffer_size = 256;
 
-    if (!(buffer = HeapAlloc( GetProcessHeap(), 0, buffer_size ))) return FALSE;
-
     if (!first && !last) last = ~0;
     if (hwnd == HWND_BROADCAST) hwnd = HWND_TOPMOST;
 
+    if (!thread_info->server_queue) get_server_queue_handle();
+    if (is_queue_empty( hwnd, first, last, flags, changed_mask ))
+    {
+        thread_info->wake_mask = changed_mask & (QS_SENDMESSAGE | QS_SMRESULT);
+        thread_info->changed_mask = changed_mask;
+        return FALSE;
+    }
+
+    if (!(buffer = HeapAlloc( GetProcessHeap(), 0, buffer_size ))) return FALSE;
+
     for (;;)
     {
         NTSTATUS res;
@@ -2994,31 +3102,6 @@ static inline void process_sent_messages(void)
 }
 
 
-/***********************************************************************
- *           get_server_queue_handle
- *
- * Get a handle to the server message queue for the current thread.
- */
-static HANDLE get_server_queue_handle(void)
-{
-    struct user_thread_info *thread_info = get_user_thread_info();
-    HANDLE ret;
-
-    if (!(ret = thread_info->server_queue))
-    {
-        SERVER_START_REQ( get_msg_queue )
-        {
-            wine_server_call( req );
-            ret = wine_server_ptr_handle( reply->handle );
-        }
-        SERVER_END_REQ;
-        thread_info->server_queue = ret;
-        if (!ret) ERR( "Cannot get server thread queue\n" );
-    }
-    return ret;
-}
-
-
 /***********************************************************************
  *           wait_message_reply
  *
@@ -228,6 +228,31 @@ UINT WINAPI GetRawInputDeviceList(RAWINPUTDEVICELIST *devices, UINT *device_coun
     return 2 + hid_devices_count;
 }
 
+/* read the raw input coalescing policy from HKCU\Software\Wine\Input, enabled by default */
+static unsigned int get_rawinput_coalesce_policy(void)
+{
+    static const WCHAR input_keyW[] = {'S','o','f','t','w','a','r','e','\\','W','i','n','e','\\',
+                                       'I','n','p','u','t',0};
+    static const WCHAR coalescingW[] = {'R','a','w','I','n','p','u','t','C','o','a','l','e','s','c','i','n','g',0};
+    static unsigned int policy = ~0u;
+    WCHAR buffer[16];
+    DWORD size = sizeof(buffer);
+    HKEY hkey;
+
+    if (policy != ~0u) return policy;
+
+    policy = RAWINPUT_COALESCE_MOUSE;
+    if (!RegOpenKeyW( HKEY_CURRENT_USER, input_keyW, &hkey ))
+    {
+        if (!RegQueryValueExW( hkey, coalescingW, NULL, NULL, (BYTE *)buffer, &size ) &&
+            (buffer[0] == 'n' || buffer[0] == 'N' || buffer[0] == 'f' || buffer[0] == 'F' || buffer[0] == '0'))
+            policy = 0;
+        RegCloseKey( hkey );
+    }
+    TRACE("raw input coalescing policy %#x\n", policy);
+    return policy;
+}
+
 /***********************************************************************
  *              RegisterRawInputDevices   (USER32.@)
  */
@@ -263,6 +288,7 @@ BOOL WINAPI DECLSPEC_HOTPATCH RegisterRawInputDevices(RAWINPUTDEVICE *devices, U
 
     SERVER_START_REQ( update_rawinput_devices )
     {
+        req->coalesce = get_rawinput_coalesce_policy();
         wine_server_add_data( req, d, device_count * sizeof(*d) );
         ret = !wine_server_call( req );
     }
@@ -316,14 +342,85 @@ UINT WINAPI GetRawInputData(HRAWINPUT rawinput, UINT command, void *data, UINT *
     return s;
 }
 
+/* retrieve the data of the pending raw input messages of the current thread */
+static UINT get_rawinput_messages(struct hardware_msg_data *msg_data, UINT count, BOOL remove)
+{
+    UINT ret = 0;
+
+    SERVER_START_REQ( get_rawinput_buffer )
+    {
+        req->count = count;
+        req->remove = remove;
+        wine_server_set_reply( req, msg_data, count * sizeof(*msg_data) );
+        if (!wine_server_call( req )) ret = reply->count;
+    }
+    SERVER_END_REQ;
+    return ret;
+}
+
 /***********************************************************************
  *              GetRawInputBuffer   (USER32.@)
  */
 UINT WINAPI DECLSPEC_HOTPATCH GetRawInputBuffer(RAWINPUT *data, UINT *data_size, UINT header_size)
 {
-    FIXME("data %p, data_size %p, header_size %u stub!\n", data, data_size, header_size);
+    struct hardware_msg_data *msg_data;
+    RAWINPUT *rawinput, next;
+    UINT count, max_count, written = 0, i;
 
-    return 0;
+    TRACE("data %p, data_size %p, header_size %u.\n", data, data_size, header_size);
+
+    if (header_size != sizeof(RAWINPUTHEADER))
+    {
+        WARN("Invalid structure size %u.\n", header_size);
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return ~0U;
+    }
+
+    if (!data_size)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return ~0U;
+    }
+
+    /* every message fits in an aligned RAWINPUT structure */
+    max_count = data ? *data_size / RAWINPUT_ALIGN(sizeof(RAWINPUT)) : 0;
+    if (!max_count)
+    {
+        struct hardware_msg_data first;
+
+        if (!get_rawinput_messages(&first, 1, FALSE) || !rawinput_from_hardware_message(&next, &first))
+        {
+            *data_size = 0;
+            return 0;
+        }
+        if (!data || *data_size < next.header.dwSize)
+        {
+            UINT ret = data ? ~0U : 0;
+            if (data) SetLastError(ERROR_INSUFFICIENT_BUFFER);
+            *data_size = next.header.dwSize;
+            return ret;
+        }
+        max_count = 1;
+    }
+
+    if (!(msg_data = HeapAlloc(GetProcessHeap(), 0, max_count * sizeof(*msg_data))))
+    {
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return ~0U;
+    }
+
+    /* drain as many messages as fit in the buffer with a single request */
+    count = get_rawinput_messages(msg_data, max_count, TRUE);
+    for (i = 0, rawinput = data; i < count; i++)
+    {
+        if (!rawinput_from_hardware_message(rawinput, &msg_data[i])) continue;
+        rawinput = NEXTRAWINPUTBLOCK(rawinput);
+        written++;
+    }
+    HeapFree(GetProcessHeap(), 0, msg_data);
+
+    TRACE("returning %u messages.\n", written);
+    return written;
 }
 
 /***********************************************************************
@@ -1662,6 +1662,88 @@ static void test_GetRawInputData(void)
     ok(ret == ~0U, "Expect ret %u, got %u\n", ~0U, ret);
 }
 
+static void test_GetRawInputBuffer(void)
+{
+    static const UINT move_count = 1000;
+    RAWINPUT buffer[16];
+    RAWINPUTDEVICE raw_devices[1];
+    RAWINPUT *ri;
+    INPUT input;
+    UINT size, count, total = 0, calls = 0, i;
+    DWORD start, elapsed;
+    LONG dx = 0;
+    HWND hwnd;
+    BOOL ret;
+
+    hwnd = CreateWindowA("static", "test", WS_OVERLAPPEDWINDOW | WS_VISIBLE, 0, 0, 100, 100, 0, 0, 0, 0);
+    ok(hwnd != 0, "CreateWindow failed\n");
+    SetForegroundWindow(hwnd);
+    empty_message_queue();
+
+    raw_devices[0].usUsagePage = 0x01;
+    raw_devices[0].usUsage = 0x02;
+    raw_devices[0].dwFlags = RIDEV_INPUTSINK;
+    raw_devices[0].hwndTarget = hwnd;
+    ret = RegisterRawInputDevices(raw_devices, ARRAY_SIZE(raw_devices), sizeof(RAWINPUTDEVICE));
+    ok(ret, "RegisterRawInputDevices failed\n");
+
+    size = sizeof(buffer);
+    count = GetRawInputBuffer(buffer, &size, 0);
+    ok(count == ~0U, "GetRawInputBuffer returned %u\n", count);
+
+    size = sizeof(buffer);
+    count = GetRawInputBuffer(NULL, &size, sizeof(RAWINPUTHEADER));
+    ok(count == 0, "GetRawInputBuffer returned %u\n", count);
+    ok(size == 0, "GetRawInputBuffer returned size %u\n", size);
+
+    /* synthetic high rate input: inject many small moves, then drain them in batches */
+    memset(&input, 0, sizeof(input));
+    input.type = INPUT_MOUSE;
+    U(input).mi.dx = 1;
+    U(input).mi.dwFlags = MOUSEEVENTF_MOVE;
+    start = GetTickCount();
+    for (i = 0; i < move_count; i++) pSendInput(1, &input, sizeof(input));
+
+    size = 0;
+    count = GetRawInputBuffer(NULL, &size, sizeof(RAWINPUTHEADER));
+    ok(count == 0, "GetRawInputBuffer returned %u\n", count);
+    if (!size)
+    {
+        skip("no raw input received\n");
+        goto done;
+    }
+    ok(size == FIELD_OFFSET(RAWINPUT, data) + sizeof(RAWMOUSE), "GetRawInputBuffer returned size %u\n", size);
+
+    for (;;)
+    {
+        size = sizeof(buffer);
+        count = GetRawInputBuffer(buffer, &size, sizeof(RAWINPUTHEADER));
+        ok(count != ~0U, "GetRawInputBuffer failed, error %u\n", GetLastError());
+        if (!count || count == ~0U) break;
+        ok(count <= ARRAY_SIZE(buffer), "GetRawInputBuffer returned %u\n", count);
+        for (i = 0, ri = buffer; i < count; i++, ri = NEXTRAWINPUTBLOCK(ri))
+        {
+            ok(ri->header.dwType == RIM_TYPEMOUSE, "got type %u\n", ri->header.dwType);
+            dx += ri->data.mouse.lLastX;
+        }
+        total += count;
+        calls++;
+    }
+    elapsed = GetTickCount() - start;
+    trace("%u mouse moves delivered as %u raw input messages in %u calls, %u ms\n",
+          move_count, total, calls, elapsed);
+    ok(total > 0 && total <= move_count, "got %u raw input messages\n", total);
+    ok(dx == move_count || broken(dx > 0) /* mouse acceleration */, "got total motion %d\n", dx);
+
+done:
+    raw_devices[0].dwFlags = RIDEV_REMOVE;
+    raw_devices[0].hwndTarget = 0;
+    ret = RegisterRawInputDevices(raw_devices, ARRAY_SIZE(raw_devices), sizeof(RAWINPUTDEVICE));
+    ok(ret, "RegisterRawInputDevices failed\n");
+    empty_message_queue();
+    DestroyWindow(hwnd);
+}
+
 static void test_key_map(void)
 {
     HKL kl = GetKeyboardLayout(0);
@@ -2840,6 +2922,7 @@ START_TEST(input)
         test_Input_whitebox();
         test_Input_unicode();
         test_Input_mouse();
+        test_GetRawInputBuffer();
     }
     else win_skip("SendInput is not available\n");
 
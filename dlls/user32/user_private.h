@@ -42,6 +42,10 @@
 #define WINE_KEYBOARD_HANDLE    ((HANDLE)2)
 
 struct window_surface;
+struct queue_shared_memory;
+struct desktop_shared_memory;
+struct shared_window;
+struct hardware_msg_data;
 
 /* internal messages codes */
 enum wine_internal_message
@@ -190,6 +194,7 @@ struct user_thread_info
     HWND                          top_window;             /* Desktop window */
     HWND                          msg_window;             /* HWND_MESSAGE parent window */
     RAWINPUT                     *rawinput;
+    const struct queue_shared_memory *queue_shm;          /* Shared memory view of the server queue state */
 };
 
 C_ASSERT( sizeof(struct user_thread_info) <= sizeof(((TEB *)0)->Win32ClientInfo) );
@@ -248,6 +253,10 @@ extern LRESULT call_current_hook( HHOOK hhook, INT code, WPARAM wparam, LPARAM l
 extern DWORD get_input_codepage( void ) DECLSPEC_HIDDEN;
 extern BOOL map_wparam_AtoW( UINT message, WPARAM *wparam, enum wm_char_mapping mapping ) DECLSPEC_HIDDEN;
 extern NTSTATUS send_hardware_message( HWND hwnd, const INPUT *input, UINT flags ) DECLSPEC_HIDDEN;
+extern BOOL get_shared_queue_state( struct queue_shared_memory *state ) DECLSPEC_HIDDEN;
+extern BOOL get_shared_desktop_state( struct desktop_shared_memory *state ) DECLSPEC_HIDDEN;
+extern BOOL get_shared_window( HWND hwnd, struct shared_window *window ) DECLSPEC_HIDDEN;
+extern BOOL rawinput_from_hardware_message( RAWINPUT *rawinput, const struct hardware_msg_data *msg_data ) DECLSPEC_HIDDEN;
 extern LRESULT MSG_SendInternalMessageTimeout( DWORD dest_pid, DWORD dest_tid,
                                                UINT msg, WPARAM wparam, LPARAM lparam,
                                                UINT flags, UINT timeout, PDWORD_PTR res_ptr ) DECLSPEC_HIDDEN;
@@ -188,6 +188,101 @@ void *free_user_handle( HANDLE handle, enum user_obj_type type )
 }
 
 
+/***********************************************************************
+ *           get_shared_desktop
+ *
+ * Return the view of the shared memory of the thread desktop, mapping it on first use.
+ * Only the first desktop used by the process is mapped, other ones use server calls.
+ */
+static const struct desktop_shared_memory *get_shared_desktop(void)
+{
+    static HWND shared_desktop_window;
+    static const struct desktop_shared_memory *shared_desktop;
+    const struct desktop_shared_memory *ret = NULL;
+    HWND desktop = GetDesktopWindow();
+    HANDLE handle = 0;
+
+    if (!desktop) return NULL;
+    if (__atomic_load_n( &shared_desktop_window, __ATOMIC_ACQUIRE ) == desktop) return shared_desktop;
+    if (shared_desktop_window) return NULL;
+
+    USER_Lock();
+    if (!shared_desktop_window)
+    {
+        SERVER_START_REQ( get_desktop_shm )
+        {
+            if (!wine_server_call( req )) handle = wine_server_ptr_handle( reply->handle );
+        }
+        SERVER_END_REQ;
+        if (handle)
+        {
+            ret = MapViewOfFile( handle, FILE_MAP_READ, 0, 0, 0 );
+            CloseHandle( handle );
+        }
+        shared_desktop = ret;
+        __atomic_store_n( &shared_desktop_window, desktop, __ATOMIC_RELEASE );
+    }
+    else if (shared_desktop_window == desktop) ret = shared_desktop;
+    USER_Unlock();
+    return ret;
+}
+
+
+/***********************************************************************
+ *           read_shared_desktop
+ *
+ * Copy a consistent snapshot of a part of the desktop shared memory.
+ */
+static void read_shared_desktop( const struct desktop_shared_memory *shared, void *dst,
+                                 const void *src, size_t size )
+{
+    unsigned int seq;
+
+    for (;;)
+    {
+        /* an odd sequence number means that the server is updating the data */
+        seq = __atomic_load_n( &shared->seq, __ATOMIC_ACQUIRE );
+        if (seq & 1) continue;
+        memcpy( dst, src, size );
+        __atomic_thread_fence( __ATOMIC_ACQUIRE );
+        if (__atomic_load_n( &shared->seq, __ATOMIC_RELAXED ) == seq) return;
+    }
+}
+
+
+/***********************************************************************
+ *           get_shared_desktop_state
+ *
+ * Retrieve the global state of the thread desktop without a server call.
+ */
+BOOL get_shared_desktop_state( struct desktop_shared_memory *state )
+{
+    const struct desktop_shared_memory *shared = get_shared_desktop();
+
+    if (!shared) return FALSE;
+    read_shared_desktop( shared, state, shared, FIELD_OFFSET( struct desktop_shared_memory, windows ));
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *           get_shared_window
+ *
+ * Retrieve the state of a window of the thread desktop without a server call.
+ * Fails if the handle is not a full handle to a window of that desktop.
+ */
+BOOL get_shared_window( HWND hwnd, struct shared_window *window )
+{
+    const struct desktop_shared_memory *shared;
+    WORD index = USER_HANDLE_TO_INDEX( hwnd );
+
+    if (index >= NB_USER_HANDLES) return FALSE;
+    if (!(shared = get_shared_desktop())) return FALSE;
+    read_shared_desktop( shared, window, &shared->windows[index], sizeof(*window) );
+    return window->handle && window->handle == wine_server_user_handle( hwnd );
+}
+
+
 /***********************************************************************
  *           create_window_handle
  *
@@ -825,6 +920,69 @@ ULONG WIN_SetStyle( HWND hwnd, ULONG set_bits, ULONG clear_bits )
 }
 
 
+/***********************************************************************
+ *           get_shared_window_rectangles
+ *
+ * Get the rectangles of a window from the desktop shared memory.
+ * Fails if the window doesn't use the DPI of the current thread.
+ */
+static BOOL get_shared_window_rectangles( HWND hwnd, enum coords_relative relative,
+                                          RECT *rectWindow, RECT *rectClient )
+{
+    struct shared_window win, parent;
+    RECT window_rect, client_rect;
+
+    if (!get_shared_window( hwnd, &win ) || win.dpi != get_thread_dpi()) return FALSE;
+
+    SetRect( &window_rect, win.window_rect.left, win.window_rect.top,
+             win.window_rect.right, win.window_rect.bottom );
+    SetRect( &client_rect, win.client_rect.left, win.client_rect.top,
+             win.client_rect.right, win.client_rect.bottom );
+
+    switch (relative)
+    {
+    case COORDS_CLIENT:
+        OffsetRect( &window_rect, -win.client_rect.left, -win.client_rect.top );
+        OffsetRect( &client_rect, -win.client_rect.left, -win.client_rect.top );
+        if (win.ex_style & WS_EX_LAYOUTRTL)
+            mirror_rect( &client_rect, &window_rect );
+        break;
+    case COORDS_WINDOW:
+        OffsetRect( &window_rect, -win.window_rect.left, -win.window_rect.top );
+        OffsetRect( &client_rect, -win.window_rect.left, -win.window_rect.top );
+        if (win.ex_style & WS_EX_LAYOUTRTL)
+            mirror_rect( &window_rect, &client_rect );
+        break;
+    case COORDS_PARENT:
+        if (!win.parent) break;
+        if (!get_shared_window( wine_server_ptr_handle( win.parent ), &parent )) return FALSE;
+        if (parent.ex_style & WS_EX_LAYOUTRTL)
+        {
+            RECT rect;
+            SetRect( &rect, parent.client_rect.left, parent.client_rect.top,
+                     parent.client_rect.right, parent.client_rect.bottom );
+            mirror_rect( &rect, &window_rect );
+            mirror_rect( &rect, &client_rect );
+        }
+        break;
+    case COORDS_SCREEN:
+        while (win.parent)
+        {
+            if (!get_shared_window( wine_server_ptr_handle( win.parent ), &win )) return FALSE;
+            if (!win.parent) break;  /* desktop window */
+            OffsetRect( &window_rect, win.client_rect.left, win.client_rect.top );
+            OffsetRect( &client_rect, win.client_rect.left, win.client_rect.top );
+        }
+        break;
+    default:
+        return FALSE;
+    }
+    if (rectWindow) *rectWindow = window_rect;
+    if (rectClient) *rectClient = client_rect;
+    return TRUE;
+}
+
+
 /***********************************************************************
  *           WIN_GetRectangles
  *
@@ -933,6 +1091,8 @@ BOOL WIN_GetRectangles( HWND hwnd, enum coords_relative relative, RECT *rectWind
     }
 
 other_process:
+    if (get_shared_window_rectangles( hwnd, relative, rectWindow, rectClient )) return TRUE;
+
     SERVER_START_REQ( get_window_rectangles )
     {
         req->handle = wine_server_user_handle( hwnd );
@@ -2348,11 +2508,15 @@ static LONG_PTR WIN_GetWindowLong( HWND hwnd, INT offset, UINT size, BOOL unicod
 
     if (wndPtr == WND_OTHER_PROCESS)
     {
+        struct shared_window shared;
+
         if (offset == GWLP_WNDPROC)
         {
             SetLastError( ERROR_ACCESS_DENIED );
             return 0;
         }
+        if ((offset == GWL_STYLE || offset == GWL_EXSTYLE) && get_shared_window( hwnd, &shared ))
+            return offset == GWL_STYLE ? shared.style : shared.ex_style;
         SERVER_START_REQ( set_window_info )
         {
             req->handle = wine_server_user_handle( hwnd );
@@ -3074,7 +3238,16 @@ HWND WINAPI GetParent( HWND hwnd )
     if (wndPtr == WND_DESKTOP) return 0;
     if (wndPtr == WND_OTHER_PROCESS)
     {
-        LONG style = GetWindowLongW( hwnd, GWL_STYLE );
+        struct shared_window shared;
+        LONG style;
+
+        if (get_shared_window( hwnd, &shared ))
+        {
+            if (shared.style & WS_POPUP) return wine_server_ptr_handle( shared.owner );
+            if (shared.style & WS_CHILD) return wine_server_ptr_handle( shared.parent );
+            return 0;
+        }
+        style = GetWindowLongW( hwnd, GWL_STYLE );
         if (style & (WS_POPUP | WS_CHILD))
         {
             SERVER_START_REQ( get_window_tree )
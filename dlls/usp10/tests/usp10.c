@@ -4185,6 +4185,98 @@ static void init_tests(void)
     pScriptGetFontFeatureTags = (void *)GetProcAddress(module, "ScriptGetFontFeatureTags");
 }
 
+static void test_plain_text(HDC hdc)
+{
+    static const WCHAR sentenceW[] = {'T','h','e',' ','q','u','i','c','k',' ','b','r','o','w','n',' ',
+            'f','o','x',',',' ','j','u','m','p','s',' ','o','v','e','r',' ','1','3',' ','l','a','z','y',
+            ' ','d','o','g','s','.',' '};
+    int count, item_count, item_count2, glyph_count, i, j, len;
+    SCRIPT_ITEM *items, *items2;
+    SCRIPT_CACHE sc = NULL;
+    SCRIPT_CONTROL control;
+    SCRIPT_VISATTR *attrs;
+    SCRIPT_STATE state;
+    WORD *glyphs, *clusters;
+    int *advances;
+    GOFFSET *offsets;
+    WCHAR *text;
+    DWORD start;
+    HRESULT hr;
+    ABC abc;
+
+    count = 1024 * ARRAY_SIZE(sentenceW);
+    text = HeapAlloc(GetProcessHeap(), 0, (count + 1) * sizeof(*text));
+    items = HeapAlloc(GetProcessHeap(), 0, (count + 1) * sizeof(*items));
+    items2 = HeapAlloc(GetProcessHeap(), 0, (count + 1) * sizeof(*items2));
+    for (i = 0; i < count; i++)
+        text[i] = sentenceW[i % ARRAY_SIZE(sentenceW)];
+
+    memset(&control, 0, sizeof(control));
+    memset(&state, 0, sizeof(state));
+
+    /* Left-to-right text gives the same items with and without bidi state. */
+    start = GetTickCount();
+    hr = ScriptItemize(text, count, count + 1, &control, &state, items, &item_count);
+    ok(hr == S_OK, "Failed to itemize, hr %#x.\n", hr);
+    trace("Itemized %d characters into %d items in %u ms.\n", count, item_count, GetTickCount() - start);
+
+    hr = ScriptItemize(text, count, count + 1, NULL, NULL, items2, &item_count2);
+    ok(hr == S_OK, "Failed to itemize, hr %#x.\n", hr);
+    ok(item_count == item_count2, "Unexpected item count %d, expected %d.\n", item_count2, item_count);
+    for (i = 0; i < min(item_count, item_count2); i++)
+    {
+        ok(items[i].iCharPos == items2[i].iCharPos, "%d: unexpected position %d, expected %d.\n", i,
+                items2[i].iCharPos, items[i].iCharPos);
+        ok(items[i].a.eScript == items2[i].a.eScript, "%d: unexpected script %d, expected %d.\n", i,
+                items2[i].a.eScript, items[i].a.eScript);
+        ok(!items[i].a.fRTL && !items[i].a.s.uBidiLevel, "%d: unexpected bidi level %d.\n", i,
+                items[i].a.s.uBidiLevel);
+    }
+
+    /* Same amount of text that goes through bidi resolution. */
+    text[count - 1] = 0x05d0;
+    start = GetTickCount();
+    hr = ScriptItemize(text, count, count + 1, &control, &state, items2, &item_count2);
+    ok(hr == S_OK, "Failed to itemize, hr %#x.\n", hr);
+    trace("Itemized %d characters with bidi text into %d items in %u ms.\n", count, item_count2, GetTickCount() - start);
+    text[count - 1] = ' ';
+
+    glyphs = HeapAlloc(GetProcessHeap(), 0, 2 * count * sizeof(*glyphs));
+    clusters = HeapAlloc(GetProcessHeap(), 0, count * sizeof(*clusters));
+    attrs = HeapAlloc(GetProcessHeap(), 0, 2 * count * sizeof(*attrs));
+    advances = HeapAlloc(GetProcessHeap(), 0, 2 * count * sizeof(*advances));
+    offsets = HeapAlloc(GetProcessHeap(), 0, 2 * count * sizeof(*offsets));
+
+    start = GetTickCount();
+    for (i = 0; i < item_count; i++)
+    {
+        len = items[i + 1].iCharPos - items[i].iCharPos;
+
+        hr = ScriptShape(hdc, &sc, text + items[i].iCharPos, len, 2 * count, &items[i].a, glyphs, clusters,
+                attrs, &glyph_count);
+        ok(hr == S_OK, "%d: failed to shape, hr %#x.\n", i, hr);
+        if (hr != S_OK)
+            break;
+        ok(glyph_count > 0 && glyph_count <= len, "%d: unexpected glyph count %d.\n", i, glyph_count);
+        for (j = 1; j < len; j++)
+            ok(clusters[j] >= clusters[j - 1], "%d: unexpected cluster map.\n", i);
+
+        hr = ScriptPlace(hdc, &sc, glyphs, glyph_count, attrs, &items[i].a, advances, offsets, &abc);
+        ok(hr == S_OK, "%d: failed to place, hr %#x.\n", i, hr);
+    }
+    trace("Shaped and placed %d items in %u ms.\n", item_count, GetTickCount() - start);
+
+    ScriptFreeCache(&sc);
+    HeapFree(GetProcessHeap(), 0, offsets);
+    HeapFree(GetProcessHeap(), 0, advances);
+    HeapFree(GetProcessHeap(), 0, attrs);
+    HeapFree(GetProcessHeap(), 0, clusters);
+    HeapFree(GetProcessHeap(), 0, glyphs);
+    HeapFree(GetProcessHeap(), 0, items2);
+    HeapFree(GetProcessHeap(), 0, items);
+    HeapFree(GetProcessHeap(), 0, text);
+}
+
 START_TEST(usp10)
 {
     HWND            hwnd;
@@ -4246,6 +4338,7 @@ START_TEST(usp10)
 
     test_ScriptIsComplex();
     test_script_cache_reuse();
+    test_plain_text(hdc);
 
     ReleaseDC(hwnd, hdc);
     DestroyWindow(hwnd);
@@ -1023,6 +1023,50 @@ static enum usp10_script get_char_script(const WCHAR *str, unsigned int index,
     return range->script;
 }
 
+/* Except for surrogate pairs, classification depends only on the character itself. Results are
+   kept in blocks that are filled once on first use, so that plain text is itemized with a
+   single table lookup per character. */
+static BYTE *char_script_blocks[0x10000 >> GLYPH_BLOCK_SHIFT];
+
+static const BYTE *get_char_script_block(WCHAR ch)
+{
+    unsigned int block = ch >> GLYPH_BLOCK_SHIFT, consumed, i;
+    BYTE *scripts;
+    WCHAR c;
+
+    if (char_script_blocks[block])
+        return char_script_blocks[block];
+
+    if (!(scripts = heap_alloc(GLYPH_BLOCK_SIZE * sizeof(*scripts))))
+        return NULL;
+
+    for (i = 0; i < GLYPH_BLOCK_SIZE; i++)
+    {
+        c = (block << GLYPH_BLOCK_SHIFT) + i;
+        scripts[i] = get_char_script(&c, 0, 1, &consumed);
+    }
+
+    if (InterlockedCompareExchangePointer((void **)&char_script_blocks[block], scripts, NULL))
+    {
+        heap_free(scripts);
+        return char_script_blocks[block];
+    }
+
+    return scripts;
+}
+
+static enum usp10_script get_char_script_cached(const WCHAR *str, unsigned int index,
+        unsigned int end, unsigned int *consumed)
+{
+    const BYTE *scripts;
+
+    if (IS_HIGH_SURROGATE(str[index]) || !(scripts = get_char_script_block(str[index])))
+        return get_char_script(str, index, end, consumed);
+
+    *consumed = 1;
+    return scripts[str[index] & GLYPH_BLOCK_MASK];
+}
+
 static int compare_FindGlyph(const void *a, const void* b)
 {
     const FindGlyph_struct *find = (FindGlyph_struct*)a;
@@ -1364,6 +1408,7 @@ static HRESULT _ItemizeInternal(const WCHAR *pwcInChars, int cInChars,
     BOOL  new_run;
     WORD layoutRTL = 0;
     BOOL forceLevels = FALSE;
+    BOOL simple_ltr = TRUE;
     unsigned int consumed = 0;
     HRESULT res = E_OUTOFMEMORY;
 
@@ -1380,7 +1425,7 @@ static HRESULT _ItemizeInternal(const WCHAR *pwcInChars, int cInChars,
     {
         if (!consumed)
         {
-            scripts[i] = get_char_script(pwcInChars,i,cInChars,&consumed);
+            scripts[i] = get_char_script_cached(pwcInChars,i,cInChars,&consumed);
             consumed --;
         }
         else
@@ -1406,6 +1451,11 @@ static HRESULT _ItemizeInternal(const WCHAR *pwcInChars, int cInChars,
 
             forceLevels = TRUE;
 
+        /* Nothing below Hebrew block has right-to-left or Arabic number bidi class, or is
+           an explicit embedding character. */
+        if (pwcInChars[i] >= 0x0590)
+            simple_ltr = FALSE;
+
         /* Diacritical marks merge with other scripts */
         if (scripts[i] == Script_Diacritical)
         {
@@ -1462,7 +1512,10 @@ static HRESULT _ItemizeInternal(const WCHAR *pwcInChars, int cInChars,
         }
     }
 
-    if (psState && psControl)
+    /* Left-to-right text at base level resolves to a single level, skip bidi analysis. */
+    if (simple_ltr && psState && !psState->uBidiLevel && !psState->fOverrideDirection)
+        TRACE("Simple left-to-right text, skipping bidi levels resolution.\n");
+    else if (psState && psControl)
     {
         if (!(levels = heap_calloc(cInChars, sizeof(*levels))))
             goto nomemory;
@@ -3084,7 +3137,7 @@ HRESULT WINAPI ScriptIsComplex(const WCHAR *chars, int len, DWORD flag)
         if ((flag & SIC_ASCIIDIGIT) && chars[i] >= 0x30 && chars[i] <= 0x39)
             return S_OK;
 
-        script = get_char_script(chars,i,len, &consumed);
+        script = get_char_script_cached(chars,i,len, &consumed);
         if ((scriptInformation[script].props.fComplex && (flag & SIC_COMPLEX))||
             (!scriptInformation[script].props.fComplex && (flag & SIC_NEUTRAL)))
             return S_OK;
@@ -3092,6 +3145,33 @@ HRESULT WINAPI ScriptIsComplex(const WCHAR *chars, int len, DWORD flag)
     return S_FALSE;
 }
 
+static BOOL has_surrogates(const WCHAR *chars, int count)
+{
+    int i;
+
+    for (i = 0; i < count; i++)
+        if (IS_HIGH_SURROGATE(chars[i]) || IS_LOW_SURROGATE(chars[i]))
+            return TRUE;
+
+    return FALSE;
+}
+
+static HRESULT get_char_glyph(HDC hdc, SCRIPT_CACHE *psc, DWORD ch, WORD *glyph)
+{
+    WORD index;
+
+    if ((*glyph = get_cache_glyph(psc, ch)))
+        return S_OK;
+
+    if (!hdc)
+        return E_PENDING;
+    if (OpenType_CMAP_GetGlyphIndex(hdc, (ScriptCache *)*psc, ch, &index, 0) == GDI_ERROR)
+        return S_FALSE;
+    *glyph = set_cache_glyph(psc, ch, index);
+
+    return S_OK;
+}
+
 /***********************************************************************
  *      ScriptShapeOpenType (USP10.@)
  *
@@ -3186,7 +3266,22 @@ HRESULT WINAPI ScriptShapeOpenType( HDC hdc, SCRIPT_CACHE *psc,
         if (!(rChars = heap_calloc(cChars, sizeof(*rChars))))
             return E_OUTOFMEMORY;
 
-        for (i = 0, g = 0, cluster = 0; i < cChars; i++)
+        /* Left-to-right runs without surrogates map each character to one glyph, and don't need
+           mirroring. */
+        if (!rtl && !psa->fRTL && !has_surrogates(pwcChars, cChars))
+        {
+            memcpy(rChars, pwcChars, cChars * sizeof(*rChars));
+            for (i = 0; i < cChars; i++)
+            {
+                if ((hr = get_char_glyph(hdc, psc, pwcChars[i], &pwOutGlyphs[i])) != S_OK)
+                {
+                    heap_free(rChars);
+                    return hr;
+                }
+            }
+            g = cChars;
+        }
+        else for (i = 0, g = 0, cluster = 0; i < cChars; i++)
         {
             int idx = i;
             DWORD chInput;
@@ -3209,20 +3304,10 @@ HRESULT WINAPI ScriptShapeOpenType( HDC hdc, SCRIPT_CACHE *psc,
                     rChars[i+1] = pwcChars[(rtl)?idx-1:idx+1];
                     cluster = 1;
                 }
-                if (!(pwOutGlyphs[g] = get_cache_glyph(psc, chInput)))
+                if ((hr = get_char_glyph(hdc, psc, chInput, &pwOutGlyphs[g])) != S_OK)
                 {
-                    WORD glyph;
-                    if (!hdc)
-                    {
-                        heap_free(rChars);
-                        return E_PENDING;
-                    }
-                    if (OpenType_CMAP_GetGlyphIndex(hdc, (ScriptCache *)*psc, chInput, &glyph, 0) == GDI_ERROR)
-                    {
-                        heap_free(rChars);
-                        return S_FALSE;
-                    }
-                    pwOutGlyphs[g] = set_cache_glyph(psc, chInput, glyph);
+                    heap_free(rChars);
+                    return hr;
                 }
                 g++;
             }
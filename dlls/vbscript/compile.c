@@ -165,6 +165,7 @@ static unsigned push_instr(compile_ctx_t *ctx, vbsop_t op)
     }
 
     ctx->code->instrs[ctx->instr_cnt].op = op;
+    ctx->code->instrs[ctx->instr_cnt].ident = NULL;
     return ctx->instr_cnt++;
 }
 
@@ -1302,6 +1303,61 @@ static void resolve_labels(compile_ctx_t *ctx, unsigned off)
     ctx->labels_cnt = 0;
 }
 
+static const WCHAR *get_instr_identifier(instr_t *instr)
+{
+    switch(instr->op) {
+    case OP_assign_ident:
+    case OP_const:
+    case OP_dim:
+    case OP_icall:
+    case OP_icallv:
+    case OP_incc:
+    case OP_set_ident:
+        return instr->arg1.bstr;
+    case OP_enumnext:
+    case OP_step:
+        return instr->arg2.bstr;
+    default:
+        return NULL;
+    }
+}
+
+/* Binds identifiers referring to local variables and arguments to their slots, so that
+ * the interpreter doesn't need to look them up by name. */
+static HRESULT resolve_identifiers(compile_ctx_t *ctx, function_t *func)
+{
+    const WCHAR *name;
+    instr_t *instr;
+    unsigned i;
+
+    for(instr = ctx->code->instrs+func->code_off; instr < ctx->code->instrs+ctx->instr_cnt; instr++) {
+        if(!(name = get_instr_identifier(instr)))
+            continue;
+
+        instr->ident = compiler_alloc_zero(ctx->code, sizeof(*instr->ident));
+        if(!instr->ident)
+            return E_OUTOFMEMORY;
+
+        for(i = 0; i < func->var_cnt; i++) {
+            if(!strcmpiW(func->vars[i].name, name)) {
+                instr->ident->local_ref = i+1;
+                break;
+            }
+        }
+        if(instr->ident->local_ref)
+            continue;
+
+        for(i = 0; i < func->arg_cnt; i++) {
+            if(!strcmpiW(func->args[i].name, name)) {
+                instr->ident->local_ref = -(int)i-1;
+                break;
+            }
+        }
+    }
+
+    return S_OK;
+}
+
 static HRESULT fill_array_desc(compile_ctx_t *ctx, dim_decl_t *dim_decl, array_desc_t *array_desc)
 {
     unsigned dim_cnt = 0, i;
@@ -1436,7 +1492,7 @@ static HRESULT compile_func(compile_ctx_t *ctx, statement_t *stat, function_t *f
         assert(array_id == func->array_cnt);
     }
 
-    return S_OK;
+    return resolve_identifiers(ctx, func);
 }
 
 static BOOL lookup_funcs_name(compile_ctx_t *ctx, const WCHAR *name)
@@ -1872,6 +1928,9 @@ HRESULT compile_script(script_ctx_t *script, const WCHAR *src, const WCHAR *deli
         script->global_funcs = ctx.funcs;
     }
 
+    if(ctx.global_vars || ctx.funcs)
+        script->names_version++;
+
     if(ctx.classes) {
         class_desc_t *class = ctx.classes;
 
@@ -52,28 +52,6 @@ typedef struct {
 
 typedef HRESULT (*instr_func_t)(exec_ctx_t*);
 
-typedef enum {
-    REF_NONE,
-    REF_DISP,
-    REF_VAR,
-    REF_OBJ,
-    REF_CONST,
-    REF_FUNC
-} ref_type_t;
-
-typedef struct {
-    ref_type_t type;
-    union {
-        struct {
-            IDispatch *disp;
-            DISPID id;
-        } d;
-        VARIANT *v;
-        function_t *f;
-        IDispatch *obj;
-    } u;
-} ref_t;
-
 typedef struct {
     VARIANT *v;
     VARIANT store;
@@ -95,7 +73,7 @@ static BOOL lookup_dynamic_vars(dynamic_var_t *var, const WCHAR *name, ref_t *re
     return FALSE;
 }
 
-static HRESULT lookup_identifier(exec_ctx_t *ctx, BSTR name, vbdisp_invoke_type_t invoke_type, ref_t *ref)
+static HRESULT lookup_global_identifier(exec_ctx_t *ctx, BSTR name, vbdisp_invoke_type_t invoke_type, ref_t *ref)
 {
     named_item_t *item;
     function_t *func;
@@ -106,30 +84,6 @@ static HRESULT lookup_identifier(exec_ctx_t *ctx, BSTR name, vbdisp_invoke_type_
 
     static const WCHAR errW[] = {'e','r','r',0};
 
-    if(invoke_type == VBDISP_LET
-            && (ctx->func->type == FUNC_FUNCTION || ctx->func->type == FUNC_PROPGET || ctx->func->type == FUNC_DEFGET)
-            && !strcmpiW(name, ctx->func->name)) {
-        ref->type = REF_VAR;
-        ref->u.v = &ctx->ret_val;
-        return S_OK;
-    }
-
-    for(i=0; i < ctx->func->var_cnt; i++) {
-        if(!strcmpiW(ctx->func->vars[i].name, name)) {
-            ref->type = REF_VAR;
-            ref->u.v = ctx->vars+i;
-            return TRUE;
-        }
-    }
-
-    for(i=0; i < ctx->func->arg_cnt; i++) {
-        if(!strcmpiW(ctx->func->args[i].name, name)) {
-            ref->type = REF_VAR;
-            ref->u.v = ctx->args+i;
-            return S_OK;
-        }
-    }
-
     if(lookup_dynamic_vars(ctx->func->type == FUNC_GLOBAL ? ctx->script->global_vars : ctx->dynamic_vars, name, ref))
         return S_OK;
 
@@ -212,6 +166,50 @@ static HRESULT lookup_identifier(exec_ctx_t *ctx, BSTR name, vbdisp_invoke_type_
     return S_OK;
 }
 
+/* Global names resolve to the same reference as long as the script's names don't change,
+ * unless the lookup goes through a class instance, per-call dynamic variables or
+ * external objects whose names we don't track. */
+static inline BOOL can_cache_identifier(exec_ctx_t *ctx)
+{
+    if(ctx->vbthis || ctx->func->code_ctx->context)
+        return FALSE;
+    return ctx->func->type == FUNC_GLOBAL || (!ctx->dynamic_vars && !ctx->script->host_global);
+}
+
+/* name is the identifier argument of the current instruction. */
+static HRESULT lookup_identifier(exec_ctx_t *ctx, BSTR name, vbdisp_invoke_type_t invoke_type, ref_t *ref)
+{
+    ident_ref_t *ident = ctx->instr->ident;
+    HRESULT hres;
+
+    if(invoke_type == VBDISP_LET
+            && (ctx->func->type == FUNC_FUNCTION || ctx->func->type == FUNC_PROPGET || ctx->func->type == FUNC_DEFGET)
+            && !strcmpiW(name, ctx->func->name)) {
+        ref->type = REF_VAR;
+        ref->u.v = &ctx->ret_val;
+        return S_OK;
+    }
+
+    if(ident->local_ref) {
+        ref->type = REF_VAR;
+        ref->u.v = ident->local_ref > 0 ? ctx->vars + ident->local_ref - 1 : ctx->args - ident->local_ref - 1;
+        return S_OK;
+    }
+
+    if(ident->ref.type != REF_NONE && ident->names_version == ctx->script->names_version
+            && can_cache_identifier(ctx)) {
+        *ref = ident->ref;
+        return S_OK;
+    }
+
+    hres = lookup_global_identifier(ctx, name, invoke_type, ref);
+    if(SUCCEEDED(hres) && ref->type != REF_NONE && can_cache_identifier(ctx)) {
+        ident->names_version = ctx->script->names_version;
+        ident->ref = *ref;
+    }
+    return hres;
+}
+
 static HRESULT add_dynamic_var(exec_ctx_t *ctx, const WCHAR *name,
         BOOL is_const, VARIANT **out_var)
 {
@@ -238,6 +236,7 @@ static HRESULT add_dynamic_var(exec_ctx_t *ctx, const WCHAR *name,
     if(ctx->func->type == FUNC_GLOBAL) {
         new_var->next = ctx->script->global_vars;
         ctx->script->global_vars = new_var;
+        ctx->script->names_version++;
     }else {
         new_var->next = ctx->dynamic_vars;
         ctx->dynamic_vars = new_var;
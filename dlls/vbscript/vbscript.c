@@ -156,6 +156,7 @@ static void release_script(script_ctx_t *ctx)
 
     release_dynamic_vars(ctx->global_vars);
     ctx->global_vars = NULL;
+    ctx->names_version++;
 
     while(!list_empty(&ctx->named_items)) {
         named_item_t *iter = LIST_ENTRY(list_head(&ctx->named_items), named_item_t, entry);
@@ -482,6 +483,7 @@ static HRESULT WINAPI VBScript_AddNamedItem(IActiveScript *iface, LPCOLESTR pstr
     }
 
     list_add_tail(&This->ctx->named_items, &item->entry);
+    This->ctx->names_version++;
     return S_OK;
 }
 
@@ -201,6 +201,9 @@ struct _script_ctx_t {
 
     heap_pool_t heap;
 
+    /* Incremented when global variables, functions or named items change. */
+    unsigned names_version;
+
     struct list objects;
     struct list code_list;
     struct list named_items;
@@ -295,10 +298,43 @@ typedef union {
     double *dbl;
 } instr_arg_t;
 
+typedef enum {
+    REF_NONE,
+    REF_DISP,
+    REF_VAR,
+    REF_OBJ,
+    REF_CONST,
+    REF_FUNC
+} ref_type_t;
+
+typedef struct {
+    ref_type_t type;
+    union {
+        struct {
+            IDispatch *disp;
+            DISPID id;
+        } d;
+        VARIANT *v;
+        function_t *f;
+        IDispatch *obj;
+    } u;
+} ref_t;
+
+/* Resolution of the identifier used by an instruction. local_ref is set by the compiler
+ * to the index plus one of the local variable (> 0) or argument (< 0) the name refers to.
+ * Other names are resolved on first execution and kept in ref while names_version matches
+ * the script's one. */
+typedef struct {
+    int local_ref;
+    unsigned names_version;
+    ref_t ref;
+} ident_ref_t;
+
 typedef struct {
     vbsop_t op;
     instr_arg_t arg1;
     instr_arg_t arg2;
+    ident_ref_t *ident;
 } instr_t;
 
 typedef struct {
@@ -1736,7 +1736,7 @@ static BOOL seen_dir( struct dirstack *dirstack, const WCHAR *path )
     return FALSE;
 }
 
-/* optimize queries of the form WHERE Name='...' [OR Name='...']* */
+/* optimize queries of the form WHERE Name='...' [OR Name='...']* [AND ...] */
 static UINT seed_dirs( struct dirstack *dirstack, const struct expr *cond, WCHAR root, UINT *count )
 {
     const struct expr *left, *right;
@@ -1783,9 +1783,27 @@ static UINT seed_dirs( struct dirstack *dirstack, const struct expr *cond, WCHAR
         if (!(seed_dirs( dirstack, right, root, &right_count ))) return *count = 0;
         return *count += left_count + right_count;
     }
+    else if (cond->u.expr.op == OP_AND)
+    {
+        /* matching rows satisfy both sides, so seeding from either one is enough */
+        if (seed_dirs( dirstack, left, root, count )) return *count;
+        return seed_dirs( dirstack, right, root, count );
+    }
     return *count = 0;
 }
 
+/* check if the directory or anything below it can match the condition */
+static BOOL match_dir( const struct expr *cond, WCHAR root, const WCHAR *path )
+{
+    WCHAR *name;
+    BOOL ret;
+
+    if (!cond || !(name = build_name( root, path ))) return TRUE;
+    ret = match_key_str( cond, prop_nameW, name, TRUE );
+    heap_free( name );
+    return ret;
+}
+
 static WCHAR *append_path( const WCHAR *path, const WCHAR *segment, UINT *len )
 {
     UINT len_path = 0, len_segment = strlenW( segment );
@@ -1884,6 +1902,11 @@ static enum fill_status fill_datafile( struct table *table, const struct expr *c
 
                     if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
                     {
+                        if (!match_dir( cond, root[0], new_path ))
+                        {
+                            heap_free( new_path );
+                            continue;
+                        }
                         if (push_dir( dirstack, new_path, len )) continue;
                         heap_free( new_path );
                         FindClose( handle );
@@ -1891,7 +1914,13 @@ static enum fill_status fill_datafile( struct table *table, const struct expr *c
                         goto done;
                     }
                     rec = (struct record_datafile *)(table->data + offset);
-                    rec->name    = build_name( root[0], new_path );
+                    rec->name = build_name( root[0], new_path );
+                    heap_free( new_path );
+                    if (!match_key_str( cond, prop_nameW, rec->name, FALSE ))
+                    {
+                        heap_free( rec->name );
+                        continue;
+                    }
                     rec->version = get_file_version( rec->name );
                     if (!match_row( table, row, cond, &status ))
                     {
@@ -2005,6 +2034,11 @@ static enum fill_status fill_directory( struct table *table, const struct expr *
                         continue;
 
                     new_path = append_path( path, data.cFileName, &len );
+                    if (!match_dir( cond, root[0], new_path ))
+                    {
+                        heap_free( new_path );
+                        continue;
+                    }
                     if (!(push_dir( dirstack, new_path, len )))
                     {
                         heap_free( new_path );
@@ -2755,9 +2789,9 @@ static enum fill_status fill_printer( struct table *table, const struct expr *co
         rec->name                 = heap_strdupW( info[i].pPrinterName );
         rec->network              = 0;
         rec->portname             = heap_strdupW( info[i].pPortName );
-        if (!match_row( table, i, cond, &status ))
+        if (!match_row( table, num_rows, cond, &status ))
         {
-            free_row_values( table, i );
+            free_row_values( table, num_rows );
             continue;
         }
         offset += sizeof(*rec);
@@ -2795,13 +2829,17 @@ static enum fill_status fill_process( struct table *table, const struct expr *co
 
     do
     {
+        sprintfW( handle, fmtW, entry.th32ProcessID );
+        if (!match_key_int( cond, prop_processidW, entry.th32ProcessID ) ||
+            !match_key_str( cond, prop_handleW, handle, FALSE ) ||
+            !match_key_str( cond, prop_nameW, entry.szExeFile, FALSE )) continue;
+
         if (!resize_table( table, row + 1, sizeof(*rec) )) goto done;
 
         rec = (struct record_process *)(table->data + offset);
         rec->caption        = heap_strdupW( entry.szExeFile );
         rec->commandline    = get_cmdline( entry.th32ProcessID );
         rec->description    = heap_strdupW( entry.szExeFile );
-        sprintfW( handle, fmtW, entry.th32ProcessID );
         rec->handle         = heap_strdupW( handle );
         rec->name           = heap_strdupW( entry.szExeFile );
         rec->process_id     = entry.th32ProcessID;
@@ -3041,9 +3079,9 @@ static enum fill_status fill_processor( struct table *table, const struct expr *
         rec->revision               = get_processor_revision();
         rec->unique_id              = NULL;
         rec->version                = heap_strdupW( version );
-        if (!match_row( table, i, cond, &status ))
+        if (!match_row( table, num_rows, cond, &status ))
         {
-            free_row_values( table, i );
+            free_row_values( table, num_rows );
             continue;
         }
         offset += sizeof(*rec);
@@ -3387,6 +3425,8 @@ static enum fill_status fill_service( struct table *table, const struct expr *co
     {
         QUERY_SERVICE_CONFIGW *config;
 
+        if (!match_key_str( cond, prop_nameW, services[i].lpServiceName, FALSE ) ||
+            !match_key_str( cond, prop_displaynameW, services[i].lpDisplayName, FALSE )) continue;
         if (!(config = query_service_config( manager, services[i].lpServiceName ))) continue;
 
         status = &services[i].ServiceStatusProcess;
@@ -3637,12 +3677,12 @@ static struct table builtin_classes[] =
     { class_biosW, ARRAY_SIZE(col_bios), col_bios, ARRAY_SIZE(data_bios), 0, (BYTE *)data_bios },
     { class_cdromdriveW, ARRAY_SIZE(col_cdromdrive), col_cdromdrive, 0, 0, NULL, fill_cdromdrive },
     { class_compsysW, ARRAY_SIZE(col_compsys), col_compsys, 0, 0, NULL, fill_compsys },
-    { class_compsysproductW, ARRAY_SIZE(col_compsysproduct), col_compsysproduct, 0, 0, NULL, fill_compsysproduct },
+    { class_compsysproductW, ARRAY_SIZE(col_compsysproduct), col_compsysproduct, 0, 0, NULL, fill_compsysproduct, TABLE_FLAG_CACHED },
     { class_datafileW, ARRAY_SIZE(col_datafile), col_datafile, 0, 0, NULL, fill_datafile },
     { class_desktopmonitorW, ARRAY_SIZE(col_desktopmonitor), col_desktopmonitor, 0, 0, NULL, fill_desktopmonitor },
     { class_directoryW, ARRAY_SIZE(col_directory), col_directory, 0, 0, NULL, fill_directory },
-    { class_diskdriveW, ARRAY_SIZE(col_diskdrive), col_diskdrive, 0, 0, NULL, fill_diskdrive },
-    { class_diskpartitionW, ARRAY_SIZE(col_diskpartition), col_diskpartition, 0, 0, NULL, fill_diskpartition },
+    { class_diskdriveW, ARRAY_SIZE(col_diskdrive), col_diskdrive, 0, 0, NULL, fill_diskdrive, TABLE_FLAG_CACHED },
+    { class_diskpartitionW, ARRAY_SIZE(col_diskpartition), col_diskpartition, 0, 0, NULL, fill_diskpartition, TABLE_FLAG_CACHED },
     { class_ip4routetableW, ARRAY_SIZE(col_ip4routetable), col_ip4routetable, 0, 0, NULL, fill_ip4routetable },
     { class_logicaldiskW, ARRAY_SIZE(col_logicaldisk), col_logicaldisk, 0, 0, NULL, fill_logicaldisk },
     { class_logicaldisk2W, ARRAY_SIZE(col_logicaldisk), col_logicaldisk, 0, 0, NULL, fill_logicaldisk },
@@ -3651,8 +3691,8 @@ static struct table builtin_classes[] =
     { class_osW, ARRAY_SIZE(col_os), col_os, 0, 0, NULL, fill_os },
     { class_paramsW, ARRAY_SIZE(col_param), col_param, ARRAY_SIZE(data_param), 0, (BYTE *)data_param },
     { class_physicalmediaW, ARRAY_SIZE(col_physicalmedia), col_physicalmedia, ARRAY_SIZE(data_physicalmedia), 0, (BYTE *)data_physicalmedia },
-    { class_physicalmemoryW, ARRAY_SIZE(col_physicalmemory), col_physicalmemory, 0, 0, NULL, fill_physicalmemory },
-    { class_pnpentityW, ARRAY_SIZE(col_pnpentity), col_pnpentity, 0, 0, NULL, fill_pnpentity },
+    { class_physicalmemoryW, ARRAY_SIZE(col_physicalmemory), col_physicalmemory, 0, 0, NULL, fill_physicalmemory, TABLE_FLAG_CACHED },
+    { class_pnpentityW, ARRAY_SIZE(col_pnpentity), col_pnpentity, 0, 0, NULL, fill_pnpentity, TABLE_FLAG_CACHED },
     { class_printerW, ARRAY_SIZE(col_printer), col_printer, 0, 0, NULL, fill_printer },
     { class_processW, ARRAY_SIZE(col_process), col_process, 0, 0, NULL, fill_process },
     { class_processorW, ARRAY_SIZE(col_processor), col_processor, 0, 0, NULL, fill_processor },
@@ -402,16 +402,112 @@ HRESULT eval_cond( const struct table *table, UINT row, const struct expr *cond,
     return WBEM_E_INVALID_QUERY;
 }
 
+static BOOL is_key_propval( const struct expr *expr, const WCHAR *prop )
+{
+    return expr->type == EXPR_PROPVAL && !strcmpiW( expr->u.propval->name, prop );
+}
+
+/* compare the characters in front of the first wildcard, the way eval_like does */
+static BOOL match_like_prefix( const WCHAR *str, const WCHAR *pattern )
+{
+    while (*str && *pattern && *pattern != '%')
+    {
+        if (toupperW( *str++ ) != toupperW( *pattern++ )) return FALSE;
+    }
+    return TRUE;
+}
+
+/* Check whether a row where string property prop has the given value can satisfy the
+ * condition, so that providers can skip a row before doing expensive work for it. Only
+ * equality and LIKE terms joined with AND are looked at, so this may return TRUE for rows
+ * that don't match, but never FALSE for rows that do. If prefix is set, value is only the
+ * leading part of the property, as in the name of a directory that is about to be searched.
+ */
+BOOL match_key_str( const struct expr *cond, const WCHAR *prop, const WCHAR *value, BOOL prefix )
+{
+    const struct expr *left, *right;
+    const WCHAR *str;
+
+    if (!cond || !value || cond->type != EXPR_COMPLEX) return TRUE;
+
+    left = cond->u.expr.left;
+    right = cond->u.expr.right;
+    switch (cond->u.expr.op)
+    {
+    case OP_AND:
+        return match_key_str( left, prop, value, prefix ) && match_key_str( right, prop, value, prefix );
+
+    case OP_EQ:
+        if (is_key_propval( left, prop ) && right->type == EXPR_SVAL) str = right->u.sval;
+        else if (is_key_propval( right, prop ) && left->type == EXPR_SVAL) str = left->u.sval;
+        else return TRUE;
+        if (prefix) return !strncmpW( str, value, strlenW( value ) );
+        return !strcmpW( str, value );
+
+    case OP_LIKE:
+        if (!is_key_propval( left, prop ) || right->type != EXPR_SVAL) return TRUE;
+        return match_like_prefix( value, right->u.sval );
+
+    default:
+        return TRUE;
+    }
+}
+
+/* same as match_key_str for integer properties compared with integer constants */
+BOOL match_key_int( const struct expr *cond, const WCHAR *prop, LONGLONG value )
+{
+    const struct expr *left, *right;
+
+    if (!cond || cond->type != EXPR_COMPLEX) return TRUE;
+
+    left = cond->u.expr.left;
+    right = cond->u.expr.right;
+    switch (cond->u.expr.op)
+    {
+    case OP_AND:
+        return match_key_int( left, prop, value ) && match_key_int( right, prop, value );
+
+    case OP_EQ:
+        if (is_key_propval( left, prop ) && right->type == EXPR_IVAL) return value == right->u.ival;
+        if (is_key_propval( right, prop ) && left->type == EXPR_IVAL) return value == left->u.ival;
+        return TRUE;
+
+    default:
+        return TRUE;
+    }
+}
+
+static enum fill_status fill_table( struct table *table, const struct expr *cond )
+{
+    enum fill_status status;
+
+    if (table->flags & TABLE_FLAG_CACHED)
+    {
+        if ((table->flags & TABLE_FLAG_FILLED) && GetTickCount() - table->fill_time < TABLE_CACHE_TTL)
+        {
+            TRACE("using cached rows for %s\n", debugstr_w(table->name));
+            return FILL_STATUS_UNFILTERED;
+        }
+        /* cached rows have to serve any condition */
+        cond = NULL;
+    }
+    clear_table( table );
+    status = table->fill( table, cond );
+    if ((table->flags & TABLE_FLAG_CACHED) && status != FILL_STATUS_FAILED)
+    {
+        table->fill_time = GetTickCount();
+        table->flags |= TABLE_FLAG_FILLED;
+    }
+    return status;
+}
+
 HRESULT execute_view( struct view *view )
 {
+    enum fill_status status = FILL_STATUS_UNFILTERED;
     UINT i, j = 0, len;
 
     if (!view->table) return S_OK;
-    if (view->table->fill)
-    {
-        clear_table( view->table );
-        view->table->fill( view->table, view->cond );
-    }
+    if (view->table->fill) status = fill_table( view->table, view->cond );
     if (!view->table->num_rows) return S_OK;
 
     len = min( view->table->num_rows, 16 );
@@ -430,8 +526,13 @@ HRESULT execute_view( struct view *view )
             if (!(tmp = heap_realloc( view->result, len * sizeof(UINT) ))) return E_OUTOFMEMORY;
             view->result = tmp;
         }
-        if ((hr = eval_cond( view->table, i, view->cond, &val, &type )) != S_OK) return hr;
-        if (val) view->result[j++] = i;
+        /* the provider has already checked the condition against filtered rows */
+        if (status != FILL_STATUS_FILTERED)
+        {
+            if ((hr = eval_cond( view->table, i, view->cond, &val, &type )) != S_OK) return hr;
+            if (!val) continue;
+        }
+        view->result[j++] = i;
     }
     view->count = j;
     return S_OK;
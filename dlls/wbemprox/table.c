@@ -304,6 +304,7 @@ void clear_table( struct table *table )
 {
     UINT i;
 
+    table->flags &= ~TABLE_FLAG_FILLED;
     if (!table->data) return;
 
     for (i = 0; i < table->num_rows; i++) free_row_values( table, i );
@@ -328,7 +329,8 @@ void free_table( struct table *table )
 {
     if (!table) return;
 
-    clear_table( table );
+    /* cached rows outlive the last reference, they are replaced when they expire */
+    if (!(table->flags & TABLE_FLAG_CACHED)) clear_table( table );
     if (table->flags & TABLE_FLAG_DYNAMIC)
     {
         TRACE("destroying %p\n", table);
@@ -382,6 +384,7 @@ struct table *create_table( const WCHAR *name, UINT num_cols, const struct colum
     table->fill               = fill;
     table->flags              = TABLE_FLAG_DYNAMIC;
     table->refs               = 0;
+    table->fill_time          = 0;
     list_init( &table->entry );
     return table;
 }
@@ -466,6 +466,91 @@ static void test_Win32_Process( IWbemServices *services, BOOL use_full_path )
     IWbemClassObject_Release( out );
 }
 
+static UINT count_results( IWbemServices *services, const WCHAR *str, UINT *process_id )
+{
+    static const WCHAR processidW[] = {'P','r','o','c','e','s','s','I','d',0};
+    BSTR wql = SysAllocString( wqlW ), query = SysAllocString( str );
+    IEnumWbemClassObject *result;
+    IWbemClassObject *obj;
+    UINT ret = 0;
+    ULONG count;
+    VARIANT val;
+    HRESULT hr;
+
+    hr = IWbemServices_ExecQuery( services, wql, query, 0, NULL, &result );
+    ok( hr == S_OK, "query %s failed %08x\n", wine_dbgstr_w(str), hr );
+    SysFreeString( wql );
+    SysFreeString( query );
+    if (hr != S_OK) return 0;
+
+    for (;;)
+    {
+        IEnumWbemClassObject_Next( result, 10000, 1, &obj, &count );
+        if (!count) break;
+        if (process_id && IWbemClassObject_Get( obj, processidW, 0, &val, NULL, NULL ) == S_OK)
+        {
+            *process_id = V_I4( &val );
+            VariantClear( &val );
+        }
+        IWbemClassObject_Release( obj );
+        ret++;
+    }
+    IEnumWbemClassObject_Release( result );
+    return ret;
+}
+
+static void test_filtered_query( IWbemServices *services )
+{
+    static const WCHAR query1W[] =
+        {'S','E','L','E','C','T',' ','*',' ','F','R','O','M',' ','W','i','n','3','2','_','P','r','o','c','e','s','s',' ',
+         'W','H','E','R','E',' ','P','r','o','c','e','s','s','I','d',' ','=',' ','%','u',0};
+    static const WCHAR query2W[] =
+        {'S','E','L','E','C','T',' ','*',' ','F','R','O','M',' ','W','i','n','3','2','_','P','r','o','c','e','s','s',' ',
+         'W','H','E','R','E',' ','H','a','n','d','l','e',' ','=',' ','"','%','u','"',' ','A','N','D',' ',
+         'P','r','o','c','e','s','s','I','d',' ','=',' ','%','u',0};
+    static const WCHAR query3W[] =
+        {'S','E','L','E','C','T',' ','*',' ','F','R','O','M',' ','W','i','n','3','2','_','P','r','o','c','e','s','s',' ',
+         'W','H','E','R','E',' ','P','r','o','c','e','s','s','I','d',' ','=',' ','%','u',' ','A','N','D',' ',
+         'P','r','o','c','e','s','s','I','d',' ','=',' ','%','u',0};
+    static const WCHAR query4W[] =
+        {'S','E','L','E','C','T',' ','*',' ','F','R','O','M',' ','W','i','n','3','2','_','P','r','o','c','e','s','s','o','r',0};
+    static const WCHAR query5W[] =
+        {'S','E','L','E','C','T',' ','*',' ','F','R','O','M',' ','W','i','n','3','2','_','P','r','o','c','e','s','s','o','r',' ',
+         'W','H','E','R','E',' ','D','e','v','i','c','e','I','d',' ','L','I','K','E',' ','"','C','P','U','0','%','"',0};
+    static const WCHAR query6W[] =
+        {'S','E','L','E','C','T',' ','*',' ','F','R','O','M',' ','W','i','n','3','2','_','P','r','o','c','e','s','s','o','r',' ',
+         'W','H','E','R','E',' ','D','e','v','i','c','e','I','d',' ','=',' ','"','C','P','U','0','"',0};
+    DWORD pid = GetCurrentProcessId();
+    UINT count, process_id;
+    WCHAR query[128];
+
+    process_id = 0;
+    wsprintfW( query, query1W, pid );
+    count = count_results( services, query, &process_id );
+    ok( count == 1, "got %u results\n", count );
+    ok( process_id == pid, "got process id %u\n", process_id );
+
+    process_id = 0;
+    wsprintfW( query, query2W, pid, pid );
+    count = count_results( services, query, &process_id );
+    ok( count == 1, "got %u results\n", count );
+    ok( process_id == pid, "got process id %u\n", process_id );
+
+    wsprintfW( query, query3W, pid, pid + 1 );
+    count = count_results( services, query, NULL );
+    ok( !count, "got %u results\n", count );
+
+    /* consecutive queries return the same rows */
+    count = count_results( services, query4W, NULL );
+    ok( count > 0, "got %u results\n", count );
+    ok( count_results( services, query4W, NULL ) == count, "got different number of results\n" );
+
+    count = count_results( services, query5W, NULL );
+    ok( count == 1, "got %u results\n", count );
+    count = count_results( services, query6W, NULL );
+    ok( count == 1, "got %u results\n", count );
+}
+
 static void test_Win32_ComputerSystem( IWbemServices *services )
 {
     static const WCHAR backslashW[] = {'\\',0};
@@ -1573,6 +1658,7 @@ START_TEST(query)
     test_Win32_Bios( services );
     test_Win32_Process( services, FALSE );
     test_Win32_Process( services, TRUE );
+    test_filtered_query( services );
     test_Win32_Service( services );
     test_Win32_ComputerSystem( services );
     test_Win32_SystemEnclosure( services );
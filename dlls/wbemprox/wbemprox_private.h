@@ -101,6 +101,11 @@ enum fill_status
 };
 
 #define TABLE_FLAG_DYNAMIC 0x00000001
+#define TABLE_FLAG_CACHED  0x00000002
+#define TABLE_FLAG_FILLED  0x00000004
+
+/* how long the rows of a cached table stay valid, in milliseconds */
+#define TABLE_CACHE_TTL    10000
 
 struct table
 {
@@ -114,6 +119,7 @@ struct table
     UINT flags;
     struct list entry;
     LONG refs;
+    DWORD fill_time;
 };
 
 struct property
@@ -187,6 +193,8 @@ void clear_table( struct table * ) DECLSPEC_HIDDEN;
 void free_table( struct table * ) DECLSPEC_HIDDEN;
 UINT get_type_size( CIMTYPE ) DECLSPEC_HIDDEN;
 HRESULT eval_cond( const struct table *, UINT, const struct expr *, LONGLONG *, UINT * ) DECLSPEC_HIDDEN;
+BOOL match_key_str( const struct expr *, const WCHAR *, const WCHAR *, BOOL ) DECLSPEC_HIDDEN;
+BOOL match_key_int( const struct expr *, const WCHAR *, LONGLONG ) DECLSPEC_HIDDEN;
 HRESULT get_column_index( const struct table *, const WCHAR *, UINT * ) DECLSPEC_HIDDEN;
 HRESULT get_value( const struct table *, UINT, UINT, LONGLONG * ) DECLSPEC_HIDDEN;
 BSTR get_value_bstr( const struct table *, UINT, UINT ) DECLSPEC_HIDDEN;
@@ -21,6 +21,9 @@
 
 #include <stdarg.h>
 #include <math.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #define COBJMACROS
 
@@ -73,6 +76,9 @@ struct pixelformatinfo {
     copyfunc copy_function;
 };
 
+/* largest part of the destination buffer converted in one go */
+#define CONVERT_BAND_SIZE 0x100000
+
 typedef struct FormatConverter {
     IWICFormatConverter IWICFormatConverter_iface;
     LONG ref;
@@ -97,6 +103,193 @@ static inline float to_sRGB_component(float f)
     return 1.055f * powf(f, 1.0f/2.4f) - 0.055f;
 }
 
+static inline BYTE to_sRGB_byte_slow(float f)
+{
+    return (BYTE)floorf(to_sRGB_component(f) * 255.0f + 0.51f);
+}
+
+/* srgb_thresholds[i] is the smallest linear value that converts to the sRGB
+ * byte value i, so converting a byte only takes a binary search. */
+static float srgb_thresholds[256];
+static INIT_ONCE srgb_init_once = INIT_ONCE_STATIC_INIT;
+
+static BOOL WINAPI init_srgb_thresholds(INIT_ONCE *once, void *param, void **context)
+{
+    union { float f; UINT u; } value;
+    UINT i, low = 0, high, mid;
+
+    /* positive floats are ordered like their bit patterns */
+    for (i = 1; i < 256; i++)
+    {
+        value.f = 1.0f;
+        high = value.u;
+        while (low < high)
+        {
+            mid = low + (high - low) / 2;
+            value.u = mid;
+            if (to_sRGB_byte_slow(value.f) >= i) high = mid;
+            else low = mid + 1;
+        }
+        value.u = low;
+        srgb_thresholds[i] = value.f;
+    }
+
+    return TRUE;
+}
+
+static void init_sRGB_table(void)
+{
+    InitOnceExecuteOnce(&srgb_init_once, init_srgb_thresholds, NULL, NULL);
+}
+
+/* Same as to_sRGB_byte_slow(), init_sRGB_table() must have been called. */
+static inline BYTE to_sRGB_byte(float f)
+{
+    UINT i = 0, step;
+
+    if (!(f >= 0.0f && f <= 1.0f)) return to_sRGB_byte_slow(f);
+
+    for (step = 128; step; step >>= 1)
+        if (f >= srgb_thresholds[i + step]) i += step;
+
+    return i;
+}
+
+static void set_alpha_opaque(BYTE *pixels, UINT width)
+{
+    DWORD *pixel = (DWORD *)pixels;
+    UINT x = 0;
+
+#ifdef __SSE2__
+    const __m128i alpha = _mm_set1_epi32((int)0xff000000);
+
+    for (; x + 4 <= width; x += 4)
+    {
+        __m128i *p = (__m128i *)(pixel + x);
+        _mm_storeu_si128(p, _mm_or_si128(_mm_loadu_si128(p), alpha));
+    }
+#endif
+
+    for (; x < width; x++)
+        pixel[x] |= 0xff000000;
+}
+
+/* Multiplies the color channels of 32bpp pixels by their alpha, rounding
+ * down like c * a / 255. */
+static void premultiply_alpha(BYTE *pixels, UINT width)
+{
+    UINT x = 0, i;
+
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i color_mask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+    const __m128i alpha_255 = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+
+    for (; x + 4 <= width; x += 4)
+    {
+        __m128i *p = (__m128i *)(pixels + x * 4);
+        __m128i src = _mm_loadu_si128(p);
+        __m128i lo = _mm_unpacklo_epi8(src, zero);
+        __m128i hi = _mm_unpacklo_epi8(_mm_srli_si128(src, 8), zero);
+        __m128i alpha_lo, alpha_hi;
+
+        /* multiply color channels by alpha and alpha by 255 */
+        alpha_lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, 0xff), 0xff);
+        alpha_hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, 0xff), 0xff);
+        alpha_lo = _mm_or_si128(_mm_and_si128(alpha_lo, color_mask), alpha_255);
+        alpha_hi = _mm_or_si128(_mm_and_si128(alpha_hi, color_mask), alpha_255);
+        lo = _mm_mullo_epi16(lo, alpha_lo);
+        hi = _mm_mullo_epi16(hi, alpha_hi);
+
+        /* t / 255 == (t + 1 + (t >> 8)) >> 8 for t <= 255 * 255 */
+        lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lo, one), _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(hi, one), _mm_srli_epi16(hi, 8)), 8);
+
+        _mm_storeu_si128(p, _mm_packus_epi16(lo, hi));
+    }
+#endif
+
+    for (; x < width; x++)
+    {
+        BYTE *pixel = pixels + x * 4, alpha = pixel[3];
+
+        if (alpha == 255) continue;
+        for (i = 0; i < 3; i++)
+            pixel[i] = pixel[i] * alpha / 255;
+    }
+}
+
+/* Divides the color channels of 32bpp pixels by their alpha, rounding down
+ * like c * 255 / a. */
+static void unpremultiply_alpha(BYTE *pixels, UINT width)
+{
+    UINT x, i;
+
+    for (x = 0; x < width; x++)
+    {
+        BYTE *pixel = pixels + x * 4, alpha = pixel[3];
+        UINT recip;
+
+        if (alpha == 0 || alpha == 255) continue;
+
+        /* one division per pixel; exact for c <= 255 as the rounding error
+         * is smaller than the distance to the next multiple of 1 / alpha */
+        recip = ((255 << 16) + alpha - 1) / alpha;
+        for (i = 0; i < 3; i++)
+            pixel[i] = (pixel[i] * recip) >> 16;
+    }
+}
+
+static void convert_24bpp_to_32bpp(const BYTE *src, BYTE *dst, UINT width)
+{
+    DWORD *dstpixel = (DWORD *)dst;
+    UINT x;
+
+    for (x = 0; x < width; x++, src += 3)
+        dstpixel[x] = 0xff000000 | (src[2] << 16) | (src[1] << 8) | src[0];
+}
+
+static void convert_32bpp_to_24bpp(const BYTE *src, BYTE *dst, UINT width)
+{
+    const DWORD *srcpixel = (const DWORD *)src;
+    UINT x;
+
+    for (x = 0; x < width; x++, dst += 3)
+    {
+        DWORD pixel = srcpixel[x];
+        dst[0] = pixel;
+        dst[1] = pixel >> 8;
+        dst[2] = pixel >> 16;
+    }
+}
+
+static void convert_gray8_to_32bpp(const BYTE *src, BYTE *dst, UINT width)
+{
+    DWORD *dstpixel = (DWORD *)dst;
+    UINT x = 0;
+
+#ifdef __SSE2__
+    const __m128i alpha = _mm_set1_epi8((char)0xff);
+
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i gray = _mm_loadu_si128((const __m128i *)(src + x));
+        __m128i gg_lo = _mm_unpacklo_epi8(gray, gray), gg_hi = _mm_unpackhi_epi8(gray, gray);
+        __m128i ga_lo = _mm_unpacklo_epi8(gray, alpha), ga_hi = _mm_unpackhi_epi8(gray, alpha);
+        __m128i *p = (__m128i *)(dstpixel + x);
+
+        _mm_storeu_si128(p, _mm_unpacklo_epi16(gg_lo, ga_lo));
+        _mm_storeu_si128(p + 1, _mm_unpackhi_epi16(gg_lo, ga_lo));
+        _mm_storeu_si128(p + 2, _mm_unpacklo_epi16(gg_hi, ga_hi));
+        _mm_storeu_si128(p + 3, _mm_unpackhi_epi16(gg_hi, ga_hi));
+    }
+#endif
+
+    for (; x < width; x++)
+        dstpixel[x] = 0xff000000 | (src[x] << 16) | (src[x] << 8) | src[x];
+}
+
 #if 0 /* FIXME: enable once needed */
 static void from_sRGB(BYTE *bgr)
 {
@@ -338,13 +531,11 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
         if (prc)
         {
             HRESULT res;
-            INT x, y;
+            INT y;
             BYTE *srcdata;
             UINT srcstride, srcdatasize;
             const BYTE *srcrow;
-            const BYTE *srcbyte;
             BYTE *dstrow;
-            DWORD *dstpixel;
 
             srcstride = prc->Width;
             srcdatasize = srcstride * prc->Height;
@@ -359,13 +550,7 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                 srcrow = srcdata;
                 dstrow = pbBuffer;
                 for (y=0; y<prc->Height; y++) {
-                    srcbyte = srcrow;
-                    dstpixel=(DWORD*)dstrow;
-                    for (x=0; x<prc->Width; x++)
-                    {
-                        *dstpixel++ = 0xff000000|(*srcbyte<<16)|(*srcbyte<<8)|*srcbyte;
-                        srcbyte++;
-                    }
+                    convert_gray8_to_32bpp(srcrow, dstrow, prc->Width);
                     srcrow += srcstride;
                     dstrow += cbStride;
                 }
@@ -620,13 +805,11 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
         if (prc)
         {
             HRESULT res;
-            INT x, y;
+            INT y;
             BYTE *srcdata;
             UINT srcstride, srcdatasize;
             const BYTE *srcrow;
-            const BYTE *srcpixel;
             BYTE *dstrow;
-            BYTE *dstpixel;
 
             srcstride = 3 * prc->Width;
             srcdatasize = srcstride * prc->Height;
@@ -641,14 +824,7 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                 srcrow = srcdata;
                 dstrow = pbBuffer;
                 for (y=0; y<prc->Height; y++) {
-                    srcpixel=srcrow;
-                    dstpixel=dstrow;
-                    for (x=0; x<prc->Width; x++) {
-                        *dstpixel++=*srcpixel++; /* blue */
-                        *dstpixel++=*srcpixel++; /* green */
-                        *dstpixel++=*srcpixel++; /* red */
-                        *dstpixel++=255; /* alpha */
-                    }
+                    convert_24bpp_to_32bpp(srcrow, dstrow, prc->Width);
                     srcrow += srcstride;
                     dstrow += cbStride;
                 }
@@ -711,15 +887,14 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
         if (prc)
         {
             HRESULT res;
-            INT x, y;
+            INT y;
 
             res = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
             if (FAILED(res)) return res;
 
             /* set all alpha values to 255 */
             for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                    pbBuffer[cbStride*y+4*x+3] = 0xff;
+                set_alpha_opaque(pbBuffer + cbStride * y, prc->Width);
         }
         return S_OK;
     case format_32bppBGRA:
@@ -730,22 +905,13 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
         if (prc)
         {
             HRESULT res;
-            INT x, y;
+            INT y;
 
             res = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
             if (FAILED(res)) return res;
 
             for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
-                    if (alpha != 0 && alpha != 255)
-                    {
-                        pbBuffer[cbStride*y+4*x] = pbBuffer[cbStride*y+4*x] * 255 / alpha;
-                        pbBuffer[cbStride*y+4*x+1] = pbBuffer[cbStride*y+4*x+1] * 255 / alpha;
-                        pbBuffer[cbStride*y+4*x+2] = pbBuffer[cbStride*y+4*x+2] * 255 / alpha;
-                    }
-                }
+                unpremultiply_alpha(pbBuffer + cbStride * y, prc->Width);
         }
         return S_OK;
     case format_48bppRGB:
@@ -873,15 +1039,14 @@ static HRESULT copypixels_to_32bppRGBA(struct FormatConverter *This, const WICRe
     case format_32bppRGB:
         if (prc)
         {
-            INT x, y;
+            INT y;
 
             hr = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
             if (FAILED(hr)) return hr;
 
             /* set all alpha values to 255 */
             for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                    pbBuffer[cbStride*y+4*x+3] = 0xff;
+                set_alpha_opaque(pbBuffer + cbStride * y, prc->Width);
         }
         return S_OK;
 
@@ -893,22 +1058,13 @@ static HRESULT copypixels_to_32bppRGBA(struct FormatConverter *This, const WICRe
     case format_32bppPRGBA:
         if (prc)
         {
-            INT x, y;
+            INT y;
 
             hr = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
             if (FAILED(hr)) return hr;
 
             for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
-                    if (alpha != 0 && alpha != 255)
-                    {
-                        pbBuffer[cbStride*y+4*x] = pbBuffer[cbStride*y+4*x] * 255 / alpha;
-                        pbBuffer[cbStride*y+4*x+1] = pbBuffer[cbStride*y+4*x+1] * 255 / alpha;
-                        pbBuffer[cbStride*y+4*x+2] = pbBuffer[cbStride*y+4*x+2] * 255 / alpha;
-                    }
-                }
+                unpremultiply_alpha(pbBuffer + cbStride * y, prc->Width);
         }
         return S_OK;
 
@@ -967,19 +1123,10 @@ static HRESULT copypixels_to_32bppPBGRA(struct FormatConverter *This, const WICR
         hr = copypixels_to_32bppBGRA(This, prc, cbStride, cbBufferSize, pbBuffer, source_format);
         if (SUCCEEDED(hr) && prc)
         {
-            INT x, y;
+            INT y;
 
             for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
-                    if (alpha != 255)
-                    {
-                        pbBuffer[cbStride*y+4*x] = pbBuffer[cbStride*y+4*x] * alpha / 255;
-                        pbBuffer[cbStride*y+4*x+1] = pbBuffer[cbStride*y+4*x+1] * alpha / 255;
-                        pbBuffer[cbStride*y+4*x+2] = pbBuffer[cbStride*y+4*x+2] * alpha / 255;
-                    }
-                }
+                premultiply_alpha(pbBuffer + cbStride * y, prc->Width);
         }
         return hr;
     }
@@ -1000,19 +1147,10 @@ static HRESULT copypixels_to_32bppPRGBA(struct FormatConverter *This, const WICR
         hr = copypixels_to_32bppRGBA(This, prc, cbStride, cbBufferSize, pbBuffer, source_format);
         if (SUCCEEDED(hr) && prc)
         {
-            INT x, y;
+            INT y;
 
             for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
-                    if (alpha != 255)
-                    {
-                        pbBuffer[cbStride*y+4*x] = pbBuffer[cbStride*y+4*x] * alpha / 255;
-                        pbBuffer[cbStride*y+4*x+1] = pbBuffer[cbStride*y+4*x+1] * alpha / 255;
-                        pbBuffer[cbStride*y+4*x+2] = pbBuffer[cbStride*y+4*x+2] * alpha / 255;
-                    }
-                }
+                premultiply_alpha(pbBuffer + cbStride * y, prc->Width);
         }
         return hr;
     }
@@ -1041,13 +1179,11 @@ static HRESULT copypixels_to_24bppBGR(struct FormatConverter *This, const WICRec
         if (prc)
         {
             HRESULT res;
-            INT x, y;
+            INT y;
             BYTE *srcdata;
             UINT srcstride, srcdatasize;
             const BYTE *srcrow;
-            const BYTE *srcpixel;
             BYTE *dstrow;
-            BYTE *dstpixel;
 
             srcstride = 4 * prc->Width;
             srcdatasize = srcstride * prc->Height;
@@ -1062,14 +1198,7 @@ static HRESULT copypixels_to_24bppBGR(struct FormatConverter *This, const WICRec
                 srcrow = srcdata;
                 dstrow = pbBuffer;
                 for (y=0; y<prc->Height; y++) {
-                    srcpixel=srcrow;
-                    dstpixel=dstrow;
-                    for (x=0; x<prc->Width; x++) {
-                        *dstpixel++=*srcpixel++; /* blue */
-                        *dstpixel++=*srcpixel++; /* green */
-                        *dstpixel++=*srcpixel++; /* red */
-                        srcpixel++; /* alpha */
-                    }
+                    convert_32bpp_to_24bpp(srcrow, dstrow, prc->Width);
                     srcrow += srcstride;
                     dstrow += cbStride;
                 }
@@ -1100,6 +1229,8 @@ static HRESULT copypixels_to_24bppBGR(struct FormatConverter *This, const WICRec
                 INT x, y;
                 BYTE *src = srcdata, *dst = pbBuffer;
 
+                init_sRGB_table();
+
                 for (y = 0; y < prc->Height; y++)
                 {
                     float *gray_float = (float *)src;
@@ -1107,7 +1238,7 @@ static HRESULT copypixels_to_24bppBGR(struct FormatConverter *This, const WICRec
 
                     for (x = 0; x < prc->Width; x++)
                     {
-                        BYTE gray = (BYTE)floorf(to_sRGB_component(gray_float[x]) * 255.0f + 0.51f);
+                        BYTE gray = to_sRGB_byte(gray_float[x]);
                         *bgr++ = gray;
                         *bgr++ = gray;
                         *bgr++ = gray;
@@ -1320,13 +1451,15 @@ static HRESULT copypixels_to_8bppGray(struct FormatConverter *This, const WICRec
                 INT x, y;
                 BYTE *src = srcdata, *dst = pbBuffer;
 
+                init_sRGB_table();
+
                 for (y=0; y < prc->Height; y++)
                 {
                     float *srcpixel = (float*)src;
                     BYTE *dstpixel = dst;
 
                     for (x=0; x < prc->Width; x++)
-                        *dstpixel++ = (BYTE)floorf(to_sRGB_component(*srcpixel++) * 255.0f + 0.51f);
+                        *dstpixel++ = to_sRGB_byte(*srcpixel++);
 
                     src += srcstride;
                     dst += cbStride;
@@ -1354,6 +1487,8 @@ static HRESULT copypixels_to_8bppGray(struct FormatConverter *This, const WICRec
         INT x, y;
         BYTE *src = srcdata, *dst = pbBuffer;
 
+        init_sRGB_table();
+
         for (y = 0; y < prc->Height; y++)
         {
             BYTE *bgr = src;
@@ -1362,8 +1497,7 @@ static HRESULT copypixels_to_8bppGray(struct FormatConverter *This, const WICRec
             {
                 float gray = (bgr[2] * 0.2126f + bgr[1] * 0.7152f + bgr[0] * 0.0722f) / 255.0f;
 
-                gray = to_sRGB_component(gray) * 255.0f;
-                dst[x] = (BYTE)floorf(gray + 0.51f);
+                dst[x] = to_sRGB_byte(gray);
                 bgr += 3;
             }
             src += srcstride;
@@ -1622,7 +1756,9 @@ static HRESULT WINAPI FormatConverter_CopyPixels(IWICFormatConverter *iface,
     const WICRect *prc, UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
 {
     FormatConverter *This = impl_from_IWICFormatConverter(iface);
-    WICRect rc;
+    WICRect rc, band;
+    UINT bpp, bytesperrow;
+    INT y, band_height;
     HRESULT hr;
     TRACE("(%p,%s,%u,%u,%p)\n", iface, debug_wic_rect(prc), cbStride, cbBufferSize, pbBuffer);
 
@@ -1640,6 +1776,30 @@ static HRESULT WINAPI FormatConverter_CopyPixels(IWICFormatConverter *iface,
             prc = &rc;
         }
 
+        hr = get_pixelformat_bpp(This->dst_format->guid, &bpp);
+        if (FAILED(hr)) return hr;
+
+        /* convert large requests a band at a time, so the source only has to
+         * provide (and temporary buffers only have to hold) a few rows at once */
+        bytesperrow = (bpp * prc->Width + 7) / 8;
+        band_height = max(CONVERT_BAND_SIZE / max(cbStride, 1), 1);
+
+        if (prc->Height > band_height && cbStride >= bytesperrow &&
+            cbStride * (prc->Height - 1) + bytesperrow <= cbBufferSize)
+        {
+            band = *prc;
+            for (y = 0; y < prc->Height; y += band.Height)
+            {
+                band.Y = prc->Y + y;
+                band.Height = min(prc->Height - y, band_height);
+
+                hr = This->dst_format->copy_function(This, &band, cbStride,
+                    cbBufferSize - cbStride * y, pbBuffer + cbStride * y, This->src_format->format);
+                if (FAILED(hr)) return hr;
+            }
+            return S_OK;
+        }
+
         return This->dst_format->copy_function(This, prc, cbStride, cbBufferSize,
             pbBuffer, This->src_format->format);
     }
@@ -69,6 +69,7 @@ static const WCHAR wszJpegYCrCbSubsampling[] = {'J','p','e','g','Y','C','r','C',
 static const WCHAR wszSuppressApp0[] = {'S','u','p','p','r','e','s','s','A','p','p','0',0};
 
 #define MAKE_FUNCPTR(f) static typeof(f) * p##f
+MAKE_FUNCPTR(jpeg_abort_decompress);
 MAKE_FUNCPTR(jpeg_CreateCompress);
 MAKE_FUNCPTR(jpeg_CreateDecompress);
 MAKE_FUNCPTR(jpeg_destroy_compress);
@@ -94,6 +95,7 @@ static void *load_libjpeg(void)
         return NULL; \
     }
 
+        LOAD_FUNCPTR(jpeg_abort_decompress);
         LOAD_FUNCPTR(jpeg_CreateCompress);
         LOAD_FUNCPTR(jpeg_CreateDecompress);
         LOAD_FUNCPTR(jpeg_destroy_compress);
@@ -157,7 +159,8 @@ typedef struct {
     struct jpeg_source_mgr source_mgr;
     BYTE source_buffer[1024];
     UINT bpp, stride;
-    BYTE *image_data;
+    struct row_cache rows;
+    ULARGE_INTEGER stream_pos; /* where the source manager continues reading */
     CRITICAL_SECTION lock;
 } JpegDecoder;
 
@@ -227,7 +230,7 @@ static ULONG WINAPI JpegDecoder_Release(IWICBitmapDecoder *iface)
         DeleteCriticalSection(&This->lock);
         if (This->cinfo_initialized) pjpeg_destroy_decompress(&This->cinfo);
         if (This->stream) IStream_Release(This->stream);
-        HeapFree(GetProcessHeap(), 0, This->image_data);
+        row_cache_free(&This->rows);
         HeapFree(GetProcessHeap(), 0, This);
     }
 
@@ -298,14 +301,59 @@ static void source_mgr_term_source(j_decompress_ptr cinfo)
 {
 }
 
+/* Reads the header from the start of the stream and prepares libjpeg to
+ * return scanlines. Must be called with a libjpeg error handler set up. */
+static HRESULT start_decode(JpegDecoder *This)
+{
+    LARGE_INTEGER seek;
+    int ret;
+
+    seek.QuadPart = 0;
+    IStream_Seek(This->stream, seek, STREAM_SEEK_SET, NULL);
+
+    This->source_mgr.bytes_in_buffer = 0;
+
+    ret = pjpeg_read_header(&This->cinfo, TRUE);
+
+    if (ret != JPEG_HEADER_OK) {
+        WARN("Jpeg image in stream has bad format, read header returned %d.\n",ret);
+        return E_FAIL;
+    }
+
+    switch (This->cinfo.jpeg_color_space)
+    {
+    case JCS_GRAYSCALE:
+        This->cinfo.out_color_space = JCS_GRAYSCALE;
+        break;
+    case JCS_RGB:
+    case JCS_YCbCr:
+        This->cinfo.out_color_space = JCS_RGB;
+        break;
+    case JCS_CMYK:
+    case JCS_YCCK:
+        This->cinfo.out_color_space = JCS_CMYK;
+        break;
+    default:
+        ERR("Unknown JPEG color space %i\n", This->cinfo.jpeg_color_space);
+        return E_FAIL;
+    }
+
+    if (!pjpeg_start_decompress(&This->cinfo))
+    {
+        ERR("jpeg_start_decompress failed\n");
+        return E_FAIL;
+    }
+
+    seek.QuadPart = 0;
+    return IStream_Seek(This->stream, seek, STREAM_SEEK_CUR, &This->stream_pos);
+}
+
 static HRESULT WINAPI JpegDecoder_Initialize(IWICBitmapDecoder *iface, IStream *pIStream,
     WICDecodeOptions cacheOptions)
 {
     JpegDecoder *This = impl_from_IWICBitmapDecoder(iface);
-    int ret;
-    LARGE_INTEGER seek;
     jmp_buf jmpbuf;
-    UINT data_size, i;
+    HRESULT hr;
 
     TRACE("(%p,%p,%u)\n", iface, pIStream, cacheOptions);
 
@@ -339,10 +387,6 @@ static HRESULT WINAPI JpegDecoder_Initialize(IWICBitmapDecoder *iface, IStream *
     This->stream = pIStream;
     IStream_AddRef(pIStream);
 
-    seek.QuadPart = 0;
-    IStream_Seek(This->stream, seek, STREAM_SEEK_SET, NULL);
-
-    This->source_mgr.bytes_in_buffer = 0;
     This->source_mgr.init_source = source_mgr_init_source;
     This->source_mgr.fill_input_buffer = source_mgr_fill_input_buffer;
     This->source_mgr.skip_input_data = source_mgr_skip_input_data;
@@ -351,38 +395,11 @@ static HRESULT WINAPI JpegDecoder_Initialize(IWICBitmapDecoder *iface, IStream *
 
     This->cinfo.src = &This->source_mgr;
 
-    ret = pjpeg_read_header(&This->cinfo, TRUE);
-
-    if (ret != JPEG_HEADER_OK) {
-        WARN("Jpeg image in stream has bad format, read header returned %d.\n",ret);
-        LeaveCriticalSection(&This->lock);
-        return E_FAIL;
-    }
-
-    switch (This->cinfo.jpeg_color_space)
-    {
-    case JCS_GRAYSCALE:
-        This->cinfo.out_color_space = JCS_GRAYSCALE;
-        break;
-    case JCS_RGB:
-    case JCS_YCbCr:
-        This->cinfo.out_color_space = JCS_RGB;
-        break;
-    case JCS_CMYK:
-    case JCS_YCCK:
-        This->cinfo.out_color_space = JCS_CMYK;
-        break;
-    default:
-        ERR("Unknown JPEG color space %i\n", This->cinfo.jpeg_color_space);
-        LeaveCriticalSection(&This->lock);
-        return E_FAIL;
-    }
-
-    if (!pjpeg_start_decompress(&This->cinfo))
+    hr = start_decode(This);
+    if (FAILED(hr))
     {
-        ERR("jpeg_start_decompress failed\n");
         LeaveCriticalSection(&This->lock);
-        return E_FAIL;
+        return hr;
     }
 
     if (This->cinfo.out_color_space == JCS_GRAYSCALE) This->bpp = 8;
@@ -390,48 +407,13 @@ static HRESULT WINAPI JpegDecoder_Initialize(IWICBitmapDecoder *iface, IStream *
     else This->bpp = 24;
 
     This->stride = (This->bpp * This->cinfo.output_width + 7) / 8;
-    data_size = This->stride * This->cinfo.output_height;
 
-    This->image_data = heap_alloc(data_size);
-    if (!This->image_data)
+    /* scanlines are decoded on demand in CopyPixels */
+    hr = row_cache_init(&This->rows, This->cinfo.output_width, This->cinfo.output_height, This->bpp);
+    if (FAILED(hr))
     {
         LeaveCriticalSection(&This->lock);
-        return E_OUTOFMEMORY;
-    }
-
-    while (This->cinfo.output_scanline < This->cinfo.output_height)
-    {
-        UINT first_scanline = This->cinfo.output_scanline;
-        UINT max_rows;
-        JSAMPROW out_rows[4];
-        JDIMENSION ret;
-
-        max_rows = min(This->cinfo.output_height-first_scanline, 4);
-        for (i=0; i<max_rows; i++)
-            out_rows[i] = This->image_data + This->stride * (first_scanline+i);
-
-        ret = pjpeg_read_scanlines(&This->cinfo, out_rows, max_rows);
-        if (ret == 0)
-        {
-            ERR("read_scanlines failed\n");
-            LeaveCriticalSection(&This->lock);
-            return E_FAIL;
-        }
-    }
-
-    if (This->bpp == 24)
-    {
-        /* libjpeg gives us RGB data and we want BGR, so byteswap the data */
-        reverse_bgr8(3, This->image_data,
-            This->cinfo.output_width, This->cinfo.output_height,
-            This->stride);
-    }
-
-    if (This->cinfo.out_color_space == JCS_CMYK && This->cinfo.saw_Adobe_marker)
-    {
-        /* Adobe JPEG's have inverted CMYK data. */
-        for (i=0; i<data_size; i++)
-            This->image_data[i] ^= 0xff;
+        return hr;
     }
 
     This->initialized = TRUE;
@@ -639,16 +621,81 @@ static HRESULT WINAPI JpegDecoder_Frame_CopyPalette(IWICBitmapFrameDecode *iface
     return E_NOTIMPL;
 }
 
+static HRESULT jpeg_decoder_read_row(void *decoder, BYTE *row)
+{
+    JpegDecoder *This = decoder;
+    LARGE_INTEGER seek;
+    jmp_buf jmpbuf;
+    UINT i;
+    HRESULT hr;
+
+    seek.QuadPart = This->stream_pos.QuadPart;
+    hr = IStream_Seek(This->stream, seek, STREAM_SEEK_SET, NULL);
+    if (FAILED(hr)) return hr;
+
+    This->cinfo.client_data = jmpbuf;
+
+    if (setjmp(jmpbuf))
+        return E_FAIL;
+
+    if (!pjpeg_read_scanlines(&This->cinfo, &row, 1))
+    {
+        ERR("read_scanlines failed\n");
+        return E_FAIL;
+    }
+
+    if (This->bpp == 24)
+    {
+        /* libjpeg gives us RGB data and we want BGR, so byteswap the data */
+        reverse_bgr8(3, row, This->cinfo.output_width, 1, This->stride);
+    }
+
+    if (This->cinfo.out_color_space == JCS_CMYK && This->cinfo.saw_Adobe_marker)
+    {
+        /* Adobe JPEG's have inverted CMYK data. */
+        for (i=0; i<This->stride; i++)
+            row[i] ^= 0xff;
+    }
+
+    seek.QuadPart = 0;
+    return IStream_Seek(This->stream, seek, STREAM_SEEK_CUR, &This->stream_pos);
+}
+
+static HRESULT jpeg_decoder_restart(void *decoder)
+{
+    JpegDecoder *This = decoder;
+    jmp_buf jmpbuf;
+
+    This->cinfo.client_data = jmpbuf;
+
+    if (setjmp(jmpbuf))
+        return E_FAIL;
+
+    pjpeg_abort_decompress(&This->cinfo);
+
+    return start_decode(This);
+}
+
+static const struct row_cache_decoder jpeg_row_funcs =
+{
+    jpeg_decoder_read_row,
+    jpeg_decoder_restart
+};
+
 static HRESULT WINAPI JpegDecoder_Frame_CopyPixels(IWICBitmapFrameDecode *iface,
     const WICRect *prc, UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
 {
     JpegDecoder *This = impl_from_IWICBitmapFrameDecode(iface);
+    HRESULT hr;
 
     TRACE("(%p,%s,%u,%u,%p)\n", iface, debug_wic_rect(prc), cbStride, cbBufferSize, pbBuffer);
 
-    return copy_pixels(This->bpp, This->image_data,
-        This->cinfo.output_width, This->cinfo.output_height, This->stride,
+    EnterCriticalSection(&This->lock);
+    hr = row_cache_copy_pixels(&This->rows, &jpeg_row_funcs, This,
         prc, cbStride, cbBufferSize, pbBuffer);
+    LeaveCriticalSection(&This->lock);
+
+    return hr;
 }
 
 static HRESULT WINAPI JpegDecoder_Frame_GetMetadataQueryReader(IWICBitmapFrameDecode *iface,
@@ -784,7 +831,7 @@ HRESULT JpegDecoder_CreateInstance(REFIID iid, void** ppv)
     This->initialized = FALSE;
     This->cinfo_initialized = FALSE;
     This->stream = NULL;
-    This->image_data = NULL;
+    This->rows.bits = NULL;
     InitializeCriticalSection(&This->lock);
     This->lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": JpegDecoder.lock");
 
@@ -120,6 +120,104 @@ HRESULT copy_pixels(UINT bpp, const BYTE *srcbuffer,
     }
 }
 
+/* Decoded rows kept by streaming decoders; images that fit are cached whole. */
+#define ROW_CACHE_MAX_SIZE 0x400000
+
+HRESULT row_cache_init(struct row_cache *cache, UINT width, UINT height, UINT bpp)
+{
+    cache->width = width;
+    cache->height = height;
+    cache->bpp = bpp;
+    cache->stride = (width * bpp + 7) / 8;
+    cache->capacity = cache->stride ? max(ROW_CACHE_MAX_SIZE / cache->stride, 1) : 1;
+    cache->capacity = min(cache->capacity, height);
+    cache->first = cache->next = 0;
+
+    cache->bits = HeapAlloc(GetProcessHeap(), 0, cache->stride * max(cache->capacity, 1));
+    return cache->bits ? S_OK : E_OUTOFMEMORY;
+}
+
+void row_cache_free(struct row_cache *cache)
+{
+    HeapFree(GetProcessHeap(), 0, cache->bits);
+    cache->bits = NULL;
+}
+
+/* Copy pixels out of the cache, decoding only as far as the last requested
+ * row. Rows that have already left the cache are decoded again from the
+ * start of the image. */
+HRESULT row_cache_copy_pixels(struct row_cache *cache, const struct row_cache_decoder *funcs,
+    void *decoder, const WICRect *rc, UINT dststride, UINT dstbuffersize, BYTE *dstbuffer)
+{
+    UINT bytesperrow;
+    WICRect rect, row_rect;
+    HRESULT hr = S_OK;
+    INT y;
+
+    if (!rc)
+    {
+        rect.X = 0;
+        rect.Y = 0;
+        rect.Width = cache->width;
+        rect.Height = cache->height;
+        rc = &rect;
+    }
+    else
+    {
+        if (rc->X < 0 || rc->Y < 0 || rc->X+rc->Width > cache->width || rc->Y+rc->Height > cache->height)
+            return E_INVALIDARG;
+    }
+
+    bytesperrow = ((cache->bpp * rc->Width)+7)/8;
+
+    if (dststride < bytesperrow)
+        return E_INVALIDARG;
+
+    if ((dststride * (rc->Height-1)) + bytesperrow > dstbuffersize)
+        return E_INVALIDARG;
+
+    if (!rc->Height)
+        return S_OK;
+
+    if (rc->Y < cache->first)
+    {
+        TRACE("row %d is no longer cached, restarting\n", rc->Y);
+        hr = funcs->restart(decoder);
+        if (FAILED(hr)) return hr;
+        cache->first = cache->next = 0;
+    }
+
+    row_rect.X = rc->X;
+    row_rect.Y = 0;
+    row_rect.Width = rc->Width;
+    row_rect.Height = 1;
+
+    for (y = rc->Y; y < rc->Y + rc->Height; y++)
+    {
+        while (y >= cache->next)
+        {
+            if (cache->next - cache->first == cache->capacity)
+                cache->first++;
+
+            hr = funcs->read_row(decoder, cache->bits + (cache->next % cache->capacity) * cache->stride);
+            if (FAILED(hr))
+            {
+                /* the decoder state is unknown, start again next time */
+                cache->first = cache->next = cache->height;
+                return hr;
+            }
+            cache->next++;
+        }
+
+        hr = copy_pixels(cache->bpp, cache->bits + (y % cache->capacity) * cache->stride,
+            cache->width, 1, cache->stride, &row_rect, dststride,
+            dstbuffersize - dststride * (y - rc->Y), dstbuffer + dststride * (y - rc->Y));
+        if (FAILED(hr)) return hr;
+    }
+
+    return S_OK;
+}
+
 HRESULT configure_write_source(IWICBitmapFrameEncode *iface,
     IWICBitmapSource *source, const WICRect *prc,
     const WICPixelFormatGUID *format,
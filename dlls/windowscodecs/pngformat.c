@@ -313,6 +313,7 @@ MAKE_FUNCPTR(png_get_error_ptr);
 MAKE_FUNCPTR(png_get_iCCP);
 MAKE_FUNCPTR(png_get_image_height);
 MAKE_FUNCPTR(png_get_image_width);
+MAKE_FUNCPTR(png_get_interlace_type);
 MAKE_FUNCPTR(png_get_io_ptr);
 MAKE_FUNCPTR(png_get_pHYs);
 MAKE_FUNCPTR(png_get_PLTE);
@@ -336,6 +337,8 @@ MAKE_FUNCPTR(png_set_swap);
 MAKE_FUNCPTR(png_read_end);
 MAKE_FUNCPTR(png_read_image);
 MAKE_FUNCPTR(png_read_info);
+MAKE_FUNCPTR(png_read_row);
+MAKE_FUNCPTR(png_start_read_image);
 MAKE_FUNCPTR(png_write_end);
 MAKE_FUNCPTR(png_write_info);
 MAKE_FUNCPTR(png_write_rows);
@@ -380,6 +383,7 @@ static void *load_libpng(void)
         LOAD_FUNCPTR(png_get_iCCP);
         LOAD_FUNCPTR(png_get_image_height);
         LOAD_FUNCPTR(png_get_image_width);
+        LOAD_FUNCPTR(png_get_interlace_type);
         LOAD_FUNCPTR(png_get_io_ptr);
         LOAD_FUNCPTR(png_get_pHYs);
         LOAD_FUNCPTR(png_get_PLTE);
@@ -403,6 +407,8 @@ static void *load_libpng(void)
         LOAD_FUNCPTR(png_read_end);
         LOAD_FUNCPTR(png_read_image);
         LOAD_FUNCPTR(png_read_info);
+        LOAD_FUNCPTR(png_read_row);
+        LOAD_FUNCPTR(png_start_read_image);
         LOAD_FUNCPTR(png_write_end);
         LOAD_FUNCPTR(png_write_info);
         LOAD_FUNCPTR(png_write_rows);
@@ -453,7 +459,9 @@ typedef struct {
     int width, height;
     UINT stride;
     const WICPixelFormatGUID *format;
-    BYTE *image_bits;
+    BYTE *image_bits; /* only used for interlaced images */
+    struct row_cache rows;
+    ULARGE_INTEGER stream_pos; /* where libpng continues reading image data */
     CRITICAL_SECTION lock; /* must be held when png structures are accessed or initialized is set */
     ULONG metadata_count;
     metadata_block_info* metadata_blocks;
@@ -525,6 +533,7 @@ static ULONG WINAPI PngDecoder_Release(IWICBitmapDecoder *iface)
         This->lock.DebugInfo->Spare[0] = 0;
         DeleteCriticalSection(&This->lock);
         HeapFree(GetProcessHeap(), 0, This->image_bits);
+        row_cache_free(&This->rows);
         for (i=0; i<This->metadata_count; i++)
         {
             if (This->metadata_blocks[i].reader)
@@ -568,96 +577,72 @@ static void user_read_data(png_structp png_ptr, png_bytep data, png_size_t lengt
     }
 }
 
-static HRESULT WINAPI PngDecoder_Initialize(IWICBitmapDecoder *iface, IStream *pIStream,
-    WICDecodeOptions cacheOptions)
+static HRESULT create_png_reader(png_structp *png_ptr, png_infop *info_ptr, png_infop *end_info)
 {
-    PngDecoder *This = impl_from_IWICBitmapDecoder(iface);
-    LARGE_INTEGER seek;
-    HRESULT hr=S_OK;
-    png_bytep *row_pointers=NULL;
-    UINT image_size;
-    UINT i;
-    int color_type, bit_depth;
-    png_bytep trans;
-    int num_trans;
-    png_uint_32 transparency;
-    png_color_16p trans_values;
-    jmp_buf jmpbuf;
-    BYTE chunk_type[4];
-    ULONG chunk_size;
-    ULARGE_INTEGER chunk_start;
-    ULONG metadata_blocks_size = 0;
-
-    TRACE("(%p,%p,%x)\n", iface, pIStream, cacheOptions);
-
-    EnterCriticalSection(&This->lock);
+    *png_ptr = ppng_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    if (!*png_ptr)
+        return E_FAIL;
 
-    /* initialize libpng */
-    This->png_ptr = ppng_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-    if (!This->png_ptr)
+    *info_ptr = ppng_create_info_struct(*png_ptr);
+    if (!*info_ptr)
     {
-        hr = E_FAIL;
-        goto end;
+        ppng_destroy_read_struct(png_ptr, NULL, NULL);
+        *png_ptr = NULL;
+        return E_FAIL;
     }
 
-    This->info_ptr = ppng_create_info_struct(This->png_ptr);
-    if (!This->info_ptr)
+    *end_info = ppng_create_info_struct(*png_ptr);
+    if (!*end_info)
     {
-        ppng_destroy_read_struct(&This->png_ptr, NULL, NULL);
-        This->png_ptr = NULL;
-        hr = E_FAIL;
-        goto end;
+        ppng_destroy_read_struct(png_ptr, info_ptr, NULL);
+        *png_ptr = NULL;
+        return E_FAIL;
     }
 
-    This->end_info = ppng_create_info_struct(This->png_ptr);
-    if (!This->end_info)
-    {
-        ppng_destroy_read_struct(&This->png_ptr, &This->info_ptr, NULL);
-        This->png_ptr = NULL;
-        hr = E_FAIL;
-        goto end;
-    }
+    return S_OK;
+}
 
-    /* set up setjmp/longjmp error handling */
-    if (setjmp(jmpbuf))
-    {
-        ppng_destroy_read_struct(&This->png_ptr, &This->info_ptr, &This->end_info);
-        This->png_ptr = NULL;
-        hr = WINCODEC_ERR_UNKNOWNIMAGEFORMAT;
-        goto end;
-    }
-    ppng_set_error_fn(This->png_ptr, jmpbuf, user_error_fn, user_warning_fn);
-    ppng_set_crc_action(This->png_ptr, PNG_CRC_QUIET_USE, PNG_CRC_QUIET_USE);
+/* Reads the PNG header and sets up the transformations to the frame's pixel
+ * format. Must be called with a libpng error handler set up. */
+static HRESULT read_png_header(PngDecoder *This, png_structp png_ptr, png_infop info_ptr, IStream *stream)
+{
+    LARGE_INTEGER seek;
+    HRESULT hr;
+    int color_type, bit_depth;
+    png_bytep trans;
+    int num_trans;
+    png_uint_32 transparency;
+    png_color_16p trans_values;
 
     /* seek to the start of the stream */
     seek.QuadPart = 0;
-    hr = IStream_Seek(pIStream, seek, STREAM_SEEK_SET, NULL);
-    if (FAILED(hr)) goto end;
+    hr = IStream_Seek(stream, seek, STREAM_SEEK_SET, NULL);
+    if (FAILED(hr)) return hr;
 
     /* set up custom i/o handling */
-    ppng_set_read_fn(This->png_ptr, pIStream, user_read_data);
+    ppng_set_read_fn(png_ptr, stream, user_read_data);
 
     /* read the header */
-    ppng_read_info(This->png_ptr, This->info_ptr);
+    ppng_read_info(png_ptr, info_ptr);
 
     /* choose a pixel format */
-    color_type = ppng_get_color_type(This->png_ptr, This->info_ptr);
-    bit_depth = ppng_get_bit_depth(This->png_ptr, This->info_ptr);
+    color_type = ppng_get_color_type(png_ptr, info_ptr);
+    bit_depth = ppng_get_bit_depth(png_ptr, info_ptr);
 
     /* PNGs with bit-depth greater than 8 are network byte order. Windows does not expect this. */
     if (bit_depth > 8)
-        ppng_set_swap(This->png_ptr);
+        ppng_set_swap(png_ptr);
 
     /* check for color-keyed alpha */
-    transparency = ppng_get_tRNS(This->png_ptr, This->info_ptr, &trans, &num_trans, &trans_values);
+    transparency = ppng_get_tRNS(png_ptr, info_ptr, &trans, &num_trans, &trans_values);
 
     if (transparency && (color_type == PNG_COLOR_TYPE_RGB ||
         (color_type == PNG_COLOR_TYPE_GRAY && bit_depth == 16)))
     {
         /* expand to RGBA */
         if (color_type == PNG_COLOR_TYPE_GRAY)
-            ppng_set_gray_to_rgb(This->png_ptr);
-        ppng_set_tRNS_to_alpha(This->png_ptr);
+            ppng_set_gray_to_rgb(png_ptr);
+        ppng_set_tRNS_to_alpha(png_ptr);
         color_type = PNG_COLOR_TYPE_RGB_ALPHA;
     }
 
@@ -665,21 +650,20 @@ static HRESULT WINAPI PngDecoder_Initialize(IWICBitmapDecoder *iface, IStream *p
     {
     case PNG_COLOR_TYPE_GRAY_ALPHA:
         /* WIC does not support grayscale alpha formats so use RGBA */
-        ppng_set_gray_to_rgb(This->png_ptr);
+        ppng_set_gray_to_rgb(png_ptr);
         /* fall through */
     case PNG_COLOR_TYPE_RGB_ALPHA:
         This->bpp = bit_depth * 4;
         switch (bit_depth)
         {
         case 8:
-            ppng_set_bgr(This->png_ptr);
+            ppng_set_bgr(png_ptr);
             This->format = &GUID_WICPixelFormat32bppBGRA;
             break;
         case 16: This->format = &GUID_WICPixelFormat64bppRGBA; break;
         default:
             ERR("invalid RGBA bit depth: %i\n", bit_depth);
-            hr = E_FAIL;
-            goto end;
+            return E_FAIL;
         }
         break;
     case PNG_COLOR_TYPE_GRAY:
@@ -695,8 +679,7 @@ static HRESULT WINAPI PngDecoder_Initialize(IWICBitmapDecoder *iface, IStream *p
             case 16: This->format = &GUID_WICPixelFormat16bppGray; break;
             default:
                 ERR("invalid grayscale bit depth: %i\n", bit_depth);
-                hr = E_FAIL;
-                goto end;
+                return E_FAIL;
             }
             break;
         }
@@ -711,8 +694,7 @@ static HRESULT WINAPI PngDecoder_Initialize(IWICBitmapDecoder *iface, IStream *p
         case 8: This->format = &GUID_WICPixelFormat8bppIndexed; break;
         default:
             ERR("invalid indexed color bit depth: %i\n", bit_depth);
-            hr = E_FAIL;
-            goto end;
+            return E_FAIL;
         }
         break;
     case PNG_COLOR_TYPE_RGB:
@@ -720,51 +702,105 @@ static HRESULT WINAPI PngDecoder_Initialize(IWICBitmapDecoder *iface, IStream *p
         switch (bit_depth)
         {
         case 8:
-            ppng_set_bgr(This->png_ptr);
+            ppng_set_bgr(png_ptr);
             This->format = &GUID_WICPixelFormat24bppBGR;
             break;
         case 16: This->format = &GUID_WICPixelFormat48bppRGB; break;
         default:
             ERR("invalid RGB color bit depth: %i\n", bit_depth);
-            hr = E_FAIL;
-            goto end;
+            return E_FAIL;
         }
         break;
     default:
         ERR("invalid color type %i\n", color_type);
-        hr = E_FAIL;
+        return E_FAIL;
+    }
+
+    return S_OK;
+}
+
+static HRESULT WINAPI PngDecoder_Initialize(IWICBitmapDecoder *iface, IStream *pIStream,
+    WICDecodeOptions cacheOptions)
+{
+    PngDecoder *This = impl_from_IWICBitmapDecoder(iface);
+    LARGE_INTEGER seek;
+    HRESULT hr=S_OK;
+    png_bytep *row_pointers=NULL;
+    UINT image_size;
+    UINT i;
+    jmp_buf jmpbuf;
+    BYTE chunk_type[4];
+    ULONG chunk_size;
+    ULARGE_INTEGER chunk_start;
+    ULONG metadata_blocks_size = 0;
+
+    TRACE("(%p,%p,%x)\n", iface, pIStream, cacheOptions);
+
+    EnterCriticalSection(&This->lock);
+
+    /* initialize libpng */
+    hr = create_png_reader(&This->png_ptr, &This->info_ptr, &This->end_info);
+    if (FAILED(hr)) goto end;
+
+    /* set up setjmp/longjmp error handling */
+    if (setjmp(jmpbuf))
+    {
+        ppng_destroy_read_struct(&This->png_ptr, &This->info_ptr, &This->end_info);
+        This->png_ptr = NULL;
+        hr = WINCODEC_ERR_UNKNOWNIMAGEFORMAT;
         goto end;
     }
+    ppng_set_error_fn(This->png_ptr, jmpbuf, user_error_fn, user_warning_fn);
+    ppng_set_crc_action(This->png_ptr, PNG_CRC_QUIET_USE, PNG_CRC_QUIET_USE);
+
+    hr = read_png_header(This, This->png_ptr, This->info_ptr, pIStream);
+    if (FAILED(hr)) goto end;
 
-    /* read the image data */
     This->width = ppng_get_image_width(This->png_ptr, This->info_ptr);
     This->height = ppng_get_image_height(This->png_ptr, This->info_ptr);
     This->stride = (This->width * This->bpp + 7) / 8;
-    image_size = This->stride * This->height;
 
-    This->image_bits = HeapAlloc(GetProcessHeap(), 0, image_size);
-    if (!This->image_bits)
+    if (ppng_get_interlace_type(This->png_ptr, This->info_ptr) == PNG_INTERLACE_NONE)
     {
-        hr = E_OUTOFMEMORY;
-        goto end;
-    }
+        /* decode rows on demand in CopyPixels */
+        ppng_start_read_image(This->png_ptr);
 
-    row_pointers = HeapAlloc(GetProcessHeap(), 0, sizeof(png_bytep)*This->height);
-    if (!row_pointers)
-    {
-        hr = E_OUTOFMEMORY;
-        goto end;
+        hr = row_cache_init(&This->rows, This->width, This->height, This->bpp);
+        if (FAILED(hr)) goto end;
+
+        seek.QuadPart = 0;
+        hr = IStream_Seek(pIStream, seek, STREAM_SEEK_CUR, &This->stream_pos);
+        if (FAILED(hr)) goto end;
     }
+    else
+    {
+        /* interlaced images can't be decoded row by row, read the image data */
+        image_size = This->stride * This->height;
 
-    for (i=0; i<This->height; i++)
-        row_pointers[i] = This->image_bits + i * This->stride;
+        This->image_bits = HeapAlloc(GetProcessHeap(), 0, image_size);
+        if (!This->image_bits)
+        {
+            hr = E_OUTOFMEMORY;
+            goto end;
+        }
 
-    ppng_read_image(This->png_ptr, row_pointers);
+        row_pointers = HeapAlloc(GetProcessHeap(), 0, sizeof(png_bytep)*This->height);
+        if (!row_pointers)
+        {
+            hr = E_OUTOFMEMORY;
+            goto end;
+        }
 
-    HeapFree(GetProcessHeap(), 0, row_pointers);
-    row_pointers = NULL;
+        for (i=0; i<This->height; i++)
+            row_pointers[i] = This->image_bits + i * This->stride;
+
+        ppng_read_image(This->png_ptr, row_pointers);
+
+        HeapFree(GetProcessHeap(), 0, row_pointers);
+        row_pointers = NULL;
 
-    ppng_read_end(This->png_ptr, This->end_info);
+        ppng_read_end(This->png_ptr, This->end_info);
+    }
 
     /* Find the metadata chunks in the file. */
     seek.QuadPart = 8;
@@ -1101,15 +1137,97 @@ end:
     return hr;
 }
 
+static HRESULT png_decoder_read_row(void *decoder, BYTE *row)
+{
+    PngDecoder *This = decoder;
+    LARGE_INTEGER seek;
+    jmp_buf jmpbuf;
+    HRESULT hr;
+
+    /* metadata readers share the stream, so continue where libpng stopped */
+    seek.QuadPart = This->stream_pos.QuadPart;
+    hr = IStream_Seek(This->stream, seek, STREAM_SEEK_SET, NULL);
+    if (FAILED(hr)) return hr;
+
+    if (setjmp(jmpbuf))
+        return E_FAIL;
+    ppng_set_error_fn(This->png_ptr, jmpbuf, user_error_fn, user_warning_fn);
+
+    ppng_read_row(This->png_ptr, row, NULL);
+
+    seek.QuadPart = 0;
+    return IStream_Seek(This->stream, seek, STREAM_SEEK_CUR, &This->stream_pos);
+}
+
+static HRESULT png_decoder_restart(void *decoder)
+{
+    PngDecoder *This = decoder;
+    png_structp png_ptr;
+    png_infop info_ptr, end_info;
+    LARGE_INTEGER seek;
+    jmp_buf jmpbuf;
+    HRESULT hr;
+
+    hr = create_png_reader(&png_ptr, &info_ptr, &end_info);
+    if (FAILED(hr)) return hr;
+
+    if (setjmp(jmpbuf))
+    {
+        ppng_destroy_read_struct(&png_ptr, &info_ptr, &end_info);
+        return E_FAIL;
+    }
+    ppng_set_error_fn(png_ptr, jmpbuf, user_error_fn, user_warning_fn);
+    ppng_set_crc_action(png_ptr, PNG_CRC_QUIET_USE, PNG_CRC_QUIET_USE);
+
+    hr = read_png_header(This, png_ptr, info_ptr, This->stream);
+    if (SUCCEEDED(hr))
+    {
+        ppng_start_read_image(png_ptr);
+
+        seek.QuadPart = 0;
+        hr = IStream_Seek(This->stream, seek, STREAM_SEEK_CUR, &This->stream_pos);
+    }
+
+    if (FAILED(hr))
+    {
+        ppng_destroy_read_struct(&png_ptr, &info_ptr, &end_info);
+        return hr;
+    }
+
+    /* keep the old structures around until the new ones are usable */
+    ppng_destroy_read_struct(&This->png_ptr, &This->info_ptr, &This->end_info);
+    This->png_ptr = png_ptr;
+    This->info_ptr = info_ptr;
+    This->end_info = end_info;
+
+    return S_OK;
+}
+
+static const struct row_cache_decoder png_row_funcs =
+{
+    png_decoder_read_row,
+    png_decoder_restart
+};
+
 static HRESULT WINAPI PngDecoder_Frame_CopyPixels(IWICBitmapFrameDecode *iface,
     const WICRect *prc, UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
 {
     PngDecoder *This = impl_from_IWICBitmapFrameDecode(iface);
+    HRESULT hr;
+
     TRACE("(%p,%s,%u,%u,%p)\n", iface, debug_wic_rect(prc), cbStride, cbBufferSize, pbBuffer);
 
-    return copy_pixels(This->bpp, This->image_bits,
-        This->width, This->height, This->stride,
+    if (This->image_bits)
+        return copy_pixels(This->bpp, This->image_bits,
+            This->width, This->height, This->stride,
+            prc, cbStride, cbBufferSize, pbBuffer);
+
+    EnterCriticalSection(&This->lock);
+    hr = row_cache_copy_pixels(&This->rows, &png_row_funcs, This,
         prc, cbStride, cbBufferSize, pbBuffer);
+    LeaveCriticalSection(&This->lock);
+
+    return hr;
 }
 
 static HRESULT WINAPI PngDecoder_Frame_GetMetadataQueryReader(IWICBitmapFrameDecode *iface,
@@ -1323,6 +1441,7 @@ HRESULT PngDecoder_CreateInstance(REFIID iid, void** ppv)
     This->stream = NULL;
     This->initialized = FALSE;
     This->image_bits = NULL;
+    This->rows.bits = NULL;
     InitializeCriticalSection(&This->lock);
     This->lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": PngDecoder.lock");
     This->metadata_count = 0;
@@ -20,6 +20,10 @@
 #include "config.h"
 
 #include <stdarg.h>
+#include <math.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #define COBJMACROS
 
@@ -33,6 +37,31 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(wincodecs);
 
+#define MAX_FILTER_TAPS 64
+
+/* Separable resampling filter for one axis. Every destination pixel takes
+ * taps consecutive source pixels from start with 14-bit fixed point weights
+ * that add up to 1 << 14. */
+struct scaler_filter
+{
+    UINT taps;
+    INT *start;
+    SHORT *weights;
+};
+
+/* Horizontally filtered source rows, kept between CopyPixels calls so that
+ * reading the destination one scanline at a time fetches every source row
+ * only once. */
+struct scaler_row_cache
+{
+    INT x, width;       /* destination columns the rows were filtered for */
+    UINT count;         /* number of slots, equal to the vertical taps */
+    INT *row_index;     /* source row held by each slot, or -1 */
+    SHORT *rows;        /* count rows of width * channels values, 6-bit fixed point */
+    BYTE *src_row;      /* raw source scanline */
+    UINT src_row_size;
+};
+
 typedef struct BitmapScaler {
     IWICBitmapScaler IWICBitmapScaler_iface;
     LONG ref;
@@ -44,6 +73,9 @@ typedef struct BitmapScaler {
     UINT bpp;
     void (*fn_get_required_source_rect)(struct BitmapScaler*,UINT,UINT,WICRect*);
     void (*fn_copy_scanline)(struct BitmapScaler*,UINT,UINT,UINT,BYTE**,UINT,UINT,BYTE*);
+    UINT channels; /* 8-bit channels per pixel, 0 if the format is not filtered */
+    struct scaler_filter filter_x, filter_y;
+    struct scaler_row_cache cache;
     CRITICAL_SECTION lock; /* must be held when initialized */
 } BitmapScaler;
 
@@ -96,6 +128,21 @@ static ULONG WINAPI BitmapScaler_AddRef(IWICBitmapScaler *iface)
     return ref;
 }
 
+static void free_scaler_filter(struct scaler_filter *filter)
+{
+    HeapFree(GetProcessHeap(), 0, filter->start);
+    HeapFree(GetProcessHeap(), 0, filter->weights);
+    memset(filter, 0, sizeof(*filter));
+}
+
+static void free_scaler_row_cache(struct scaler_row_cache *cache)
+{
+    HeapFree(GetProcessHeap(), 0, cache->row_index);
+    HeapFree(GetProcessHeap(), 0, cache->rows);
+    HeapFree(GetProcessHeap(), 0, cache->src_row);
+    memset(cache, 0, sizeof(*cache));
+}
+
 static ULONG WINAPI BitmapScaler_Release(IWICBitmapScaler *iface)
 {
     BitmapScaler *This = impl_from_IWICBitmapScaler(iface);
@@ -108,6 +155,9 @@ static ULONG WINAPI BitmapScaler_Release(IWICBitmapScaler *iface)
         This->lock.DebugInfo->Spare[0] = 0;
         DeleteCriticalSection(&This->lock);
         if (This->source) IWICBitmapSource_Release(This->source);
+        free_scaler_filter(&This->filter_x);
+        free_scaler_filter(&This->filter_y);
+        free_scaler_row_cache(&This->cache);
         HeapFree(GetProcessHeap(), 0, This);
     }
 
@@ -205,6 +255,268 @@ static void NearestNeighbor_CopyScanline(BitmapScaler *This,
     }
 }
 
+/* Catmull-Rom spline */
+static double cubic_weight(double x)
+{
+    x = fabs(x);
+    if (x < 1.0) return (1.5 * x - 2.5) * x * x + 1.0;
+    if (x < 2.0) return ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0;
+    return 0.0;
+}
+
+static double linear_weight(double x)
+{
+    x = fabs(x);
+    return x < 1.0 ? 1.0 - x : 0.0;
+}
+
+static HRESULT init_scaler_filter(struct scaler_filter *filter, WICBitmapInterpolationMode mode,
+    UINT src_size, UINT dst_size)
+{
+    double scale = (double)src_size / dst_size, support, filter_scale, weights[MAX_FILTER_TAPS];
+    BOOL box = FALSE;
+    UINT i, j;
+
+    switch (mode)
+    {
+    case WICBitmapInterpolationModeFant:
+        /* area averaging when shrinking, linear when enlarging */
+        box = scale > 1.0;
+        support = box ? 0.5 : 1.0;
+        filter_scale = box ? scale : 1.0;
+        break;
+    case WICBitmapInterpolationModeCubic:
+        support = 2.0;
+        filter_scale = 1.0;
+        break;
+    case WICBitmapInterpolationModeHighQualityCubic:
+        support = 2.0;
+        filter_scale = max(scale, 1.0);
+        break;
+    case WICBitmapInterpolationModeLinear:
+    default:
+        support = 1.0;
+        filter_scale = 1.0;
+        break;
+    }
+
+    filter->taps = (UINT)ceil(2.0 * support * filter_scale) + 1;
+    if (filter->taps > ARRAY_SIZE(weights))
+    {
+        /* very large reductions keep the area average of a limited footprint */
+        filter->taps = ARRAY_SIZE(weights);
+        filter_scale = (filter->taps - 1) / (2.0 * support);
+    }
+    if (filter->taps > src_size) filter->taps = src_size;
+
+    filter->start = HeapAlloc(GetProcessHeap(), 0, dst_size * sizeof(*filter->start));
+    filter->weights = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, dst_size * filter->taps * sizeof(*filter->weights));
+    if (!filter->start || !filter->weights)
+    {
+        free_scaler_filter(filter);
+        return E_OUTOFMEMORY;
+    }
+
+    for (i = 0; i < dst_size; i++)
+    {
+        double center = (i + 0.5) * scale - 0.5, sum = 0.0;
+        SHORT *fixed = filter->weights + i * filter->taps;
+        INT first, last, start, total = 0, largest = 0;
+
+        first = (INT)ceil(center - support * filter_scale);
+        last = (INT)floor(center + support * filter_scale);
+        if (box)
+        {
+            first = (INT)floor(i * scale);
+            last = (INT)ceil((i + 1) * scale) - 1;
+        }
+        if (last - first + 1 > ARRAY_SIZE(weights))
+            last = first + ARRAY_SIZE(weights) - 1;
+
+        start = min(max(first, 0), (INT)(src_size - filter->taps));
+        filter->start[i] = start;
+
+        for (j = 0; j < last - first + 1; j++)
+        {
+            INT pos = first + j;
+
+            if (box)
+                weights[j] = min(pos + 1.0, (i + 1) * scale) - max((double)pos, i * scale);
+            else if (support == 2.0)
+                weights[j] = cubic_weight((pos - center) / filter_scale);
+            else
+                weights[j] = linear_weight((pos - center) / filter_scale);
+            sum += weights[j];
+        }
+
+        /* fold taps outside the image onto the edge pixels */
+        for (j = 0; j < last - first + 1; j++)
+        {
+            INT pos = min(max(first + (INT)j, 0), (INT)src_size - 1) - start;
+            INT value = (INT)floor(weights[j] / sum * (1 << 14) + 0.5);
+
+            fixed[pos] += value;
+            total += value;
+        }
+
+        for (j = 1; j < filter->taps; j++)
+            if (fixed[j] > fixed[largest]) largest = j;
+        fixed[largest] += (1 << 14) - total;
+    }
+
+    return S_OK;
+}
+
+static void filter_row(const struct scaler_filter *filter, UINT channels, const BYTE *src,
+    INT src_x, INT dst_x, INT width, SHORT *dst)
+{
+    INT i, k, c;
+
+    for (i = 0; i < width; i++)
+    {
+        const SHORT *weights = filter->weights + (dst_x + i) * filter->taps;
+        const BYTE *pixel = src + (filter->start[dst_x + i] - src_x) * channels;
+
+        for (c = 0; c < channels; c++)
+        {
+            INT sum = 0;
+
+            for (k = 0; k < filter->taps; k++)
+                sum += weights[k] * pixel[k * channels + c];
+
+            *dst++ = (sum + (1 << 7)) >> 8;
+        }
+    }
+}
+
+static inline BYTE clamp_filtered(INT sum)
+{
+    sum = (sum + (1 << 19)) >> 20;
+    return sum < 0 ? 0 : sum > 255 ? 255 : sum;
+}
+
+/* Vertical pass: weighted sum of the horizontally filtered rows. */
+static void filter_column(const SHORT **rows, const SHORT *weights, UINT taps, UINT count, BYTE *dst)
+{
+    UINT i = 0, k;
+
+#ifdef __SSE2__
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i sum_lo = _mm_setzero_si128(), sum_hi = _mm_setzero_si128();
+
+        for (k = 0; k < taps; k += 2)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i *)(rows[k] + i)), b, w;
+
+            if (k + 1 < taps)
+            {
+                b = _mm_loadu_si128((const __m128i *)(rows[k + 1] + i));
+                w = _mm_set1_epi32(((UINT)(USHORT)weights[k + 1] << 16) | (USHORT)weights[k]);
+            }
+            else
+            {
+                b = _mm_setzero_si128();
+                w = _mm_set1_epi32((USHORT)weights[k]);
+            }
+
+            sum_lo = _mm_add_epi32(sum_lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), w));
+            sum_hi = _mm_add_epi32(sum_hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), w));
+        }
+
+        sum_lo = _mm_srai_epi32(_mm_add_epi32(sum_lo, _mm_set1_epi32(1 << 19)), 20);
+        sum_hi = _mm_srai_epi32(_mm_add_epi32(sum_hi, _mm_set1_epi32(1 << 19)), 20);
+        sum_lo = _mm_packs_epi32(sum_lo, sum_hi);
+        _mm_storel_epi64((__m128i *)(dst + i), _mm_packus_epi16(sum_lo, sum_lo));
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        INT sum = 0;
+
+        for (k = 0; k < taps; k++)
+            sum += weights[k] * rows[k][i];
+
+        dst[i] = clamp_filtered(sum);
+    }
+}
+
+static HRESULT Filter_CopyPixels(BitmapScaler *This, const WICRect *dest_rect,
+    UINT cbStride, BYTE *pbBuffer)
+{
+    struct scaler_row_cache *cache = &This->cache;
+    const struct scaler_filter *filter_y = &This->filter_y;
+    UINT row_size = dest_rect->Width * This->channels;
+    const SHORT *rows[MAX_FILTER_TAPS];
+    WICRect src_rect;
+    HRESULT hr = S_OK;
+    INT y;
+
+    src_rect.X = This->filter_x.start[dest_rect->X];
+    src_rect.Width = This->filter_x.start[dest_rect->X + dest_rect->Width - 1] +
+        This->filter_x.taps - src_rect.X;
+    src_rect.Height = 1;
+
+    if (cache->x != dest_rect->X || cache->width != dest_rect->Width || !cache->rows)
+    {
+        UINT src_row_size = (src_rect.Width * This->bpp + 7) / 8;
+
+        free_scaler_row_cache(cache);
+
+        cache->count = filter_y->taps;
+        cache->row_index = HeapAlloc(GetProcessHeap(), 0, cache->count * sizeof(*cache->row_index));
+        cache->rows = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, cache->count * row_size * sizeof(*cache->rows));
+        cache->src_row = HeapAlloc(GetProcessHeap(), 0, src_row_size);
+        if (!cache->row_index || !cache->rows || !cache->src_row)
+        {
+            free_scaler_row_cache(cache);
+            return E_OUTOFMEMORY;
+        }
+
+        memset(cache->row_index, 0xff, cache->count * sizeof(*cache->row_index));
+        cache->x = dest_rect->X;
+        cache->width = dest_rect->Width;
+        cache->src_row_size = src_row_size;
+    }
+
+    for (y = dest_rect->Y; y < dest_rect->Y + dest_rect->Height; y++)
+    {
+        const SHORT *weights = filter_y->weights + y * filter_y->taps;
+        UINT k;
+
+        for (k = 0; k < filter_y->taps; k++)
+        {
+            INT src_y = filter_y->start[y] + k;
+            UINT slot = src_y % cache->count;
+            SHORT *row = cache->rows + slot * row_size;
+
+            rows[k] = row;
+
+            /* only fetch rows that contribute */
+            if (!weights[k] || cache->row_index[slot] == src_y) continue;
+
+            src_rect.Y = src_y;
+            hr = IWICBitmapSource_CopyPixels(This->source, &src_rect, cache->src_row_size,
+                cache->src_row_size, cache->src_row);
+            if (FAILED(hr))
+            {
+                cache->row_index[slot] = -1;
+                return hr;
+            }
+
+            filter_row(&This->filter_x, This->channels, cache->src_row, src_rect.X,
+                dest_rect->X, dest_rect->Width, row);
+            cache->row_index[slot] = src_y;
+        }
+
+        filter_column(rows, weights, filter_y->taps, row_size,
+            pbBuffer + cbStride * (y - dest_rect->Y));
+    }
+
+    return hr;
+}
+
 static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
     const WICRect *prc, UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
 {
@@ -259,6 +571,15 @@ static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
         goto end;
     }
 
+    if (This->channels)
+    {
+        if (dest_rect.Width && dest_rect.Height)
+            hr = Filter_CopyPixels(This, &dest_rect, cbStride, pbBuffer);
+        else
+            hr = S_OK;
+        goto end;
+    }
+
     /* MSDN recommends calling CopyPixels once for each scanline from top to
      * bottom, and claims codecs optimize for this. Ideally, when called in this
      * way, we should avoid requesting a scanline from the source more than
@@ -314,6 +635,34 @@ end:
     return hr;
 }
 
+/* Formats made of 8-bit channels can be filtered one channel at a time. */
+static UINT get_filter_channels(const WICPixelFormatGUID *format)
+{
+    static const struct
+    {
+        const WICPixelFormatGUID *format;
+        UINT channels;
+    } formats[] =
+    {
+        { &GUID_WICPixelFormat8bppGray, 1 },
+        { &GUID_WICPixelFormat24bppBGR, 3 },
+        { &GUID_WICPixelFormat24bppRGB, 3 },
+        { &GUID_WICPixelFormat32bppBGR, 4 },
+        { &GUID_WICPixelFormat32bppBGRA, 4 },
+        { &GUID_WICPixelFormat32bppPBGRA, 4 },
+        { &GUID_WICPixelFormat32bppRGB, 4 },
+        { &GUID_WICPixelFormat32bppRGBA, 4 },
+        { &GUID_WICPixelFormat32bppPRGBA, 4 },
+    };
+    UINT i;
+
+    for (i = 0; i < ARRAY_SIZE(formats); i++)
+        if (IsEqualGUID(format, formats[i].format))
+            return formats[i].channels;
+
+    return 0;
+}
+
 static HRESULT WINAPI BitmapScaler_Initialize(IWICBitmapScaler *iface,
     IWICBitmapSource *pISource, UINT uiWidth, UINT uiHeight,
     WICBitmapInterpolationMode mode)
@@ -349,13 +698,49 @@ static HRESULT WINAPI BitmapScaler_Initialize(IWICBitmapScaler *iface,
         hr = get_pixelformat_bpp(&src_pixelformat, &This->bpp);
     }
 
-    if (SUCCEEDED(hr))
+    if (SUCCEEDED(hr) && mode != WICBitmapInterpolationModeNearestNeighbor)
     {
         switch (mode)
         {
+        case WICBitmapInterpolationModeLinear:
+        case WICBitmapInterpolationModeCubic:
+        case WICBitmapInterpolationModeFant:
+        case WICBitmapInterpolationModeHighQualityCubic:
+            This->channels = get_filter_channels(&src_pixelformat);
+            if (!This->channels)
+                FIXME("format %s not supported for mode %i\n", debugstr_guid(&src_pixelformat), mode);
+            break;
         default:
             FIXME("unsupported mode %i\n", mode);
-            /* fall-through */
+            break;
+        }
+
+        if (This->channels)
+        {
+            hr = init_scaler_filter(&This->filter_x, mode, This->src_width, This->width);
+            if (SUCCEEDED(hr))
+                hr = init_scaler_filter(&This->filter_y, mode, This->src_height, This->height);
+
+            if (SUCCEEDED(hr))
+            {
+                IWICBitmapSource_AddRef(pISource);
+                This->source = pISource;
+            }
+            else
+            {
+                free_scaler_filter(&This->filter_x);
+                free_scaler_filter(&This->filter_y);
+                This->channels = 0;
+            }
+            goto end;
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        switch (mode)
+        {
+        default:
         case WICBitmapInterpolationModeNearestNeighbor:
             if ((This->bpp % 8) == 0)
             {
@@ -529,6 +914,10 @@ HRESULT BitmapScaler_Create(IWICBitmapScaler **scaler)
     This->src_height = 0;
     This->mode = 0;
     This->bpp = 0;
+    This->channels = 0;
+    memset(&This->filter_x, 0, sizeof(This->filter_x));
+    memset(&This->filter_y, 0, sizeof(This->filter_y));
+    memset(&This->cache, 0, sizeof(This->cache));
     InitializeCriticalSection(&This->lock);
     This->lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": BitmapScaler.lock");
 
@@ -20,6 +20,7 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <assert.h>
+#include <stdlib.h>
 #include <math.h>
 
 #define COBJMACROS
@@ -1324,6 +1325,102 @@ static void test_bitmap_scaler(void)
     IWICBitmap_Release(bitmap);
 }
 
+static void test_bitmap_scaler_modes(void)
+{
+    static const WICBitmapInterpolationMode modes[] =
+    {
+        WICBitmapInterpolationModeLinear,
+        WICBitmapInterpolationModeCubic,
+        WICBitmapInterpolationModeFant,
+        WICBitmapInterpolationModeHighQualityCubic,
+    };
+    static const UINT sizes[][2] = { {5, 7}, {37, 29}, {16, 16} };
+    BYTE src[16 * 16 * 3], full[37 * 29 * 3], part[37 * 3], small[4 * 4 * 3];
+    IWICBitmapScaler *scaler;
+    IWICBitmap *bitmap;
+    WICRect rc;
+    UINT i, j, x, y, mismatch;
+    HRESULT hr;
+
+    for (i = 0; i < sizeof(src); i++)
+        src[i] = 0x5a;
+
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, 16, 16, &GUID_WICPixelFormat24bppBGR,
+                                                   16 * 3, sizeof(src), src, &bitmap);
+    ok(hr == S_OK, "Failed to create a bitmap, hr %#x.\n", hr);
+
+    for (i = 0; i < ARRAY_SIZE(modes); i++)
+    {
+        for (j = 0; j < ARRAY_SIZE(sizes); j++)
+        {
+            UINT width = sizes[j][0], height = sizes[j][1];
+
+            hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+            ok(hr == S_OK, "Failed to create bitmap scaler, hr %#x.\n", hr);
+
+            hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, width, height, modes[i]);
+            if (hr != S_OK && modes[i] == WICBitmapInterpolationModeHighQualityCubic)
+            {
+                win_skip("HighQualityCubic is not supported.\n");
+                IWICBitmapScaler_Release(scaler);
+                break;
+            }
+            ok(hr == S_OK, "%u: Failed to initialize bitmap scaler, hr %#x.\n", modes[i], hr);
+
+            /* a solid image stays solid */
+            memset(full, 0, sizeof(full));
+            hr = IWICBitmapScaler_CopyPixels(scaler, NULL, width * 3, sizeof(full), full);
+            ok(hr == S_OK, "%u: Failed to copy pixels, hr %#x.\n", modes[i], hr);
+            for (x = 0, mismatch = 0; x < width * height * 3; x++)
+                if (full[x] != 0x5a) mismatch++;
+            ok(!mismatch, "%u, %ux%u: %u bytes differ.\n", modes[i], width, height, mismatch);
+
+            /* single scanlines match the full image */
+            for (y = 0; y < height; y++)
+            {
+                rc.X = 1;
+                rc.Y = y;
+                rc.Width = width - 2;
+                rc.Height = 1;
+                hr = IWICBitmapScaler_CopyPixels(scaler, &rc, sizeof(part), sizeof(part), part);
+                ok(hr == S_OK, "%u: Failed to copy pixels, hr %#x.\n", modes[i], hr);
+                ok(!memcmp(part, full + (y * width + 1) * 3, rc.Width * 3),
+                   "%u, %ux%u: row %u differs.\n", modes[i], width, height, y);
+            }
+
+            IWICBitmapScaler_Release(scaler);
+        }
+    }
+
+    IWICBitmap_Release(bitmap);
+
+    /* Fant averages the source pixels covered by each destination pixel */
+    for (y = 0; y < 16; y++)
+        for (x = 0; x < 16; x++)
+            src[(y * 16 + x) * 3] = src[(y * 16 + x) * 3 + 1] = src[(y * 16 + x) * 3 + 2] = x * 8 + y * 4;
+
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, 16, 16, &GUID_WICPixelFormat24bppBGR,
+                                                   16 * 3, sizeof(src), src, &bitmap);
+    ok(hr == S_OK, "Failed to create a bitmap, hr %#x.\n", hr);
+
+    hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+    ok(hr == S_OK, "Failed to create bitmap scaler, hr %#x.\n", hr);
+    hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, 4, 4, WICBitmapInterpolationModeFant);
+    ok(hr == S_OK, "Failed to initialize bitmap scaler, hr %#x.\n", hr);
+    hr = IWICBitmapScaler_CopyPixels(scaler, NULL, 4 * 3, sizeof(small), small);
+    ok(hr == S_OK, "Failed to copy pixels, hr %#x.\n", hr);
+
+    for (y = 0; y < 4; y++)
+        for (x = 0; x < 4; x++)
+        {
+            int expected = x * 32 + 12 + y * 16 + 6, got = small[(y * 4 + x) * 3];
+            ok(abs(got - expected) <= 1, "%u,%u: expected %d, got %d.\n", x, y, expected, got);
+        }
+
+    IWICBitmapScaler_Release(scaler);
+    IWICBitmap_Release(bitmap);
+}
+
 static LONG obj_refcount(void *obj)
 {
     IUnknown_AddRef((IUnknown *)obj);
@@ -1494,6 +1591,7 @@ START_TEST(bitmap)
     test_CreateBitmapFromHBITMAP();
     test_clipper();
     test_bitmap_scaler();
+    test_bitmap_scaler_modes();
 
     IWICImagingFactory_Release(factory);
 
@@ -579,6 +579,108 @@ static void test_conversion(const struct bitmap_data *src, const struct bitmap_d
     DeleteTestBitmap(src_obj);
 }
 
+static void test_conversion_throughput(void)
+{
+    static const struct
+    {
+        const WICPixelFormatGUID *src_format;
+        UINT src_bpp;
+        const WICPixelFormatGUID *dst_format;
+        UINT dst_bpp;
+        BOOL lossless;
+        const char *name;
+    } tests[] =
+    {
+        { &GUID_WICPixelFormat32bppBGR, 32, &GUID_WICPixelFormat32bppBGRA, 32, TRUE, "32bppBGR -> 32bppBGRA" },
+        { &GUID_WICPixelFormat24bppBGR, 24, &GUID_WICPixelFormat32bppBGRA, 32, TRUE, "24bppBGR -> 32bppBGRA" },
+        { &GUID_WICPixelFormat32bppBGRA, 32, &GUID_WICPixelFormat24bppBGR, 24, TRUE, "32bppBGRA -> 24bppBGR" },
+        { &GUID_WICPixelFormat8bppGray, 8, &GUID_WICPixelFormat32bppBGRA, 32, TRUE, "8bppGray -> 32bppBGRA" },
+        { &GUID_WICPixelFormat32bppBGRA, 32, &GUID_WICPixelFormat32bppPBGRA, 32, FALSE, "32bppBGRA -> 32bppPBGRA" },
+        { &GUID_WICPixelFormat32bppPBGRA, 32, &GUID_WICPixelFormat32bppBGRA, 32, FALSE, "32bppPBGRA -> 32bppBGRA" },
+        { &GUID_WICPixelFormat24bppBGR, 24, &GUID_WICPixelFormat8bppGray, 8, FALSE, "24bppBGR -> 8bppGray" },
+        { &GUID_WICPixelFormat32bppGrayFloat, 32, &GUID_WICPixelFormat8bppGray, 8, FALSE, "32bppGrayFloat -> 8bppGray" },
+    };
+    static const UINT width = 1024, height = 256, loops = 4;
+    struct bitmap_data data = { NULL, 0, NULL, width, height, 96.0, 96.0 };
+    IWICBitmapSource *dst_bitmap;
+    BitmapTestSrc *src_obj;
+    UINT i, j, x, y, src_stride, dst_stride;
+    DWORD start, elapsed;
+    BYTE *src_bits, *dst_bits;
+    HRESULT hr;
+
+    src_bits = HeapAlloc(GetProcessHeap(), 0, width * height * 4);
+    dst_bits = HeapAlloc(GetProcessHeap(), 0, width * height * 4);
+
+    for (i = 0; i < ARRAY_SIZE(tests); i++)
+    {
+        src_stride = width * tests[i].src_bpp / 8;
+        dst_stride = width * tests[i].dst_bpp / 8;
+
+        if (IsEqualGUID(tests[i].src_format, &GUID_WICPixelFormat32bppGrayFloat))
+        {
+            float *gray = (float *)src_bits;
+            for (x = 0; x < width * height; x++)
+                gray[x] = (x % 1021) / 1020.0f;
+        }
+        else
+        {
+            for (x = 0; x < src_stride * height; x++)
+                src_bits[x] = x * 7 + x / 251;
+        }
+
+        data.format = tests[i].src_format;
+        data.bpp = tests[i].src_bpp;
+        data.bits = src_bits;
+        CreateTestBitmap(&data, &src_obj);
+
+        hr = WICConvertBitmapSource(tests[i].dst_format, &src_obj->IWICBitmapSource_iface, &dst_bitmap);
+        ok(hr == S_OK, "%s: WICConvertBitmapSource error %#x\n", tests[i].name, hr);
+        if (hr != S_OK)
+        {
+            DeleteTestBitmap(src_obj);
+            continue;
+        }
+
+        start = GetTickCount();
+        for (j = 0; j < loops; j++)
+        {
+            hr = IWICBitmapSource_CopyPixels(dst_bitmap, NULL, dst_stride, dst_stride * height, dst_bits);
+            ok(hr == S_OK, "%s: CopyPixels error %#x\n", tests[i].name, hr);
+        }
+        elapsed = GetTickCount() - start;
+        trace("%s: %u ms for %u megapixels\n", tests[i].name, elapsed, width * height * loops / 1000000);
+
+        if (tests[i].lossless)
+        {
+            for (y = 0; y < height; y++)
+            {
+                for (x = 0; x < width; x++)
+                {
+                    const BYTE *src = src_bits + y * src_stride + x * tests[i].src_bpp / 8;
+                    const BYTE *dst = dst_bits + y * dst_stride + x * tests[i].dst_bpp / 8;
+                    BYTE expect[4];
+
+                    if (tests[i].src_bpp == 8)
+                        expect[0] = expect[1] = expect[2] = src[0];
+                    else
+                        memcpy(expect, src, 3);
+                    expect[3] = 0xff;
+                    if (memcmp(dst, expect, tests[i].dst_bpp / 8)) break;
+                }
+                if (x != width) break;
+            }
+            ok(y == height, "%s: wrong data at %u,%u\n", tests[i].name, x, y);
+        }
+
+        IWICBitmapSource_Release(dst_bitmap);
+        DeleteTestBitmap(src_obj);
+    }
+
+    HeapFree(GetProcessHeap(), 0, dst_bits);
+    HeapFree(GetProcessHeap(), 0, src_bits);
+}
+
 static void test_invalid_conversion(void)
 {
     BitmapTestSrc *src_obj;
@@ -1830,6 +1932,7 @@ START_TEST(converter)
     test_conversion(&testdata_32bppGrayFloat, &testdata_24bppBGR_gray, "32bppGrayFloat -> 24bppBGR gray", FALSE);
     test_conversion(&testdata_32bppGrayFloat, &testdata_8bppGray, "32bppGrayFloat -> 8bppGray", FALSE);
 
+    test_conversion_throughput();
     test_invalid_conversion();
     test_default_converter();
     test_converter_8bppIndexed();
@@ -743,12 +743,8 @@ static void test_color_formats(void)
         { 4, PNG_COLOR_TYPE_RGB, NULL, NULL, NULL },
         { 8, PNG_COLOR_TYPE_RGB,
           &GUID_WICPixelFormat24bppBGR, &GUID_WICPixelFormat24bppBGR, &GUID_WICPixelFormat24bppBGR },
-        /* libpng refuses to load our test image complaining about extra compressed data,
-         * but libpng is still able to load the image with other combination of type/depth
-         * making RGB 16 bpp case special for some reason. Therefore todo = TRUE.
-         */
         { 16, PNG_COLOR_TYPE_RGB,
-          &GUID_WICPixelFormat48bppRGB, &GUID_WICPixelFormat48bppRGB, &GUID_WICPixelFormat48bppRGB, TRUE, TRUE },
+          &GUID_WICPixelFormat48bppRGB, &GUID_WICPixelFormat48bppRGB, &GUID_WICPixelFormat48bppRGB },
         { 24, PNG_COLOR_TYPE_RGB, NULL, NULL, NULL },
         { 32, PNG_COLOR_TYPE_RGB, NULL, NULL, NULL },
         /* 0 - PNG_COLOR_TYPE_GRAY */
@@ -922,6 +918,99 @@ todo_wine_if(td[i].todo)
 #undef PNG_COLOR_TYPE_GRAY_ALPHA
 #undef PNG_COLOR_TYPE_RGB_ALPHA
 
+static void test_large_image(void)
+{
+    static const UINT width = 1400, height = 1100, band = 64;
+    IWICBitmapEncoder *encoder;
+    IWICBitmapFrameEncode *frame_encode;
+    IWICBitmapDecoder *decoder;
+    IWICBitmapFrameDecode *frame;
+    IPropertyBag2 *options;
+    IStream *stream;
+    WICPixelFormatGUID format;
+    WICRect rc;
+    UINT stride = width * 3, x, y, i;
+    BYTE *bits, *buffer;
+    LARGE_INTEGER zero;
+    HRESULT hr;
+
+    bits = HeapAlloc(GetProcessHeap(), 0, stride * height);
+    buffer = HeapAlloc(GetProcessHeap(), 0, stride * band);
+    for (y = 0; y < height; y++)
+        for (x = 0; x < stride; x++)
+            bits[y * stride + x] = (x * 3 + y * 5 + x / 17 * y / 11) & 0xff;
+
+    hr = CreateStreamOnHGlobal(NULL, TRUE, &stream);
+    ok(hr == S_OK, "CreateStreamOnHGlobal error %#x\n", hr);
+
+    hr = IWICImagingFactory_CreateEncoder(factory, &GUID_ContainerFormatPng, NULL, &encoder);
+    ok(hr == S_OK, "CreateEncoder error %#x\n", hr);
+    hr = IWICBitmapEncoder_Initialize(encoder, stream, WICBitmapEncoderNoCache);
+    ok(hr == S_OK, "Initialize error %#x\n", hr);
+    hr = IWICBitmapEncoder_CreateNewFrame(encoder, &frame_encode, &options);
+    ok(hr == S_OK, "CreateNewFrame error %#x\n", hr);
+    hr = IWICBitmapFrameEncode_Initialize(frame_encode, options);
+    ok(hr == S_OK, "Initialize error %#x\n", hr);
+    hr = IWICBitmapFrameEncode_SetSize(frame_encode, width, height);
+    ok(hr == S_OK, "SetSize error %#x\n", hr);
+    format = GUID_WICPixelFormat24bppBGR;
+    hr = IWICBitmapFrameEncode_SetPixelFormat(frame_encode, &format);
+    ok(hr == S_OK, "SetPixelFormat error %#x\n", hr);
+    hr = IWICBitmapFrameEncode_WritePixels(frame_encode, height, stride, stride * height, bits);
+    ok(hr == S_OK, "WritePixels error %#x\n", hr);
+    hr = IWICBitmapFrameEncode_Commit(frame_encode);
+    ok(hr == S_OK, "Commit error %#x\n", hr);
+    hr = IWICBitmapEncoder_Commit(encoder);
+    ok(hr == S_OK, "Commit error %#x\n", hr);
+    IPropertyBag2_Release(options);
+    IWICBitmapFrameEncode_Release(frame_encode);
+    IWICBitmapEncoder_Release(encoder);
+
+    zero.QuadPart = 0;
+    IStream_Seek(stream, zero, STREAM_SEEK_SET, NULL);
+    hr = IWICImagingFactory_CreateDecoderFromStream(factory, stream, NULL, 0, &decoder);
+    ok(hr == S_OK, "CreateDecoderFromStream error %#x\n", hr);
+    hr = IWICBitmapDecoder_GetFrame(decoder, 0, &frame);
+    ok(hr == S_OK, "GetFrame error %#x\n", hr);
+
+    hr = IWICBitmapFrameDecode_GetPixelFormat(frame, &format);
+    ok(hr == S_OK, "GetPixelFormat error %#x\n", hr);
+    ok(IsEqualGUID(&format, &GUID_WICPixelFormat24bppBGR), "got wrong format %s\n", wine_dbgstr_guid(&format));
+
+    /* read the image bottom up, so rows have to be decoded again */
+    for (i = 0; i < 2; i++)
+    {
+        for (y = height; y > 0; y -= rc.Height)
+        {
+            rc.Height = min(y, band);
+            rc.X = i * 100;
+            rc.Y = y - rc.Height;
+            rc.Width = width - rc.X;
+            hr = IWICBitmapFrameDecode_CopyPixels(frame, &rc, stride, stride * rc.Height, buffer);
+            ok(hr == S_OK, "CopyPixels error %#x\n", hr);
+            for (x = 0; x < rc.Height; x++)
+                if (memcmp(buffer + x * stride, bits + (rc.Y + x) * stride + rc.X * 3, rc.Width * 3)) break;
+            ok(x == rc.Height, "%u: row %u doesn't match\n", i, rc.Y + x);
+            if (x != rc.Height) break;
+        }
+    }
+
+    /* rows that are still cached */
+    rc.X = 0;
+    rc.Y = 1;
+    rc.Width = width;
+    rc.Height = 2;
+    hr = IWICBitmapFrameDecode_CopyPixels(frame, &rc, stride, stride * rc.Height, buffer);
+    ok(hr == S_OK, "CopyPixels error %#x\n", hr);
+    ok(!memcmp(buffer, bits + stride, stride * 2), "rows don't match\n");
+
+    IWICBitmapFrameDecode_Release(frame);
+    IWICBitmapDecoder_Release(decoder);
+    IStream_Release(stream);
+    HeapFree(GetProcessHeap(), 0, buffer);
+    HeapFree(GetProcessHeap(), 0, bits);
+}
+
 START_TEST(pngformat)
 {
     HRESULT hr;
@@ -935,6 +1024,7 @@ START_TEST(pngformat)
     test_color_contexts();
     test_png_palette();
     test_color_formats();
+    test_large_image();
 
     IWICImagingFactory_Release(factory);
     CoUninitialize();
@@ -167,6 +167,29 @@ extern HRESULT copy_pixels(UINT bpp, const BYTE *srcbuffer,
     UINT srcwidth, UINT srcheight, INT srcstride,
     const WICRect *rc, UINT dststride, UINT dstbuffersize, BYTE *dstbuffer) DECLSPEC_HIDDEN;
 
+/* Bounded cache of scanlines for decoders that can only produce rows in
+ * order. Rows [first, next) are held in a ring of capacity rows. */
+struct row_cache
+{
+    UINT width, height, bpp, stride;
+    UINT capacity;
+    UINT first, next;
+    BYTE *bits;
+};
+
+struct row_cache_decoder
+{
+    /* decode the next row of the image into the given buffer */
+    HRESULT (*read_row)(void *decoder, BYTE *row);
+    /* start decoding from the first row again */
+    HRESULT (*restart)(void *decoder);
+};
+
+extern HRESULT row_cache_init(struct row_cache *cache, UINT width, UINT height, UINT bpp) DECLSPEC_HIDDEN;
+extern void row_cache_free(struct row_cache *cache) DECLSPEC_HIDDEN;
+extern HRESULT row_cache_copy_pixels(struct row_cache *cache, const struct row_cache_decoder *funcs,
+    void *decoder, const WICRect *rc, UINT dststride, UINT dstbuffersize, BYTE *dstbuffer) DECLSPEC_HIDDEN;
+
 extern HRESULT configure_write_source(IWICBitmapFrameEncode *iface,
     IWICBitmapSource *source, const WICRect *prc,
     const WICPixelFormatGUID *format,
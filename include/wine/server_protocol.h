@@ -758,6 +758,43 @@ struct rawinput_device
 
 
 
+struct queue_shared_memory
+{
+    unsigned int   seq;
+    unsigned int   wake_bits;
+    unsigned int   changed_bits;
+    unsigned int   wake_mask;
+    unsigned int   changed_mask;
+    unsigned int   access_time;
+};
+
+
+struct shared_window
+{
+    user_handle_t  handle;
+    user_handle_t  parent;
+    user_handle_t  owner;
+    unsigned int   style;
+    unsigned int   ex_style;
+    unsigned int   dpi;
+    rectangle_t    window_rect;
+    rectangle_t    client_rect;
+};
+
+
+struct desktop_shared_memory
+{
+    unsigned int   seq;
+    unsigned int   zorder_version;
+    user_handle_t  foreground;
+    int            cursor_x;
+    int            cursor_y;
+    unsigned int   cursor_change;
+    struct shared_window windows[1];
+};
+
+
+
 
 
 struct new_process_request
@@ -3045,6 +3082,20 @@ struct get_msg_queue_request
     char __pad_12[4];
 };
 struct get_msg_queue_reply
+{
+    struct reply_header __header;
+    obj_handle_t handle;
+    obj_handle_t shm_handle;
+};
+
+
+
+struct get_desktop_shm_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+};
+struct get_desktop_shm_reply
 {
     struct reply_header __header;
     obj_handle_t handle;
@@ -5630,13 +5681,31 @@ struct set_cursor_reply
 struct update_rawinput_devices_request
 {
     struct request_header __header;
+    unsigned int coalesce;
     /* VARARG(devices,rawinput_devices); */
-    char __pad_12[4];
 };
 struct update_rawinput_devices_reply
 {
     struct reply_header __header;
 };
+#define RAWINPUT_COALESCE_MOUSE  0x01
+
+
+
+struct get_rawinput_buffer_request
+{
+    struct request_header __header;
+    unsigned int count;
+    int          remove;
+    char __pad_20[4];
+};
+struct get_rawinput_buffer_reply
+{
+    struct reply_header __header;
+    unsigned int count;
+    unsigned int pending;
+    /* VARARG(data,bytes); */
+};
 
 
 
@@ -6100,6 +6169,7 @@ enum request
     REQ_empty_atom_table,
     REQ_init_atom_table,
     REQ_get_msg_queue,
+    REQ_get_desktop_shm,
     REQ_set_queue_fd,
     REQ_set_queue_mask,
     REQ_get_queue_status,
@@ -6253,6 +6323,7 @@ enum request
     REQ_free_user_handle,
     REQ_set_cursor,
     REQ_update_rawinput_devices,
+    REQ_get_rawinput_buffer,
     REQ_get_suspend_context,
     REQ_set_suspend_context,
     REQ_create_job,
@@ -6415,6 +6486,7 @@ union generic_request
     struct empty_atom_table_request empty_atom_table_request;
     struct init_atom_table_request init_atom_table_request;
     struct get_msg_queue_request get_msg_queue_request;
+    struct get_desktop_shm_request get_desktop_shm_request;
     struct set_queue_fd_request set_queue_fd_request;
     struct set_queue_mask_request set_queue_mask_request;
     struct get_queue_status_request get_queue_status_request;
@@ -6568,6 +6640,7 @@ union generic_request
     struct free_user_handle_request free_user_handle_request;
     struct set_cursor_request set_cursor_request;
     struct update_rawinput_devices_request update_rawinput_devices_request;
+    struct get_rawinput_buffer_request get_rawinput_buffer_request;
     struct get_suspend_context_request get_suspend_context_request;
     struct set_suspend_context_request set_suspend_context_request;
     struct create_job_request create_job_request;
@@ -6728,6 +6801,7 @@ union generic_reply
     struct empty_atom_table_reply empty_atom_table_reply;
     struct init_atom_table_reply init_atom_table_reply;
     struct get_msg_queue_reply get_msg_queue_reply;
+    struct get_desktop_shm_reply get_desktop_shm_reply;
     struct set_queue_fd_reply set_queue_fd_reply;
     struct set_queue_mask_reply set_queue_mask_reply;
     struct get_queue_status_reply get_queue_status_reply;
@@ -6881,6 +6955,7 @@ union generic_reply
     struct free_user_handle_reply free_user_handle_reply;
     struct set_cursor_reply set_cursor_reply;
     struct update_rawinput_devices_reply update_rawinput_devices_reply;
+    struct get_rawinput_buffer_reply get_rawinput_buffer_reply;
     struct get_suspend_context_reply get_suspend_context_reply;
     struct set_suspend_context_reply set_suspend_context_reply;
     struct create_job_reply create_job_reply;
@@ -6904,6 +6979,6 @@ union generic_reply
     struct get_fsync_apc_idx_reply get_fsync_apc_idx_reply;
 };
 
-#define SERVER_PROTOCOL_VERSION 606
+#define SERVER_PROTOCOL_VERSION 609
 
 #endif /* __WINE_WINE_SERVER_PROTOCOL_H */
@@ -159,6 +159,7 @@ extern struct mapping *get_mapping_obj( struct process *process, obj_handle_t ha
 extern struct file *get_mapping_file( struct process *process, client_ptr_t base,
                                       unsigned int access, unsigned int sharing );
 extern void free_mapped_views( struct process *process );
+extern struct object *create_shared_mapping( mem_size_t size, void **ptr );
 extern int get_page_size(void);
 
 /* device functions */
@@ -538,6 +538,7 @@ struct process *create_process( int fd, struct process *parent, int inherit_all,
     process->trace_data      = 0;
     process->rawinput_mouse  = NULL;
     process->rawinput_kbd    = NULL;
+    process->rawinput_coalesce = 0;
     list_init( &process->kernel_object );
     process->esync_fd        = -1;
     process->fsync_idx       = 0;
@@ -146,6 +146,8 @@ struct msg_queue
     int                    esync_in_msgwait; /* our thread is currently waiting on us */
     unsigned int           fsync_idx;
     int                    fsync_in_msgwait; /* our thread is currently waiting on us */
+    struct object         *shared_mapping;  /* mapping for the shared memory block */
+    struct queue_shared_memory *shared;     /* queue state shared with the client */
 };
 
 struct hotkey
@@ -315,6 +317,7 @@ static struct msg_queue *create_msg_queue( struct thread *thread, struct thread_
         queue->esync_fd        = -1;
         queue->fsync_idx       = 0;
         queue->fsync_in_msgwait = 0;
+        queue->shared          = NULL;
         list_init( &queue->send_result );
         list_init( &queue->callback_result );
         list_init( &queue->pending_timers );
@@ -327,6 +330,10 @@ static struct msg_queue *create_msg_queue( struct thread *thread, struct thread_
         if (do_esync())
             queue->esync_fd = esync_create_fd( 0, 0 );
 
+        /* the client falls back to server calls if this fails */
+        queue->shared_mapping = create_shared_mapping( sizeof(*queue->shared), (void **)&queue->shared );
+        if (!queue->shared_mapping) clear_error();
+
         thread->queue = queue;
     }
     if (new_input) release_object( new_input );
@@ -411,6 +418,31 @@ static void get_message_defaults( struct msg_queue *queue, int *x, int *y, unsig
     *time = get_tick_count();
 }
 
+/* publish the cursor position to the desktop shared memory */
+static void update_shared_cursor( struct desktop *desktop )
+{
+    struct desktop_shared_memory *shared = desktop->shared;
+
+    if (!shared) return;
+    begin_shared_update( &shared->seq );
+    shared->cursor_x      = desktop->cursor.x;
+    shared->cursor_y      = desktop->cursor.y;
+    shared->cursor_change = desktop->cursor.last_change;
+    end_shared_update( &shared->seq );
+}
+
+/* publish the foreground window to the desktop shared memory */
+static void update_shared_foreground( struct desktop *desktop )
+{
+    struct desktop_shared_memory *shared = desktop->shared;
+    user_handle_t foreground = desktop->foreground_input ? desktop->foreground_input->active : 0;
+
+    if (!shared || shared->foreground == foreground) return;
+    begin_shared_update( &shared->seq );
+    shared->foreground = foreground;
+    end_shared_update( &shared->seq );
+}
+
 /* set the cursor clip rectangle */
 static void set_clip_rectangle( struct desktop *desktop, const rectangle_t *rect, int send_clip_msg )
 {
@@ -445,6 +477,7 @@ static void set_foreground_input( struct desktop *desktop, struct thread_input *
     if (desktop->foreground_input == input) return;
     set_clip_rectangle( desktop, NULL, 1 );
     desktop->foreground_input = input;
+    update_shared_foreground( desktop );
 }
 
 /* get the hook table for a given thread */
@@ -469,11 +502,41 @@ static inline int is_signaled( struct msg_queue *queue )
     return ((queue->wake_bits & queue->wake_mask) || (queue->changed_bits & queue->changed_mask));
 }
 
+/* publish the queue bits and masks to the client shared memory */
+static void update_shared_queue( struct msg_queue *queue )
+{
+    struct queue_shared_memory *shared = queue->shared;
+
+    if (!shared) return;
+    if (shared->wake_bits == queue->wake_bits && shared->changed_bits == queue->changed_bits &&
+        shared->wake_mask == queue->wake_mask && shared->changed_mask == queue->changed_mask)
+        return;
+
+    begin_shared_update( &shared->seq );
+    shared->wake_bits    = queue->wake_bits;
+    shared->changed_bits = queue->changed_bits;
+    shared->wake_mask    = queue->wake_mask;
+    shared->changed_mask = queue->changed_mask;
+    end_shared_update( &shared->seq );
+}
+
+/* record a get_message call, the client must not skip the server for too long */
+static void touch_shared_queue( struct msg_queue *queue )
+{
+    struct queue_shared_memory *shared = queue->shared;
+
+    if (!shared) return;
+    begin_shared_update( &shared->seq );
+    shared->access_time = get_tick_count();
+    end_shared_update( &shared->seq );
+}
+
 /* set some queue bits */
 static inline void set_queue_bits( struct msg_queue *queue, unsigned int bits )
 {
     queue->wake_bits |= bits;
     queue->changed_bits |= bits;
+    update_shared_queue( queue );
     if (is_signaled( queue )) wake_up( &queue->obj, 0 );
 }
 
@@ -482,6 +545,7 @@ static inline void clear_queue_bits( struct msg_queue *queue, unsigned int bits
 {
     queue->wake_bits &= ~bits;
     queue->changed_bits &= ~bits;
+    update_shared_queue( queue );
 
     if (do_fsync() && !is_signaled( queue ))
         fsync_clear( &queue->obj );
@@ -542,12 +606,53 @@ static inline unsigned int get_unique_id(void)
     return id;
 }
 
+/* check if a raw input message only contains relative mouse motion that can be merged */
+static int is_rawinput_motion( const struct message *msg )
+{
+    const struct hardware_msg_data *data = msg->data;
+
+    if (msg->msg != WM_INPUT || !data) return 0;
+    if (data->rawinput.type != RIM_TYPEMOUSE) return 0;
+    return (data->flags & ~(MOUSEEVENTF_ABSOLUTE | MOUSEEVENTF_VIRTUALDESK)) == MOUSEEVENTF_MOVE;
+}
+
+/* try to merge raw mouse motion with the last raw input message in the list */
+static int merge_rawinput_message( struct thread_input *input, const struct message *msg )
+{
+    struct hardware_msg_data *prev_data, *msg_data = msg->data;
+    struct message *prev;
+    struct list *ptr;
+
+    if (!(current->process->rawinput_coalesce & RAWINPUT_COALESCE_MOUSE)) return 0;
+    if (!is_rawinput_motion( msg )) return 0;
+    for (ptr = list_tail( &input->msg_list ); ptr; ptr = list_prev( &input->msg_list, ptr ))
+    {
+        prev = LIST_ENTRY( ptr, struct message, entry );
+        if (prev->msg != WM_MOUSEMOVE) break;
+    }
+    if (!ptr) return 0;
+    if (prev->result) return 0;
+    if (prev->unique_id) return 0;  /* already returned to the app */
+    if (prev->win != msg->win) return 0;
+    if (!is_rawinput_motion( prev )) return 0;
+    /* now we can merge it, accumulating the relative motion */
+    prev_data = prev->data;
+    prev_data->rawinput.mouse.x += msg_data->rawinput.mouse.x;
+    prev_data->rawinput.mouse.y += msg_data->rawinput.mouse.y;
+    prev_data->info = msg_data->info;
+    prev->time = msg->time;
+    list_remove( ptr );
+    list_add_tail( &input->msg_list, ptr );
+    return 1;
+}
+
 /* try to merge a message with the last in the list; return 1 if successful */
 static int merge_message( struct thread_input *input, const struct message *msg )
 {
     struct message *prev;
     struct list *ptr;
 
+    if (msg->msg == WM_INPUT) return merge_rawinput_message( input, msg );
     if (msg->msg != WM_MOUSEMOVE) return 0;
     for (ptr = list_tail( &input->msg_list ); ptr; ptr = list_prev( &input->msg_list, ptr ))
     {
@@ -1018,6 +1123,7 @@ static void msg_queue_satisfied( struct object *obj, struct wait_queue_entry *en
     struct msg_queue *queue = (struct msg_queue *)obj;
     queue->wake_mask = 0;
     queue->changed_mask = 0;
+    update_shared_queue( queue );
 }
 
 static void msg_queue_destroy( struct object *obj )
@@ -1056,6 +1162,7 @@ static void msg_queue_destroy( struct object *obj )
     release_object( queue->input );
     if (queue->hooks) release_object( queue->hooks );
     if (queue->fd) release_object( queue->fd );
+    if (queue->shared_mapping) release_object( queue->shared_mapping );
 
     if (do_esync())
         close( queue->esync_fd );
@@ -1097,7 +1204,11 @@ static inline void thread_input_cleanup_window( struct msg_queue *queue, user_ha
 
     if (window == input->focus) input->focus = 0;
     if (window == input->capture) input->capture = 0;
-    if (window == input->active) input->active = 0;
+    if (window == input->active)
+    {
+        input->active = 0;
+        update_shared_foreground( input->desktop );
+    }
     if (window == input->menu_owner) input->menu_owner = 0;
     if (window == input->move_size) input->move_size = 0;
     if (window == input->caret) set_caret_window( input, 0 );
@@ -1156,6 +1267,7 @@ int attach_thread_input( struct thread *thread_from, struct thread *thread_to )
 
     ret = assign_thread_input( thread_from, input );
     if (ret) memset( input->keystate, 0, sizeof(input->keystate) );
+    update_shared_foreground( input->desktop );
     release_object( input );
     return ret;
 }
@@ -1187,6 +1299,7 @@ void detach_thread_input( struct thread *thread_from )
             release_object( thread );
         }
         assign_thread_input( thread_from, input );
+        update_shared_foreground( input->desktop );
         release_object( input );
     }
 }
@@ -1559,6 +1672,7 @@ static void queue_hardware_message( struct desktop *desktop, struct message *msg
             desktop->cursor.x = x;
             desktop->cursor.y = y;
             desktop->cursor.last_change = get_tick_count();
+            update_shared_cursor( desktop );
         }
         if (desktop->keystate[VK_LBUTTON] & 0x80)  msg->wparam |= MK_LBUTTON;
         if (desktop->keystate[VK_MBUTTON] & 0x80)  msg->wparam |= MK_MBUTTON;
@@ -1676,6 +1790,7 @@ static int queue_mouse_message( struct desktop *desktop, user_handle_t win, cons
     };
 
     desktop->cursor.last_change = get_tick_count();
+    update_shared_cursor( desktop );
     flags = input->mouse.flags;
     time  = input->mouse.time;
     if (!time) time = desktop->cursor.last_change;
@@ -2230,7 +2345,16 @@ DECL_HANDLER(get_msg_queue)
     struct msg_queue *queue = get_current_queue();
 
     reply->handle = 0;
-    if (queue) reply->handle = alloc_handle( current->process, queue, SYNCHRONIZE, 0 );
+    reply->shm_handle = 0;
+    if (!queue) return;
+    reply->handle = alloc_handle( current->process, queue, SYNCHRONIZE, 0 );
+    if (queue->shared_mapping)
+    {
+        update_shared_queue( queue );
+        touch_shared_queue( queue );
+        reply->shm_handle = alloc_handle( current->process, queue->shared_mapping,
+                                          SECTION_QUERY | SECTION_MAP_READ, 0 );
+    }
 }
 
 
@@ -2276,6 +2400,7 @@ DECL_HANDLER(set_queue_mask)
             if (req->skip_wait) queue->wake_mask = queue->changed_mask = 0;
             else wake_up( &queue->obj, 0 );
         }
+        update_shared_queue( queue );
     }
 }
 
@@ -2289,6 +2414,7 @@ DECL_HANDLER(get_queue_status)
         reply->wake_bits    = queue->wake_bits;
         reply->changed_bits = queue->changed_bits;
         queue->changed_bits &= ~req->clear_bits;
+        update_shared_queue( queue );
 
         if (do_fsync() && !is_signaled( queue ))
             fsync_clear( &queue->obj );
@@ -2453,6 +2579,7 @@ DECL_HANDLER(get_message)
 
     if (!queue) return;
     queue->last_get_msg = current_time;
+    touch_shared_queue( queue );
     if (!filter) filter = QS_ALLINPUT;
 
     /* first check for sent messages */
@@ -2471,6 +2598,7 @@ DECL_HANDLER(get_message)
     }
     if (filter & QS_INPUT) queue->changed_bits &= ~QS_INPUT;
     if (filter & QS_PAINT) queue->changed_bits &= ~QS_PAINT;
+    update_shared_queue( queue );
 
     /* then check for posted messages */
     if ((filter & QS_POSTMESSAGE) &&
@@ -2525,6 +2653,7 @@ DECL_HANDLER(get_message)
     if (get_win == -1 && current->process->idle_event) set_event( current->process->idle_event );
     queue->wake_mask = req->wake_mask;
     queue->changed_mask = req->changed_mask;
+    update_shared_queue( queue );
     set_error( STATUS_PENDING );  /* FIXME */
 }
 
@@ -3010,6 +3139,7 @@ DECL_HANDLER(set_active_window)
         {
             reply->previous = queue->input->active;
             queue->input->active = get_user_full_handle( req->handle );
+            update_shared_foreground( queue->input->desktop );
         }
         else set_error( STATUS_INVALID_HANDLE );
     }
@@ -3179,6 +3309,58 @@ DECL_HANDLER(update_rawinput_devices)
     current->process->rawinput_mouse = e ? &e->device : NULL;
     e = find_rawinput_device( 1, 6 );
     current->process->rawinput_kbd   = e ? &e->device : NULL;
+    current->process->rawinput_coalesce = req->coalesce;
+}
+
+/* retrieve the pending raw input messages of the current thread */
+DECL_HANDLER(get_rawinput_buffer)
+{
+    struct msg_queue *queue = get_current_queue();
+    struct hardware_msg_data *data = NULL;
+    struct message *msg, *next;
+    struct thread_input *input;
+    struct thread *win_thread;
+    unsigned int count = 0, max_count, msg_code;
+    int others = 0;
+
+    if (!queue) return;
+    input = queue->input;
+
+    max_count = min( req->count, get_reply_max_size() / sizeof(*data) );
+    if (max_count && !(data = mem_alloc( max_count * sizeof(*data) ))) return;
+
+    LIST_FOR_EACH_ENTRY_SAFE( msg, next, &input->msg_list, struct message, entry )
+    {
+        if (get_hardware_msg_bit( msg ) != QS_RAWINPUT) continue;
+        win_thread = NULL;
+        if (msg->msg != WM_INPUT || msg->unique_id ||
+            !find_hardware_message_window( input->desktop, input, msg, &msg_code, &win_thread ) ||
+            win_thread != current)
+        {
+            /* leave it to get_message */
+            if (win_thread) release_object( win_thread );
+            others = 1;
+            continue;
+        }
+        release_object( win_thread );
+        if (count == max_count)
+        {
+            reply->pending++;
+            continue;
+        }
+        data[count++] = *(struct hardware_msg_data *)msg->data;
+        if (req->remove)
+        {
+            list_remove( &msg->entry );
+            free_message( msg );
+        }
+        else reply->pending++;
+    }
+    if (req->remove && !reply->pending && !others) clear_queue_bits( queue, QS_RAWINPUT );
+
+    reply->count = count;
+    if (count) set_reply_data_ptr( data, count * sizeof(*data) );
+    else free( data );
 }
 
 DECL_HANDLER(esync_msgwait)
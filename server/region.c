@@ -758,6 +758,35 @@ struct region *copy_region( struct region *dst, const struct region *src )
     return dst;
 }
 
+/* create a new copy of a region */
+struct region *dup_region( const struct region *src )
+{
+    struct region *region = create_empty_region();
+
+    if (region && !copy_region( region, src ))
+    {
+        free_region( region );
+        return NULL;
+    }
+    return region;
+}
+
+/* find the first rectangle of the band containing or following a given y coordinate */
+static const rectangle_t *find_band( const struct region *region, int y )
+{
+    const rectangle_t *rects = region->rects;
+    unsigned int first = 0, last = region->num_rects;
+
+    /* the bottom coordinate is increasing across bands */
+    while (first < last)
+    {
+        unsigned int pos = (first + last) / 2;
+        if (rects[pos].bottom <= y) first = pos + 1;
+        else last = pos;
+    }
+    return rects + first;
+}
+
 /* compute the intersection of two regions into dst, which can be one of the source regions */
 struct region *intersect_region( struct region *dst, const struct region *src1,
                                  const struct region *src2 )
@@ -843,7 +872,8 @@ int point_in_region( struct region *region, int x, int y )
 {
     const rectangle_t *ptr, *end;
 
-    for (ptr = region->rects, end = region->rects + region->num_rects; ptr < end; ptr++)
+    if (!point_in_rect( &region->extents, x, y )) return 0;
+    for (ptr = find_band( region, y ), end = region->rects + region->num_rects; ptr < end; ptr++)
     {
         if (ptr->top > y) return 0;
         if (ptr->bottom <= y) continue;
@@ -860,7 +890,8 @@ int rect_in_region( struct region *region, const rectangle_t *rect )
 {
     const rectangle_t *ptr, *end;
 
-    for (ptr = region->rects, end = region->rects + region->num_rects; ptr < end; ptr++)
+    if (!EXTENTCHECK( &region->extents, rect )) return 0;
+    for (ptr = find_band( region, rect->top ), end = region->rects + region->num_rects; ptr < end; ptr++)
     {
         if (ptr->top >= rect->bottom) return 0;
         if (ptr->bottom <= rect->top) continue;
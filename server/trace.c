@@ -2770,6 +2770,16 @@ static void dump_get_msg_queue_request( const struct get_msg_queue_request *req
 }
 
 static void dump_get_msg_queue_reply( const struct get_msg_queue_reply *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+    fprintf( stderr, ", shm_handle=%04x", req->shm_handle );
+}
+
+static void dump_get_desktop_shm_request( const struct get_desktop_shm_request *req )
+{
+}
+
+static void dump_get_desktop_shm_reply( const struct get_desktop_shm_reply *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
 }
@@ -4518,7 +4528,21 @@ static void dump_set_cursor_reply( const struct set_cursor_reply *req )
 
 static void dump_update_rawinput_devices_request( const struct update_rawinput_devices_request *req )
 {
-    dump_varargs_rawinput_devices( " devices=", cur_size );
+    fprintf( stderr, " coalesce=%08x", req->coalesce );
+    dump_varargs_rawinput_devices( ", devices=", cur_size );
+}
+
+static void dump_get_rawinput_buffer_request( const struct get_rawinput_buffer_request *req )
+{
+    fprintf( stderr, " count=%08x", req->count );
+    fprintf( stderr, ", remove=%d", req->remove );
+}
+
+static void dump_get_rawinput_buffer_reply( const struct get_rawinput_buffer_reply *req )
+{
+    fprintf( stderr, " count=%08x", req->count );
+    fprintf( stderr, ", pending=%08x", req->pending );
+    dump_varargs_bytes( ", data=", cur_size );
 }
 
 static void dump_get_suspend_context_request( const struct get_suspend_context_request *req )
@@ -4844,6 +4868,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_empty_atom_table_request,
     (dump_func)dump_init_atom_table_request,
     (dump_func)dump_get_msg_queue_request,
+    (dump_func)dump_get_desktop_shm_request,
     (dump_func)dump_set_queue_fd_request,
     (dump_func)dump_set_queue_mask_request,
     (dump_func)dump_get_queue_status_request,
@@ -4997,6 +5022,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_free_user_handle_request,
     (dump_func)dump_set_cursor_request,
     (dump_func)dump_update_rawinput_devices_request,
+    (dump_func)dump_get_rawinput_buffer_request,
     (dump_func)dump_get_suspend_context_request,
     (dump_func)dump_set_suspend_context_request,
     (dump_func)dump_create_job_request,
@@ -5155,6 +5181,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     NULL,
     (dump_func)dump_init_atom_table_reply,
     (dump_func)dump_get_msg_queue_reply,
+    (dump_func)dump_get_desktop_shm_reply,
     NULL,
     (dump_func)dump_set_queue_mask_reply,
     (dump_func)dump_get_queue_status_reply,
@@ -5308,6 +5335,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     NULL,
     (dump_func)dump_set_cursor_reply,
     NULL,
+    (dump_func)dump_get_rawinput_buffer_reply,
     (dump_func)dump_get_suspend_context_reply,
     NULL,
     (dump_func)dump_create_job_reply,
@@ -5466,6 +5494,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "empty_atom_table",
     "init_atom_table",
     "get_msg_queue",
+    "get_desktop_shm",
     "set_queue_fd",
     "set_queue_mask",
     "get_queue_status",
@@ -5619,6 +5648,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "free_user_handle",
     "set_cursor",
     "update_rawinput_devices",
+    "get_rawinput_buffer",
     "get_suspend_context",
     "set_suspend_context",
     "create_job",
@@ -77,8 +77,20 @@ struct desktop
     unsigned int         users;            /* processes and threads using this desktop */
     struct global_cursor cursor;           /* global cursor information */
     unsigned char        keystate[256];    /* asynchronous key state */
+    struct object       *shared_mapping;   /* mapping for the shared memory block */
+    struct desktop_shared_memory *shared;  /* desktop state shared with the clients */
 };
 
+/* shared memory functions */
+
+extern void begin_shared_update( unsigned int *seq );
+extern void end_shared_update( unsigned int *seq );
+
+static inline unsigned int get_user_handle_index( user_handle_t handle )
+{
+    return ((handle & 0xffff) - FIRST_USER_HANDLE) >> 1;
+}
+
 /* user handles functions */
 
 extern user_handle_t alloc_user_handle( void *ptr, enum user_object type );
@@ -137,6 +149,7 @@ extern void offset_region( struct region *region, int x, int y );
 extern void mirror_region( const rectangle_t *client_rect, struct region *region );
 extern void scale_region( struct region *region, unsigned int dpi_from, unsigned int dpi_to );
 extern struct region *copy_region( struct region *dst, const struct region *src );
+extern struct region *dup_region( const struct region *src );
 extern struct region *intersect_region( struct region *dst, const struct region *src1,
                                         const struct region *src2 );
 extern struct region *subtract_region( struct region *dst, const struct region *src1,
@@ -92,6 +92,12 @@ struct window
     int              prop_inuse;      /* number of in-use window properties */
     int              prop_alloc;      /* number of allocated window properties */
     struct property *properties;      /* window properties array */
+    unsigned int     change_serial;   /* serial of the last change to the position, style or region */
+    unsigned int     children_serial; /* serial of the last change to any of the children */
+    struct children_index *children_index; /* spatial index of the children for hit-testing */
+    struct region   *vis_cache;       /* cached visible region (relative to window rect) */
+    unsigned int     vis_cache_flags; /* DCX flags used to compute the cached visible region */
+    unsigned int     vis_cache_serial;/* serial at the time the cached visible region was computed */
     int              nb_extra_bytes;  /* number of extra bytes */
     char             extra_bytes[1];  /* extra bytes storage */
 };
@@ -107,6 +113,22 @@ struct window
 #define PAINT_DELAYED_ERASE      0x0080  /* still needs erase after WM_ERASEBKGND */
 #define PAINT_PIXEL_FORMAT_CHILD 0x0100  /* at least one child has a custom pixel format */
 
+/* grid of the visible children of a window, each cell listing the children overlapping it in z-order */
+struct children_index
+{
+    unsigned int     serial;          /* children serial of the parent when the index was built */
+    unsigned int     cols;            /* number of columns, 0 if the index is not usable */
+    unsigned int     rows;            /* number of rows */
+    rectangle_t      bounds;          /* bounding rectangle of the indexed children */
+    int              cell_width;      /* size of a cell */
+    int              cell_height;
+    unsigned int    *cells;           /* start of each cell in the windows array, cols * rows + 1 entries */
+    struct window  **windows;         /* children overlapping each cell */
+};
+
+#define CHILDREN_INDEX_MIN_COUNT  32  /* minimum number of visible children to build an index */
+#define CHILDREN_INDEX_MAX_CELLS  64  /* maximum number of cells in each direction */
+
 /* growable array of user handles */
 struct user_handle_array
 {
@@ -117,6 +139,9 @@ struct user_handle_array
 
 static const rectangle_t empty_rect;
 
+/* serial of the last window change, for cache invalidation */
+static unsigned int change_serial;
+
 /* global window pointers */
 static struct window *shell_window;
 static struct window *shell_listview;
@@ -187,6 +212,207 @@ static unsigned int get_monitor_dpi( struct window *win )
     return win->dpi ? win->dpi : USER_DEFAULT_SCREEN_DPI;
 }
 
+/* free the cached visible region and children index of a window */
+static void free_window_caches( struct window *win )
+{
+    if (win->vis_cache) free_region( win->vis_cache );
+    win->vis_cache = NULL;
+    free( win->children_index );
+    win->children_index = NULL;
+}
+
+/* record a change of the position, style, region or z-order of a window */
+static void window_changed( struct window *win )
+{
+    if (!++change_serial)
+    {
+        /* the serial wrapped around, flush all the caches */
+        user_handle_t handle = 0;
+        struct window *ptr;
+
+        while ((ptr = next_user_handle( &handle, USER_WINDOW )))
+        {
+            free_window_caches( ptr );
+            ptr->change_serial = ptr->children_serial = 0;
+        }
+        change_serial = 1;
+    }
+    win->change_serial = change_serial;
+    if (win->parent) win->parent->children_serial = change_serial;
+}
+
+/* get the range of index cells overlapped by a rectangle */
+static void get_index_cells( const struct children_index *index, const rectangle_t *rect,
+                             unsigned int *left, unsigned int *top, unsigned int *right, unsigned int *bottom )
+{
+    *left   = (rect->left - index->bounds.left) / index->cell_width;
+    *top    = (rect->top - index->bounds.top) / index->cell_height;
+    *right  = (rect->right - 1 - index->bounds.left) / index->cell_width;
+    *bottom = (rect->bottom - 1 - index->bounds.top) / index->cell_height;
+}
+
+/* build the spatial index of the visible children of a window */
+static struct children_index *build_children_index( struct window *parent )
+{
+    struct children_index *index, tmp;
+    struct window *ptr;
+    unsigned int count = 0, total = 0, size, i, x, y, left, top, right, bottom;
+    int usable = 1;
+
+    memset( &tmp, 0, sizeof(tmp) );
+    tmp.serial = parent->children_serial;
+
+    LIST_FOR_EACH_ENTRY( ptr, &parent->children, struct window, entry )
+    {
+        if (!(ptr->style & WS_VISIBLE) || is_rect_empty( &ptr->visible_rect )) continue;
+        if (ptr->dpi != parent->dpi) usable = 0;  /* the point would need to be scaled */
+        if (!count++) tmp.bounds = ptr->visible_rect;
+        else
+        {
+            tmp.bounds.left   = min( tmp.bounds.left, ptr->visible_rect.left );
+            tmp.bounds.top    = min( tmp.bounds.top, ptr->visible_rect.top );
+            tmp.bounds.right  = max( tmp.bounds.right, ptr->visible_rect.right );
+            tmp.bounds.bottom = max( tmp.bounds.bottom, ptr->visible_rect.bottom );
+        }
+    }
+
+    if (usable && count >= CHILDREN_INDEX_MIN_COUNT)
+    {
+        for (size = 1; size < CHILDREN_INDEX_MAX_CELLS && (size + 1) * (size + 1) <= count; size++) ;
+        tmp.cols = tmp.rows = size;
+        tmp.cell_width  = max( 1, (tmp.bounds.right - tmp.bounds.left + size - 1) / (int)size );
+        tmp.cell_height = max( 1, (tmp.bounds.bottom - tmp.bounds.top + size - 1) / (int)size );
+
+        LIST_FOR_EACH_ENTRY( ptr, &parent->children, struct window, entry )
+        {
+            if (!(ptr->style & WS_VISIBLE) || is_rect_empty( &ptr->visible_rect )) continue;
+            get_index_cells( &tmp, &ptr->visible_rect, &left, &top, &right, &bottom );
+            total += (right - left + 1) * (bottom - top + 1);
+        }
+        /* an index of heavily overlapping windows wouldn't be faster than walking the list */
+        if (total > count * 8) tmp.cols = tmp.rows = 0;
+    }
+    if (!tmp.cols) total = 0;
+
+    size = sizeof(*index) + total * sizeof(*index->windows) + (tmp.cols * tmp.rows + 1) * sizeof(*index->cells);
+    if (!(index = malloc( size ))) return NULL;
+    *index = tmp;
+    index->windows = (struct window **)(index + 1);
+    index->cells = (unsigned int *)(index->windows + total);
+    memset( index->cells, 0, (tmp.cols * tmp.rows + 1) * sizeof(*index->cells) );
+    if (!index->cols) return index;
+
+    /* count the windows in each cell, then fill the cells in z-order */
+    LIST_FOR_EACH_ENTRY( ptr, &parent->children, struct window, entry )
+    {
+        if (!(ptr->style & WS_VISIBLE) || is_rect_empty( &ptr->visible_rect )) continue;
+        get_index_cells( index, &ptr->visible_rect, &left, &top, &right, &bottom );
+        for (y = top; y <= bottom; y++)
+            for (x = left; x <= right; x++) index->cells[y * index->cols + x + 1]++;
+    }
+    for (i = 0; i < index->cols * index->rows; i++) index->cells[i + 1] += index->cells[i];
+    LIST_FOR_EACH_ENTRY( ptr, &parent->children, struct window, entry )
+    {
+        if (!(ptr->style & WS_VISIBLE) || is_rect_empty( &ptr->visible_rect )) continue;
+        get_index_cells( index, &ptr->visible_rect, &left, &top, &right, &bottom );
+        for (y = top; y <= bottom; y++)
+            for (x = left; x <= right; x++) index->windows[index->cells[y * index->cols + x]++] = ptr;
+    }
+    for (i = index->cols * index->rows; i > 0; i--) index->cells[i] = index->cells[i - 1];
+    index->cells[0] = 0;
+    return index;
+}
+
+/* get the visible children that may contain a point, in z-order; return 0 if there is no usable index */
+static int get_children_from_index( struct window *parent, int x, int y,
+                                    struct window ***windows, unsigned int *count )
+{
+    struct children_index *index = parent->children_index;
+    unsigned int cell;
+
+    if (list_empty( &parent->children )) return 0;
+    if (!index || index->serial != parent->children_serial)
+    {
+        free( index );
+        if (!(index = parent->children_index = build_children_index( parent ))) return 0;
+    }
+    if (!index->cols) return 0;
+
+    *count = 0;
+    if (!point_in_rect( &index->bounds, x, y )) return 1;
+    cell = (y - index->bounds.top) / index->cell_height * index->cols +
+           (x - index->bounds.left) / index->cell_width;
+    *windows = index->windows + index->cells[cell];
+    *count = index->cells[cell + 1] - index->cells[cell];
+    return 1;
+}
+
+/* check if the cached visible region of a window is still valid */
+static int is_vis_cache_valid( struct window *win, unsigned int flags )
+{
+    unsigned int serial = win->vis_cache_serial;
+
+    if (!win->vis_cache || win->vis_cache_flags != flags) return 0;
+    if ((flags & DCX_CLIPCHILDREN) && win->children_serial > serial) return 0;
+
+    /* the region only depends on the window, its ancestors and the siblings along that path */
+    for (;;)
+    {
+        if (win->change_serial > serial) return 0;
+        if (!win->parent) break;
+        if (is_desktop_window( win->parent ))
+        {
+            if (win->parent->change_serial > serial) return 0;
+            break;
+        }
+        if (win->parent->children_serial > serial) return 0;
+        win = win->parent;
+    }
+    return 1;
+}
+
+/* publish the window state to the desktop shared memory */
+static void update_shared_window( struct window *win )
+{
+    struct desktop_shared_memory *shared = win->desktop->shared;
+    struct shared_window *entry;
+
+    if (!shared) return;
+    entry = &shared->windows[get_user_handle_index( win->handle )];
+    begin_shared_update( &shared->seq );
+    entry->handle      = win->handle;
+    entry->parent      = win->parent ? win->parent->handle : 0;
+    entry->owner       = win->owner;
+    entry->style       = win->style;
+    entry->ex_style    = win->ex_style;
+    entry->dpi         = win->dpi;
+    entry->window_rect = win->window_rect;
+    entry->client_rect = win->client_rect;
+    end_shared_update( &shared->seq );
+}
+
+/* remove the window from the desktop shared memory */
+static void clear_shared_window( struct window *win )
+{
+    struct desktop_shared_memory *shared = win->desktop->shared;
+
+    if (!shared) return;
+    begin_shared_update( &shared->seq );
+    memset( &shared->windows[get_user_handle_index( win->handle )], 0, sizeof(struct shared_window) );
+    end_shared_update( &shared->seq );
+}
+
+/* let the clients know that the z-order of the desktop windows changed */
+static void update_shared_zorder( struct window *win )
+{
+    struct desktop_shared_memory *shared = win->desktop->shared;
+
+    if (!shared) return;
+    begin_shared_update( &shared->seq );
+    shared->zorder_version++;
+    end_shared_update( &shared->seq );
+}
+
 /* link a window at the right place in the siblings list */
 static void link_window( struct window *win, struct window *previous )
 {
@@ -240,6 +466,9 @@ static void link_window( struct window *win, struct window *previous )
     }
 
     win->is_linked = 1;
+    window_changed( win );
+    update_shared_window( win );
+    update_shared_zorder( win );
 }
 
 /* change the parent of a window (or unlink the window if the new parent is NULL) */
@@ -257,6 +486,8 @@ static int set_parent_window( struct window *win, struct window *parent )
         }
     }
 
+    window_changed( win );  /* invalidate the caches of the old parent */
+
     if (parent)
     {
         win->parent = parent;
@@ -281,7 +512,9 @@ static int set_parent_window( struct window *win, struct window *parent )
         list_remove( &win->entry );  /* unlink it from the previous location */
         list_add_head( &win->parent->unlinked, &win->entry );
         win->is_linked = 0;
+        update_shared_zorder( win );
     }
+    update_shared_window( win );
     return 1;
 }
 
@@ -510,6 +743,12 @@ static struct window *create_window( struct window *parent, struct window *owner
     win->prop_inuse     = 0;
     win->prop_alloc     = 0;
     win->properties     = NULL;
+    win->change_serial  = 0;
+    win->children_serial = 0;
+    win->children_index = NULL;
+    win->vis_cache      = NULL;
+    win->vis_cache_flags = 0;
+    win->vis_cache_serial = 0;
     win->nb_extra_bytes = extra_bytes;
     win->window_rect = win->visible_rect = win->surface_rect = win->client_rect = empty_rect;
     memset( win->extra_bytes, 0, extra_bytes );
@@ -545,6 +784,7 @@ static struct window *create_window( struct window *parent, struct window *owner
         }
     }
 
+    update_shared_window( win );
     current->desktop_users++;
     return win;
 
@@ -749,51 +989,80 @@ static unsigned int get_children_windows( struct window *parent, atom_t atom, th
     return count;
 }
 
+static struct window *child_window_from_point( struct window *parent, int x, int y );
+
+/* find the window containing the given point within a child of 'parent', NULL if not in the child */
+static struct window *point_in_child_window( struct window *parent, struct window *ptr, int x, int y )
+{
+    if (!is_point_in_window( ptr, &x, &y, parent->dpi )) return NULL;  /* skip it */
+
+    /* if window is minimized or disabled, return at once */
+    if (ptr->style & (WS_MINIMIZE|WS_DISABLED)) return ptr;
+
+    /* if point is not in client area, return at once */
+    if (!point_in_rect( &ptr->client_rect, x, y )) return ptr;
+
+    return child_window_from_point( ptr, x - ptr->client_rect.left, y - ptr->client_rect.top );
+}
+
 /* find child of 'parent' that contains the given point (in parent-relative coords) */
 static struct window *child_window_from_point( struct window *parent, int x, int y )
 {
-    struct window *ptr;
+    struct window *ptr, *ret, **windows;
+    unsigned int i, count;
 
-    LIST_FOR_EACH_ENTRY( ptr, &parent->children, struct window, entry )
+    if (get_children_from_index( parent, x, y, &windows, &count ))
     {
-        int x_child = x, y_child = y;
+        for (i = 0; i < count; i++)
+            if ((ret = point_in_child_window( parent, windows[i], x, y ))) return ret;
+        return parent;  /* not found any child */
+    }
 
-        if (!is_point_in_window( ptr, &x_child, &y_child, parent->dpi )) continue;  /* skip it */
+    LIST_FOR_EACH_ENTRY( ptr, &parent->children, struct window, entry )
+    {
+        if ((ret = point_in_child_window( parent, ptr, x, y ))) return ret;
+    }
+    return parent;  /* not found any child */
+}
 
-        /* if window is minimized or disabled, return at once */
-        if (ptr->style & (WS_MINIMIZE|WS_DISABLED)) return ptr;
+static int get_window_children_from_point( struct window *parent, int x, int y,
+                                           struct user_handle_array *array );
 
-        /* if point is not in client area, return at once */
-        if (!point_in_rect( &ptr->client_rect, x_child, y_child )) return ptr;
+/* add a child of 'parent' and its children to the array if they contain the given point */
+static int add_child_windows_from_point( struct window *parent, struct window *ptr, int x, int y,
+                                         struct user_handle_array *array )
+{
+    if (!is_point_in_window( ptr, &x, &y, parent->dpi )) return 1;  /* skip it */
 
-        return child_window_from_point( ptr, x_child - ptr->client_rect.left,
-                                        y_child - ptr->client_rect.top );
+    /* if point is in client area, and window is not minimized or disabled, check children */
+    if (!(ptr->style & (WS_MINIMIZE|WS_DISABLED)) && point_in_rect( &ptr->client_rect, x, y ))
+    {
+        if (!get_window_children_from_point( ptr, x - ptr->client_rect.left,
+                                             y - ptr->client_rect.top, array ))
+            return 0;
     }
-    return parent;  /* not found any child */
+
+    /* now add window to the array */
+    return add_handle_to_array( array, ptr->handle );
 }
 
 /* find all children of 'parent' that contain the given point */
 static int get_window_children_from_point( struct window *parent, int x, int y,
                                            struct user_handle_array *array )
 {
-    struct window *ptr;
+    struct window *ptr, **windows;
+    unsigned int i, count;
 
-    LIST_FOR_EACH_ENTRY( ptr, &parent->children, struct window, entry )
+    if (get_children_from_index( parent, x, y, &windows, &count ))
     {
-        int x_child = x, y_child = y;
-
-        if (!is_point_in_window( ptr, &x_child, &y_child, parent->dpi )) continue;  /* skip it */
-
-        /* if point is in client area, and window is not minimized or disabled, check children */
-        if (!(ptr->style & (WS_MINIMIZE|WS_DISABLED)) && point_in_rect( &ptr->client_rect, x_child, y_child ))
-        {
-            if (!get_window_children_from_point( ptr, x_child - ptr->client_rect.left,
-                                                 y_child - ptr->client_rect.top, array ))
-                return 0;
-        }
+        for (i = 0; i < count; i++)
+            if (!add_child_windows_from_point( parent, windows[i], x, y, array )) return 0;
+        return 1;
+    }
 
-        /* now add window to the array */
-        if (!add_handle_to_array( array, ptr->handle )) return 0;
+    LIST_FOR_EACH_ENTRY( ptr, &parent->children, struct window, entry )
+    {
+        if (!add_child_windows_from_point( parent, ptr, x, y, array )) return 0;
     }
     return 1;
 }
@@ -1016,7 +1285,7 @@ static inline struct window *get_top_clipping_window( struct window *win )
 
 
 /* compute the visible region of a window, in window coordinates */
-static struct region *get_visible_region( struct window *win, unsigned int flags )
+static struct region *compute_visible_region( struct window *win, unsigned int flags )
 {
     struct region *tmp = NULL, *region;
     int offset_x, offset_y;
@@ -1095,6 +1364,26 @@ error:
 }
 
 
+/* get the visible region of a window, in window coordinates, using the cached one if still valid */
+static struct region *get_visible_region( struct window *win, unsigned int flags )
+{
+    struct region *region;
+
+    if (is_vis_cache_valid( win, flags )) return dup_region( win->vis_cache );
+
+    if (!(region = compute_visible_region( win, flags ))) return NULL;
+
+    if (win->vis_cache) free_region( win->vis_cache );
+    if ((win->vis_cache = dup_region( region )))
+    {
+        win->vis_cache_flags  = flags;
+        win->vis_cache_serial = change_serial;
+    }
+    else clear_error();
+    return region;
+}
+
+
 /* clip all children with a custom pixel format out of the visible region */
 static struct region *clip_pixel_format_children( struct window *parent, struct region *parent_clip,
                                                   struct region *region, int offset_x, int offset_y )
@@ -1700,6 +1989,7 @@ static void set_window_pos( struct window *win, struct window *previous,
     if (!(swp_flags & SWP_NOZORDER) && win->parent) link_window( win, previous );
     if (swp_flags & SWP_SHOWWINDOW) win->style |= WS_VISIBLE;
     else if (swp_flags & SWP_HIDEWINDOW) win->style &= ~WS_VISIBLE;
+    window_changed( win );
 
     /* keep children at the same position relative to top right corner when the parent is mirrored */
     if (win->ex_style & WS_EX_LAYOUTRTL)
@@ -1714,6 +2004,8 @@ static void set_window_pos( struct window *win, struct window *previous,
             offset_rect( &child->visible_rect, new_size - old_size, 0 );
             offset_rect( &child->surface_rect, new_size - old_size, 0 );
             offset_rect( &child->client_rect, new_size - old_size, 0 );
+            window_changed( child );
+            update_shared_window( child );
         }
     }
 
@@ -1855,6 +2147,7 @@ static void set_window_region( struct window *win, struct region *region, int re
 
     if (win->win_region) free_region( win->win_region );
     win->win_region = region;
+    window_changed( win );
 
     /* expose anything revealed by the change */
     if (old_vis_rgn && ((exposed_rgn = expose_window( win, &win->window_rect, old_vis_rgn ))))
@@ -1876,6 +2169,8 @@ void destroy_window( struct window *win )
     {
         struct region *vis_rgn = get_visible_region( win, DCX_WINDOW );
         win->style &= ~WS_VISIBLE;
+        window_changed( win );
+        update_shared_window( win );
         if (vis_rgn)
         {
             struct region *exposed_rgn = expose_window( win, &win->window_rect, vis_rgn );
@@ -1899,8 +2194,10 @@ void destroy_window( struct window *win )
     if (win == taskman_window) taskman_window = NULL;
     free_hotkeys( win->desktop, win->handle );
     cleanup_clipboard_window( win->desktop, win->handle );
+    clear_shared_window( win );
     free_user_handle( win->handle );
     destroy_properties( win );
+    window_changed( win );
     list_remove( &win->entry );
     if (is_desktop_window(win))
     {
@@ -1917,6 +2214,7 @@ void destroy_window( struct window *win )
     detach_window_thread( win );
     if (win->win_region) free_region( win->win_region );
     if (win->update_region) free_region( win->update_region );
+    free_window_caches( win );
     if (win->class) release_class( win->class );
     free( win->text );
     memset( win, 0x55, sizeof(*win) + win->nb_extra_bytes - 1 );
@@ -1963,6 +2261,7 @@ DECL_HANDLER(create_window)
         win->dpi_awareness = req->awareness;
         win->dpi = req->dpi;
     }
+    update_shared_window( win );
 
     reply->handle    = win->handle;
     reply->parent    = win->parent ? win->parent->handle : 0;
@@ -2025,6 +2324,8 @@ DECL_HANDLER(get_desktop_window)
         {
             detach_window_thread( desktop->top_window );
             desktop->top_window->style  = WS_POPUP | WS_VISIBLE | WS_CLIPSIBLINGS | WS_CLIPCHILDREN;
+            window_changed( desktop->top_window );
+            update_shared_window( desktop->top_window );
         }
     }
 
@@ -2037,6 +2338,8 @@ DECL_HANDLER(get_desktop_window)
         {
             detach_window_thread( desktop->msg_window );
             desktop->msg_window->style = WS_POPUP | WS_CLIPSIBLINGS | WS_CLIPCHILDREN;
+            window_changed( desktop->msg_window );
+            update_shared_window( desktop->msg_window );
         }
     }
 
@@ -2072,6 +2375,7 @@ DECL_HANDLER(set_window_owner)
 
     reply->prev_owner = win->owner;
     reply->full_owner = win->owner = owner ? owner->handle : 0;
+    update_shared_window( win );
 }
 
 
@@ -2146,6 +2450,11 @@ DECL_HANDLER(set_window_info)
 
     /* changing window style triggers a non-client paint */
     if (req->flags & SET_WIN_STYLE) win->paint_flags |= PAINT_NONCLIENT;
+    if (req->flags & (SET_WIN_STYLE | SET_WIN_EXSTYLE))
+    {
+        window_changed( win );
+        update_shared_window( win );
+    }
 }
 
 
@@ -2347,6 +2656,7 @@ DECL_HANDLER(set_window_pos)
 
     set_window_pos( win, previous, flags, &window_rect, &client_rect,
                     &visible_rect, &surface_rect, &valid_rect );
+    update_shared_window( win );
 
     reply->new_style = win->style;
     reply->new_ex_style = win->ex_style;
@@ -2673,6 +2983,8 @@ DECL_HANDLER(update_window_zorder)
         {
             list_remove( &win->entry );
             list_add_before( &ptr->entry, &win->entry );
+            window_changed( win );
+            update_shared_zorder( win );
         }
         break;
     }
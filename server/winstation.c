@@ -213,6 +213,19 @@ struct desktop *get_desktop_obj( struct process *process, obj_handle_t handle, u
     return (struct desktop *)get_handle_obj( process, handle, access, &desktop_ops );
 }
 
+/* start updating a shared memory block */
+/* the sequence number is odd while the data is being updated, clients retry in that case */
+void begin_shared_update( unsigned int *seq )
+{
+    interlocked_xchg_add( (int *)seq, 1 );
+}
+
+/* finish updating a shared memory block */
+void end_shared_update( unsigned int *seq )
+{
+    interlocked_xchg_add( (int *)seq, 1 );
+}
+
 /* create a desktop object */
 static struct desktop *create_desktop( const struct unicode_str *name, unsigned int attr,
                                        unsigned int flags, struct winstation *winstation )
@@ -236,6 +249,15 @@ static struct desktop *create_desktop( const struct unicode_str *name, unsigned
             memset( desktop->keystate, 0, sizeof(desktop->keystate) );
             list_add_tail( &winstation->desktops, &desktop->entry );
             list_init( &desktop->hotkeys );
+            /* clients fall back to server requests if this fails */
+            desktop->shared_mapping = create_shared_mapping( FIELD_OFFSET( struct desktop_shared_memory,
+                                          windows[(LAST_USER_HANDLE - FIRST_USER_HANDLE + 1) >> 1] ),
+                                          (void **)&desktop->shared );
+            if (!desktop->shared_mapping)
+            {
+                desktop->shared = NULL;
+                clear_error();
+            }
         }
         else clear_error();
     }
@@ -297,6 +319,7 @@ static void desktop_destroy( struct object *obj )
     if (desktop->close_timeout) remove_timeout_user( desktop->close_timeout );
     list_remove( &desktop->entry );
     release_object( desktop->winstation );
+    if (desktop->shared_mapping) release_object( desktop->shared_mapping );
 }
 
 static unsigned int desktop_map_access( struct object *obj, unsigned int access )
@@ -595,6 +618,21 @@ DECL_HANDLER(get_thread_desktop)
 }
 
 
+/* get a read-only view of the shared memory of the thread desktop */
+DECL_HANDLER(get_desktop_shm)
+{
+    struct desktop *desktop;
+
+    if (!(desktop = get_thread_desktop( current, 0 ))) return;
+    if (desktop->shared_mapping)
+        reply->handle = alloc_handle( current->process, desktop->shared_mapping,
+                                      SECTION_QUERY | SECTION_MAP_READ, 0 );
+    else
+        set_error( STATUS_NOT_SUPPORTED );
+    release_object( desktop );
+}
+
+
 /* set the thread current desktop */
 DECL_HANDLER(set_thread_desktop)
 {